@@ -0,0 +1,434 @@
+// Runs the same random workloads on `DynamicConnectivity` and on simpler
+// connectivity strategies, and reports where the fastest strategy changes as
+// the graph density and the ratio of queries to updates vary.
+//
+// Usage:
+//   benchmark_baselines [<number of vertices> [<number of operations>]]
+//
+// Strategies:
+//   - hdt: `DynamicConnectivity`.
+//   - recompute: keeps the edge set and rebuilds a union-find structure from
+//     scratch at the first query after any update.
+//   - union_find: applies additions to a union-find structure in place and
+//     rebuilds it at the first query after a deletion.
+//   - single_level_ett: keeps a spanning forest in a `DynamicForest` without
+//     HDT's levels, and on deleting a tree edge scans every non-tree edge
+//     incident to the smaller of the two resulting trees for a replacement.
+//
+// Each workload starts from a random graph with density * n edges, which is
+// built without being timed. Each timed operation is then a connectivity query
+// between random vertices with probability r / (1 + r) for a ratio r of queries
+// to updates, and otherwise an update that deletes a random edge or adds a
+// random new edge with equal probability, so that the density stays about the
+// same.
+#include <dynamic_forest.hpp>
+#include <dynamic_graph/dynamic_connectivity.hpp>
+#include <dynamic_graph/operation.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <numeric>
+#include <random>
+#include <sstream>
+#include <string>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+double DurationToSeconds(const Clock::duration& duration) {
+  return
+    std::chrono::duration_cast<std::chrono::duration<double>>(duration).count();
+}
+
+typedef std::unordered_set<UndirectedEdge, UndirectedEdgeHash> EdgeSet;
+
+class UnionFind {
+ public:
+  explicit UnionFind(int64_t num_vertices)
+    : parents_(num_vertices), sizes_(num_vertices) {
+    Reset();
+  }
+
+  void Reset() {
+    std::iota(parents_.begin(), parents_.end(), 0);
+    std::fill(sizes_.begin(), sizes_.end(), 1);
+  }
+
+  Vertex Find(Vertex v) {
+    while (parents_[v] != v) {
+      parents_[v] = parents_[parents_[v]];
+      v = parents_[v];
+    }
+    return v;
+  }
+
+  void Union(Vertex u, Vertex v) {
+    u = Find(u);
+    v = Find(v);
+    if (u == v) {
+      return;
+    }
+    if (sizes_[u] < sizes_[v]) {
+      std::swap(u, v);
+    }
+    parents_[v] = u;
+    sizes_[u] += sizes_[v];
+  }
+
+ private:
+  std::vector<Vertex> parents_;
+  std::vector<int64_t> sizes_;
+};
+
+class RecomputeEngine {
+ public:
+  explicit RecomputeEngine(int64_t num_vertices) : components_{num_vertices} {}
+
+  void AddEdge(const UndirectedEdge& edge) {
+    edges_.emplace(edge);
+    is_stale_ = true;
+  }
+
+  void DeleteEdge(const UndirectedEdge& edge) {
+    edges_.erase(edge);
+    is_stale_ = true;
+  }
+
+  bool IsConnected(Vertex u, Vertex v) {
+    if (is_stale_) {
+      components_.Reset();
+      for (const UndirectedEdge& edge : edges_) {
+        components_.Union(edge.first, edge.second);
+      }
+      is_stale_ = false;
+    }
+    return components_.Find(u) == components_.Find(v);
+  }
+
+ private:
+  EdgeSet edges_;
+  UnionFind components_;
+  bool is_stale_{false};
+};
+
+class UnionFindEngine {
+ public:
+  explicit UnionFindEngine(int64_t num_vertices) : components_{num_vertices} {}
+
+  void AddEdge(const UndirectedEdge& edge) {
+    edges_.emplace(edge);
+    if (!is_stale_) {
+      components_.Union(edge.first, edge.second);
+    }
+  }
+
+  void DeleteEdge(const UndirectedEdge& edge) {
+    edges_.erase(edge);
+    is_stale_ = true;
+  }
+
+  bool IsConnected(Vertex u, Vertex v) {
+    if (is_stale_) {
+      components_.Reset();
+      for (const UndirectedEdge& edge : edges_) {
+        components_.Union(edge.first, edge.second);
+      }
+      is_stale_ = false;
+    }
+    return components_.Find(u) == components_.Find(v);
+  }
+
+ private:
+  EdgeSet edges_;
+  UnionFind components_;
+  bool is_stale_{false};
+};
+
+class SingleLevelEttEngine {
+ public:
+  explicit SingleLevelEttEngine(int64_t num_vertices)
+    : forest_{num_vertices}, non_tree_adjacency_lists_(num_vertices) {}
+
+  void AddEdge(const UndirectedEdge& edge) {
+    if (forest_.IsConnected(edge.first, edge.second)) {
+      AddNonTreeEdge(edge.first, edge.second);
+    } else {
+      forest_.AddEdge(edge);
+    }
+  }
+
+  void DeleteEdge(const UndirectedEdge& edge) {
+    if (!forest_.HasEdge(edge)) {
+      DeleteNonTreeEdge(edge.first, edge.second);
+      return;
+    }
+    forest_.DeleteEdge(edge);
+    const Vertex smaller_side{
+      forest_.GetSizeOfTree(edge.first) <= forest_.GetSizeOfTree(edge.second)
+        ? edge.first
+        : edge.second};
+    // Vertices incident to non-tree edges are marked in the forest.
+    for (const Vertex u : forest_.GetMarkedVerticesInTree(smaller_side)) {
+      for (const Vertex v : non_tree_adjacency_lists_[u]) {
+        if (!forest_.IsConnected(u, v)) {
+          DeleteNonTreeEdge(u, v);
+          forest_.AddEdge({u, v});
+          return;
+        }
+      }
+    }
+  }
+
+  bool IsConnected(Vertex u, Vertex v) const {
+    return forest_.IsConnected(u, v);
+  }
+
+ private:
+  void AddNonTreeEdge(Vertex u, Vertex v) {
+    for (const auto& [x, y] : {std::make_pair(u, v), std::make_pair(v, u)}) {
+      non_tree_adjacency_lists_[x].emplace(y);
+      if (non_tree_adjacency_lists_[x].size() == 1) {
+        forest_.MarkVertex(x, true);
+      }
+    }
+  }
+
+  void DeleteNonTreeEdge(Vertex u, Vertex v) {
+    for (const auto& [x, y] : {std::make_pair(u, v), std::make_pair(v, u)}) {
+      non_tree_adjacency_lists_[x].erase(y);
+      if (non_tree_adjacency_lists_[x].empty()) {
+        forest_.MarkVertex(x, false);
+      }
+    }
+  }
+
+  DynamicForest forest_;
+  std::vector<std::unordered_set<Vertex>> non_tree_adjacency_lists_;
+};
+
+struct Workload {
+  std::vector<Operation> initial_edges;
+  std::vector<Operation> operations;
+};
+
+Workload MakeWorkload(
+    int64_t num_vertices,
+    int64_t num_operations,
+    double density,
+    double queries_per_update) {
+  std::mt19937_64 random_generator{0};
+  std::uniform_int_distribution<Vertex> vertex_distribution{
+    0, num_vertices - 1};
+  std::uniform_real_distribution<double> unit_distribution{0, 1};
+  const double query_probability{queries_per_update / (1 + queries_per_update)};
+  EdgeSet edges;
+  std::vector<std::pair<Vertex, Vertex>> edge_list;
+  Workload workload;
+  // Adds a random edge that is not in the graph.
+  const auto add_edge{[&](std::vector<Operation>* operations) {
+    while (true) {
+      const UndirectedEdge edge{
+        vertex_distribution(random_generator),
+        vertex_distribution(random_generator)};
+      if (edge.first != edge.second && edges.emplace(edge).second) {
+        edge_list.emplace_back(edge.first, edge.second);
+        operations->push_back({Operation::Type::kAddEdge, edge});
+        return;
+      }
+    }
+  }};
+  while (static_cast<double>(edge_list.size()) < density * num_vertices) {
+    add_edge(&workload.initial_edges);
+  }
+  for (int64_t i = 0; i < num_operations; i++) {
+    if (unit_distribution(random_generator) < query_probability) {
+      workload.operations.push_back(
+          {Operation::Type::kIsConnected,
+           UndirectedEdge{
+             vertex_distribution(random_generator),
+             vertex_distribution(random_generator)}});
+    } else if (edge_list.empty() || random_generator() % 2 == 0) {
+      add_edge(&workload.operations);
+    } else {
+      const std::size_t index{random_generator() % edge_list.size()};
+      const UndirectedEdge edge{
+        edge_list[index].first, edge_list[index].second};
+      std::swap(edge_list[index], edge_list.back());
+      edge_list.pop_back();
+      edges.erase(edge);
+      workload.operations.push_back({Operation::Type::kDeleteEdge, edge});
+    }
+  }
+  return workload;
+}
+
+struct RunResult {
+  double seconds;
+  // Number of queries answered positively, for checking that the strategies
+  // agree.
+  int64_t num_connected_queries;
+};
+
+template <typename Engine>
+RunResult Run(int64_t num_vertices, const Workload& workload) {
+  Engine engine(num_vertices);
+  for (const Operation& operation : workload.initial_edges) {
+    engine.AddEdge(operation.edge);
+  }
+  int64_t num_connected_queries{0};
+  const auto start{Clock::now()};
+  for (const Operation& operation : workload.operations) {
+    switch (operation.type) {
+      case Operation::Type::kAddEdge:
+        engine.AddEdge(operation.edge);
+        break;
+      case Operation::Type::kDeleteEdge:
+        engine.DeleteEdge(operation.edge);
+        break;
+      case Operation::Type::kIsConnected:
+        num_connected_queries +=
+          engine.IsConnected(operation.edge.first, operation.edge.second);
+        break;
+    }
+  }
+  return {DurationToSeconds(Clock::now() - start), num_connected_queries};
+}
+
+enum Strategy {
+  kHdt,
+  kRecompute,
+  kUnionFind,
+  kSingleLevelEtt,
+  kNumStrategies,
+};
+
+const char* const kStrategyNames[kNumStrategies]{
+  "hdt",
+  "recompute",
+  "union_find",
+  "single_level_ett",
+};
+
+// Prints where the faster of HDT and `baseline` changes as one parameter
+// varies with the other held fixed. `seconds[i][s]` is the time of strategy
+// `s` at the i-th parameter value.
+void PrintCrossovers(
+    Strategy baseline,
+    const std::string& fixed_description,
+    const std::string& varied_name,
+    const std::vector<double>& varied_values,
+    const std::vector<std::vector<double>>& seconds) {
+  std::cout << "  " << kStrategyNames[baseline] << " vs hdt, "
+    << fixed_description << ": ";
+  const auto winner{[&](std::size_t i) {
+    return seconds[i][baseline] < seconds[i][kHdt] ? baseline : kHdt;
+  }};
+  bool has_crossover{false};
+  for (std::size_t i = 1; i < varied_values.size(); i++) {
+    if (winner(i) != winner(i - 1)) {
+      std::cout << (has_crossover ? "; " : "") << kStrategyNames[winner(i - 1)]
+        << " at " << varied_name << ' ' << varied_values[i - 1] << ", "
+        << kStrategyNames[winner(i)] << " at " << varied_values[i];
+      has_crossover = true;
+    }
+  }
+  if (!has_crossover) {
+    std::cout << kStrategyNames[winner(0)] << " is faster throughout";
+  }
+  std::cout << '\n';
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  const int64_t num_vertices{argc > 1 ? std::stoll(argv[1]) : 4096};
+  const int64_t num_operations{argc > 2 ? std::stoll(argv[2]) : 20000};
+  if (argc > 3 || num_vertices < 2 || num_operations <= 0) {
+    std::cerr << "Usage: " << argv[0]
+      << " [<number of vertices> [<number of operations>]]\n";
+    return 1;
+  }
+  const std::vector<double> densities{0.5, 1, 2, 4, 8};
+  const std::vector<double> ratios{0.1, 1, 10, 100};
+
+  // seconds[d][r][s] is the time of strategy `s` at the d-th density and the
+  // r-th ratio of queries to updates.
+  std::vector<std::vector<std::vector<double>>> seconds(
+      densities.size(),
+      std::vector<std::vector<double>>(
+          ratios.size(), std::vector<double>(kNumStrategies)));
+  const int32_t kPrecision{4};
+  std::cout << std::setprecision(kPrecision);
+  std::cout << "Graph of " << num_vertices << " vertices, " << num_operations
+    << " timed operations per workload.\nTime per operation in ns:\n";
+  std::cout << std::setw(8) << "density" << std::setw(16) << "queries/update";
+  for (const char* name : kStrategyNames) {
+    std::cout << std::setw(18) << name;
+  }
+  std::cout << std::setw(18) << "fastest" << '\n';
+  for (std::size_t d = 0; d < densities.size(); d++) {
+    for (std::size_t r = 0; r < ratios.size(); r++) {
+      const Workload workload{
+        MakeWorkload(num_vertices, num_operations, densities[d], ratios[r])};
+      const RunResult results[kNumStrategies]{
+        Run<DynamicConnectivity>(num_vertices, workload),
+        Run<RecomputeEngine>(num_vertices, workload),
+        Run<UnionFindEngine>(num_vertices, workload),
+        Run<SingleLevelEttEngine>(num_vertices, workload),
+      };
+      std::cout << std::setw(8) << densities[d] << std::setw(16) << ratios[r];
+      int32_t fastest{kHdt};
+      for (int32_t s = 0; s < kNumStrategies; s++) {
+        if (results[s].num_connected_queries
+            != results[kHdt].num_connected_queries) {
+          std::cerr << kStrategyNames[s] << " disagrees with hdt\n";
+          return 1;
+        }
+        seconds[d][r][s] = results[s].seconds;
+        if (results[s].seconds < results[fastest].seconds) {
+          fastest = s;
+        }
+        std::cout << std::setw(18) << results[s].seconds * 1e9 / num_operations;
+      }
+      std::cout << std::setw(18) << kStrategyNames[fastest] << '\n';
+    }
+  }
+
+  std::cout << "Crossovers as the ratio of queries to updates grows:\n";
+  for (std::size_t d = 0; d < densities.size(); d++) {
+    for (int32_t s = kRecompute; s < kNumStrategies; s++) {
+      std::ostringstream description;
+      description << "density " << densities[d];
+      PrintCrossovers(
+          static_cast<Strategy>(s),
+          description.str(),
+          "queries/update",
+          ratios,
+          seconds[d]);
+    }
+  }
+  std::cout << "Crossovers as the density grows:\n";
+  for (std::size_t r = 0; r < ratios.size(); r++) {
+    std::vector<std::vector<double>> seconds_by_density;
+    for (std::size_t d = 0; d < densities.size(); d++) {
+      seconds_by_density.emplace_back(seconds[d][r]);
+    }
+    for (int32_t s = kRecompute; s < kNumStrategies; s++) {
+      std::ostringstream description;
+      description << ratios[r] << " queries/update";
+      PrintCrossovers(
+          static_cast<Strategy>(s),
+          description.str(),
+          "density",
+          densities,
+          seconds_by_density);
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,320 @@
+// Benchmarks the layers below `DynamicConnectivity` on their own: Euler tour
+// sequences (both the treap and the B-tree backend) and dynamic forests built
+// on them. For each operation it reports nanoseconds per operation and, where
+// the kernel allows perf_event_open(2), last-level cache misses per operation.
+//
+// Sequence operations run on one sequence holding all elements:
+//   - split, join: each round splits the sequence after 64 random elements and
+//     then joins the pieces back, in random orders. Later splits in a round act
+//     on shorter pieces.
+//   - get_representative: finds the root of the sequence from a random element.
+//   - mark: marks 1% of the elements, chosen at random.
+//   - find_marked_element: finds a marked element from a random element.
+// Forest operations run on a spanning tree of the vertices shaped as a path, a
+// star, or a random tree in which each vertex links to a random earlier one:
+//   - link, cut: each round cuts 64 random tree edges and then links them back,
+//     in random orders.
+//   - is_connected: asks whether two random vertices are connected.
+#include <dynamic_forest.hpp>
+#include <btree_sequence.hpp>
+#include <sequence.hpp>
+
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+constexpr int64_t kNumOperations{1 << 16};
+constexpr int64_t kRoundSize{64};
+
+// Keeps the compiler from discarding the computation of `value`.
+template <typename T>
+void DoNotOptimize(const T& value) {
+  asm volatile("" : : "r,m"(value) : "memory");
+}
+
+// Accumulates the time spent and the cache misses incurred by the calling
+// thread between calls to `Start()` and `Stop()`.
+class Meter {
+ public:
+  Meter() {
+    perf_event_attr attributes{};
+    attributes.type = PERF_TYPE_HARDWARE;
+    attributes.size = sizeof(attributes);
+    attributes.config = PERF_COUNT_HW_CACHE_MISSES;
+    attributes.disabled = 1;
+    attributes.exclude_kernel = 1;
+    attributes.exclude_hv = 1;
+    file_descriptor_ = syscall(SYS_perf_event_open, &attributes, 0, -1, -1, 0);
+  }
+
+  ~Meter() {
+    if (file_descriptor_ != -1) {
+      close(file_descriptor_);
+    }
+  }
+
+  Meter(const Meter& other) = delete;
+  Meter& operator=(const Meter& other) = delete;
+
+  void Start() {
+    if (file_descriptor_ != -1) {
+      ioctl(file_descriptor_, PERF_EVENT_IOC_ENABLE, 0);
+    }
+    start_ = Clock::now();
+  }
+
+  void Stop() {
+    duration_ += Clock::now() - start_;
+    if (file_descriptor_ != -1) {
+      ioctl(file_descriptor_, PERF_EVENT_IOC_DISABLE, 0);
+    }
+  }
+
+  // Prints a row of the results table.
+  void Report(
+      const std::string& structure,
+      const std::string& variant,
+      int64_t size,
+      const std::string& operation,
+      int64_t num_operations) const {
+    const double nanoseconds{
+      std::chrono::duration<double, std::nano>{duration_}.count()};
+    std::cout << std::left << std::setw(10) << structure << std::setw(14)
+      << variant << std::right << std::setw(9) << size << "  " << std::left
+      << std::setw(20) << operation << std::right << std::setw(12)
+      << nanoseconds / num_operations;
+    uint64_t num_cache_misses{0};
+    if (file_descriptor_ != -1
+        && read(file_descriptor_, &num_cache_misses, sizeof(num_cache_misses))
+          == sizeof(num_cache_misses)) {
+      std::cout << std::setw(16)
+        << static_cast<double>(num_cache_misses) / num_operations;
+    } else {
+      std::cout << std::setw(16) << "n/a";
+    }
+    std::cout << '\n';
+  }
+
+ private:
+  int file_descriptor_{-1};
+  Clock::time_point start_;
+  Clock::duration duration_{0};
+};
+
+// Returns `count` distinct random integers in [0, n).
+std::vector<int64_t> SampleDistinct(
+    int64_t n, int64_t count, std::mt19937_64* random_generator) {
+  std::vector<int64_t> sample;
+  std::uniform_int_distribution<int64_t> distribution{0, n - 1};
+  while (static_cast<int64_t>(sample.size()) < count) {
+    const int64_t x{distribution(*random_generator)};
+    if (std::find(sample.begin(), sample.end(), x) == sample.end()) {
+      sample.emplace_back(x);
+    }
+  }
+  return sample;
+}
+
+template <typename Element>
+void BenchmarkSequence(const std::string& backend, int64_t size) {
+  std::mt19937_64 random_generator{0};
+  std::uniform_int_distribution<int64_t> index_distribution{0, size - 1};
+  std::vector<Element> elements(size);
+  for (int64_t i = 1; i < size; i++) {
+    Element::Join(&elements[i - 1], &elements[i]);
+  }
+
+  {
+    Meter split_meter;
+    Meter join_meter;
+    const int64_t num_rounds{kNumOperations / kRoundSize};
+    for (int64_t round = 0; round < num_rounds; round++) {
+      // Never split after the last element, which has no successor.
+      const std::vector<int64_t> split_indices{
+        SampleDistinct(size - 1, kRoundSize, &random_generator)};
+      split_meter.Start();
+      for (const int64_t i : split_indices) {
+        DoNotOptimize(elements[i].Split());
+      }
+      split_meter.Stop();
+      std::vector<int64_t> join_indices{split_indices};
+      std::shuffle(join_indices.begin(), join_indices.end(), random_generator);
+      join_meter.Start();
+      for (const int64_t i : join_indices) {
+        Element::Join(&elements[i], &elements[i + 1]);
+      }
+      join_meter.Stop();
+    }
+    split_meter.Report(
+        "sequence", backend, size, "split", num_rounds * kRoundSize);
+    join_meter.Report(
+        "sequence", backend, size, "join", num_rounds * kRoundSize);
+  }
+
+  {
+    std::vector<int64_t> indices(kNumOperations);
+    for (int64_t& i : indices) {
+      i = index_distribution(random_generator);
+    }
+    Meter meter;
+    meter.Start();
+    for (const int64_t i : indices) {
+      DoNotOptimize(elements[i].GetRepresentative());
+    }
+    meter.Stop();
+    meter.Report(
+        "sequence", backend, size, "get_representative", kNumOperations);
+  }
+
+  {
+    const std::vector<int64_t> mark_indices{SampleDistinct(
+        size, std::max<int64_t>(size / 100, 1), &random_generator)};
+    Meter mark_meter;
+    mark_meter.Start();
+    for (const int64_t i : mark_indices) {
+      elements[i].Mark(0, true);
+    }
+    mark_meter.Stop();
+    mark_meter.Report("sequence", backend, size, "mark", mark_indices.size());
+
+    std::vector<int64_t> indices(kNumOperations);
+    for (int64_t& i : indices) {
+      i = index_distribution(random_generator);
+    }
+    Meter find_meter;
+    find_meter.Start();
+    for (const int64_t i : indices) {
+      DoNotOptimize(elements[i].FindMarkedElement(0));
+    }
+    find_meter.Stop();
+    find_meter.Report(
+        "sequence", backend, size, "find_marked_element", kNumOperations);
+  }
+}
+
+enum class TreeShape {
+  kPath,
+  kStar,
+  kRandom,
+};
+
+template <typename Forest>
+void BenchmarkForest(
+    const std::string& backend, TreeShape shape, int64_t num_vertices) {
+  std::mt19937_64 random_generator{0};
+  std::vector<std::pair<Vertex, Vertex>> edges;
+  for (Vertex v = 1; v < num_vertices; v++) {
+    switch (shape) {
+      case TreeShape::kPath:
+        edges.emplace_back(v - 1, v);
+        break;
+      case TreeShape::kStar:
+        edges.emplace_back(0, v);
+        break;
+      case TreeShape::kRandom:
+        edges.emplace_back(
+            std::uniform_int_distribution<Vertex>{0, v - 1}(random_generator),
+            v);
+        break;
+    }
+  }
+  const std::string variant{
+    backend + (shape == TreeShape::kPath ? " path"
+               : shape == TreeShape::kStar ? " star"
+               : " random")};
+
+  Forest forest{num_vertices};
+  std::shuffle(edges.begin(), edges.end(), random_generator);
+  for (const auto& [u, v] : edges) {
+    forest.AddEdge({u, v});
+  }
+
+  {
+    Meter link_meter;
+    Meter cut_meter;
+    const int64_t num_rounds{kNumOperations / kRoundSize};
+    for (int64_t round = 0; round < num_rounds; round++) {
+      const std::vector<int64_t> cut_indices{
+        SampleDistinct(edges.size(), kRoundSize, &random_generator)};
+      cut_meter.Start();
+      for (const int64_t i : cut_indices) {
+        forest.DeleteEdge({edges[i].first, edges[i].second});
+      }
+      cut_meter.Stop();
+      std::vector<int64_t> link_indices{cut_indices};
+      std::shuffle(link_indices.begin(), link_indices.end(), random_generator);
+      link_meter.Start();
+      for (const int64_t i : link_indices) {
+        forest.AddEdge({edges[i].first, edges[i].second});
+      }
+      link_meter.Stop();
+    }
+    link_meter.Report(
+        "forest", variant, num_vertices, "link", num_rounds * kRoundSize);
+    cut_meter.Report(
+        "forest", variant, num_vertices, "cut", num_rounds * kRoundSize);
+  }
+
+  {
+    std::uniform_int_distribution<Vertex> vertex_distribution{
+      0, num_vertices - 1};
+    std::vector<std::pair<Vertex, Vertex>> queries(kNumOperations);
+    for (auto& [u, v] : queries) {
+      u = vertex_distribution(random_generator);
+      v = vertex_distribution(random_generator);
+    }
+    Meter meter;
+    meter.Start();
+    for (const auto& [u, v] : queries) {
+      DoNotOptimize(forest.IsConnected(u, v));
+    }
+    meter.Stop();
+    meter.Report(
+        "forest", variant, num_vertices, "is_connected", kNumOperations);
+  }
+}
+
+}  // namespace
+
+int main() {
+  typedef sequence::Element TreapElement;
+  typedef sequence::BTreeElement<NoAggregate> BTreeElement;
+
+  const int32_t kPrecision{4};
+  std::cout << std::setprecision(kPrecision);
+  std::cout << std::left << std::setw(10) << "structure" << std::setw(14)
+    << "variant" << std::right << std::setw(9) << "size" << "  " << std::left
+    << std::setw(20) << "operation" << std::right << std::setw(12) << "ns/op"
+    << std::setw(16) << "misses/op" << '\n';
+  for (const int64_t size : {int64_t{1} << 10, int64_t{1} << 14,
+                             int64_t{1} << 18}) {
+    BenchmarkSequence<TreapElement>("treap", size);
+    BenchmarkSequence<BTreeElement>("btree", size);
+  }
+  for (const int64_t num_vertices : {int64_t{1} << 10, int64_t{1} << 14,
+                                     int64_t{1} << 17}) {
+    for (const TreeShape shape :
+         {TreeShape::kPath, TreeShape::kStar, TreeShape::kRandom}) {
+      BenchmarkForest<BasicDynamicForest<TreapElement>>(
+          "treap", shape, num_vertices);
+      BenchmarkForest<BasicDynamicForest<BTreeElement>>(
+          "btree", shape, num_vertices);
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,189 @@
+// Measures how the memory held by `DynamicConnectivity` scales with the number
+// of vertices n and the number of edges m.
+//
+// Usage:
+//   benchmark_memory
+//
+// For each configuration, the benchmark adds m random edges to an empty graph
+// of n vertices, then deletes a random half of the edges and adds them back so
+// that some edges rise above level 0. It reports:
+//   - bytes/vertex: the bytes accounted for by `GetMemoryUsage()` on the empty
+//     graph, divided by n.
+//   - bytes/edge: the growth in accounted bytes from the empty graph to the
+//     final graph, divided by m, followed by its breakdown into spanning
+//     forests, non-tree adjacency lists, the map of edges, and everything
+//     else.
+//   - peak RSS: the peak resident set size of the process that ran the
+//     configuration, which also counts the benchmark's own list of edges and
+//     memory that the allocator has not returned to the system.
+// Each configuration runs in its own child process so that its peak resident
+// set size is not inflated by earlier configurations.
+#include <dynamic_graph/dynamic_connectivity.hpp>
+
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace {
+
+// Bytes held by the parts of a graph, as reported by `GetMemoryUsage()`, with
+// the levels combined.
+struct Breakdown {
+  std::size_t forests{0};
+  std::size_t non_tree_adjacency_lists{0};
+  std::size_t edges{0};
+  std::size_t other{0};
+};
+
+Breakdown GetBreakdown(const GraphMemoryUsage& usage) {
+  Breakdown breakdown;
+  for (const GraphMemoryUsage::Level& level : usage.levels) {
+    breakdown.forests += level.vertex_elements + level.edge_element_pool
+      + level.sequence_nodes + level.forest_edges;
+    breakdown.non_tree_adjacency_lists += level.non_tree_adjacency_lists;
+  }
+  breakdown.edges = usage.edges;
+  breakdown.other = usage.other;
+  return breakdown;
+}
+
+// Summary of a configuration that the child process sends to its parent.
+struct Result {
+  int64_t num_levels;
+  Breakdown empty;
+  Breakdown full;
+  std::size_t empty_total;
+  std::size_t full_total;
+};
+
+Result RunConfiguration(int64_t num_vertices, int64_t num_edges) {
+  std::mt19937_64 random_generator{0};
+  std::uniform_int_distribution<Vertex> vertex_distribution{
+    0, num_vertices - 1};
+  std::vector<std::pair<Vertex, Vertex>> edges;
+  edges.reserve(num_edges);
+  {
+    std::unordered_set<UndirectedEdge, UndirectedEdgeHash> edge_set;
+    while (static_cast<int64_t>(edges.size()) < num_edges) {
+      const Vertex u{vertex_distribution(random_generator)};
+      const Vertex v{vertex_distribution(random_generator)};
+      if (u != v && edge_set.insert(UndirectedEdge{u, v}).second) {
+        edges.emplace_back(u, v);
+      }
+    }
+  }
+
+  DynamicConnectivity graph(num_vertices);
+  const GraphMemoryUsage empty_usage{graph.GetMemoryUsage()};
+  for (const auto& [u, v] : edges) {
+    graph.AddEdge({u, v});
+  }
+  std::shuffle(edges.begin(), edges.end(), random_generator);
+  for (int64_t i = 0; i < num_edges / 2; i++) {
+    graph.DeleteEdge({edges[i].first, edges[i].second});
+  }
+  for (int64_t i = 0; i < num_edges / 2; i++) {
+    graph.AddEdge({edges[i].first, edges[i].second});
+  }
+  const GraphMemoryUsage full_usage{graph.GetMemoryUsage()};
+
+  return Result{
+    .num_levels = static_cast<int64_t>(full_usage.levels.size()),
+    .empty = GetBreakdown(empty_usage),
+    .full = GetBreakdown(full_usage),
+    .empty_total = empty_usage.GetTotal(),
+    .full_total = full_usage.GetTotal(),
+  };
+}
+
+// Runs a configuration in a child process. Returns false if the child fails.
+bool RunInChild(
+    int64_t num_vertices,
+    int64_t num_edges,
+    Result* result,
+    int64_t* peak_rss_kilobytes) {
+  int pipe_file_descriptors[2];
+  if (pipe(pipe_file_descriptors) != 0) {
+    return false;
+  }
+  const pid_t child{fork()};
+  if (child == -1) {
+    return false;
+  }
+  if (child == 0) {
+    close(pipe_file_descriptors[0]);
+    const Result child_result{RunConfiguration(num_vertices, num_edges)};
+    const bool is_written{
+      write(pipe_file_descriptors[1], &child_result, sizeof(child_result))
+        == sizeof(child_result)};
+    _exit(is_written ? 0 : 1);
+  }
+  close(pipe_file_descriptors[1]);
+  const bool is_read{
+    read(pipe_file_descriptors[0], result, sizeof(*result))
+      == sizeof(*result)};
+  close(pipe_file_descriptors[0]);
+  int status;
+  rusage usage;
+  if (wait4(child, &status, 0, &usage) != child || !WIFEXITED(status)
+      || WEXITSTATUS(status) != 0) {
+    return false;
+  }
+  *peak_rss_kilobytes = usage.ru_maxrss;
+  return is_read;
+}
+
+}  // namespace
+
+int main() {
+  const int32_t kPrecision{4};
+  std::cout << std::setprecision(kPrecision);
+  std::cout << std::right << std::setw(8) << "n" << std::setw(10) << "m"
+    << std::setw(8) << "levels" << std::setw(14) << "bytes/vertex"
+    << std::setw(12) << "bytes/edge" << std::setw(10) << "forests"
+    << std::setw(12) << "adjacency"
+    << std::setw(10) << "edges" << std::setw(10) << "other"
+    << std::setw(14) << "peak RSS MB" << '\n';
+  for (const int64_t num_vertices : {int64_t{1} << 12, int64_t{1} << 14,
+                                     int64_t{1} << 16}) {
+    for (const int64_t density : {1, 2, 4, 8}) {
+      const int64_t num_edges{density * num_vertices};
+      Result result;
+      int64_t peak_rss_kilobytes;
+      if (!RunInChild(num_vertices, num_edges, &result, &peak_rss_kilobytes)) {
+        std::cerr << "Configuration n = " << num_vertices << ", m = "
+          << num_edges << " failed\n";
+        return 1;
+      }
+      const double total_per_edge{
+        (static_cast<double>(result.full_total) - result.empty_total)
+        / num_edges};
+      // Bytes per edge of the growth of `part` from the empty graph.
+      const auto part_per_edge{[&](std::size_t Breakdown::*part) {
+        return (static_cast<double>(result.full.*part) - result.empty.*part)
+          / num_edges;
+      }};
+      std::cout << std::setw(8) << num_vertices << std::setw(10) << num_edges
+        << std::setw(8) << result.num_levels
+        << std::setw(14)
+        << static_cast<double>(result.empty_total) / num_vertices
+        << std::setw(12) << total_per_edge
+        << std::setw(10) << part_per_edge(&Breakdown::forests)
+        << std::setw(12) << part_per_edge(&Breakdown::non_tree_adjacency_lists)
+        << std::setw(10) << part_per_edge(&Breakdown::edges)
+        << std::setw(10) << part_per_edge(&Breakdown::other)
+        << std::setw(14) << peak_rss_kilobytes / 1024.0 << '\n';
+    }
+  }
+  return 0;
+}
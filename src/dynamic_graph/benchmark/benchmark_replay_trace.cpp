@@ -0,0 +1,331 @@
+// Replays a recorded trace of operations on a `DynamicConnectivity` and reports
+// throughput and latency percentiles for each kind of operation.
+//
+// Usage:
+//   benchmark_replay_trace [--text] [--json] [--vertices <n>] <trace>
+//
+// By default the trace is an operation stream (see operation_stream.hpp). With
+// --text, it has one operation per line instead: "a u v" adds edge {u, v},
+// "d u v" deletes it, and "q u v" asks whether u and v are connected. Lines
+// that are empty or start with '#' are skipped. The graph has the number of
+// vertices given by --vertices, or else one more than the largest vertex in the
+// trace.
+//
+// Updates that the graph cannot apply, namely self-loops, additions of edges
+// already in the graph, and deletions of edges not in the graph, are skipped
+// and counted, as in `IngestOperationStream()`.
+//
+// Latencies are recorded in histograms with logarithmically sized buckets, as
+// in HdrHistogram, so the reported percentiles are within 2% of the exact
+// ones. Each latency includes the roughly 20 ns cost of reading the clock.
+#include <dynamic_graph/operation_stream.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+double DurationToSeconds(const Clock::duration& duration) {
+  return
+    std::chrono::duration_cast<std::chrono::duration<double>>(duration).count();
+}
+
+// Histogram of nonnegative integers that keeps 7 significant bits of each
+// value. Values below 128 have their own buckets, and each power-of-two range
+// [2^k, 2^(k+1)) above that is split into 64 buckets.
+class LatencyHistogram {
+ public:
+  LatencyHistogram() : counts_(kNumBuckets) {}
+
+  void Record(int64_t value) {
+    counts_[GetBucket(value)]++;
+    count_++;
+    total_ += value;
+    max_ = std::max(max_, value);
+  }
+
+  int64_t GetCount() const { return count_; }
+  int64_t GetTotal() const { return total_; }
+  int64_t GetMax() const { return max_; }
+
+  // Returns the smallest bucket bound that at least a `quantile` proportion of
+  // the recorded values are at most.
+  int64_t GetQuantile(double quantile) const {
+    if (count_ == 0) {
+      return 0;
+    }
+    const int64_t rank{std::max<int64_t>(
+        1, static_cast<int64_t>(std::ceil(quantile * count_)))};
+    int64_t cumulative_count{0};
+    for (int32_t bucket = 0; bucket < kNumBuckets; bucket++) {
+      cumulative_count += counts_[bucket];
+      if (cumulative_count >= rank) {
+        return std::min(GetBucketUpperBound(bucket), max_);
+      }
+    }
+    return max_;
+  }
+
+ private:
+  static constexpr int32_t kSubBucketBits{7};
+  static constexpr int32_t kHalfSubBucketCount{1 << (kSubBucketBits - 1)};
+  static constexpr int32_t kNumBuckets{64 * kHalfSubBucketCount};
+
+  static int32_t GetBucket(int64_t value) {
+    if (value < 2 * kHalfSubBucketCount) {
+      return value;
+    }
+    const int32_t shift{
+      63 - __builtin_clzll(value) - (kSubBucketBits - 1)};
+    return shift * kHalfSubBucketCount + (value >> shift);
+  }
+
+  static int64_t GetBucketUpperBound(int32_t bucket) {
+    if (bucket < 2 * kHalfSubBucketCount) {
+      return bucket;
+    }
+    const int32_t shift{bucket / kHalfSubBucketCount - 1};
+    const int64_t sub_bucket{bucket - shift * kHalfSubBucketCount};
+    return ((sub_bucket + 1) << shift) - 1;
+  }
+
+  std::vector<int64_t> counts_;
+  int64_t count_{0};
+  int64_t total_{0};
+  int64_t max_{0};
+};
+
+enum OperationKind {
+  kAddEdge,
+  kDeleteTreeEdge,
+  kDeleteNonTreeEdge,
+  kIsConnected,
+  kNumOperationKinds,
+};
+
+const char* const kOperationKindNames[kNumOperationKinds]{
+  "add_edge",
+  "delete_tree_edge",
+  "delete_non_tree_edge",
+  "is_connected",
+};
+
+int PrintUsage(const char* program) {
+  std::cerr << "Usage: " << program
+    << " [--text] [--json] [--vertices <n>] <trace>\n";
+  return 1;
+}
+
+// Reads a text trace into `trace`. Returns false on a malformed line.
+bool ReadTextTrace(const std::string& path, OperationBatch* trace) {
+  std::ifstream file{path};
+  if (!file) {
+    std::cerr << "Failed to open " << path << '\n';
+    return false;
+  }
+  std::string line;
+  for (int64_t line_number = 1; std::getline(file, line); line_number++) {
+    if (line.empty() || line[0] == '#') {
+      continue;
+    }
+    std::istringstream line_stream{line};
+    char op_code;
+    Vertex u;
+    Vertex v;
+    if (!(line_stream >> op_code >> u >> v)
+        || (op_code != 'a' && op_code != 'd' && op_code != 'q')) {
+      std::cerr << path << ':' << line_number
+        << ": expected an operation of the form \"a|d|q u v\"\n";
+      return false;
+    }
+    trace->types.emplace_back(
+        op_code == 'a' ? Operation::Type::kAddEdge
+        : op_code == 'd' ? Operation::Type::kDeleteEdge
+        : Operation::Type::kIsConnected);
+    trace->first_vertices.emplace_back(u);
+    trace->second_vertices.emplace_back(v);
+  }
+  return true;
+}
+
+void PrintText(
+    int64_t num_vertices,
+    int64_t num_operations,
+    int64_t num_updates_skipped,
+    double seconds,
+    const LatencyHistogram (&histograms)[kNumOperationKinds]) {
+  const int32_t kPrecision{4};
+  std::cout << std::setprecision(kPrecision);
+  std::cout << "Graph of " << num_vertices << " vertices.\n";
+  std::cout << seconds << " seconds to replay " << num_operations
+    << " operations (" << num_operations / seconds
+    << " operations per second).\n";
+  std::cout << "Skipped " << num_updates_skipped << " updates.\n";
+  std::cout << std::left << std::setw(22) << "operation" << std::right
+    << std::setw(10) << "count" << std::setw(12) << "ops/s"
+    << std::setw(10) << "p50 ns" << std::setw(10) << "p99 ns"
+    << std::setw(10) << "p99.9 ns" << std::setw(12) << "max ns" << '\n';
+  for (int32_t kind = 0; kind < kNumOperationKinds; kind++) {
+    const LatencyHistogram& histogram{histograms[kind]};
+    const double kind_seconds{histogram.GetTotal() * 1e-9};
+    std::cout << std::left << std::setw(22) << kOperationKindNames[kind]
+      << std::right << std::setw(10) << histogram.GetCount()
+      << std::setw(12)
+      << (kind_seconds > 0 ? histogram.GetCount() / kind_seconds : 0.0)
+      << std::setw(10) << histogram.GetQuantile(.5)
+      << std::setw(10) << histogram.GetQuantile(.99)
+      << std::setw(10) << histogram.GetQuantile(.999)
+      << std::setw(12) << histogram.GetMax() << '\n';
+  }
+}
+
+void PrintJson(
+    int64_t num_vertices,
+    int64_t num_operations,
+    int64_t num_updates_skipped,
+    double seconds,
+    const LatencyHistogram (&histograms)[kNumOperationKinds]) {
+  std::cout << std::setprecision(std::numeric_limits<double>::max_digits10);
+  std::cout << "{\"num_vertices\": " << num_vertices
+    << ", \"num_operations\": " << num_operations
+    << ", \"num_updates_skipped\": " << num_updates_skipped
+    << ", \"seconds\": " << seconds
+    << ", \"operations_per_second\": " << num_operations / seconds
+    << ", \"operations\": {";
+  for (int32_t kind = 0; kind < kNumOperationKinds; kind++) {
+    const LatencyHistogram& histogram{histograms[kind]};
+    const double kind_seconds{histogram.GetTotal() * 1e-9};
+    std::cout << (kind == 0 ? "" : ", ")
+      << '"' << kOperationKindNames[kind] << "\": {"
+      << "\"count\": " << histogram.GetCount()
+      << ", \"operations_per_second\": "
+      << (kind_seconds > 0 ? histogram.GetCount() / kind_seconds : 0.0)
+      << ", \"p50_ns\": " << histogram.GetQuantile(.5)
+      << ", \"p99_ns\": " << histogram.GetQuantile(.99)
+      << ", \"p99_9_ns\": " << histogram.GetQuantile(.999)
+      << ", \"max_ns\": " << histogram.GetMax() << '}';
+  }
+  std::cout << "}}\n";
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  bool is_text{false};
+  bool is_json{false};
+  int64_t num_vertices{0};
+  std::string path;
+  for (int32_t i = 1; i < argc; i++) {
+    const std::string argument{argv[i]};
+    if (argument == "--text") {
+      is_text = true;
+    } else if (argument == "--json") {
+      is_json = true;
+    } else if (argument == "--vertices" && i + 1 < argc) {
+      num_vertices = std::stoll(argv[++i]);
+    } else if (path.empty() && argument.compare(0, 2, "--") != 0) {
+      path = argument;
+    } else {
+      return PrintUsage(argv[0]);
+    }
+  }
+  if (path.empty() || num_vertices < 0) {
+    return PrintUsage(argv[0]);
+  }
+
+  // Load the whole trace up front so that reading it is not timed.
+  OperationBatch trace;
+  if (is_text) {
+    if (!ReadTextTrace(path, &trace)) {
+      return 1;
+    }
+  } else {
+    const OperationStreamReader stream{path};
+    const int64_t num_operations{stream.GetNumberOfOperations()};
+    const int64_t first_invalid{stream.Decode(
+        0, num_operations, std::numeric_limits<int64_t>::max(), &trace)};
+    if (first_invalid < num_operations) {
+      std::cerr << "Operation " << first_invalid << " of " << path
+        << " is invalid\n";
+      return 1;
+    }
+  }
+  const int64_t num_operations{trace.GetSize()};
+  const auto [min_vertex, max_vertex]{[&] {
+    Vertex min{0};
+    Vertex max{-1};
+    for (int64_t i = 0; i < num_operations; i++) {
+      min = std::min({min, trace.first_vertices[i], trace.second_vertices[i]});
+      max = std::max({max, trace.first_vertices[i], trace.second_vertices[i]});
+    }
+    return std::make_pair(min, max);
+  }()};
+  if (num_vertices == 0) {
+    num_vertices = max_vertex + 1;
+  }
+  if (min_vertex < 0 || max_vertex >= num_vertices) {
+    std::cerr << "The trace has vertices outside of [0, " << num_vertices
+      << ")\n";
+    return 1;
+  }
+
+  DynamicConnectivity graph(num_vertices);
+  LatencyHistogram histograms[kNumOperationKinds];
+  int64_t num_updates_skipped{0};
+  const auto replay_start{Clock::now()};
+  for (int64_t i = 0; i < num_operations; i++) {
+    const Vertex u{trace.first_vertices[i]};
+    const Vertex v{trace.second_vertices[i]};
+    OperationKind kind;
+    Clock::time_point start;
+    switch (trace.types[i]) {
+      case Operation::Type::kAddEdge: {
+        const UndirectedEdge edge{u, v};
+        if (u == v || graph.HasEdge(edge)) {
+          num_updates_skipped++;
+          continue;
+        }
+        kind = kAddEdge;
+        start = Clock::now();
+        graph.AddEdge(edge);
+        break;
+      }
+      case Operation::Type::kDeleteEdge: {
+        const UndirectedEdge edge{u, v};
+        if (!graph.HasEdge(edge)) {
+          num_updates_skipped++;
+          continue;
+        }
+        kind = graph.IsTreeEdge(edge) ? kDeleteTreeEdge : kDeleteNonTreeEdge;
+        start = Clock::now();
+        graph.DeleteEdge(edge);
+        break;
+      }
+      case Operation::Type::kIsConnected:
+      default:
+        kind = kIsConnected;
+        start = Clock::now();
+        graph.IsConnected(u, v);
+        break;
+    }
+    const auto finish{Clock::now()};
+    histograms[kind].Record(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(
+            finish - start).count());
+  }
+  const double seconds{DurationToSeconds(Clock::now() - replay_start)};
+
+  (is_json ? PrintJson : PrintText)(
+      num_vertices, num_operations, num_updates_skipped, seconds, histograms);
+  return 0;
+}
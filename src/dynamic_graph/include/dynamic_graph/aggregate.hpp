@@ -0,0 +1,68 @@
+/** @file aggregate.hpp
+ *  Monoids for aggregating per-vertex values over connected components.
+ *
+ *  A monoid is a type `M` that provides
+ *    - a value type `M::Value`,
+ *    - `static M::Value M::Identity()`, and
+ *    - `static M::Value M::Combine(const M::Value& a, const M::Value& b)`.
+ *
+ *  `Combine` must be associative and commutative, and `Identity()` must be an
+ *  identity for `Combine`. Custom monoids following this pattern may be used
+ *  anywhere the monoids in this file are used.
+ *
+ *  @author Tom Tseng (tomtseng)
+ */
+#pragma once
+
+#include <limits>
+
+/** The monoid used when no per-vertex values are needed.
+ *
+ *  Its value is an empty struct. Like any object, it still takes a byte, plus
+ *  padding, wherever it is stored as a member. `BasicDynamicConnectivity`
+ *  stores the values of its level-0 spanning forest so that an empty value
+ *  takes no space there.
+ */
+struct NoAggregate {
+  /** Empty value. */
+  struct Value {};
+  /** Returns the empty value. */
+  static Value Identity() { return {}; }
+  /** Returns the empty value. */
+  static Value Combine(const Value&, const Value&) { return {}; }
+};
+
+/** Aggregates values by summing them. For instance, with a value of 1 on
+ *  flagged vertices and 0 elsewhere, this counts flagged vertices.
+ */
+template <typename T>
+struct SumAggregate {
+  /** Type of value to sum. */
+  typedef T Value;
+  /** Returns zero. */
+  static Value Identity() { return T{0}; }
+  /** Returns \p a + \p b. */
+  static Value Combine(const Value& a, const Value& b) { return a + b; }
+};
+
+/** Aggregates values by taking their maximum. */
+template <typename T>
+struct MaxAggregate {
+  /** Type of value to take the maximum of. */
+  typedef T Value;
+  /** Returns the lowest value of `T`. */
+  static Value Identity() { return std::numeric_limits<T>::lowest(); }
+  /** Returns the maximum of \p a and \p b. */
+  static Value Combine(const Value& a, const Value& b) { return a < b ? b : a; }
+};
+
+/** Aggregates values by taking their minimum. */
+template <typename T>
+struct MinAggregate {
+  /** Type of value to take the minimum of. */
+  typedef T Value;
+  /** Returns the greatest value of `T`. */
+  static Value Identity() { return std::numeric_limits<T>::max(); }
+  /** Returns the minimum of \p a and \p b. */
+  static Value Combine(const Value& a, const Value& b) { return b < a ? b : a; }
+};
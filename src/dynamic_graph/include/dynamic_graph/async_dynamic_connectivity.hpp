@@ -0,0 +1,219 @@
+/** @file async_dynamic_connectivity.hpp
+ *  Declaration for a dynamic connectivity data structure whose updates are
+ *  queued from any thread and applied in coalesced batches by a background
+ *  thread.
+ *
+ *  @author Tom Tseng (tomtseng)
+ */
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <future>
+#include <mutex>
+#include <optional>
+#include <thread>
+
+#include <dynamic_graph/concurrent_dynamic_connectivity.hpp>
+#include <dynamic_graph/graph.hpp>
+
+namespace detail {
+
+// An update waiting in the queue of an `AsyncDynamicConnectivity`.
+struct QueuedUpdate {
+  enum class Type {
+    kAddEdge,
+    kDeleteEdge,
+    // Changes nothing. Used to wait for earlier updates.
+    kNone,
+  };
+
+  Type type;
+  UndirectedEdge edge;
+  // Fulfilled once the update has been applied.
+  std::promise<void> done;
+};
+
+// Lock-free queue with many producers and one consumer, as described by Dmitry
+// Vyukov ("Non-intrusive MPSC node-based queue", 1024cores.net).
+class UpdateQueue {
+ public:
+  UpdateQueue();
+  ~UpdateQueue();
+
+  UpdateQueue(const UpdateQueue& other) = delete;
+  UpdateQueue& operator=(const UpdateQueue& other) = delete;
+
+  // Adds an update to the back of the queue. May be called from any thread.
+  void Push(QueuedUpdate update);
+  // Removes and returns the update at the front of the queue, or returns
+  // nothing if the queue is empty. May only be called from the consumer
+  // thread.
+  std::optional<QueuedUpdate> Pop();
+  // Returns true if `Pop()` would find the queue empty. May only be called
+  // from the consumer thread.
+  bool IsEmpty() const;
+
+ private:
+  struct Node {
+    std::atomic<Node*> next{nullptr};
+    std::optional<QueuedUpdate> update;
+  };
+
+  // Most recently pushed node.
+  std::atomic<Node*> head_;
+  // Node preceding the front of the queue. Its update has already been popped.
+  Node* tail_;
+};
+
+}  // namespace detail
+
+/** This class represents an undirected graph whose edge insertions and
+ *  deletions are submitted asynchronously from any number of threads.
+ *
+ *  Updates go into a lock-free queue, and a background thread applies them to
+ *  a `ConcurrentDynamicConnectivity`. The background thread takes updates off
+ *  of the queue in batches and coalesces each batch before applying it. Only
+ *  the last update to each edge in a batch matters, and it is skipped if the
+ *  edge is already in the state it asks for. An edge that is inserted and then
+ *  deleted within a batch never touches the graph.
+ *
+ *  Because of this, asynchronous updates are idempotent: adding an edge that
+ *  is already in the graph or deleting an edge that is not in the graph does
+ *  nothing.
+ *
+ *  Queries can be called from any thread and do not wait for updates. They see
+ *  the updates that have been applied so far. Within a batch, the background
+ *  thread applies deletions before insertions, so queries made while a batch
+ *  is being applied may see some of its deletions without its insertions.
+ */
+class AsyncDynamicConnectivity {
+ public:
+  /** Initializes an empty graph with a fixed number of vertices and starts the
+   *  background thread.
+   *
+   *  Efficiency: \f$ O(n \log n ) \f$ where \f$ n \f$ is the number of vertices
+   *  in the graph.
+   *
+   *  @param[in] num_vertices Number of vertices in the graph.
+   *  @param[in] coalescing_window How long the background thread waits after
+   *  seeing a new update before taking a batch off of the queue. A longer
+   *  window lets more updates cancel out at the cost of latency.
+   *  @param[in] max_batch_size Maximum number of updates in a batch.
+   */
+  explicit AsyncDynamicConnectivity(
+      int64_t num_vertices,
+      std::chrono::microseconds coalescing_window
+        = std::chrono::microseconds{0},
+      int64_t max_batch_size = 4096);
+
+  /** Applies all submitted updates, stops the background thread, and
+   *  deallocates the data structure. */
+  ~AsyncDynamicConnectivity();
+
+  /** The default constructor is invalid because the number of vertices in the
+   *  graph must be known. */
+  AsyncDynamicConnectivity() = delete;
+  /** Copy constructor not implemented. */
+  AsyncDynamicConnectivity(const AsyncDynamicConnectivity& other) = delete;
+  /** Copy assignment not implemented. */
+  AsyncDynamicConnectivity& operator=(const AsyncDynamicConnectivity& other)
+    = delete;
+  /** Move constructor not implemented. */
+  AsyncDynamicConnectivity(AsyncDynamicConnectivity&& other) = delete;
+  /** Move assignment not implemented. */
+  AsyncDynamicConnectivity& operator=(AsyncDynamicConnectivity&& other)
+    = delete;
+
+  /** Returns true if vertices \p u and \p v are connected in the graph.
+   *
+   *  Efficiency: logarithmic in the size of the graph.
+   *
+   *  @param[in] u Vertex.
+   *  @param[in] v Vertex.
+   *  @returns True if \p u and \p v are connected, false if they are not.
+   */
+  bool IsConnected(Vertex u, Vertex v) const;
+
+  /** Returns true if edge \p edge is in the graph.
+   *
+   *  Efficiency: constant on average.
+   *
+   *  @param[in] edge Edge.
+   *  @returns True if \p edge is in the graph, false if it is not.
+   */
+  bool HasEdge(const UndirectedEdge& edge) const;
+
+  /** Returns the number of vertices in `v`'s connected component.
+   *
+   *  Efficiency: logarithmic in the size of the graph.
+   *
+   *  @param[in] v Vertex.
+   *  @returns The number of vertices in \p v's connected component.
+   */
+  int64_t GetSizeOfConnectedComponent(Vertex v) const;
+
+  /** Returns the number of connected components in the graph.
+   *
+   *  Efficiency: constant.
+   *
+   *  @returns The number of connected components.
+   */
+  int64_t GetNumberOfConnectedComponents() const;
+
+  /** Submits the addition of an edge to the graph.
+   *
+   *  The edge must not be a self-loop edge.
+   *
+   *  Efficiency: constant, not counting the work of the background thread.
+   *
+   *  @param[in] edge Edge to be added.
+   *  @returns A future that becomes ready once the update has been applied or
+   *  cancelled out.
+   */
+  std::future<void> AddEdge(const UndirectedEdge& edge);
+
+  /** Submits the deletion of an edge from the graph.
+   *
+   *  Efficiency: constant, not counting the work of the background thread.
+   *
+   *  @param[in] edge Edge to be deleted.
+   *  @returns A future that becomes ready once the update has been applied or
+   *  cancelled out.
+   */
+  std::future<void> DeleteEdge(const UndirectedEdge& edge);
+
+  /** Waits until every update that the calling thread submitted before calling
+   *  this has been applied. */
+  void Flush();
+
+  /** Returns the number of submitted updates that were skipped because a later
+   *  update to the same edge superseded them or because the edge was already
+   *  in the requested state.
+   *
+   *  @returns The number of skipped updates.
+   */
+  int64_t GetNumberOfSkippedUpdates() const;
+
+ private:
+  std::future<void> Submit(
+      detail::QueuedUpdate::Type type, const UndirectedEdge& edge);
+  void RunApplier();
+  void ApplyBatch();
+
+  const int64_t num_vertices_;
+  const std::chrono::microseconds coalescing_window_;
+  const int64_t max_batch_size_;
+  ConcurrentDynamicConnectivity graph_;
+  detail::UpdateQueue queue_;
+  std::atomic<int64_t> num_skipped_updates_{0};
+  // The background thread sleeps on `wake_condition_` while the queue is empty.
+  // Producers only take `wake_mutex_` if `is_applier_sleeping_` is set.
+  std::atomic<bool> is_applier_sleeping_{false};
+  std::atomic<bool> is_stopping_{false};
+  std::mutex wake_mutex_;
+  std::condition_variable wake_condition_;
+  std::thread applier_;
+};
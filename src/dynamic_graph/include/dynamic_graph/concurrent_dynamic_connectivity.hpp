@@ -0,0 +1,285 @@
+/** @file concurrent_dynamic_connectivity.hpp
+ *  Declaration for a dynamic connectivity data structure that can be queried by
+ *  many threads while another thread updates it.
+ *
+ *  @author Tom Tseng (tomtseng)
+ */
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+
+#include <dynamic_graph/aggregate.hpp>
+#include <dynamic_graph/dynamic_connectivity.hpp>
+#include <dynamic_graph/graph.hpp>
+
+namespace detail {
+
+// Counts the threads currently reading from one side of a
+// `BasicConcurrentDynamicConnectivity`. The count is spread over several cache
+// lines so that readers on different threads rarely touch the same line.
+class ReadIndicator {
+ public:
+  ReadIndicator();
+
+  ReadIndicator(const ReadIndicator& other) = delete;
+  ReadIndicator& operator=(const ReadIndicator& other) = delete;
+
+  // Records that the calling thread started reading.
+  void Arrive();
+  // Records that the calling thread, which must have called `Arrive()`,
+  // finished reading.
+  void Depart();
+  // Returns true if no thread is between `Arrive()` and `Depart()`.
+  bool IsEmpty() const;
+
+ private:
+  static constexpr int32_t kNumCounters{64};
+
+  struct alignas(64) Counter {
+    std::atomic<int64_t> count{0};
+  };
+
+  std::array<Counter, kNumCounters> counters_;
+};
+
+}  // namespace detail
+
+/** This class represents an undirected graph that supports the same updates
+ *  and queries as `BasicDynamicConnectivity`, but whose queries may be called
+ *  from any number of threads while another thread is updating the graph.
+ *
+ *  It holds two copies of the graph and uses the Left-Right technique to keep
+ *  one copy quiet for readers while the writer updates the other, as described
+ *  in the following paper:
+ *    Pedro Ramalhete and Andreia Correia. "Left-Right: A concurrency control
+ *    technique with wait-free population oblivious reads." 2015.
+ *
+ *  Queries never wait on updates or on each other, and every query sees the
+ *  graph as it was between two updates. Updates are serialized among
+ *  themselves. Each update is applied to both copies, and after applying it to
+ *  the first copy the writer waits for queries still reading the second copy
+ *  to finish, so updates cost a bit more than twice as much as they do in
+ *  `BasicDynamicConnectivity`, and the structure takes twice the memory.
+ *
+ *  @tparam Monoid Monoid of per-vertex values.
+ */
+template <typename Monoid>
+class BasicConcurrentDynamicConnectivity {
+ public:
+  /** Type of the value held by each vertex. */
+  typedef typename Monoid::Value Value;
+
+  /** Initializes an empty graph with a fixed number of vertices.
+   *
+   *  Efficiency: \f$ O(n \log n ) \f$ where \f$ n \f$ is the number of vertices
+   *  in the graph.
+   *
+   *  @param[in] num_vertices Number of vertices in the graph.
+   */
+  explicit BasicConcurrentDynamicConnectivity(int64_t num_vertices);
+
+  /** Deallocates the data structure. No other thread may be using it. */
+  ~BasicConcurrentDynamicConnectivity();
+
+  /** The default constructor is invalid because the number of vertices in the
+   *  graph must be known. */
+  BasicConcurrentDynamicConnectivity() = delete;
+  /** Copy constructor not implemented. */
+  BasicConcurrentDynamicConnectivity(
+      const BasicConcurrentDynamicConnectivity& other) = delete;
+  /** Copy assignment not implemented. */
+  BasicConcurrentDynamicConnectivity&
+  operator=(const BasicConcurrentDynamicConnectivity& other) = delete;
+  /** Move constructor not implemented. */
+  BasicConcurrentDynamicConnectivity(
+      BasicConcurrentDynamicConnectivity&& other) = delete;
+  /** Move assignment not implemented. */
+  BasicConcurrentDynamicConnectivity&
+  operator=(BasicConcurrentDynamicConnectivity&& other) = delete;
+
+  /** Returns true if vertices \p u and \p v are connected in the graph.
+   *
+   *  Safe to call concurrently with any other method.
+   *
+   *  Efficiency: logarithmic in the size of the graph.
+   *
+   *  @param[in] u Vertex.
+   *  @param[in] v Vertex.
+   *  @returns True if \p u and \p v are connected, false if they are not.
+   */
+  bool IsConnected(Vertex u, Vertex v) const;
+
+  /** Returns true if edge \p edge is in the graph.
+   *
+   *  Safe to call concurrently with any other method.
+   *
+   *  Efficiency: constant on average.
+   *
+   *  @param[in] edge Edge.
+   *  @returns True if \p edge is in the graph, false if it is not.
+   */
+  bool HasEdge(const UndirectedEdge& edge) const;
+
+  /** Returns the number of vertices in `v`'s connected component.
+   *
+   *  Safe to call concurrently with any other method.
+   *
+   *  Efficiency: logarithmic in the size of the graph.
+   *
+   *  @param[in] v Vertex.
+   *  @returns The number of vertices in \p v's connected component.
+   */
+  int64_t GetSizeOfConnectedComponent(Vertex v) const;
+
+  /** Returns the number of connected components in the graph.
+   *
+   *  Safe to call concurrently with any other method.
+   *
+   *  Efficiency: constant.
+   *
+   *  @returns The number of connected components.
+   */
+  int64_t GetNumberOfConnectedComponents() const;
+
+  /** Returns the value held by vertex \p v.
+   *
+   *  Safe to call concurrently with any other method.
+   *
+   *  Efficiency: constant.
+   *
+   *  @param[in] v Vertex.
+   *  @returns The value held by \p v.
+   */
+  Value GetVertexValue(Vertex v) const;
+
+  /** Returns the combination under `Monoid::Combine` of the values held by the
+   *  vertices in \p v's connected component.
+   *
+   *  Safe to call concurrently with any other method.
+   *
+   *  Efficiency: logarithmic in the size of the graph.
+   *
+   *  @param[in] v Vertex.
+   *  @returns The aggregate value of \p v's connected component.
+   */
+  Value GetComponentAggregate(Vertex v) const;
+
+  /** Returns true if edge \p edge is a bridge. See
+   *  `BasicDynamicConnectivity::IsBridge()`.
+   *
+   *  Safe to call concurrently with any other method, though if
+   *  2-edge-connectivity is tracked, concurrent calls take turns on a lock.
+   *
+   *  Efficiency: that of `BasicDynamicConnectivity::IsBridge()`.
+   *
+   *  @param[in] edge Edge.
+   *  @returns True if \p edge is a bridge, false if it is not.
+   */
+  bool IsBridge(const UndirectedEdge& edge) const;
+
+  /** Returns true if vertices \p u and \p v are 2-edge-connected. See
+   *  `BasicDynamicConnectivity::Is2EdgeConnected()`.
+   *
+   *  Tracking must have been turned on with
+   *  `SetTwoEdgeConnectivityTracking()`.
+   *
+   *  Safe to call concurrently with any other method, though concurrent calls
+   *  to this method take turns on a lock.
+   *
+   *  Efficiency: that of `BasicDynamicConnectivity::Is2EdgeConnected()`.
+   *
+   *  @param[in] u Vertex.
+   *  @param[in] v Vertex.
+   *  @returns True if \p u and \p v are 2-edge-connected, false if they are
+   *  not.
+   */
+  bool Is2EdgeConnected(Vertex u, Vertex v) const;
+
+  /** Adds an edge to the graph.
+   *
+   *  The edge must not already be in the graph and must not be a self-loop edge.
+   *
+   *  Safe to call concurrently with any other method, though concurrent
+   *  updates run one at a time.
+   *
+   *  Efficiency: twice that of `BasicDynamicConnectivity::AddEdge()`, plus the
+   *  time to wait for queries that started before the update to finish.
+   *
+   *  @param[in] edge Edge to be added.
+   */
+  void AddEdge(const UndirectedEdge& edge);
+
+  /** Deletes an edge from the graph.
+   *
+   *  An exception will be thrown if the edge is not in the graph.
+   *
+   *  Safe to call concurrently with any other method, though concurrent
+   *  updates run one at a time.
+   *
+   *  Efficiency: twice that of `BasicDynamicConnectivity::DeleteEdge()`, plus
+   *  the time to wait for queries that started before the update to finish.
+   *
+   *  @param[in] edge Edge to be deleted.
+   */
+  void DeleteEdge(const UndirectedEdge& edge);
+
+  /** Sets the value held by vertex \p v. Every vertex starts with
+   *  `Monoid::Identity()` as its value.
+   *
+   *  Safe to call concurrently with any other method, though concurrent
+   *  updates run one at a time.
+   *
+   *  Efficiency: twice that of `BasicDynamicConnectivity::SetVertexValue()`,
+   *  plus the time to wait for queries that started before the update to
+   *  finish.
+   *
+   *  @param[in] v Vertex.
+   *  @param[in] value New value for \p v.
+   */
+  void SetVertexValue(Vertex v, const Value& value);
+
+  /** Turns tracking of 2-edge-connectivity for `Is2EdgeConnected()` on or off.
+   *  See `BasicDynamicConnectivity::SetTwoEdgeConnectivityTracking()`.
+   *
+   *  Safe to call concurrently with any other method, though concurrent
+   *  updates run one at a time.
+   *
+   *  Efficiency: twice that of
+   *  `BasicDynamicConnectivity::SetTwoEdgeConnectivityTracking()`, plus the
+   *  time to wait for queries that started before the update to finish.
+   *
+   *  @param[in] is_tracked Whether to track 2-edge-connectivity.
+   */
+  void SetTwoEdgeConnectivityTracking(bool is_tracked);
+
+ private:
+  typedef BasicDynamicConnectivity<Monoid> Graph;
+
+  template <typename Query>
+  auto Read(Query query) const;
+  template <typename Update>
+  void Write(Update update);
+
+  // Readers read `graphs_[read_index_]` while the writer updates the other
+  // graph.
+  std::array<Graph, 2> graphs_;
+  std::atomic<int32_t> read_index_{0};
+  // Readers announce themselves in `read_indicators_[version_index_]`. Once
+  // the writer has switched `read_index_`, it switches `version_index_` so that
+  // it can tell when all readers that may still be reading the graph it wants
+  // to update next have finished.
+  mutable std::array<detail::ReadIndicator, 2> read_indicators_;
+  std::atomic<int32_t> version_index_{0};
+  std::mutex writer_mutex_;
+};
+
+/** Concurrent graph whose vertices hold no values. */
+typedef BasicConcurrentDynamicConnectivity<NoAggregate>
+  ConcurrentDynamicConnectivity;
+
+extern template class BasicConcurrentDynamicConnectivity<NoAggregate>;
+
+#include <concurrent_dynamic_connectivity_impl.hpp>
@@ -0,0 +1,189 @@
+/** @file durable_dynamic_connectivity.hpp
+ *  Declaration for a dynamic connectivity data structure that logs its updates
+ *  to disk so that it survives crashes.
+ *
+ *  @author Tom Tseng (tomtseng)
+ */
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <dynamic_graph/dynamic_connectivity.hpp>
+#include <dynamic_graph/graph.hpp>
+#include <dynamic_graph/operation.hpp>
+
+/** This class represents an undirected graph that can undergo efficient edge
+ *  insertions, edge deletions, and connectivity queries, and that is saved in
+ *  a directory so that it can be recovered after a crash.
+ *
+ *  Updates are appended to a write-ahead log in the binary encoding of
+ *  operation.hpp. They are buffered and written in batches, each batch
+ *  carrying a checksum so that a batch torn by a crash is detected and
+ *  dropped. Every so often the graph is saved to a snapshot, which records the
+ *  level of each edge in the internal level structure as well as the edge
+ *  itself, and the log is started over.
+ *
+ *  On construction, the graph is recovered from the directory: the snapshot is
+ *  loaded with `BasicDynamicConnectivity::RestoreEdge()`, which is much faster
+ *  than adding its edges with `AddEdge()`, and the updates in the log are then
+ *  replayed as one batch, in which only the last update to each edge is
+ *  applied.
+ *
+ *  An update is durable once the batch holding it has been written and, if
+ *  requested, synced to disk. A crash loses at most the updates that were
+ *  still buffered.
+ *
+ *  The methods are not thread-safe, and only one object may use a directory at
+ *  a time.
+ */
+class DurableDynamicConnectivity {
+ public:
+  /** When the log is synced to disk. */
+  enum class SyncPolicy {
+    /** Never sync. Written batches survive a crash of the process but may be
+     *  lost if the machine crashes. */
+    kNone,
+    /** Sync after writing each batch. */
+    kEveryBatch,
+  };
+
+  /** Recovers the graph saved in \p directory, or initializes an empty graph
+   *  there if there is none.
+   *
+   *  Efficiency: \f$ O(n + m \log n + k \log^2 n) \f$ amortized where \f$ n \f$
+   *  is the number of vertices in the graph, \f$ m \f$ is the number of edges
+   *  in the snapshot, and \f$ k \f$ is the number of updates in the log.
+   *
+   *  @param[in] num_vertices Number of vertices in the graph. It must match
+   *  the saved graph, if any.
+   *  @param[in] directory Existing directory to save the graph in.
+   *  @param[in] batch_size Number of updates buffered before they are written
+   *  to the log.
+   *  @param[in] sync_policy When the log is synced to disk.
+   *  @param[in] snapshot_interval Number of logged updates after which the
+   *  graph is saved to a new snapshot, or 0 to only save snapshots when
+   *  `SaveSnapshot()` is called.
+   */
+  DurableDynamicConnectivity(
+      int64_t num_vertices,
+      const std::string& directory,
+      int64_t batch_size = 256,
+      SyncPolicy sync_policy = SyncPolicy::kEveryBatch,
+      int64_t snapshot_interval = int64_t{1} << 22);
+
+  /** Writes the buffered updates to the log and closes it. */
+  ~DurableDynamicConnectivity();
+
+  /** The default constructor is invalid because the number of vertices in the
+   *  graph must be known. */
+  DurableDynamicConnectivity() = delete;
+  /** Copy constructor not implemented. */
+  DurableDynamicConnectivity(const DurableDynamicConnectivity& other) = delete;
+  /** Copy assignment not implemented. */
+  DurableDynamicConnectivity& operator=(const DurableDynamicConnectivity& other)
+    = delete;
+  /** Move constructor not implemented. */
+  DurableDynamicConnectivity(DurableDynamicConnectivity&& other) = delete;
+  /** Move assignment not implemented. */
+  DurableDynamicConnectivity& operator=(DurableDynamicConnectivity&& other)
+    = delete;
+
+  /** Returns true if vertices \p u and \p v are connected in the graph.
+   *
+   *  Efficiency: logarithmic in the size of the graph.
+   *
+   *  @param[in] u Vertex.
+   *  @param[in] v Vertex.
+   *  @returns True if \p u and \p v are connected, false if they are not.
+   */
+  bool IsConnected(Vertex u, Vertex v) const;
+
+  /** Returns true if edge \p edge is in the graph.
+   *
+   *  Efficiency: constant on average.
+   *
+   *  @param[in] edge Edge.
+   *  @returns True if \p edge is in the graph, false if it is not.
+   */
+  bool HasEdge(const UndirectedEdge& edge) const;
+
+  /** Returns the number of vertices in `v`'s connected component.
+   *
+   *  Efficiency: logarithmic in the size of the graph.
+   *
+   *  @param[in] v Vertex.
+   *  @returns The number of vertices in \p v's connected component.
+   */
+  int64_t GetSizeOfConnectedComponent(Vertex v) const;
+
+  /** Returns the number of connected components in the graph.
+   *
+   *  Efficiency: constant.
+   *
+   *  @returns The number of connected components.
+   */
+  int64_t GetNumberOfConnectedComponents() const;
+
+  /** Adds edge to graph and logs the addition.
+   *
+   *  The edge must not already be in the graph and must not be a self-loop
+   *  edge.
+   *
+   *  Efficiency: \f$ O\left( \log^2 n \right) \f$ amortized where \f$ n \f$ is
+   *  the number of vertices in the graph, plus the cost of writing a batch or
+   *  saving a snapshot when one is due.
+   *
+   *  @param[in] edge Edge to be added.
+   */
+  void AddEdge(const UndirectedEdge& edge);
+
+  /** Deletes edge from graph and logs the deletion.
+   *
+   *  The edge must be in the graph.
+   *
+   *  Efficiency: \f$ O\left( \log^2 n \right) \f$ amortized where \f$ n \f$ is
+   *  the number of vertices in the graph, plus the cost of writing a batch or
+   *  saving a snapshot when one is due.
+   *
+   *  @param[in] edge Edge to be deleted.
+   */
+  void DeleteEdge(const UndirectedEdge& edge);
+
+  /** Writes the buffered updates to the log and syncs it if the sync policy
+   *  asks for it, making all updates so far durable. */
+  void Flush();
+
+  /** Saves the graph to a new snapshot and starts a new, empty log.
+   *
+   *  Efficiency: linear in the size of the graph.
+   */
+  void SaveSnapshot();
+
+ private:
+  void LoadSnapshot();
+  void ReplayLog();
+  void OpenLog();
+  void LogUpdate(Operation::Type type, const UndirectedEdge& edge);
+
+  const int64_t num_vertices_;
+  const std::string directory_;
+  const int64_t batch_size_;
+  const SyncPolicy sync_policy_;
+  const int64_t snapshot_interval_;
+  DynamicConnectivity graph_;
+  // The snapshot holds all updates logged in generations before this one, and
+  // the log of this generation holds the updates since.
+  int64_t generation_{0};
+  int log_file_descriptor_{-1};
+  // Whether the directory has been synced since the log was opened, so that
+  // the log itself survives a crash.
+  bool is_log_entry_synced_{false};
+  // Encoded updates not yet written to the log, preceded by room for the
+  // batch header.
+  std::vector<char> buffer_;
+  int64_t num_buffered_updates_{0};
+  // Number of updates logged since the last snapshot.
+  int64_t num_logged_updates_{0};
+};
@@ -6,13 +6,29 @@
  */
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
+#include <deque>
+#include <functional>
+#include <limits>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <random>
+#include <type_traits>
 #include <unordered_map>
 #include <unordered_set>
 #include <vector>
 
+#include <btree_sequence.hpp>
 #include <dynamic_forest.hpp>
+#include <dynamic_graph/aggregate.hpp>
 #include <dynamic_graph/graph.hpp>
+#include <dynamic_graph/memory_arena.hpp>
+#include <sequence.hpp>
+#include <thread_pool.hpp>
+#include <two_edge_connectivity.hpp>
 #include <utilities/hash.hpp>
 
 namespace detail {
@@ -29,39 +45,263 @@ enum class EdgeType {
 struct EdgeInfo {
   Level level;
   EdgeType type;
+  // Random label of a non-tree edge used to detect bridges, which it keeps if
+  // it becomes a tree edge. See `LevelZeroAggregate`.
+  uint64_t cut_label{0};
+};
+
+// Set of the vertices adjacent to a vertex by non-tree edges of some level.
+typedef std::unordered_set<
+  Vertex, std::hash<Vertex>, std::equal_to<Vertex>, ArenaAllocator<Vertex>>
+  AdjacencyList;
+
+// Monoid of the vertex values held in F_0. Alongside the user's value, each
+// vertex holds the XOR of the cut labels (see `EdgeInfo`) of its incident
+// non-tree edges. XORing these over one side of a tree edge gives the XOR of
+// the labels of the non-tree edges crossing the edge's cut, which is zero when
+// no non-tree edge crosses it and is otherwise unlikely to be zero.
+template <typename Monoid>
+struct LevelZeroAggregate {
+  typedef typename Monoid::Value UserValue;
+
+  // The user's value and a cut label. Both are initialized as
+  // `{user_value, cut_label}`.
+  template <typename T, bool is_empty>
+  struct BasicValue {
+    const T& GetUserValue() const { return user_value; }
+
+    T user_value;
+    uint64_t cut_label;
+  };
+  // An empty user value, such as `NoAggregate`'s, is a base so that it takes
+  // no space.
+  template <typename T>
+  struct BasicValue<T, true> : T {
+    const T& GetUserValue() const { return *this; }
+
+    uint64_t cut_label;
+  };
+  typedef BasicValue<
+    UserValue,
+    std::is_empty_v<UserValue> && !std::is_final_v<UserValue>> Value;
+
+  static Value Identity() { return {Monoid::Identity(), 0}; }
+  static Value Combine(const Value& a, const Value& b) {
+    return {
+      Monoid::Combine(a.GetUserValue(), b.GetUserValue()),
+      a.cut_label ^ b.cut_label};
+  }
+};
+
+static_assert(
+    sizeof(LevelZeroAggregate<NoAggregate>::Value) == sizeof(uint64_t),
+    "Vertices of F_0 should not spend space on an empty user value");
+
+// An entry in the log of changes that `BasicDynamicConnectivity::Rollback()`
+// undoes.
+template <typename Value>
+struct UndoRecord {
+  enum class Type {
+    // `edge` was added to the graph.
+    kAddEdgeInfo,
+    // `edge`, which had info `edge_info`, was removed from the graph.
+    kDeleteEdgeInfo,
+    // `edge`'s info was changed from `edge_info`.
+    kChangeEdgeInfo,
+    // `edge` was added to the level-`level` spanning forest.
+    kAddForestEdge,
+    // `edge` was deleted from the level-`level` spanning forest.
+    kDeleteForestEdge,
+    // `edge` was marked (if `mark` is true) or unmarked (if `mark` is false) in
+    // the level-`level` spanning forest.
+    kMarkForestEdge,
+    // `edge` was added to the level-`level` non-tree adjacency lists.
+    kAddToAdjacencyList,
+    // `edge` was deleted from the level-`level` non-tree adjacency lists.
+    kDeleteFromAdjacencyList,
+    // The value of vertex `edge.first` was changed from `value`.
+    kSetVertexValue,
+    // The cut label of `edge` was XORed into the values of its endpoints.
+    kToggleCutLabel,
+    // A promotion of the tree of vertex `edge.first` in the level-`level`
+    // spanning forest was appended to the deferred promotions.
+    kPushDeferredPromotion,
+    // A promotion of the tree of vertex `edge.first` in the level-`level`
+    // spanning forest was removed from the front of the deferred promotions.
+    kPopDeferredPromotion,
+  };
+
+  Type type;
+  UndirectedEdge edge;
+  Level level;
+  EdgeInfo edge_info;
+  bool mark;
+  Value value;
+};
+
+// Promotions left undone by a latency-bounded deletion: the level-`level` tree
+// edges of the level-`level` tree containing `vertex` should move up a level.
+struct DeferredPromotion {
+  Vertex vertex;
+  Level level;
 };
 
 }  // namespace detail
 
+/** Bytes of memory held by a `BasicDynamicConnectivity`, broken down by part,
+ *  as reported by `BasicDynamicConnectivity::GetMemoryUsage()`.
+ *
+ *  Sizes of hash tables are estimates, since the standard library does not
+ *  report them. They assume that each element lives in its own node holding a
+ *  next pointer and a cached hash.
+ */
+struct GraphMemoryUsage {
+  /** Bytes held by one level of the data structure. */
+  struct Level {
+    /** Euler tour elements representing the vertices of the level's spanning
+     *  forest. */
+    std::size_t vertex_elements{0};
+    /** Euler tour elements preallocated for the edges of the level's spanning
+     *  forest, whether used or not. */
+    std::size_t edge_element_pool{0};
+    /** Search tree nodes holding the level's Euler tours, other than the
+     *  elements themselves. Only level 0, which stores its Euler tours in
+     *  B-trees, has any. */
+    std::size_t sequence_nodes{0};
+    /** Map from the edges of the level's spanning forest to their Euler tour
+     *  elements. */
+    std::size_t forest_edges{0};
+    /** Adjacency lists of the level's non-tree edges. */
+    std::size_t non_tree_adjacency_lists{0};
+  };
+
+  /** `levels[i]` holds the bytes held by level $ i $. */
+  std::vector<Level> levels;
+  /** Structure kept for `Is2EdgeConnected()`, if tracking is enabled. */
+  std::size_t two_edge_connectivity{0};
+  /** Map from each edge of the graph to its level and type. */
+  std::size_t edges{0};
+  /** Everything else, such as the log kept for `Rollback()`. */
+  std::size_t other{0};
+
+  /** Returns the total number of bytes.
+   *
+   *  @returns The total number of bytes.
+   */
+  std::size_t GetTotal() const {
+    std::size_t total{two_edge_connectivity + edges + other};
+    for (const Level& level : levels) {
+      total += level.vertex_elements + level.edge_element_pool
+        + level.sequence_nodes + level.forest_edges
+        + level.non_tree_adjacency_lists;
+    }
+    return total;
+  }
+};
+
+/** A change in the connected components of a `BasicDynamicConnectivity`, as
+ *  reported to the callbacks registered with
+ *  `BasicDynamicConnectivity::SubscribeToComponentEvents()`.
+ */
+struct ComponentEvent {
+  /** Kind of change. */
+  enum class Type {
+    /** Two components merged into one. */
+    kMerge,
+    /** A component split into two. */
+    kSplit,
+  };
+
+  /** Kind of change. */
+  Type type;
+  /** Endpoints of the edge whose addition or deletion caused the change. They
+   *  lie in different components before a merge and after a split. */
+  Vertex first_vertex;
+  /** See `first_vertex`. */
+  Vertex second_vertex;
+  /** Number of vertices in `first_vertex`'s component before a merge or after
+   *  a split. */
+  int64_t first_size;
+  /** Number of vertices in `second_vertex`'s component before a merge or
+   *  after a split. The merged component of a merge has
+   *  `first_size + second_size` vertices. */
+  int64_t second_size;
+};
+
 /** This class represents an undirected graph that can undergo efficient edge
  *  insertions, edge deletions, and connectivity queries.
+ *
+ *  Each vertex holds a value of the monoid \p Monoid (see aggregate.hpp), and
+ *  the combination of the values over any connected component can be queried.
+ *  Use `DynamicConnectivity` if vertex values are not needed.
+ *
+ *  @tparam Monoid Monoid of per-vertex values.
  */
-class DynamicConnectivity {
+template <typename Monoid>
+class BasicDynamicConnectivity {
  public:
+  /** Type of the value held by each vertex. */
+  typedef typename Monoid::Value Value;
+
   /** Initializes an empty graph with a fixed number of vertices.
    *
-   *  Efficiency: \f$ O(n \log n ) \f$ where \f$ n \f$ is the number of vertices
-   *  in the graph.
+   *  Only the lowest level of the internal level structure is allocated up
+   *  front. Higher levels are allocated once edges reach them.
+   *
+   *  If \p arena is given, the spanning forests and their Euler tour B-tree
+   *  nodes, the adjacency lists, the edge table, and the undo log are
+   *  allocated from it, e.g. from a `HugePageArena` to back a large
+   *  graph with huge pages. If \p upper_level_arena is also given, the
+   *  forests and adjacency lists of the levels above 0 are allocated from it
+   *  instead. Those levels are only touched when tree edges are deleted, so a
+   *  `MappedFileArena` there lets a graph too large for memory keep the
+   *  level-0 structures that every update and query uses resident while the
+   *  upper levels page out. Copies of the graph allocate from the same arenas.
+   *  The structure enabled by `SetTwoEdgeConnectivityTracking()` still comes
+   *  from the global allocator.
+   *
+   *  Efficiency: \f$ O(n) \f$ where \f$ n \f$ is the number of vertices in the
+   *  graph.
    *
    *  @param[in] num_vertices Number of vertices in the graph.
+   *  @param[in] arena Arena to allocate from, or null for the global
+   *  allocator.
+   *  @param[in] upper_level_arena Arena to allocate the levels above 0 from,
+   *  or null to use \p arena.
    */
-  explicit DynamicConnectivity(int64_t num_vertices);
+  explicit BasicDynamicConnectivity(
+      int64_t num_vertices,
+      std::shared_ptr<MemoryArena> arena = nullptr,
+      std::shared_ptr<MemoryArena> upper_level_arena = nullptr);
 
   /** Deallocates the data structure. */
-  ~DynamicConnectivity();
+  ~BasicDynamicConnectivity();
 
   /** The default constructor is invalid because the number of vertices in the
    *  graph must be known. */
-  DynamicConnectivity() = delete;
-  /** Copy constructor not implemented. */
-  DynamicConnectivity(const DynamicConnectivity& other) = delete;
+  BasicDynamicConnectivity() = delete;
+  /** Copy constructor. Makes an independent deep copy of the graph, including
+   *  its internal level structure and any held checkpoints.
+   *
+   *  This is much faster than building a new graph by adding each edge of
+   *  \p other, so it suits forking a graph to evaluate several scenarios in
+   *  parallel.
+   *
+   *  Efficiency: \f$ O(m + n \log n) \f$ where \f$ m \f$ is the number of
+   *  edges and \f$ n \f$ is the number of vertices in the graph.
+   *
+   *  @param[in] other Graph to copy.
+   */
+  BasicDynamicConnectivity(const BasicDynamicConnectivity& other);
   /** Copy assignment not implemented. */
-  DynamicConnectivity& operator=(const DynamicConnectivity& other) = delete;
+  BasicDynamicConnectivity& operator=(const BasicDynamicConnectivity& other)
+    = delete;
 
   /** Move constructor. */
-  DynamicConnectivity(DynamicConnectivity&& other) noexcept;
+  BasicDynamicConnectivity(BasicDynamicConnectivity&& other) noexcept;
   /** Move assignment not implemented. */
-  DynamicConnectivity& operator=(DynamicConnectivity&& other) noexcept;
+  BasicDynamicConnectivity& operator=(BasicDynamicConnectivity&& other) noexcept
+    = delete;
 
   /** Returns true if vertices \p u and \p v are connected in the graph.
    *
@@ -99,6 +339,48 @@ class DynamicConnectivity {
    */
   int64_t GetNumberOfConnectedComponents() const;
 
+  /** Returns the sizes of the \p k largest connected components, largest
+   *  first. If the graph has fewer than \p k components, returns the sizes of
+   *  all of them.
+   *
+   *  Component sizes are kept up to date as components merge and split, so
+   *  this does not look at the vertices.
+   *
+   * Efficiency: \f$ O(k) \f$.
+   *
+   * @param[in] k Number of components.
+   * @returns The sizes of the \p k largest connected components.
+   */
+  std::vector<int64_t> GetLargestComponentSizes(int64_t k) const;
+
+  /** Returns a histogram of the sizes of the connected components. Element
+   *  \f$ i \f$ of the histogram is the number of components with at least
+   *  \f$ 2^i \f$ and fewer than \f$ 2^{i + 1} \f$ vertices.
+   *
+   * Efficiency: constant. The histogram has \f$ \lfloor \log_2 n \rfloor + 1
+   * \f$ elements where \f$ n \f$ is the number of vertices in the graph.
+   *
+   * @returns The histogram of component sizes.
+   */
+  const std::vector<int64_t>& GetComponentSizeHistogram() const;
+
+  /** Returns the number of vertices in the graph.
+   *
+   * Efficiency: constant.
+   *
+   * @returns The number of vertices.
+   */
+  int64_t GetNumberOfVertices() const;
+
+  /** Returns the number of bytes of memory that the graph holds, broken down
+   *  by part.
+   *
+   *  Efficiency: linear in the size of the graph.
+   *
+   *  @returns The number of bytes held by each part of the graph.
+   */
+  GraphMemoryUsage GetMemoryUsage() const;
+
   /** Adds an edge to the graph.
    *
    *  The edge must not already be in the graph and must not be a self-loop edge.
@@ -121,24 +403,458 @@ class DynamicConnectivity {
    */
   void DeleteEdge(const UndirectedEdge& edge);
 
+  /** Caps the number of edge promotions that each update performs.
+   *
+   *  When a deletion disconnects a spanning tree, the data structure moves
+   *  every tree edge on the smaller side up a level before searching for a
+   *  replacement edge, and it moves up every non-tree edge that fails to be a
+   *  replacement. These promotions pay for later searches, but a single
+   *  deletion may promote a large fraction of the graph. With a cap, a deletion
+   *  stops promoting once it reaches the cap and leaves the rest for later
+   *  updates or for `RunDeferredWork()`. Connectivity is still updated
+   *  immediately, so queries stay correct.
+   *
+   *  With a cap of \f$ k \f$, a deletion spends \f$ O(k \log n) \f$ time on
+   *  promotions plus logarithmic time for each non-tree edge it looks at while
+   *  searching for a replacement.
+   *
+   *  The amortized bound does not hold with a cap. A deferred promotion is
+   *  dropped if, by the time it runs, its tree has grown too large to move up
+   *  a level (for instance because a replacement edge joined it back to the
+   *  rest of its component) or its level has been removed. Its tree edges then
+   *  stay on their level, which keeps the data structure and queries correct,
+   *  but the promotions never happen, so they no longer pay for later
+   *  searches. A non-tree edge may then be looked at by every deletion that
+   *  searches its tree, and a deletion may take time linear in the number of
+   *  edges of the graph.
+   *
+   *  @param[in] max_promotions Maximum number of promotions per update, or
+   *  `std::nullopt` for no cap, which is the default.
+   */
+  void SetMaxPromotionsPerUpdate(std::optional<int64_t> max_promotions);
+
+  /** Performs up to \p max_promotions promotions left undone by earlier
+   *  updates. Calling this while the graph is otherwise idle keeps the
+   *  deferred work from piling up.
+   *
+   *  Efficiency: \f$ O(k \log n) \f$ where \f$ k \f$ is \p max_promotions
+   *  and \f$ n \f$ is the number of vertices in the graph.
+   *
+   *  @param[in] max_promotions Maximum number of promotions to perform.
+   *  @returns True if deferred work remains afterwards, false if not.
+   */
+  bool RunDeferredWork(int64_t max_promotions);
+
+  /** Sets the number of threads that look for a replacement edge when a
+   *  deletion disconnects a spanning tree.
+   *
+   *  With more than one thread, a search that has many non-tree edges to look
+   *  at checks them concurrently and then applies the results on the calling
+   *  thread. The search still picks the same replacement edge and promotes the
+   *  same edges as a search on one thread would, so the resulting graph does
+   *  not depend on the number of threads.
+   *
+   *  The graph keeps \p num_threads - 1 worker threads running until the
+   *  number of threads is changed or the graph is destroyed.
+   *
+   *  @param[in] num_threads Number of threads, including the calling thread.
+   *  Defaults to 1.
+   */
+  void SetNumberOfSearchThreads(int32_t num_threads);
+
+  /** Releases memory that the graph no longer needs, such as after many
+   *  edges have been deleted.
+   *
+   *  This shrinks the hash tables of edges and adjacency lists to fit their
+   *  contents, frees the levels above the highest level that any edge has
+   *  reached, and shrinks each spanning forest's pool of preallocated Euler
+   *  tour elements to the elements its edges use. The remaining elements are
+   *  renumbered in Euler tour order, which restores locality after long runs
+   *  of updates. The pools grow back as edges are added, at some cost to the
+   *  updates that grow them.
+   *
+   *  If the graph allocates from an arena, the freed memory returns to the
+   *  arena rather than to the system. A `ChunkedArena` reuses it for later
+   *  allocations but does not unmap its chunks until it is destroyed, so an
+   *  arena-backed graph keeps the high-water mark of its memory usage mapped,
+   *  and only the memory of freed allocations larger than a quarter chunk,
+   *  such as big element arrays, goes back to the system.
+   *
+   *  Efficiency: \f$ O((n + m) \log n) \f$ where \f$ n \f$ is the number of
+   *  vertices and \f$ m \f$ is the number of edges in the graph.
+   */
+  void Compact();
+
+  /** Makes deletions call `Compact()` automatically once the table of edges
+   *  becomes sparse.
+   *
+   *  After each deletion, if the table of edges has at least as many buckets
+   *  as the graph has vertices and its load factor, the number of edges per
+   *  bucket, is below \p load_factor, the graph compacts itself. Since
+   *  compacting shrinks the table to fit, roughly a fraction of one minus
+   *  \p load_factor of the edges must be deleted between automatic
+   *  compactions, so their cost is amortized over the deletions.
+   *
+   *  @param[in] load_factor Load factor in \f$ (0, 1) \f$ below which to
+   *  compact, or `std::nullopt` to never compact automatically, which is the
+   *  default.
+   */
+  void SetCompactionThreshold(std::optional<double> load_factor);
+
+  /** Registers \p callback to be called with each change in the connected
+   *  components, so that callers can react to merges and splits instead of
+   *  polling `IsConnected()`.
+   *
+   *  Each update queues an event for each merge or split it causes and calls
+   *  the callbacks with them once the update is complete, in subscription
+   *  order. Deleting a tree edge that has a replacement causes no event.
+   *  `Rollback()` reports each merge and split it undoes, so it may report
+   *  changes that cancel out. `RestoreEdge()` reports nothing.
+   *
+   *  Callbacks may query the graph but must not update it. Copies of the
+   *  graph start with no subscriptions.
+   *
+   *  @param[in] callback Function to call with each event.
+   *  @returns An identifier for passing to
+   *  `UnsubscribeFromComponentEvents()`.
+   */
+  int64_t SubscribeToComponentEvents(
+      std::function<void(const ComponentEvent&)> callback);
+
+  /** Cancels a subscription made by `SubscribeToComponentEvents()`.
+   *
+   *  @param[in] subscription Identifier returned when subscribing.
+   */
+  void UnsubscribeFromComponentEvents(int64_t subscription);
+
+  /** Records the current state of the graph so that it can be restored later
+   *  by `Rollback()`.
+   *
+   *  Checkpoints nest: each call to `Rollback()` or `DiscardCheckpoint()`
+   *  applies to the most recent checkpoint that has not yet been rolled back or
+   *  discarded.
+   *
+   *  While a checkpoint is held, every update records how to undo itself, so
+   *  memory use grows with the number of updates since the oldest held
+   *  checkpoint.
+   *
+   *  Efficiency: constant.
+   */
+  void Checkpoint();
+
+  /** Restores the graph to its state at the most recent checkpoint and
+   *  discards that checkpoint.
+   *
+   *  Besides restoring the set of edges, this restores the internal level of
+   *  every edge, so rolling back does not perturb the amortization of later
+   *  updates the way deleting and re-adding edges does.
+   *
+   *  There must be a checkpoint to roll back to.
+   *
+   *  Efficiency: proportional to the work done by the updates since the
+   *  checkpoint.
+   */
+  void Rollback();
+
+  /** Discards the most recent checkpoint without restoring it.
+   *
+   *  There must be a checkpoint to discard.
+   *
+   *  Efficiency: constant.
+   */
+  void DiscardCheckpoint();
+
+  /** Sets the value held by vertex \p v. Every vertex starts with
+   *  `Monoid::Identity()` as its value.
+   *
+   *  Efficiency: logarithmic in the size of the graph.
+   *
+   *  @param[in] v Vertex.
+   *  @param[in] value New value for \p v.
+   */
+  void SetVertexValue(Vertex v, const Value& value);
+
+  /** Returns the value held by vertex \p v.
+   *
+   *  Efficiency: constant.
+   *
+   *  @param[in] v Vertex.
+   *  @returns The value held by \p v.
+   */
+  const Value& GetVertexValue(Vertex v) const;
+
+  /** Returns the combination under `Monoid::Combine` of the values held by the
+   *  vertices in \p v's connected component.
+   *
+   *  The result is maintained incrementally as edges are added and deleted.
+   *
+   *  Efficiency: logarithmic in the size of the graph.
+   *
+   *  @param[in] v Vertex.
+   *  @returns The aggregate value of \p v's connected component.
+   */
+  const Value& GetComponentAggregate(Vertex v) const;
+
+  /** Returns true if edge \p edge is in the spanning forest that the data
+   *  structure maintains internally. Deleting such an edge starts a search for
+   *  a replacement edge, so it is much more costly than deleting a non-tree
+   *  edge.
+   *
+   *  The edge must be in the graph.
+   *
+   *  Efficiency: constant on average.
+   *
+   *  @param[in] edge Edge.
+   *  @returns True if \p edge is a tree edge, false if it is not.
+   */
+  bool IsTreeEdge(const UndirectedEdge& edge) const;
+
+  /** Returns true if edge \p edge is a bridge, i.e., deleting it would
+   *  disconnect its endpoints.
+   *
+   *  The edge must be in the graph.
+   *
+   *  If `SetTwoEdgeConnectivityTracking()` has turned tracking on, the answer
+   *  is exact. Otherwise this is a Monte Carlo query: each non-tree edge gets
+   *  a random 64-bit label when it is added, independent of the edge, and an
+   *  edge is reported to be a bridge if the labels of the non-tree edges
+   *  crossing its cut XOR to zero. A bridge is never missed, and a non-bridge
+   *  is reported as a bridge with probability \f$ 2^{-64} \f$ per query.
+   *
+   *  Efficiency: logarithmic in the size of the graph, or that of
+   *  `Is2EdgeConnected()` if tracking is on.
+   *
+   *  @param[in] edge Edge.
+   *  @returns True if \p edge is a bridge, false if it is not.
+   */
+  bool IsBridge(const UndirectedEdge& edge) const;
+
+  /** Returns true if vertices \p u and \p v are 2-edge-connected, i.e., they
+   *  remain connected after deleting any one edge. Every vertex is
+   *  2-edge-connected to itself.
+   *
+   *  Tracking must be enabled with `SetTwoEdgeConnectivityTracking()`. The
+   *  answer is exact.
+   *
+   *  The query restructures the tracking structure internally, so concurrent
+   *  calls on the same graph take turns on a lock, though they may run
+   *  alongside other queries.
+   *
+   *  Efficiency: \f$ O\left( \log^4 n \right) \f$ amortized where \f$ n \f$
+   *  is the number of vertices in the graph.
+   *
+   *  @param[in] u Vertex.
+   *  @param[in] v Vertex.
+   *  @returns True if \p u and \p v are 2-edge-connected, false if they are
+   *  not.
+   */
+  bool Is2EdgeConnected(Vertex u, Vertex v) const;
+
+  /** Enables or disables tracking of 2-edge connectivity, which
+   *  `Is2EdgeConnected()` needs and which makes `IsBridge()` exact.
+   *
+   *  Tracking maintains the 2-edge connectivity structure of Holm, de
+   *  Lichtenberg, and Thorup alongside the graph. The structure is separate
+   *  from the connectivity levels: it keeps its own spanning forest in a
+   *  link-cut tree, its own levels of non-tree edges, and
+   *  \f$ O(\log n) \f$ counts per vertex. It adds
+   *  \f$ O\left( \log^5 n \right) \f$ amortized time to every `AddEdge()`
+   *  and `DeleteEdge()` and \f$ O(n \log n) \f$ memory, so it is off by
+   *  default. Copies of the graph keep tracking if the original does.
+   *
+   *  Efficiency: enabling takes \f$ O\left( \log^5 n \right) \f$ amortized
+   *  time per edge in the graph. Disabling takes time linear in the size of
+   *  the structure.
+   *
+   *  @param[in] is_tracked Whether to track 2-edge connectivity.
+   */
+  void SetTwoEdgeConnectivityTracking(bool is_tracked);
+
+  /** Calls `function(edge)` for each edge in the graph, in no particular
+   *  order.
+   *
+   *  The graph must not be modified during the iteration.
+   *
+   *  Efficiency: linear in the number of edges in the graph.
+   *
+   *  @param[in] function Function to call on each edge.
+   */
+  template <typename Function>
+  void ForEachEdge(Function function) const;
+
+  /** Calls `function(edge, level, is_tree_edge)` for each edge in the graph, in
+   *  no particular order, where `level` is the edge's level in the internal
+   *  level structure and `is_tree_edge` tells whether the edge is in the
+   *  internal spanning forest.
+   *
+   *  Saving this information and passing it to `RestoreEdge()` rebuilds the
+   *  graph with the same level structure, so that the work already done to
+   *  raise edges through the levels is not repeated.
+   *
+   *  The graph must not be modified during the iteration.
+   *
+   *  Efficiency: linear in the number of edges in the graph.
+   *
+   *  @param[in] function Function to call on each edge.
+   */
+  template <typename Function>
+  void ForEachEdgeWithLevel(Function function) const;
+
+  /** Adds an edge reported by `ForEachEdgeWithLevel()` of a graph with the
+   *  same number of vertices, keeping its level.
+   *
+   *  Restoring all edges of the reported graph, in any order, to a graph with
+   *  no edges gives a graph with the same edges and level structure. The graph
+   *  is not valid until all of them have been restored; it must not be
+   *  queried or updated in between.
+   *
+   *  Efficiency: \f$ O(\ell \log n) \f$ where \f$ \ell \f$ is \p level and
+   *  \f$ n \f$ is the number of vertices in the graph.
+   *
+   *  @param[in] edge Edge to be restored.
+   *  @param[in] level Level reported for the edge.
+   *  @param[in] is_tree_edge Whether the edge was reported to be in the
+   *  spanning forest.
+   */
+  void RestoreEdge(const UndirectedEdge& edge, int8_t level, bool is_tree_edge);
+
  private:
+  typedef detail::LevelZeroAggregate<Monoid> LevelZeroMonoid;
+
+  void AddLevelsUpTo(detail::Level level);
+  bool HasLevel(detail::Level level) const;
   void AddNonTreeEdge(const UndirectedEdge& edge);
   void AddTreeEdge(const UndirectedEdge& edge);
   void AddEdgeToAdjacencyList(const UndirectedEdge& edge, detail::Level level);
   void DeleteEdgeFromAdjacencyList(
       const UndirectedEdge& edge, detail::Level level);
   void ReplaceTreeEdge(const UndirectedEdge& edge, detail::Level level);
+  std::optional<UndirectedEdge> FindReplacementEdge(
+      Vertex u,
+      detail::Level level,
+      bool promoted_tree,
+      const std::vector<Vertex>& vertices_with_incident_edges);
+  std::optional<UndirectedEdge> FindReplacementEdgeInParallel(
+      Vertex u,
+      detail::Level level,
+      bool promoted_tree,
+      const std::vector<Vertex>& vertices_with_incident_edges);
+  bool PromoteTreeEdges(Vertex v, detail::Level level);
+  void TryPromoteFailedCandidate(
+      const UndirectedEdge& edge, detail::Level level, bool promoted_tree);
+  void PromoteNonTreeEdge(const UndirectedEdge& edge, detail::Level level);
+  bool TrySpendPromotion();
+  void RunDeferredPromotions();
+  void ToggleCutLabel(const UndirectedEdge& edge, uint64_t label);
+  void CountComponent(int64_t size, int64_t count);
+  void QueueComponentEvent(
+      ComponentEvent::Type type, const UndirectedEdge& edge);
+  void PublishComponentEvents();
+
+  void AddEdgeInfo(const UndirectedEdge& edge, const detail::EdgeInfo& info);
+  detail::EdgeInfo DeleteEdgeInfo(const UndirectedEdge& edge);
+  void SetEdgeInfo(const UndirectedEdge& edge, const detail::EdgeInfo& info);
+  void AddEdgeToForest(const UndirectedEdge& edge, detail::Level level);
+  void DeleteEdgeFromForest(const UndirectedEdge& edge, detail::Level level);
+  void MarkEdgeInForest(
+      const UndirectedEdge& edge, detail::Level level, bool mark);
+  void MarkVertexInForest(Vertex v, detail::Level level, bool mark);
+  bool IsConnectedInForest(Vertex u, Vertex v, detail::Level level) const;
+  int64_t GetSizeOfTreeInForest(Vertex v, detail::Level level) const;
+  std::optional<UndirectedEdge>
+  GetMarkedEdgeInForest(Vertex v, detail::Level level) const;
+  std::vector<UndirectedEdge> TakeMarkedEdgesInForest(
+      Vertex v, detail::Level level, int64_t max_edges);
+  std::vector<Vertex>
+  GetMarkedVerticesInForest(Vertex v, detail::Level level) const;
+  void RecordUndo(
+      typename detail::UndoRecord<Value>::Type type,
+      const UndirectedEdge& edge,
+      detail::Level level = 0,
+      detail::EdgeInfo edge_info = {},
+      bool mark = false,
+      const Value& value = Monoid::Identity());
+  void Undo(const detail::UndoRecord<Value>& record);
 
+  // The arenas are declared first so that they outlive all storage allocated
+  // from them. `upper_level_arena_` holds the levels above 0.
+  const std::shared_ptr<MemoryArena> arena_;
+  const std::shared_ptr<MemoryArena> upper_level_arena_;
   const int64_t num_vertices_;
-  // `spanning_forests_[i]` stores F_i, the spanning forest for the i-th
-  // subgraph. In particular, `spanning_forests[0]` is a spanning forest for the
-  // whole graph.
-  std::vector<DynamicForest> spanning_forests_;
+  // Draws the cut labels of non-tree edges. It is seeded from
+  // `std::random_device` for each graph.
+  std::mt19937_64 cut_label_generator_;
+  // `spanning_forest_` stores F_0, the spanning forest for the whole graph.
+  // Its vertices hold the values set by `SetVertexValue()` and the cut labels
+  // of their incident non-tree edges. Connectivity queries only look at F_0,
+  // so it stores its Euler tours in B-trees, which are shallower than the
+  // treaps used for the upper levels.
+  BasicDynamicForest<sequence::BTreeElement<LevelZeroMonoid>>
+    spanning_forest_;
+  // `upper_spanning_forests_[i - 1]` stores F_i, the spanning forest for the
+  // i-th subgraph, for i >= 1, once an edge has reached level i. The private
+  // `...InForest()` methods look up F_i by level.
+  std::vector<DynamicForest> upper_spanning_forests_;
+  // Tracks 2-edge connectivity if enabled by
+  // `SetTwoEdgeConnectivityTracking()`, or null otherwise. It is updated
+  // whenever an edge is added to or deleted from `edges_`.
+  std::unique_ptr<TwoEdgeConnectivity> two_edge_connectivity_;
+  // Serializes `Is2EdgeConnected()`, which changes `two_edge_connectivity_`.
+  mutable std::mutex two_edge_connectivity_mutex_;
+  // Maps each size to the number of connected components of that size. These
+  // and `component_size_histogram_` are updated whenever F_0 changes, so they
+  // stay correct through `Rollback()` and `RestoreEdge()`.
+  std::map<int64_t, int64_t> component_size_counts_;
+  // `component_size_histogram_[i]` is the number of connected components with
+  // at least 2^i and fewer than 2^(i + 1) vertices.
+  std::vector<int64_t> component_size_histogram_;
   // `adjacency_lists_by_level_[i][v]` contains the vertices connected to vertex
   // v by level-i non-tree edges.
-  std::vector<std::vector<std::unordered_set<Vertex>>>
+  std::vector<
+    std::vector<
+      detail::AdjacencyList, ArenaAllocator<detail::AdjacencyList>>>
     non_tree_adjacency_lists_;
   // All edges in the graph.
-  std::unordered_map<UndirectedEdge, detail::EdgeInfo, UndirectedEdgeHash>
-    edges_;
+  std::unordered_map<
+    UndirectedEdge,
+    detail::EdgeInfo,
+    UndirectedEdgeHash,
+    std::equal_to<UndirectedEdge>,
+    ArenaAllocator<std::pair<const UndirectedEdge, detail::EdgeInfo>>> edges_;
+  // Changes made since the oldest held checkpoint, in the order they were made.
+  std::vector<
+    detail::UndoRecord<Value>, ArenaAllocator<detail::UndoRecord<Value>>>
+    undo_log_;
+  // `checkpoints_[i]` is the size `undo_log_` had when the i-th held checkpoint
+  // was made.
+  std::vector<std::size_t> checkpoints_;
+  // Cap set by `SetMaxPromotionsPerUpdate()`.
+  std::optional<int64_t> max_promotions_per_update_;
+  // Number of promotions the current update may still perform, or null if it
+  // may perform any number.
+  std::optional<int64_t> promotion_budget_;
+  // Promotions skipped because of `promotion_budget_`, oldest first. Entries
+  // are checked for validity when they are run, so they need not be updated
+  // as the graph changes.
+  std::deque<detail::DeferredPromotion> deferred_promotions_;
+  // Number of threads set by `SetNumberOfSearchThreads()`.
+  int32_t num_search_threads_{1};
+  // Worker threads that help the updating thread search for replacement edges,
+  // or null if `num_search_threads_` is 1. Copies of the graph start their own.
+  std::unique_ptr<ThreadPool> search_thread_pool_;
+  // Threshold set by `SetCompactionThreshold()`.
+  std::optional<double> compaction_threshold_;
+  // Callbacks registered by `SubscribeToComponentEvents()`, by subscription.
+  std::map<int64_t, std::function<void(const ComponentEvent&)>>
+    component_subscribers_;
+  int64_t next_subscription_{0};
+  // Events of the current update, which are published once it is complete.
+  std::vector<ComponentEvent> pending_component_events_;
 };
+
+/** Graph whose vertices hold no values. */
+typedef BasicDynamicConnectivity<NoAggregate> DynamicConnectivity;
+
+extern template class BasicDynamicConnectivity<NoAggregate>;
+
+#include <dynamic_connectivity_impl.hpp>
@@ -0,0 +1,278 @@
+/** @file dynamic_minimum_spanning_forest.hpp
+ *  Declaration for a data structure that maintains a minimum spanning forest of
+ *  an undirected weighted graph that can have edges added or removed.
+ *
+ *  @author Tom Tseng (tomtseng)
+ */
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <set>
+#include <unordered_map>
+#include <vector>
+
+#include <dynamic_forest.hpp>
+#include <dynamic_graph/dynamic_connectivity.hpp>
+#include <dynamic_graph/graph.hpp>
+#include <dynamic_graph/memory_arena.hpp>
+#include <link_cut_tree.hpp>
+#include <sequence.hpp>
+#include <utilities/hash.hpp>
+
+namespace detail {
+
+// Monoid for finding the lightest non-tree edge incident to a tree. The value
+// of each vertex is the lightest non-tree edge incident to it.
+struct LightestEdge {
+  typedef WeightedEdgeKey Value;
+  // Compares greater than every edge.
+  static Value Identity() {
+    return {
+      std::numeric_limits<int64_t>::max(),
+      std::numeric_limits<Vertex>::max(),
+      std::numeric_limits<Vertex>::max()};
+  }
+  static Value Combine(const Value& a, const Value& b) { return b < a ? b : a; }
+};
+
+struct WeightedEdgeInfo {
+  Level level;
+  EdgeType type;
+  int64_t weight;
+};
+
+}  // namespace detail
+
+/** This class represents an undirected weighted graph that maintains a minimum
+ *  spanning forest of the graph as edges are added and deleted.
+ *
+ *  It uses the same level structure as `DynamicConnectivity`, but searches for
+ *  replacement edges in order of increasing weight so that a deleted forest
+ *  edge is always replaced by the lightest edge that reconnects the forest.
+ *
+ *  Edges of equal weight are ordered by their endpoints, so the minimum
+ *  spanning forest is uniquely determined by the graph.
+ */
+class DynamicMinimumSpanningForest {
+ public:
+  /** Type of edge weights. */
+  typedef int64_t Weight;
+
+  /** Initializes an empty graph with a fixed number of vertices.
+   *
+   *  If \p arena is given, the spanning forests, adjacency lists, and edge
+   *  table are allocated from it. See `BasicDynamicConnectivity`'s
+   *  constructor.
+   *
+   *  Efficiency: \f$ O(n \log n ) \f$ where \f$ n \f$ is the number of vertices
+   *  in the graph.
+   *
+   *  @param[in] num_vertices Number of vertices in the graph.
+   *  @param[in] arena Arena to allocate from, or null for the global
+   *  allocator.
+   */
+  explicit DynamicMinimumSpanningForest(
+      int64_t num_vertices, std::shared_ptr<MemoryArena> arena = nullptr);
+
+  /** Deallocates the data structure. */
+  ~DynamicMinimumSpanningForest();
+
+  /** The default constructor is invalid because the number of vertices in the
+   *  graph must be known. */
+  DynamicMinimumSpanningForest() = delete;
+  /** Copy constructor not implemented. */
+  DynamicMinimumSpanningForest(const DynamicMinimumSpanningForest& other)
+    = delete;
+  /** Copy assignment not implemented. */
+  DynamicMinimumSpanningForest&
+  operator=(const DynamicMinimumSpanningForest& other) = delete;
+
+  /** Move constructor. */
+  DynamicMinimumSpanningForest(DynamicMinimumSpanningForest&& other) noexcept;
+  /** Move assignment not implemented. */
+  DynamicMinimumSpanningForest&
+  operator=(DynamicMinimumSpanningForest&& other) noexcept = delete;
+
+  /** Returns true if vertices \p u and \p v are connected in the graph.
+   *
+   *  Efficiency: logarithmic in the size of the graph.
+   *
+   *  @param[in] u Vertex.
+   *  @param[in] v Vertex.
+   *  @returns True if \p u and \p v are connected, false if they are not.
+   */
+  bool IsConnected(Vertex u, Vertex v) const;
+
+  /** Returns true if edge \p edge is in the graph.
+   *
+   *  Efficiency: constant on average.
+   *
+   *  @param[in] edge Edge.
+   *  @returns True if \p edge is in the graph, false if it is not.
+   */
+  bool HasEdge(const UndirectedEdge& edge) const;
+
+  /** Returns true if edge \p edge is in the minimum spanning forest.
+   *
+   *  The edge must be in the graph.
+   *
+   *  Efficiency: constant on average.
+   *
+   *  @param[in] edge Edge.
+   *  @returns True if \p edge is in the minimum spanning forest, false if it is
+   *  not.
+   */
+  bool IsInForest(const UndirectedEdge& edge) const;
+
+  /** Returns the weight of edge \p edge.
+   *
+   *  The edge must be in the graph.
+   *
+   *  Efficiency: constant on average.
+   *
+   *  @param[in] edge Edge.
+   *  @returns The weight of \p edge.
+   */
+  Weight GetEdgeWeight(const UndirectedEdge& edge) const;
+
+  /** Returns the number of vertices in `v`'s connected component.
+   *
+   * Efficiency: logarithmic in the size of the graph.
+   *
+   * @param[in] v Vertex.
+   * @returns The number of vertices in \p v's connected component.
+   */
+  int64_t GetSizeOfConnectedComponent(Vertex v) const;
+
+  /** Returns the number of connected components in the graph.
+   *
+   * Efficiency: constant.
+   *
+   * @returns The number of connected components.
+   */
+  int64_t GetNumberOfConnectedComponents() const;
+
+  /** Adds an edge with weight \p weight to the graph.
+   *
+   *  The edge must not already be in the graph and must not be a self-loop edge.
+   *
+   *  If the edge closes a cycle whose heaviest edge is heavier than it, that
+   *  heaviest edge leaves the minimum spanning forest and the new edge takes
+   *  its place.
+   *
+   *  Efficiency: \f$ O\left( \log^2 n \right) \f$ amortized where \f$ n \f$ is
+   *  the number of vertices in the graph, plus the cost of a deletion when an
+   *  edge leaves the forest.
+   *
+   *  @param[in] edge Edge to be added.
+   *  @param[in] weight Weight of the edge.
+   */
+  void AddEdge(const UndirectedEdge& edge, Weight weight);
+
+  /** Deletes an edge from the graph.
+   *
+   *  An exception will be thrown if the edge is not in the graph.
+   *
+   *  Efficiency: not polylogarithmic. Deleting a forest edge costs
+   *  \f$ O\left( \log n \right) \f$ for each non-tree edge it promotes or
+   *  lowers, where \f$ n \f$ is the number of vertices in the graph. Non-tree
+   *  edges move down a level when the lightest replacement for a deleted forest
+   *  edge lies on a lower level than some other replacement edge. Lowering an
+   *  edge gives back the levels it was promoted through, so promotions are not
+   *  paid for by the \f$ O(\log n) \f$ levels an edge can climb. In the worst
+   *  case a single deletion takes \f$ O\left( m \log n \right) \f$ time, where
+   *  \f$ m \f$ is the number of edges, and the amortized bound is no better.
+   *  The \f$ O\left( \log^4 n \right) \f$ amortized bound of Holm et al.
+   *  needs their decremental-to-fully-dynamic reduction, which this class
+   *  does not implement.
+   *
+   *  @param[in] edge Edge to be deleted.
+   */
+  void DeleteEdge(const UndirectedEdge& edge);
+
+  /** Returns the total weight of the edges in the minimum spanning forest.
+   *
+   *  Efficiency: constant.
+   *
+   *  @returns The weight of the minimum spanning forest.
+   */
+  Weight GetForestWeight() const;
+
+  /** Calls `function(edge, weight)` for each edge in the minimum spanning
+   *  forest, in no particular order.
+   *
+   *  The graph must not be modified during the iteration.
+   *
+   *  Efficiency: linear in the number of edges in the graph.
+   *
+   *  @param[in] function Function to call on each forest edge.
+   */
+  template <typename Function>
+  void ForEachForestEdge(Function function) const;
+
+ private:
+  typedef BasicDynamicForest<sequence::AugmentedElement<detail::LightestEdge>>
+    Forest;
+  typedef std::set<
+    detail::WeightedEdgeKey,
+    std::less<detail::WeightedEdgeKey>,
+    ArenaAllocator<detail::WeightedEdgeKey>> AdjacencyList;
+
+  void AddNonTreeEdge(const UndirectedEdge& edge, Weight weight);
+  void AddTreeEdge(const UndirectedEdge& edge, Weight weight);
+  void AddEdgeToAdjacencyList(
+      const UndirectedEdge& edge, Weight weight, detail::Level level);
+  void DeleteEdgeFromAdjacencyList(
+      const UndirectedEdge& edge, Weight weight, detail::Level level);
+  void UpdateVertexValue(Vertex v, detail::Level level);
+  void MoveNonTreeEdge(
+      const UndirectedEdge& edge,
+      detail::Level old_level,
+      detail::Level new_level);
+  void PromoteTreeEdges(Vertex v, detail::Level level);
+  std::optional<detail::WeightedEdgeKey> FindReplacementEdge(
+      Vertex v,
+      detail::Level level,
+      const std::optional<detail::WeightedEdgeKey>& bound,
+      std::vector<UndirectedEdge>* non_replacement_edges);
+  void LowerReplacementEdges(
+      Vertex v, detail::Level level, detail::Level new_level);
+  void ReplaceTreeEdge(const UndirectedEdge& edge, detail::Level level);
+
+  // Arena that the graph's storage is allocated from, or null. It is held here
+  // to keep it alive as long as the graph.
+  const std::shared_ptr<MemoryArena> arena_;
+  const int64_t num_vertices_;
+  // `spanning_forests_[i]` stores F_i, the spanning forest for the i-th
+  // subgraph. Each vertex of F_i holds its lightest incident level-i non-tree
+  // edge.
+  std::vector<Forest> spanning_forests_;
+  // `non_tree_adjacency_lists_[i][v]` contains the level-i non-tree edges
+  // incident to vertex v, ordered from lightest to heaviest.
+  std::vector<std::vector<AdjacencyList, ArenaAllocator<AdjacencyList>>>
+    non_tree_adjacency_lists_;
+  // Mirrors F_0 to find the heaviest forest edge on a cycle.
+  LinkCutTree path_forest_;
+  // All edges in the graph.
+  std::unordered_map<
+    UndirectedEdge,
+    detail::WeightedEdgeInfo,
+    UndirectedEdgeHash,
+    std::equal_to<UndirectedEdge>,
+    ArenaAllocator<std::pair<const UndirectedEdge, detail::WeightedEdgeInfo>>>
+    edges_;
+  Weight forest_weight_{0};
+};
+
+template <typename Function>
+void DynamicMinimumSpanningForest::ForEachForestEdge(Function function) const {
+  for (const auto& [edge, info] : edges_) {
+    if (info.type == detail::EdgeType::kTree) {
+      function(edge, info.weight);
+    }
+  }
+}
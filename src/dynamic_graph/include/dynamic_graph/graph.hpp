@@ -8,6 +8,7 @@
 #include <cstdint>
 #include <ostream>
 #include <utility>
+#include <vector>
 
 /** Represents a vertex in a graph. */
 typedef int64_t Vertex;
@@ -47,3 +48,29 @@ struct UndirectedEdgeHash {
    */
   std::size_t operator()(const UndirectedEdge& edge) const;
 };
+
+/** Computes a numbering of the vertices of a graph under which vertices that
+ *  are close together in the graph get close numbers.
+ *
+ *  Renumbering a graph this way before building a data structure over it lays
+ *  out the data of neighboring vertices near each other in memory, so that
+ *  operations on a component touch fewer cache lines.
+ *
+ *  The numbering is the preorder of a depth-first search, so the vertices of
+ *  each component, and of each subtree of the search tree, get consecutive
+ *  numbers. The Euler tour of the search tree visits vertices in nearly this
+ *  order. Vertices without edges are numbered last.
+ *
+ *  The parent of a vertex in the search tree is its neighbor with the highest
+ *  number below its own.
+ *
+ *  Efficiency: \f$ O(m + n) \f$ where \f$ m \f$ is the number of edges and
+ *  \f$ n \f$ is the number of vertices in the graph.
+ *
+ *  @param[in] num_vertices Number of vertices in the graph.
+ *  @param[in] edges Edges of the graph.
+ *  @returns A vector whose \f$ v \f$-th entry is the new number of vertex
+ *  \f$ v \f$.
+ */
+std::vector<Vertex> ComputeLocalityOrder(
+    int64_t num_vertices, const std::vector<UndirectedEdge>& edges);
@@ -0,0 +1,134 @@
+/** @file graph_pool.hpp
+ *  Declaration for a pool that hosts many small independent dynamic
+ *  connectivity graphs.
+ *
+ *  @author Tom Tseng (tomtseng)
+ */
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+#include <dynamic_graph/dynamic_connectivity.hpp>
+#include <dynamic_graph/memory_arena.hpp>
+#include <utilities/assert.hpp>
+
+/** This class hosts many independent `DynamicConnectivity` graphs, such as one
+ *  small graph per customer.
+ *
+ *  Graphs are stored in fixed-size slabs of slots that are allocated together
+ *  and never move, and the slots of removed graphs are reused by later graphs.
+ *  The slabs hold only the graph objects. The storage inside each graph comes
+ *  from the global allocator, or, if the pool is given an arena, from a
+ *  `SubArena` of the graph's own that carves chunks out of that arena. Graphs
+ *  then only take the shared arena's lock to get a new chunk, and a removed
+ *  graph gives its chunks back to the shared arena.
+ *  Each graph only allocates the forests of the levels that its edges have
+ *  reached, so a graph that never sees a deletion costs little more than its
+ *  level-0 forest.
+ *
+ *  Different graphs may be used from different threads at the same time. Each
+ *  graph has its own lock, so calls on the same graph are serialized, and
+ *  calls on different graphs run in parallel.
+ */
+class GraphPool {
+ public:
+  /** Identifier of a graph in the pool. */
+  typedef int64_t GraphId;
+
+  /** Initializes an empty pool.
+   *
+   *  @param[in] arena Arena that all graphs of the pool allocate from, or null
+   *  for the global allocator. See `BasicDynamicConnectivity`'s constructor.
+   */
+  explicit GraphPool(std::shared_ptr<MemoryArena> arena = nullptr);
+
+  /** Copy constructor not implemented. */
+  GraphPool(const GraphPool& other) = delete;
+  /** Copy assignment not implemented. */
+  GraphPool& operator=(const GraphPool& other) = delete;
+  /** Move constructor not implemented. */
+  GraphPool(GraphPool&& other) = delete;
+  /** Move assignment not implemented. */
+  GraphPool& operator=(GraphPool&& other) = delete;
+
+  /** Adds an empty graph to the pool.
+   *
+   *  Efficiency: \f$ O(n) \f$ where \f$ n \f$ is the number of vertices in the
+   *  new graph.
+   *
+   *  @param[in] num_vertices Number of vertices in the new graph.
+   *  @returns Identifier of the new graph. It may be the identifier of a graph
+   *  that has been removed.
+   */
+  GraphId AddGraph(int64_t num_vertices);
+
+  /** Removes a graph from the pool.
+   *
+   *  No other thread may be using the graph.
+   *
+   *  @param[in] id Identifier of the graph to remove.
+   */
+  void RemoveGraph(GraphId id);
+
+  /** Returns true if \p id identifies a graph in the pool.
+   *
+   *  @param[in] id Identifier.
+   *  @returns True if \p id identifies a graph in the pool.
+   */
+  bool HasGraph(GraphId id) const;
+
+  /** Returns the number of graphs in the pool.
+   *
+   *  @returns The number of graphs in the pool.
+   */
+  int64_t GetNumberOfGraphs() const;
+
+  /** Calls \p f on a graph while holding the graph's lock and returns the
+   *  result.
+   *
+   *  \p f must not call `AddGraph()` or `RemoveGraph()`.
+   *
+   *  @param[in] id Identifier of the graph.
+   *  @param[in] f Function to call with a `DynamicConnectivity&`.
+   *  @returns The result of \p f.
+   */
+  template <typename F>
+  auto WithGraph(GraphId id, F&& f);
+
+ private:
+  static constexpr int64_t kSlabSize{64};
+  // Size of the chunks that each graph's sub-arena takes from `arena_`. Graphs
+  // in a pool are small, so the chunks are too.
+  static constexpr std::size_t kGraphArenaChunkSize{std::size_t{64} << 10};
+
+  struct Slot {
+    std::mutex mutex;
+    std::optional<DynamicConnectivity> graph;
+  };
+  typedef std::array<Slot, kSlabSize> Slab;
+
+  Slot& GetSlot(GraphId id) const;
+
+  const std::shared_ptr<MemoryArena> arena_;
+  // Guards `slabs_`, `free_ids_`, and `num_graphs_`.
+  mutable std::mutex pool_mutex_;
+  std::vector<std::unique_ptr<Slab>> slabs_;
+  // Identifiers of empty slots.
+  std::vector<GraphId> free_ids_;
+  int64_t num_graphs_{0};
+};
+
+template <typename F>
+auto GraphPool::WithGraph(GraphId id, F&& f) {
+  Slot& slot{GetSlot(id)};
+  std::lock_guard<std::mutex> lock{slot.mutex};
+  ASSERT_MSG_ALWAYS(
+      slot.graph.has_value(), "Graph " << id << " is not in the pool");
+  return f(*slot.graph);
+}
@@ -0,0 +1,222 @@
+/** @file keyed_dynamic_connectivity.hpp
+ *  Declaration for a dynamic connectivity data structure whose vertices are
+ *  identified by arbitrary keys, such as sparse 64-bit IDs or strings.
+ *
+ *  @author Tom Tseng (tomtseng)
+ */
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <dynamic_graph/dynamic_connectivity.hpp>
+#include <dynamic_graph/graph.hpp>
+
+namespace detail {
+
+// Open-addressing hash table from keys to vertices that holds a fixed maximum
+// number of keys. Collisions are resolved by linear probing, and deletions
+// shift later entries back rather than leaving tombstones, so lookups never
+// slow down as keys come and go.
+template <typename Key, typename KeyHash>
+class VertexTable {
+ public:
+  explicit VertexTable(int64_t max_num_keys);
+
+  // Returns the vertex mapped to `key`, or -1 if `key` is not in the table.
+  Vertex Find(const Key& key) const;
+  // Maps `key`, which must not be in the table, to `v`.
+  void Insert(const Key& key, Vertex v);
+  // Removes `key`, which must be in the table.
+  void Erase(const Key& key);
+  // Removes all keys.
+  void Clear();
+
+ private:
+  struct Entry {
+    Key key;
+    // -1 if the entry is empty.
+    Vertex vertex;
+  };
+
+  std::size_t GetHomeIndex(const Key& key) const;
+  // Returns the index of the entry holding `key` or of the empty entry where
+  // probing for `key` stops.
+  std::size_t Probe(const Key& key) const;
+
+  KeyHash key_hash_;
+  // The number of entries is a power of two and at least twice the maximum
+  // number of keys.
+  std::vector<Entry> entries_;
+  std::size_t index_mask_;
+};
+
+}  // namespace detail
+
+/** This class represents an undirected graph that can undergo efficient edge
+ *  insertions, edge deletions, and connectivity queries, with vertices
+ *  identified by keys of type `Key` rather than by integers in
+ *  \f$ [0, n) \f$.
+ *
+ *  Keys are mapped to vertices of an internal `DynamicConnectivity` by a
+ *  compact open-addressing hash table, so each operation looks up each key
+ *  once. A key gets a vertex when it gets its first edge and gives the vertex
+ *  back when it loses its last edge, so the graph only needs room for the keys
+ *  that currently have edges. A key that has never had an edge is treated as
+ *  an isolated vertex.
+ *
+ *  @tparam Key Type of the keys identifying vertices.
+ *  @tparam KeyHash Hash function for `Key`. Its output is mixed further before
+ *  use, so identity hashes of integers are fine.
+ */
+template <typename Key, typename KeyHash = std::hash<Key>>
+class KeyedDynamicConnectivity {
+ public:
+  /** Initializes an empty graph.
+   *
+   *  Efficiency: \f$ O(n) \f$ where \f$ n \f$ is \p max_num_vertices.
+   *
+   *  @param[in] max_num_vertices Maximum number of keys that may have edges at
+   *  the same time.
+   */
+  explicit KeyedDynamicConnectivity(int64_t max_num_vertices);
+
+  /** Initializes a graph with the edges \p edges, numbering the internal
+   *  vertices as `ReorderVertices()` does.
+   *
+   *  The edges must be distinct and must not be self-loop edges.
+   *
+   *  Efficiency: \f$ O\left( m \log^2 n \right) \f$ amortized where
+   *  \f$ m \f$ is the number of edges and \f$ n \f$ is \p max_num_vertices.
+   *
+   *  @param[in] max_num_vertices Maximum number of keys that may have edges at
+   *  the same time.
+   *  @param[in] edges Edges of the graph, each given by the keys of its
+   *  endpoints.
+   */
+  KeyedDynamicConnectivity(
+      int64_t max_num_vertices,
+      const std::vector<std::pair<Key, Key>>& edges);
+
+  /** The default constructor is invalid because the maximum number of vertices
+   *  in the graph must be known. */
+  KeyedDynamicConnectivity() = delete;
+  /** Copy constructor not implemented. */
+  KeyedDynamicConnectivity(const KeyedDynamicConnectivity& other) = delete;
+  /** Copy assignment not implemented. */
+  KeyedDynamicConnectivity& operator=(const KeyedDynamicConnectivity& other)
+    = delete;
+  /** Move constructor. */
+  KeyedDynamicConnectivity(KeyedDynamicConnectivity&& other) noexcept
+    = default;
+  /** Move assignment not implemented. */
+  KeyedDynamicConnectivity& operator=(KeyedDynamicConnectivity&& other)
+    = delete;
+
+  /** Returns true if the vertices identified by \p u and \p v are connected
+   *  in the graph.
+   *
+   *  Efficiency: logarithmic in the size of the graph.
+   *
+   *  @param[in] u Key of a vertex.
+   *  @param[in] v Key of a vertex.
+   *  @returns True if \p u and \p v are connected, false if they are not.
+   */
+  bool IsConnected(const Key& u, const Key& v) const;
+
+  /** Returns true if the edge between \p u and \p v is in the graph.
+   *
+   *  Efficiency: constant on average.
+   *
+   *  @param[in] u Key of an endpoint of the edge.
+   *  @param[in] v Key of the other endpoint of the edge.
+   *  @returns True if the edge is in the graph, false if it is not.
+   */
+  bool HasEdge(const Key& u, const Key& v) const;
+
+  /** Returns the number of vertices in \p v's connected component.
+   *
+   *  Efficiency: logarithmic in the size of the graph.
+   *
+   *  @param[in] v Key of a vertex.
+   *  @returns The number of vertices in \p v's connected component.
+   */
+  int64_t GetSizeOfConnectedComponent(const Key& v) const;
+
+  /** Returns the number of keys that currently have at least one edge.
+   *
+   *  Efficiency: constant.
+   *
+   *  @returns The number of keys with edges.
+   */
+  int64_t GetNumberOfNonIsolatedVertices() const;
+
+  /** Adds the edge between \p u and \p v to the graph.
+   *
+   *  The edge must not already be in the graph and must not be a self-loop
+   *  edge. If either key has no edges yet, there must be room for it: at most
+   *  `max_num_vertices` keys may have edges at once.
+   *
+   *  Efficiency: \f$ O\left( \log^2 n \right) \f$ amortized where \f$ n \f$ is
+   *  the maximum number of vertices in the graph.
+   *
+   *  @param[in] u Key of an endpoint of the edge.
+   *  @param[in] v Key of the other endpoint of the edge.
+   */
+  void AddEdge(const Key& u, const Key& v);
+
+  /** Deletes the edge between \p u and \p v from the graph.
+   *
+   *  The edge must be in the graph.
+   *
+   *  Efficiency: \f$ O\left( \log^2 n \right) \f$ amortized where \f$ n \f$ is
+   *  the maximum number of vertices in the graph.
+   *
+   *  @param[in] u Key of an endpoint of the edge.
+   *  @param[in] v Key of the other endpoint of the edge.
+   */
+  void DeleteEdge(const Key& u, const Key& v);
+
+  /** Renumbers the internal vertices so that vertices close together in the
+   *  graph sit close together in memory, then rebuilds the graph.
+   *
+   *  Keys that come and go scatter the data of neighboring vertices across
+   *  the internal arrays. After renumbering with `ComputeLocalityOrder()`,
+   *  operations on a component touch fewer cache lines. Since vertices are
+   *  only identified by keys, the renumbering is invisible to callers.
+   *
+   *  Rebuilding discards the internal level of every edge, so later deletions
+   *  may again promote edges that had already been promoted.
+   *
+   *  Efficiency: \f$ O\left( m \log^2 n \right) \f$ amortized where
+   *  \f$ m \f$ is the number of edges and \f$ n \f$ is the maximum number of
+   *  vertices in the graph.
+   */
+  void ReorderVertices();
+
+ private:
+  void CheckForFreeVertices(int64_t num_vertices) const;
+  Vertex MapToFreeVertex(const Key& key);
+  void ReleaseVertexIfIsolated(Vertex v);
+  void Rebuild(const std::vector<UndirectedEdge>& edges);
+
+  const int64_t max_num_vertices_;
+  // Only empty while `Rebuild()` replaces the graph.
+  std::optional<DynamicConnectivity> graph_;
+  detail::VertexTable<Key, KeyHash> vertices_;
+  // `keys_[v]` is the key mapped to vertex v, if any.
+  std::vector<Key> keys_;
+  // `degrees_[v]` is the number of edges incident to vertex v.
+  std::vector<int64_t> degrees_;
+  // Vertices that no key is mapped to.
+  std::vector<Vertex> free_vertices_;
+};
+
+extern template class KeyedDynamicConnectivity<int64_t>;
+extern template class KeyedDynamicConnectivity<std::string>;
+
+#include <keyed_dynamic_connectivity_impl.hpp>
@@ -0,0 +1,370 @@
+/** @file memory_arena.hpp
+ *  Declaration for memory arenas that the dynamic graph data structures can
+ *  allocate their storage from.
+ *
+ *  @author Tom Tseng (tomtseng)
+ */
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+/** Source of memory for the storage of a dynamic graph data structure.
+ *
+ *  Data structures that accept an arena allocate their element arrays, hash
+ *  tables, and adjacency sets from it. An arena must outlive every data
+ *  structure that allocates from it, and it must be safe to call from every
+ *  thread that updates those data structures.
+ */
+class MemoryArena {
+ public:
+  virtual ~MemoryArena();
+
+  /** Allocates memory.
+   *
+   *  @param[in] num_bytes Size of the allocation in bytes.
+   *  @param[in] alignment Alignment of the allocation. Must be a power of two.
+   *  @returns Pointer to the allocated memory.
+   */
+  virtual void* Allocate(std::size_t num_bytes, std::size_t alignment) = 0;
+
+  /** Frees memory returned by `Allocate()`.
+   *
+   *  @param[in] pointer Pointer returned by `Allocate()`.
+   *  @param[in] num_bytes Size passed to `Allocate()`.
+   *  @param[in] alignment Alignment passed to `Allocate()`.
+   */
+  virtual void Deallocate(
+      void* pointer, std::size_t num_bytes, std::size_t alignment) = 0;
+};
+
+/** Arena that carves allocations out of large chunks of mapped memory.
+ *
+ *  Allocations much smaller than a chunk are rounded up to one of a few size
+ *  classes, bumped out of the current chunk so that memory allocated in
+ *  sequence sits in sequence, and recycled through a free list per size class.
+ *  Chunks are not unmapped until the arena is destroyed, so the arena keeps
+ *  the high-water mark of the memory allocated from it. Larger allocations get
+ *  mappings of their own that are unmapped when freed. Subclasses decide how
+ *  memory is mapped.
+ *
+ *  All methods are thread-safe.
+ */
+class ChunkedArena : public MemoryArena {
+ public:
+  /** Copy constructor not implemented. */
+  ChunkedArena(const ChunkedArena& other) = delete;
+  /** Copy assignment not implemented. */
+  ChunkedArena& operator=(const ChunkedArena& other) = delete;
+
+  void* Allocate(std::size_t num_bytes, std::size_t alignment) override;
+  void Deallocate(
+      void* pointer, std::size_t num_bytes, std::size_t alignment) override;
+
+  /** Returns the number of bytes that the arena has mapped.
+   *
+   *  @returns The number of bytes mapped.
+   */
+  std::size_t GetNumberOfMappedBytes() const;
+
+ protected:
+  /** Initializes an arena that has not mapped any memory yet.
+   *
+   *  @param[in] page_size Size of the pages backing the arena. Every mapping
+   *  is a multiple of it.
+   *  @param[in] chunk_size Size in bytes of the chunks that small allocations
+   *  are carved from. It is rounded up to a multiple of \p page_size.
+   */
+  ChunkedArena(std::size_t page_size, std::size_t chunk_size);
+
+  /** Maps memory. Called with the arena's lock held.
+   *
+   *  @param[in] num_bytes Size of the mapping, a multiple of the page size.
+   *  @returns Address of the mapping, aligned to the page size.
+   */
+  virtual void* Map(std::size_t num_bytes) = 0;
+
+  /** Unmaps memory returned by `Map()`. Called with the arena's lock held.
+   *
+   *  @param[in] address Address returned by `Map()`.
+   *  @param[in] num_bytes Size passed to `Map()`.
+   */
+  virtual void Unmap(void* address, std::size_t num_bytes) = 0;
+
+  /** Unmaps all memory of the arena. Subclasses must call this from their
+   *  destructors, since `Unmap()` cannot be called from this class's. */
+  void UnmapAll();
+
+  /** Size of the pages backing the arena. */
+  const std::size_t page_size_;
+
+ private:
+  // Allocations are rounded up to a multiple of this size, which is also the
+  // alignment of every allocation carved from a chunk.
+  static constexpr std::size_t kGranularity{16};
+
+  // Returns the index of the size class of allocations of `num_bytes` bytes
+  // and sets `*class_size` to the size of the class.
+  static std::size_t GetSizeClass(
+      std::size_t num_bytes, std::size_t* class_size);
+
+  const std::size_t chunk_size_;
+
+  mutable std::mutex mutex_;
+  // Unused space at the end of the current chunk.
+  char* chunk_position_{nullptr};
+  char* chunk_end_{nullptr};
+  // `free_lists_[c]` holds freed chunk allocations of size class `c`.
+  std::vector<std::vector<void*>> free_lists_;
+  // Maps the address of each mapping to its size.
+  std::unordered_map<void*, std::size_t> mappings_;
+  std::size_t num_mapped_bytes_{0};
+};
+
+/** Arena backed by huge pages, which cuts the TLB misses and page walks that
+ *  a large graph spread over ordinary 4 KB pages incurs.
+ *
+ *  Memory is mapped with `MAP_HUGETLB` when the system has huge pages of the
+ *  requested size reserved. Otherwise it falls back to ordinary mappings
+ *  marked with `madvise(MADV_HUGEPAGE)` so that transparent huge pages can
+ *  back them.
+ *
+ *  On machines with several NUMA nodes, the memory can be interleaved across
+ *  all nodes, which spreads the memory bandwidth of a graph shared by threads
+ *  on every socket. The default is the kernel's first-touch placement, which
+ *  puts each page on the node of the thread that first writes it and so suits
+ *  a graph built and used by threads on one socket.
+ *
+ *  All methods are thread-safe.
+ */
+class HugePageArena : public ChunkedArena {
+ public:
+  /** Size of the huge pages backing the arena. */
+  enum class PageSize {
+    /** 2 MB pages. */
+    k2Mb,
+    /** 1 GB pages. */
+    k1Gb,
+  };
+
+  /** Placement of the arena's memory across NUMA nodes. */
+  enum class NumaPlacement {
+    /** Place each page on the node of the thread that first touches it. */
+    kFirstTouch,
+    /** Interleave pages across all nodes. */
+    kInterleave,
+  };
+
+  /** Initializes an arena that has not mapped any memory yet.
+   *
+   *  @param[in] page_size Size of the huge pages to request.
+   *  @param[in] placement Placement of the memory across NUMA nodes.
+   *  @param[in] chunk_size Size in bytes of the chunks that small allocations
+   *  are carved from. It is rounded up to a multiple of the page size.
+   */
+  explicit HugePageArena(
+      PageSize page_size = PageSize::k2Mb,
+      NumaPlacement placement = NumaPlacement::kFirstTouch,
+      std::size_t chunk_size = std::size_t{32} << 20);
+
+  /** Unmaps all memory of the arena. */
+  ~HugePageArena() override;
+
+  /** Returns the number of bytes that the arena has mapped with
+   *  `MAP_HUGETLB`, as opposed to mappings that fell back to transparent huge
+   *  pages.
+   *
+   *  @returns The number of bytes mapped with `MAP_HUGETLB`.
+   */
+  std::size_t GetNumberOfHugeTlbBytes() const;
+
+ protected:
+  void* Map(std::size_t num_bytes) override;
+  void Unmap(void* address, std::size_t num_bytes) override;
+
+ private:
+  const NumaPlacement placement_;
+  // Addresses of the mappings made with `MAP_HUGETLB`.
+  std::unordered_set<void*> huge_tlb_mappings_;
+  // Updated with the arena's lock held, but atomic so that
+  // `GetNumberOfHugeTlbBytes()` may read it without taking the lock.
+  std::atomic<std::size_t> num_huge_tlb_bytes_{0};
+};
+
+/** Arena backed by a file, for graphs whose storage does not fit in memory.
+ *
+ *  Memory is mapped from a temporary file in a given directory, which is
+ *  deleted as soon as it is created so that it disappears when the arena is
+ *  destroyed or the process dies. The kernel pages the file in and out like
+ *  swap, so rarely used parts of a graph, such as the upper levels of
+ *  `BasicDynamicConnectivity`, leave memory to the parts in use. Each array
+ *  allocated from the arena lies contiguously in the file, so paging it in
+ *  reads the file sequentially.
+ *
+ *  The file only holds memory for the lifetime of the arena; it is not a way
+ *  to persist a graph.
+ *
+ *  All methods are thread-safe.
+ */
+class MappedFileArena : public ChunkedArena {
+ public:
+  /** Creates the arena's file.
+   *
+   *  @param[in] directory Directory to create the file in. It should be on a
+   *  local disk with room for the graph.
+   *  @param[in] chunk_size Size in bytes of the chunks that small allocations
+   *  are carved from. It is rounded up to a multiple of the page size.
+   */
+  explicit MappedFileArena(
+      const std::string& directory,
+      std::size_t chunk_size = std::size_t{64} << 20);
+
+  /** Unmaps all memory of the arena and deletes its file. */
+  ~MappedFileArena() override;
+
+ protected:
+  void* Map(std::size_t num_bytes) override;
+  void Unmap(void* address, std::size_t num_bytes) override;
+
+ private:
+  const int file_descriptor_;
+  // Size of the file. Mappings are appended to its end.
+  int64_t file_size_{0};
+  // Maps the address of each mapping to its offset in the file.
+  std::unordered_map<void*, int64_t> file_offsets_;
+};
+
+/** Arena that carves its chunks out of another arena.
+ *
+ *  An arena shared by data structures on many threads serializes their
+ *  allocations on its lock. Giving each data structure a sub-arena of the
+ *  shared arena keeps those allocations on the sub-arena's own lock, so the
+ *  shared arena's lock is only taken to get a new chunk or to allocate
+ *  something larger than a quarter chunk. Destroying the sub-arena gives its
+ *  chunks back to the parent.
+ *
+ *  All methods are thread-safe.
+ */
+class SubArena : public ChunkedArena {
+ public:
+  /** Initializes an arena that has not allocated from its parent yet.
+   *
+   *  @param[in] parent Arena to carve chunks out of. It is kept alive as long
+   *  as the sub-arena.
+   *  @param[in] chunk_size Size in bytes of the chunks that small allocations
+   *  are carved from.
+   */
+  explicit SubArena(
+      std::shared_ptr<MemoryArena> parent,
+      std::size_t chunk_size = std::size_t{64} << 10);
+
+  /** Gives all chunks back to the parent. */
+  ~SubArena() override;
+
+ protected:
+  void* Map(std::size_t num_bytes) override;
+  void Unmap(void* address, std::size_t num_bytes) override;
+
+ private:
+  const std::shared_ptr<MemoryArena> parent_;
+};
+
+/** Standard allocator that allocates from a `MemoryArena`, or from the global
+ *  `operator new` if it has no arena.
+ *
+ *  @tparam T Type of the objects to allocate.
+ */
+template <typename T>
+class ArenaAllocator {
+ public:
+  /** Type of the objects to allocate. */
+  typedef T value_type;
+
+  /** Initializes an allocator that allocates from \p arena, or from the
+   *  global `operator new` if \p arena is null.
+   *
+   *  @param[in] arena Arena to allocate from.
+   */
+  ArenaAllocator(MemoryArena* arena = nullptr) noexcept : arena_{arena} {}
+
+  /** Converts an allocator for another type.
+   *
+   *  @param[in] other Allocator to convert.
+   */
+  template <typename U>
+  ArenaAllocator(const ArenaAllocator<U>& other) noexcept
+    : arena_{other.GetArena()} {}
+
+  /** Allocates space for \p n objects.
+   *
+   *  @param[in] n Number of objects.
+   *  @returns Pointer to the allocated space.
+   */
+  T* allocate(std::size_t n) {
+    return static_cast<T*>(
+        arena_ == nullptr
+          ? ::operator new(n * sizeof(T))
+          : arena_->Allocate(n * sizeof(T), alignof(T)));
+  }
+
+  /** Frees space returned by `allocate()`.
+   *
+   *  @param[in] pointer Pointer returned by `allocate()`.
+   *  @param[in] n Number of objects passed to `allocate()`.
+   */
+  void deallocate(T* pointer, std::size_t n) noexcept {
+    if (arena_ == nullptr) {
+      ::operator delete(pointer);
+    } else {
+      arena_->Deallocate(pointer, n * sizeof(T), alignof(T));
+    }
+  }
+
+  /** Returns the arena that the allocator allocates from.
+   *
+   *  @returns The arena, or null for the global `operator new`.
+   */
+  MemoryArena* GetArena() const noexcept { return arena_; }
+
+ private:
+  MemoryArena* arena_;
+};
+
+/** Returns true if memory from \p a can be freed by \p b. */
+template <typename T, typename U>
+bool operator==(const ArenaAllocator<T>& a, const ArenaAllocator<U>& b) {
+  return a.GetArena() == b.GetArena();
+}
+
+/** Returns true if memory from \p a cannot be freed by \p b. */
+template <typename T, typename U>
+bool operator!=(const ArenaAllocator<T>& a, const ArenaAllocator<U>& b) {
+  return !(a == b);
+}
+
+namespace detail {
+
+// Returns about how many bytes a node-based hash table like
+// `std::unordered_map` holds: its bucket array, and a node per element holding
+// a next pointer, the element, and the element's cached hash.
+template <typename HashTable>
+std::size_t GetHashTableBytes(const HashTable& table) {
+  // A table with a single bucket keeps it inside the table object.
+  const std::size_t bucket_bytes{
+    table.bucket_count() > 1 ? table.bucket_count() * sizeof(void*) : 0};
+  return bucket_bytes
+    + table.size() * (
+        sizeof(void*)
+        + sizeof(typename HashTable::value_type)
+        + sizeof(std::size_t));
+}
+
+}  // namespace detail
@@ -0,0 +1,54 @@
+/** @file operation.hpp
+ *  Declaration for graph operations and their fixed-width binary encoding,
+ *  which operation logs, streams, and traces share.
+ *
+ *  @author Tom Tseng (tomtseng)
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+
+#include <dynamic_graph/graph.hpp>
+
+/** An operation on an undirected graph. */
+struct Operation {
+  /** Kind of operation. The values are the op codes of the binary encoding. */
+  enum class Type : uint8_t {
+    /** Adds `edge` to the graph. */
+    kAddEdge = 1,
+    /** Deletes `edge` from the graph. */
+    kDeleteEdge = 2,
+    /** Asks whether the endpoints of `edge` are connected. */
+    kIsConnected = 3,
+  };
+
+  /** Kind of operation. */
+  Type type;
+  /** Edge, or pair of vertices, that the operation acts on. */
+  UndirectedEdge edge;
+};
+
+/** Number of bytes in the binary encoding of an operation.
+ *
+ *  An encoded operation is the op code as a byte, seven zero bytes, and the two
+ *  vertices as little-endian 64-bit integers. The fixed width and 8-byte
+ *  alignment of the fields let a stream of operations be decoded with plain
+ *  loads.
+ */
+constexpr std::size_t kEncodedOperationSize{24};
+
+/** Writes the binary encoding of an operation.
+ *
+ *  @param[in] operation Operation to encode.
+ *  @param[out] out Buffer of at least `kEncodedOperationSize` bytes.
+ */
+void EncodeOperation(const Operation& operation, char* out);
+
+/** Reads the binary encoding of an operation.
+ *
+ *  @param[in] in Buffer of at least `kEncodedOperationSize` bytes.
+ *  @returns The operation, or nothing if the op code is invalid.
+ */
+std::optional<Operation> DecodeOperation(const char* in);
@@ -0,0 +1,189 @@
+/** @file operation_stream.hpp
+ *  Declaration for reading, writing, and ingesting files of binary-encoded
+ *  graph operations.
+ *
+ *  @author Tom Tseng (tomtseng)
+ */
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <dynamic_graph/dynamic_connectivity.hpp>
+#include <dynamic_graph/graph.hpp>
+#include <dynamic_graph/operation.hpp>
+
+/** Operations decoded from an operation stream, stored as one array per field
+ *  so that decoding them is a loop of plain loads and stores. */
+struct OperationBatch {
+  /** Kind of each operation. */
+  std::vector<Operation::Type> types;
+  /** First vertex of each operation, as it appears in the stream. */
+  std::vector<Vertex> first_vertices;
+  /** Second vertex of each operation, as it appears in the stream. */
+  std::vector<Vertex> second_vertices;
+
+  /** Returns the number of operations in the batch. */
+  int64_t GetSize() const { return types.size(); }
+};
+
+/** Decodes a run of operations in the binary encoding of operation.hpp.
+ *
+ *  The operations are validated in a separate branch-free pass, so a batch of
+ *  valid operations is decoded without branching on each operation.
+ *
+ *  Efficiency: linear in \p num_operations.
+ *
+ *  @param[in] in Buffer of `num_operations * kEncodedOperationSize` bytes.
+ *  @param[in] num_operations Number of operations to decode.
+ *  @param[in] num_vertices Number of vertices in the graph. Operations on
+ *  vertices outside of \f$ [0, \f$ \p num_vertices \f$ ) \f$ are invalid.
+ *  @param[out] batch Batch that is overwritten with the operations.
+ *  @returns The index of the first invalid operation, or \p num_operations if
+ *  all operations are valid. The contents of \p batch are unspecified if some
+ *  operation is invalid.
+ */
+int64_t DecodeOperations(
+    const char* in,
+    int64_t num_operations,
+    int64_t num_vertices,
+    OperationBatch* batch);
+
+/** A file of operations in the binary encoding of operation.hpp, mapped into
+ *  memory for reading.
+ *
+ *  An operation stream is the encoded operations laid end to end with no
+ *  header, so streams can be concatenated with `cat` and their length is their
+ *  size divided by `kEncodedOperationSize`.
+ */
+class OperationStreamReader {
+ public:
+  /** Maps the operation stream at \p path into memory.
+   *
+   *  @param[in] path Path of the operation stream.
+   */
+  explicit OperationStreamReader(const std::string& path);
+
+  /** Unmaps the operation stream. */
+  ~OperationStreamReader();
+
+  /** Copy constructor not implemented. */
+  OperationStreamReader(const OperationStreamReader& other) = delete;
+  /** Copy assignment not implemented. */
+  OperationStreamReader& operator=(const OperationStreamReader& other) = delete;
+  /** Move constructor not implemented. */
+  OperationStreamReader(OperationStreamReader&& other) = delete;
+  /** Move assignment not implemented. */
+  OperationStreamReader& operator=(OperationStreamReader&& other) = delete;
+
+  /** Returns the number of operations in the stream.
+   *
+   *  @returns The number of operations in the stream.
+   */
+  int64_t GetNumberOfOperations() const;
+
+  /** Decodes operations from the stream.
+   *
+   *  @param[in] begin Index of the first operation to decode.
+   *  @param[in] end One past the index of the last operation to decode.
+   *  @param[in] num_vertices Number of vertices in the graph.
+   *  @param[out] batch Batch that is overwritten with the operations.
+   *  @returns The index of the first invalid operation in the stream, or \p end
+   *  if all operations are valid.
+   */
+  int64_t Decode(
+      int64_t begin,
+      int64_t end,
+      int64_t num_vertices,
+      OperationBatch* batch) const;
+
+  /** Asks the operating system to start reading operations from disk ahead of
+   *  time.
+   *
+   *  @param[in] begin Index of the first operation to read.
+   *  @param[in] end One past the index of the last operation to read.
+   */
+  void Prefetch(int64_t begin, int64_t end) const;
+
+ private:
+  const std::string path_;
+  const char* data_{nullptr};
+  std::size_t size_{0};
+};
+
+/** Writes operations to a file in the binary encoding of operation.hpp, for
+ *  reading with `OperationStreamReader`. */
+class OperationStreamWriter {
+ public:
+  /** Creates the operation stream at \p path, replacing any file there.
+   *
+   *  @param[in] path Path of the operation stream.
+   */
+  explicit OperationStreamWriter(const std::string& path);
+
+  /** Writes the buffered operations and closes the stream. */
+  ~OperationStreamWriter();
+
+  /** Copy constructor not implemented. */
+  OperationStreamWriter(const OperationStreamWriter& other) = delete;
+  /** Copy assignment not implemented. */
+  OperationStreamWriter& operator=(const OperationStreamWriter& other) = delete;
+  /** Move constructor not implemented. */
+  OperationStreamWriter(OperationStreamWriter&& other) = delete;
+  /** Move assignment not implemented. */
+  OperationStreamWriter& operator=(OperationStreamWriter&& other) = delete;
+
+  /** Appends an operation to the stream.
+   *
+   *  @param[in] operation Operation to append.
+   */
+  void Append(const Operation& operation);
+
+  /** Writes the buffered operations to the file. */
+  void Flush();
+
+ private:
+  const std::string path_;
+  int file_descriptor_{-1};
+  std::vector<char> buffer_;
+};
+
+/** Counts of what happened to the operations of an ingested stream. */
+struct IngestStatistics {
+  /** Number of edges added to the graph. */
+  int64_t num_edges_added{0};
+  /** Number of edges deleted from the graph. */
+  int64_t num_edges_deleted{0};
+  /** Number of updates skipped because they were self-loops or because the
+   *  edge was already in the requested state. */
+  int64_t num_updates_skipped{0};
+  /** Number of connectivity queries answered. */
+  int64_t num_queries{0};
+  /** Number of connectivity queries whose vertices were connected. */
+  int64_t num_connected_queries{0};
+};
+
+/** Applies the operations of an operation stream to a graph in order.
+ *
+ *  The stream is decoded on a separate thread, one batch ahead of the calling
+ *  thread, which applies the batches to the graph. Reading from disk, decoding,
+ *  and updating the graph therefore overlap.
+ *
+ *  Updates are idempotent, as in `AsyncDynamicConnectivity`: adding an edge
+ *  that is already in the graph, deleting an edge that is not, and adding a
+ *  self-loop do nothing. Connectivity queries are answered and counted.
+ *
+ *  The stream must only hold valid operations on vertices of the graph. The
+ *  program aborts at the first invalid operation, after applying the
+ *  operations before it.
+ *
+ *  @param[in] stream Operation stream to apply.
+ *  @param[in,out] graph Graph to apply the operations to.
+ *  @param[in] batch_size Number of operations decoded at a time.
+ *  @returns Counts of what happened to the operations.
+ */
+IngestStatistics IngestOperationStream(
+    const OperationStreamReader& stream,
+    DynamicConnectivity* graph,
+    int64_t batch_size = 1 << 16);
@@ -0,0 +1,179 @@
+#include <dynamic_graph/async_dynamic_connectivity.hpp>
+
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <utilities/assert.hpp>
+
+namespace detail {
+
+UpdateQueue::UpdateQueue() {
+  Node* const stub{new Node{}};
+  head_.store(stub);
+  tail_ = stub;
+}
+
+UpdateQueue::~UpdateQueue() {
+  while (Pop().has_value()) {}
+  delete tail_;
+}
+
+void UpdateQueue::Push(QueuedUpdate update) {
+  Node* const node{new Node{}};
+  node->update.emplace(std::move(update));
+  Node* const previous{head_.exchange(node)};
+  // Until this store, the consumer sees the queue end at `previous`.
+  previous->next.store(node);
+}
+
+std::optional<QueuedUpdate> UpdateQueue::Pop() {
+  Node* const next{tail_->next.load()};
+  if (next == nullptr) {
+    return {};
+  }
+  delete tail_;
+  tail_ = next;
+  std::optional<QueuedUpdate> update{std::move(next->update)};
+  next->update.reset();
+  return update;
+}
+
+bool UpdateQueue::IsEmpty() const {
+  return tail_->next.load() == nullptr;
+}
+
+}  // namespace detail
+
+AsyncDynamicConnectivity::AsyncDynamicConnectivity(
+    int64_t num_vertices,
+    std::chrono::microseconds coalescing_window,
+    int64_t max_batch_size)
+    : num_vertices_{num_vertices}
+    , coalescing_window_{coalescing_window}
+    , max_batch_size_{max_batch_size}
+    , graph_{num_vertices} {
+  ASSERT_MSG_ALWAYS(max_batch_size_ > 0, "The batch size must be positive");
+  applier_ = std::thread{[this] { RunApplier(); }};
+}
+
+AsyncDynamicConnectivity::~AsyncDynamicConnectivity() {
+  {
+    const std::lock_guard<std::mutex> lock{wake_mutex_};
+    is_stopping_.store(true);
+  }
+  wake_condition_.notify_one();
+  applier_.join();
+}
+
+bool AsyncDynamicConnectivity::IsConnected(Vertex u, Vertex v) const {
+  return graph_.IsConnected(u, v);
+}
+
+bool AsyncDynamicConnectivity::HasEdge(const UndirectedEdge& edge) const {
+  return graph_.HasEdge(edge);
+}
+
+int64_t AsyncDynamicConnectivity::GetSizeOfConnectedComponent(Vertex v) const {
+  return graph_.GetSizeOfConnectedComponent(v);
+}
+
+int64_t AsyncDynamicConnectivity::GetNumberOfConnectedComponents() const {
+  return graph_.GetNumberOfConnectedComponents();
+}
+
+std::future<void> AsyncDynamicConnectivity::AddEdge(
+    const UndirectedEdge& edge) {
+  detail::ValidateEdge(edge, num_vertices_);
+  ASSERT_MSG(edge.first != edge.second, edge << " is a self-loop edge");
+  return Submit(detail::QueuedUpdate::Type::kAddEdge, edge);
+}
+
+std::future<void> AsyncDynamicConnectivity::DeleteEdge(
+    const UndirectedEdge& edge) {
+  detail::ValidateEdge(edge, num_vertices_);
+  return Submit(detail::QueuedUpdate::Type::kDeleteEdge, edge);
+}
+
+void AsyncDynamicConnectivity::Flush() {
+  Submit(detail::QueuedUpdate::Type::kNone, UndirectedEdge{0, 0}).wait();
+}
+
+int64_t AsyncDynamicConnectivity::GetNumberOfSkippedUpdates() const {
+  return num_skipped_updates_.load();
+}
+
+std::future<void> AsyncDynamicConnectivity::Submit(
+    detail::QueuedUpdate::Type type, const UndirectedEdge& edge) {
+  detail::QueuedUpdate update{type, edge, {}};
+  std::future<void> done{update.done.get_future()};
+  queue_.Push(std::move(update));
+  // The applier sets `is_applier_sleeping_` before checking whether the queue
+  // is empty, so either it sees this update or we see that it's sleeping.
+  if (is_applier_sleeping_.load()) {
+    const std::lock_guard<std::mutex> lock{wake_mutex_};
+    wake_condition_.notify_one();
+  }
+  return done;
+}
+
+void AsyncDynamicConnectivity::RunApplier() {
+  while (true) {
+    if (queue_.IsEmpty()) {
+      std::unique_lock<std::mutex> lock{wake_mutex_};
+      is_applier_sleeping_.store(true);
+      wake_condition_.wait(lock, [this] {
+        return !queue_.IsEmpty() || is_stopping_.load();
+      });
+      is_applier_sleeping_.store(false);
+      if (queue_.IsEmpty()) {
+        return;  // Stopping.
+      }
+    }
+    if (coalescing_window_.count() > 0) {
+      std::this_thread::sleep_for(coalescing_window_);
+    }
+    ApplyBatch();
+  }
+}
+
+// Takes a batch of updates off of the queue and applies the last update to
+// each edge if it would change the graph.
+void AsyncDynamicConnectivity::ApplyBatch() {
+  std::vector<detail::QueuedUpdate> batch;
+  std::unordered_map<UndirectedEdge, bool, UndirectedEdgeHash> final_states;
+  int64_t num_updates{0};
+  while (static_cast<int64_t>(batch.size()) < max_batch_size_) {
+    std::optional<detail::QueuedUpdate> update{queue_.Pop()};
+    if (!update.has_value()) {
+      break;
+    }
+    if (update->type != detail::QueuedUpdate::Type::kNone) {
+      final_states.insert_or_assign(
+          update->edge, update->type == detail::QueuedUpdate::Type::kAddEdge);
+      num_updates++;
+    }
+    batch.emplace_back(std::move(*update));
+  }
+
+  std::vector<UndirectedEdge> deletions;
+  std::vector<UndirectedEdge> additions;
+  for (const auto& [edge, should_have_edge] : final_states) {
+    if (graph_.HasEdge(edge) != should_have_edge) {
+      (should_have_edge ? additions : deletions).emplace_back(edge);
+    }
+  }
+  // Deleting first keeps the graph smaller while inserting.
+  for (const UndirectedEdge& edge : deletions) {
+    graph_.DeleteEdge(edge);
+  }
+  for (const UndirectedEdge& edge : additions) {
+    graph_.AddEdge(edge);
+  }
+  num_skipped_updates_ +=
+    num_updates - static_cast<int64_t>(deletions.size() + additions.size());
+
+  for (detail::QueuedUpdate& update : batch) {
+    update.done.set_value();
+  }
+}
@@ -0,0 +1,7 @@
+#include <btree_sequence.hpp>
+
+namespace sequence {
+
+template class BTreeElement<NoAggregate>;
+
+}  // namespace sequence
@@ -0,0 +1,277 @@
+// This is a data structure for storing lists of elements, with the same
+// interface and augmentation as `AugmentedElement` in <sequence.hpp>.
+//
+// Whereas `AugmentedElement` stores each sequence in a binary treap,
+// `BTreeElement` stores each sequence in a B-tree whose nodes have dozens of
+// children. Walking from an element up to the root of its sequence then
+// touches only a handful of nodes, so queries like `GetRepresentative()` and
+// `GetSize()` take O(log n / log B) steps for fanout B rather than the
+// treap's O(log n), each step costing about one cache miss. In exchange, joins,
+// splits, and value updates cost a factor of B more than they do on treaps.
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include <dynamic_graph/aggregate.hpp>
+#include <dynamic_graph/memory_arena.hpp>
+#include <sequence.hpp>
+
+namespace sequence {
+
+namespace detail {
+
+// Maximum and minimum number of children of a B-tree node other than the root.
+constexpr int32_t kBTreeMaxFanout{32};
+constexpr int32_t kBTreeMinFanout{kBTreeMaxFanout / 2};
+
+// Node of a B-tree representing a sequence. The children of a node of height 0
+// are sequence elements, and the children of a node of height h > 0 are nodes
+// of height h - 1.
+template <typename Monoid>
+struct BTreeNode {
+  BTreeNode* parent{nullptr};
+  // Index of this node among its parent's children.
+  int32_t index{0};
+  int32_t height{0};
+  int32_t num_children{0};
+  // Number of elements in this subtree.
+  int64_t size{0};
+  // Bit i of `has_marked[j]` is set if the i-th child's subtree has an element
+  // marked at index j.
+  std::array<uint64_t, 2> has_marked{{0, 0}};
+  // Combination of the values of the elements in this subtree, in order.
+  typename Monoid::Value aggregate{Monoid::Identity()};
+  // Each child is a `BTreeNode*` or a `BTreeElement<Monoid>*` depending on
+  // `height`. There is room for one extra child while a node is overfull.
+  std::array<void*, kBTreeMaxFanout + 1> children{};
+};
+
+static_assert(
+    kBTreeMaxFanout < 64,
+    "Children's marks must fit in the bits of `BTreeNode::has_marked`");
+
+}  // namespace detail
+
+// Usage: create single-element sequences with the `BTreeElement()`
+// constructor, and build bigger sequences from there.
+//
+// An element in a single-element sequence has no B-tree node, so isolated
+// elements cost no more memory than treap elements do. The B-tree nodes of a
+// sequence are allocated from the arena of the element whose operation creates
+// them, so all elements that are ever joined together must share an arena.
+template <typename Monoid>
+class BTreeElement {
+ public:
+  typedef typename Monoid::Value Value;
+
+  // Initializes a single sequence element. If `arena` is not null, the B-tree
+  // nodes of the element's sequences are allocated from it.
+  explicit BTreeElement(
+      const std::pair<int64_t, int64_t>& id, MemoryArena* arena = nullptr);
+  BTreeElement();
+
+  // Elements must be destroyed all together with every other element in their
+  // sequence, e.g., by destroying the container holding all of them.
+  ~BTreeElement();
+
+  // Copies elements that are in single-element sequences. Copying will throw an
+  // exception if attempted on an element that lives in a sequence of several
+  // elements.
+  BTreeElement(const BTreeElement& other);
+  BTreeElement& operator=(const BTreeElement& other) = delete;
+  // Moves element. The sequence of the moved element will be changed to hold
+  // the new element.
+  BTreeElement(BTreeElement&& other) noexcept;
+  BTreeElement& operator=(BTreeElement&& other) noexcept = delete;
+
+  // Returns a representative of the sequence that the element lives in.
+  //
+  // Two elements are in the same sequence if and only if their representatives
+  // are the same. Representatives are invalidated after the sequence is
+  // modified.
+  //
+  // Efficiency: logarithmic in the size of the element's sequence with base
+  // `detail::kBTreeMinFanout`.
+  const void* GetRepresentative() const;
+
+  // Get element immediately preceding this element in the sequence. Returns
+  // null if this element is the first element in the sequence.
+  //
+  // Efficiency: logarithmic in the size of the element's sequence.
+  BTreeElement* GetPredecessor() const;
+
+  // Concatenates the sequence containing `lesser` and the sequence containing
+  // `greater`. Does nothing if either is null.
+  //
+  // `lesser` and `greater` must not live in the same sequence and must share an
+  // arena.
+  //
+  // Efficiency: logarithmic in the sum of the sizes of `lesser` and `greater`'s
+  // sequences times `detail::kBTreeMaxFanout`.
+  static void Join(BTreeElement* lesser, BTreeElement* greater);
+
+  // Splits the sequence that this element lives in immediately after the
+  // element.
+  //
+  // After splitting, this element's sequence contains itself and all elements
+  // that were before this element, and the returned element's sequence contains
+  // all elements that were after the calling element.
+  //
+  // Returns what was formerly the successor of this element.
+  //
+  // Efficiency: logarithmic in the size of the element's sequence times
+  // `detail::kBTreeMaxFanout`.
+  BTreeElement* Split();
+
+  // Returns size of the sequence that the element lives in.
+  //
+  // Efficiency: logarithmic in the size of the element's sequence with base
+  // `detail::kBTreeMinFanout`.
+  int64_t GetSize() const;
+
+  // Mark (if `mark` is true) or unmark (if `mark` is false) the element at
+  // index `index`. See `FindMarkedElement`.
+  //
+  // Efficiency: logarithmic in the size of the element's sequence.
+  void Mark(int32_t index, bool mark);
+  // Return an element in the calling element's sequence that is marked at its
+  // `index`-th index if such an element exists.
+  //
+  // Efficiency: logarithmic in the size of the element's sequence.
+  std::optional<BTreeElement*> FindMarkedElement(int32_t index) const;
+  // Returns up to `max_elements` elements in the calling element's sequence
+  // that are marked at their `index`-th index, in sequence order.
+  //
+  // Efficiency: O(k log(n / k)) where n is the size of the element's
+  // sequence and k is the number of elements returned.
+  std::vector<BTreeElement*>
+  FindMarkedElements(int32_t index, int64_t max_elements) const;
+  // Same as `FindMarkedElements()`, but also unmarks the returned elements at
+  // index `index` in the same pass.
+  std::vector<BTreeElement*>
+  TakeMarkedElements(int32_t index, int64_t max_elements);
+
+  // Sets the value of this element.
+  //
+  // Efficiency: logarithmic in the size of the element's sequence times
+  // `detail::kBTreeMaxFanout`.
+  void SetValue(const Value& value);
+  // Returns the value of this element.
+  //
+  // Efficiency: constant.
+  const Value& GetValue() const;
+  // Returns the combination of the values of all elements in this element's
+  // sequence, in sequence order.
+  //
+  // Efficiency: logarithmic in the size of the element's sequence.
+  const Value& GetAggregate() const;
+  // Returns the combination of the values of this element and all elements
+  // before it in its sequence, in sequence order.
+  //
+  // Efficiency: logarithmic in the size of the element's sequence times
+  // `detail::kBTreeMaxFanout`.
+  Value GetPrefixAggregate() const;
+
+  // Returns the ids of the elements of the sequence in which this
+  // element lives.
+  std::vector<Id> SequenceIds() const;
+
+  // Copies the `num_elements` contiguous elements starting at `source`, along
+  // with the sequences they form, into the `num_elements` contiguous elements
+  // starting at `destination`.
+  //
+  // If `destination_indices` is not null, `source[i]` is instead copied to
+  // `destination[destination_indices[i]]`, or not at all if
+  // `destination_indices[i]` is negative. Uncopied elements must live in
+  // single-element sequences.
+  //
+  // Every element that shares a sequence with a source element must itself be
+  // a source element, and every destination element must live in a
+  // single-element sequence. The copied B-tree nodes are allocated from the
+  // arenas of the destination elements, which keep their arenas.
+  //
+  // Efficiency: linear in `num_elements`.
+  static void CopySequences(
+      const BTreeElement* source,
+      BTreeElement* destination,
+      int64_t num_elements,
+      const int64_t* destination_indices = nullptr);
+
+  // Returns the number of bytes of the B-tree nodes holding the sequences of
+  // the `num_elements` contiguous elements starting at `elements`. Every
+  // element that shares a sequence with one of these elements must itself be
+  // one of them.
+  //
+  // Efficiency: linear in `num_elements`.
+  static std::size_t GetNodeBytes(
+      const BTreeElement* elements, int64_t num_elements);
+
+  // Identifier for the element.
+  //
+  // This is specialized for storing Euler tour elements. The identifier can
+  // store what edge this element represents.
+  Id id_{-1, -1};
+
+ private:
+  typedef detail::BTreeNode<Monoid> Node;
+
+  static Node* NewNode(ArenaAllocator<Node> allocator, int32_t height);
+  static void DeleteNode(ArenaAllocator<Node> allocator, Node* node);
+  static BTreeElement* ChildElement(const Node* node, int32_t index);
+  static Node* ChildNode(const Node* node, int32_t index);
+  static void SetChild(Node* node, int32_t index, void* child);
+  static void InsertChild(Node* node, int32_t index, void* child);
+  static void MoveChildren(Node* source, int32_t begin, Node* destination);
+  static void PrependChildren(Node* source, Node* destination);
+  static void Rebalance(Node* left, Node* right);
+  static void UpdateNode(Node* node);
+  static void UpdateAncestors(Node* node);
+  static Node* GetRootOfNode(Node* node);
+  static Node* SplitOverfullNodes(Node* node, ArenaAllocator<Node> allocator);
+  static Node* JoinTrees(
+      Node* lesser, Node* greater, ArenaAllocator<Node> allocator);
+  static Node* CollapseRoot(Node* root, ArenaAllocator<Node> allocator);
+  static void ReleaseSingleElementRoot(
+      Node* root, ArenaAllocator<Node> allocator);
+  static Node* CloneTree(
+      const Node* node,
+      const BTreeElement* source,
+      BTreeElement* destination,
+      int64_t num_elements,
+      const int64_t* destination_indices,
+      ArenaAllocator<Node> allocator);
+  Node* GetRoot() const;
+  Node* GetOrMakeRoot();
+  BTreeElement* GetSuccessor() const;
+  void SequenceIds(const Node* node, std::vector<Id>* output) const;
+  static void CollectMarkedElements(
+      Node* node,
+      int32_t index,
+      bool unmark,
+      int64_t max_elements,
+      std::vector<BTreeElement*>* output);
+  std::vector<BTreeElement*> CollectMarkedElements(
+      int32_t index, bool unmark, int64_t max_elements) const;
+
+  // The height-0 node holding this element, or null if this element is in a
+  // single-element sequence.
+  Node* leaf_{nullptr};
+  // Allocates the B-tree nodes of the sequences this element's operations
+  // create.
+  ArenaAllocator<Node> allocator_;
+  // Index of this element among `leaf_`'s children.
+  int32_t index_{0};
+  std::array<bool, 2> marked_{{false, false}};
+  Value value_{Monoid::Identity()};
+};
+
+extern template class BTreeElement<NoAggregate>;
+
+}  // namespace sequence
+
+#include <btree_sequence_impl.hpp>
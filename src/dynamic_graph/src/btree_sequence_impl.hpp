@@ -0,0 +1,770 @@
+// Each sequence of several elements is stored in a B-tree in which all leaves
+// (height-0 nodes) have the same depth and the in-order traversal of the leaves'
+// children gives the sequence. Every node other than the root has between
+// `kBTreeMinFanout` and `kBTreeMaxFanout` children.
+//
+// Joining two trees hangs the shorter tree off of the spine of the taller tree
+// and splits overfull nodes on the way back up. Splitting a tree cuts each node
+// on the path from the leaf to the root into a left and a right piece and joins
+// the pieces back together. The costs of these joins telescope, so a split
+// costs about as much as a single join.
+//
+// This file holds the definitions of the templates declared in
+// <btree_sequence.hpp> and should only be included from there.
+#pragma once
+
+#include <btree_sequence.hpp>
+
+#include <algorithm>
+#include <new>
+
+#include <utilities/assert.hpp>
+
+namespace sequence {
+
+template <typename Monoid>
+BTreeElement<Monoid>::BTreeElement(
+    const std::pair<int64_t, int64_t>& id, MemoryArena* arena)
+  : id_{id}
+  , allocator_{arena} {}
+
+template <typename Monoid>
+BTreeElement<Monoid>::BTreeElement() {}
+
+template <typename Monoid>
+BTreeElement<Monoid>::~BTreeElement() {
+  // The other elements of the sequence are being destroyed too, so there's no
+  // need to keep the tree valid. Just free each node once its last child is
+  // gone.
+  Node* node{leaf_};
+  while (node != nullptr && --node->num_children == 0) {
+    Node* const parent{node->parent};
+    DeleteNode(allocator_, node);
+    node = parent;
+  }
+}
+
+template <typename Monoid>
+BTreeElement<Monoid>::BTreeElement(const BTreeElement& other)
+    : id_{other.id_}
+    , allocator_{other.allocator_}
+    , marked_{other.marked_}
+    , value_{other.value_} {
+  ASSERT_MSG_ALWAYS(
+      other.leaf_ == nullptr,
+      "Copied element cannot live in a sequence of multiple elements");
+}
+
+template <typename Monoid>
+BTreeElement<Monoid>::BTreeElement(BTreeElement&& other) noexcept
+    : id_{other.id_}
+    , leaf_{other.leaf_}
+    , allocator_{other.allocator_}
+    , index_{other.index_}
+    , marked_{other.marked_}
+    , value_{other.value_} {
+  if (leaf_ != nullptr) {
+    leaf_->children[index_] = this;
+    other.leaf_ = nullptr;
+  }
+}
+
+template <typename Monoid>
+typename BTreeElement<Monoid>::Node*
+BTreeElement<Monoid>::NewNode(ArenaAllocator<Node> allocator, int32_t height) {
+  Node* const node{new (allocator.allocate(1)) Node{}};
+  node->height = height;
+  return node;
+}
+
+template <typename Monoid>
+void BTreeElement<Monoid>::DeleteNode(
+    ArenaAllocator<Node> allocator, Node* node) {
+  node->~Node();
+  allocator.deallocate(node, 1);
+}
+
+template <typename Monoid>
+BTreeElement<Monoid>*
+BTreeElement<Monoid>::ChildElement(const Node* node, int32_t index) {
+  return static_cast<BTreeElement*>(node->children[index]);
+}
+
+template <typename Monoid>
+typename BTreeElement<Monoid>::Node*
+BTreeElement<Monoid>::ChildNode(const Node* node, int32_t index) {
+  return static_cast<Node*>(node->children[index]);
+}
+
+// Places `child` at index `index` among `node`'s children without changing the
+// number of children.
+template <typename Monoid>
+void BTreeElement<Monoid>::SetChild(Node* node, int32_t index, void* child) {
+  node->children[index] = child;
+  if (node->height == 0) {
+    BTreeElement* const element{static_cast<BTreeElement*>(child)};
+    element->leaf_ = node;
+    element->index_ = index;
+  } else {
+    Node* const child_node{static_cast<Node*>(child)};
+    child_node->parent = node;
+    child_node->index = index;
+  }
+}
+
+// Inserts `child` at index `index` among `node`'s children, shifting later
+// children over.
+template <typename Monoid>
+void BTreeElement<Monoid>::InsertChild(Node* node, int32_t index, void* child) {
+  ASSERT_MSG(
+      node->num_children <= detail::kBTreeMaxFanout,
+      "Inserting into overfull node");
+  for (int32_t i = node->num_children; i > index; i--) {
+    SetChild(node, i, node->children[i - 1]);
+  }
+  SetChild(node, index, child);
+  node->num_children++;
+}
+
+// Moves the children of `source` from index `begin` onwards to the end of
+// `destination`'s children.
+template <typename Monoid>
+void BTreeElement<Monoid>::MoveChildren(
+    Node* source, int32_t begin, Node* destination) {
+  for (int32_t i = begin; i < source->num_children; i++) {
+    SetChild(destination, destination->num_children++, source->children[i]);
+  }
+  source->num_children = std::min(source->num_children, begin);
+}
+
+// Moves all children of `source` to the front of `destination`'s children.
+template <typename Monoid>
+void BTreeElement<Monoid>::PrependChildren(Node* source, Node* destination) {
+  const int32_t shift{source->num_children};
+  for (int32_t i = destination->num_children - 1; i >= 0; i--) {
+    SetChild(destination, i + shift, destination->children[i]);
+  }
+  for (int32_t i = 0; i < shift; i++) {
+    SetChild(destination, i, source->children[i]);
+  }
+  destination->num_children += shift;
+  source->num_children = 0;
+}
+
+// Evens out the children of adjacent nodes `left` and `right`, which must
+// together have at least `2 * kBTreeMinFanout` children.
+template <typename Monoid>
+void BTreeElement<Monoid>::Rebalance(Node* left, Node* right) {
+  const int32_t total{left->num_children + right->num_children};
+  ASSERT_MSG(
+      total >= 2 * detail::kBTreeMinFanout,
+      "Too few children to rebalance");
+  std::array<void*, 2 * detail::kBTreeMaxFanout> children;
+  std::copy_n(left->children.begin(), left->num_children, children.begin());
+  std::copy_n(
+      right->children.begin(),
+      right->num_children,
+      children.begin() + left->num_children);
+  left->num_children = total / 2;
+  right->num_children = total - left->num_children;
+  for (int32_t i = 0; i < left->num_children; i++) {
+    SetChild(left, i, children[i]);
+  }
+  for (int32_t i = 0; i < right->num_children; i++) {
+    SetChild(right, i, children[left->num_children + i]);
+  }
+  UpdateNode(left);
+  UpdateNode(right);
+}
+
+// Recomputes the augmented data of `node` assuming that its children's data is
+// correct.
+template <typename Monoid>
+void BTreeElement<Monoid>::UpdateNode(Node* node) {
+  node->size = 0;
+  node->has_marked = {0, 0};
+  node->aggregate = Monoid::Identity();
+  for (int32_t i = 0; i < node->num_children; i++) {
+    const uint64_t bit{uint64_t{1} << i};
+    if (node->height == 0) {
+      const BTreeElement* const child{ChildElement(node, i)};
+      node->size++;
+      for (std::size_t j = 0; j < node->has_marked.size(); j++) {
+        if (child->marked_[j]) {
+          node->has_marked[j] |= bit;
+        }
+      }
+      node->aggregate = Monoid::Combine(node->aggregate, child->value_);
+    } else {
+      const Node* const child{ChildNode(node, i)};
+      node->size += child->size;
+      for (std::size_t j = 0; j < node->has_marked.size(); j++) {
+        if (child->has_marked[j] != 0) {
+          node->has_marked[j] |= bit;
+        }
+      }
+      node->aggregate = Monoid::Combine(node->aggregate, child->aggregate);
+    }
+  }
+}
+
+template <typename Monoid>
+void BTreeElement<Monoid>::UpdateAncestors(Node* node) {
+  for (; node != nullptr; node = node->parent) {
+    UpdateNode(node);
+  }
+}
+
+template <typename Monoid>
+typename BTreeElement<Monoid>::Node*
+BTreeElement<Monoid>::GetRootOfNode(Node* node) {
+  while (node->parent != nullptr) {
+    node = node->parent;
+  }
+  return node;
+}
+
+// Splits `node` and its ancestors while they have too many children, then
+// updates the augmented data of the remaining ancestors. Returns the root of
+// the tree.
+template <typename Monoid>
+typename BTreeElement<Monoid>::Node*
+BTreeElement<Monoid>::SplitOverfullNodes(
+    Node* node, ArenaAllocator<Node> allocator) {
+  while (node->num_children > detail::kBTreeMaxFanout) {
+    Node* const right{NewNode(allocator, node->height)};
+    MoveChildren(node, (node->num_children + 1) / 2, right);
+    UpdateNode(node);
+    UpdateNode(right);
+    Node* parent{node->parent};
+    if (parent == nullptr) {
+      parent = NewNode(allocator, node->height + 1);
+      InsertChild(parent, 0, node);
+    }
+    InsertChild(parent, node->index + 1, right);
+    node = parent;
+  }
+  UpdateAncestors(node);
+  return GetRootOfNode(node);
+}
+
+// Concatenates the trees rooted at `lesser` and `greater`, either of which may
+// be null, and returns the root of the result. The roots may have fewer than
+// `kBTreeMinFanout` children.
+template <typename Monoid>
+typename BTreeElement<Monoid>::Node*
+BTreeElement<Monoid>::JoinTrees(
+    Node* lesser, Node* greater, ArenaAllocator<Node> allocator) {
+  if (lesser == nullptr) {
+    return greater;
+  } else if (greater == nullptr) {
+    return lesser;
+  }
+
+  if (lesser->height == greater->height) {
+    if (lesser->num_children + greater->num_children
+        <= detail::kBTreeMaxFanout) {
+      MoveChildren(greater, 0, lesser);
+      DeleteNode(allocator, greater);
+      UpdateNode(lesser);
+      return lesser;
+    }
+    Rebalance(lesser, greater);
+    Node* const root{NewNode(allocator, lesser->height + 1)};
+    InsertChild(root, 0, lesser);
+    InsertChild(root, 1, greater);
+    UpdateNode(root);
+    return root;
+  } else if (lesser->height > greater->height) {
+    // Hang `greater` off of the right spine of `lesser`.
+    Node* parent{lesser};
+    while (parent->height > greater->height + 1) {
+      parent = ChildNode(parent, parent->num_children - 1);
+    }
+    Node* const sibling{ChildNode(parent, parent->num_children - 1)};
+    if (greater->num_children < detail::kBTreeMinFanout) {
+      if (sibling->num_children + greater->num_children
+          <= detail::kBTreeMaxFanout) {
+        MoveChildren(greater, 0, sibling);
+        DeleteNode(allocator, greater);
+        UpdateAncestors(sibling);
+        return lesser;
+      }
+      Rebalance(sibling, greater);
+    }
+    InsertChild(parent, parent->num_children, greater);
+    return SplitOverfullNodes(parent, allocator);
+  } else {
+    // Hang `lesser` off of the left spine of `greater`.
+    Node* parent{greater};
+    while (parent->height > lesser->height + 1) {
+      parent = ChildNode(parent, 0);
+    }
+    Node* const sibling{ChildNode(parent, 0)};
+    if (lesser->num_children < detail::kBTreeMinFanout) {
+      if (sibling->num_children + lesser->num_children
+          <= detail::kBTreeMaxFanout) {
+        PrependChildren(lesser, sibling);
+        DeleteNode(allocator, lesser);
+        UpdateAncestors(sibling);
+        return greater;
+      }
+      Rebalance(lesser, sibling);
+    }
+    InsertChild(parent, 0, lesser);
+    return SplitOverfullNodes(parent, allocator);
+  }
+}
+
+// Removes roots with a single node child from the tree rooted at `root` and
+// returns the new root. Frees `root` and returns null if it has no children.
+template <typename Monoid>
+typename BTreeElement<Monoid>::Node*
+BTreeElement<Monoid>::CollapseRoot(
+    Node* root, ArenaAllocator<Node> allocator) {
+  if (root == nullptr) {
+    return nullptr;
+  }
+  if (root->num_children == 0) {
+    DeleteNode(allocator, root);
+    return nullptr;
+  }
+  while (root->height > 0 && root->num_children == 1) {
+    Node* const child{ChildNode(root, 0)};
+    DeleteNode(allocator, root);
+    child->parent = nullptr;
+    child->index = 0;
+    root = child;
+  }
+  return root;
+}
+
+// Frees `root` if it is a leaf holding a single element so that the element
+// is left in a single-element sequence.
+template <typename Monoid>
+void BTreeElement<Monoid>::ReleaseSingleElementRoot(
+    Node* root, ArenaAllocator<Node> allocator) {
+  if (root != nullptr && root->height == 0 && root->num_children == 1) {
+    BTreeElement* const element{ChildElement(root, 0)};
+    element->leaf_ = nullptr;
+    element->index_ = 0;
+    DeleteNode(allocator, root);
+  }
+}
+
+template <typename Monoid>
+typename BTreeElement<Monoid>::Node* BTreeElement<Monoid>::GetRoot() const {
+  return leaf_ == nullptr ? nullptr : GetRootOfNode(leaf_);
+}
+
+// Returns the root of this element's tree, putting the element in a tree of
+// its own if it has none.
+template <typename Monoid>
+typename BTreeElement<Monoid>::Node* BTreeElement<Monoid>::GetOrMakeRoot() {
+  if (leaf_ != nullptr) {
+    return GetRootOfNode(leaf_);
+  }
+  Node* const leaf{NewNode(allocator_, 0)};
+  InsertChild(leaf, 0, this);
+  UpdateNode(leaf);
+  return leaf;
+}
+
+template <typename Monoid>
+const void* BTreeElement<Monoid>::GetRepresentative() const {
+  if (leaf_ == nullptr) {
+    return this;
+  }
+  return GetRootOfNode(leaf_);
+}
+
+template <typename Monoid>
+BTreeElement<Monoid>* BTreeElement<Monoid>::GetPredecessor() const {
+  if (leaf_ == nullptr) {
+    return nullptr;
+  }
+  if (index_ > 0) {
+    return ChildElement(leaf_, index_ - 1);
+  }
+  // The predecessor is the last element under the left sibling of the lowest
+  // ancestor that has one.
+  const Node* node{leaf_};
+  while (node->parent != nullptr && node->index == 0) {
+    node = node->parent;
+  }
+  if (node->parent == nullptr) {
+    return nullptr;
+  }
+  node = ChildNode(node->parent, node->index - 1);
+  while (node->height > 0) {
+    node = ChildNode(node, node->num_children - 1);
+  }
+  return ChildElement(node, node->num_children - 1);
+}
+
+template <typename Monoid>
+BTreeElement<Monoid>* BTreeElement<Monoid>::GetSuccessor() const {
+  if (leaf_ == nullptr) {
+    return nullptr;
+  }
+  if (index_ + 1 < leaf_->num_children) {
+    return ChildElement(leaf_, index_ + 1);
+  }
+  const Node* node{leaf_};
+  while (node->parent != nullptr
+      && node->index + 1 == node->parent->num_children) {
+    node = node->parent;
+  }
+  if (node->parent == nullptr) {
+    return nullptr;
+  }
+  node = ChildNode(node->parent, node->index + 1);
+  while (node->height > 0) {
+    node = ChildNode(node, 0);
+  }
+  return ChildElement(node, 0);
+}
+
+template <typename Monoid>
+void BTreeElement<Monoid>::Join(BTreeElement* lesser, BTreeElement* greater) {
+  if (lesser == nullptr || greater == nullptr) {
+    return;
+  }
+  ASSERT_MSG(
+      lesser->GetRepresentative() != greater->GetRepresentative(),
+      "Input nodes live in the same sequence");
+  ASSERT_MSG(
+      lesser->allocator_ == greater->allocator_,
+      "Input nodes allocate from different arenas");
+  JoinTrees(
+      lesser->GetOrMakeRoot(), greater->GetOrMakeRoot(), lesser->allocator_);
+}
+
+template <typename Monoid>
+BTreeElement<Monoid>* BTreeElement<Monoid>::Split() {
+  BTreeElement* const successor{GetSuccessor()};
+  if (successor == nullptr) {
+    return nullptr;
+  }
+
+  // Cut each node on the path to the root into the children before the path
+  // and the children after the path. At the leaf, this element itself goes
+  // before the cut.
+  Node* lesser{nullptr};
+  Node* greater{nullptr};
+  Node* node{leaf_};
+  int32_t lesser_end{index_ + 1};
+  int32_t greater_begin{index_ + 1};
+  while (node != nullptr) {
+    Node* const parent{node->parent};
+    const int32_t index_in_parent{node->index};
+    node->parent = nullptr;
+    node->index = 0;
+
+    Node* greater_piece{nullptr};
+    if (greater_begin < node->num_children) {
+      greater_piece = NewNode(allocator_, node->height);
+      MoveChildren(node, greater_begin, greater_piece);
+      UpdateNode(greater_piece);
+    }
+    node->num_children = lesser_end;
+    UpdateNode(node);
+
+    lesser = JoinTrees(CollapseRoot(node, allocator_), lesser, allocator_);
+    greater = JoinTrees(
+        greater, CollapseRoot(greater_piece, allocator_), allocator_);
+
+    node = parent;
+    lesser_end = index_in_parent;
+    greater_begin = index_in_parent + 1;
+  }
+  ReleaseSingleElementRoot(CollapseRoot(lesser, allocator_), allocator_);
+  ReleaseSingleElementRoot(CollapseRoot(greater, allocator_), allocator_);
+  return successor;
+}
+
+template <typename Monoid>
+int64_t BTreeElement<Monoid>::GetSize() const {
+  return leaf_ == nullptr ? 1 : GetRoot()->size;
+}
+
+template <typename Monoid>
+void BTreeElement<Monoid>::Mark(int32_t index, bool mark) {
+  marked_[index] = mark;
+  bool child_has_marked{mark};
+  int32_t child_index{index_};
+  for (Node* node = leaf_; node != nullptr; node = node->parent) {
+    const bool old_has_marked{node->has_marked[index] != 0};
+    const uint64_t bit{uint64_t{1} << child_index};
+    if (child_has_marked) {
+      node->has_marked[index] |= bit;
+    } else {
+      node->has_marked[index] &= ~bit;
+    }
+    child_has_marked = node->has_marked[index] != 0;
+    if (child_has_marked == old_has_marked) {
+      break;
+    }
+    child_index = node->index;
+  }
+}
+
+template <typename Monoid>
+std::optional<BTreeElement<Monoid>*>
+BTreeElement<Monoid>::FindMarkedElement(int32_t index) const {
+  if (leaf_ == nullptr) {
+    if (marked_[index]) {
+      return const_cast<BTreeElement*>(this);
+    }
+    return {};
+  }
+  const Node* node{GetRoot()};
+  if (node->has_marked[index] == 0) {
+    return {};
+  }
+  while (node->height > 0) {
+    node = ChildNode(node, __builtin_ctzll(node->has_marked[index]));
+  }
+  return ChildElement(node, __builtin_ctzll(node->has_marked[index]));
+}
+
+// Appends the elements in `node`'s subtree that are marked at index `index` to
+// `output` in order until `output` holds `max_elements` elements. Unmarks them
+// if `unmark` is true. Only descends into children holding marked elements.
+template <typename Monoid>
+void BTreeElement<Monoid>::CollectMarkedElements(
+    Node* node,
+    int32_t index,
+    bool unmark,
+    int64_t max_elements,
+    std::vector<BTreeElement*>* output) {
+  uint64_t children_to_visit{node->has_marked[index]};
+  while (children_to_visit != 0
+      && static_cast<int64_t>(output->size()) < max_elements) {
+    const int32_t i{__builtin_ctzll(children_to_visit)};
+    const uint64_t bit{uint64_t{1} << i};
+    children_to_visit &= ~bit;
+    bool child_has_marked{false};
+    if (node->height == 0) {
+      BTreeElement* const element{ChildElement(node, i)};
+      output->push_back(element);
+      element->marked_[index] = !unmark;
+      child_has_marked = !unmark;
+    } else {
+      Node* const child{ChildNode(node, i)};
+      CollectMarkedElements(child, index, unmark, max_elements, output);
+      child_has_marked = child->has_marked[index] != 0;
+    }
+    if (!child_has_marked) {
+      node->has_marked[index] &= ~bit;
+    }
+  }
+}
+
+template <typename Monoid>
+std::vector<BTreeElement<Monoid>*>
+BTreeElement<Monoid>::CollectMarkedElements(
+    int32_t index, bool unmark, int64_t max_elements) const {
+  std::vector<BTreeElement*> marked_elements;
+  if (max_elements <= 0) {
+    return marked_elements;
+  }
+  if (leaf_ == nullptr) {
+    if (marked_[index]) {
+      BTreeElement* const element{const_cast<BTreeElement*>(this)};
+      marked_elements.push_back(element);
+      element->marked_[index] = !unmark;
+    }
+    return marked_elements;
+  }
+  CollectMarkedElements(
+      GetRoot(), index, unmark, max_elements, &marked_elements);
+  return marked_elements;
+}
+
+template <typename Monoid>
+std::vector<BTreeElement<Monoid>*>
+BTreeElement<Monoid>::FindMarkedElements(
+    int32_t index, int64_t max_elements) const {
+  return CollectMarkedElements(index, false, max_elements);
+}
+
+template <typename Monoid>
+std::vector<BTreeElement<Monoid>*>
+BTreeElement<Monoid>::TakeMarkedElements(
+    int32_t index, int64_t max_elements) {
+  return CollectMarkedElements(index, true, max_elements);
+}
+
+template <typename Monoid>
+void BTreeElement<Monoid>::SetValue(const Value& value) {
+  value_ = value;
+  UpdateAncestors(leaf_);
+}
+
+template <typename Monoid>
+const typename BTreeElement<Monoid>::Value&
+BTreeElement<Monoid>::GetValue() const {
+  return value_;
+}
+
+template <typename Monoid>
+const typename BTreeElement<Monoid>::Value&
+BTreeElement<Monoid>::GetAggregate() const {
+  return leaf_ == nullptr ? value_ : GetRoot()->aggregate;
+}
+
+template <typename Monoid>
+typename BTreeElement<Monoid>::Value
+BTreeElement<Monoid>::GetPrefixAggregate() const {
+  if (leaf_ == nullptr) {
+    return value_;
+  }
+  Value aggregate{Monoid::Identity()};
+  for (int32_t i = 0; i <= index_; i++) {
+    aggregate = Monoid::Combine(aggregate, ChildElement(leaf_, i)->value_);
+  }
+  // Walking up, the left siblings of each ancestor precede this element.
+  for (const Node* node = leaf_; node->parent != nullptr; node = node->parent) {
+    Value siblings_aggregate{Monoid::Identity()};
+    for (int32_t i = 0; i < node->index; i++) {
+      siblings_aggregate = Monoid::Combine(
+          siblings_aggregate, ChildNode(node->parent, i)->aggregate);
+    }
+    aggregate = Monoid::Combine(siblings_aggregate, aggregate);
+  }
+  return aggregate;
+}
+
+// Returns a copy of the subtree rooted at `node` whose elements are the
+// elements that `node`'s elements are copied to, as described by
+// `CopySequences()`.
+template <typename Monoid>
+typename BTreeElement<Monoid>::Node* BTreeElement<Monoid>::CloneTree(
+    const Node* node,
+    const BTreeElement* source,
+    BTreeElement* destination,
+    int64_t num_elements,
+    const int64_t* destination_indices,
+    ArenaAllocator<Node> allocator) {
+  Node* const copy{NewNode(allocator, node->height)};
+  *copy = *node;
+  copy->parent = nullptr;
+  for (int32_t i = 0; i < node->num_children; i++) {
+    if (node->height == 0) {
+      const BTreeElement* const element{ChildElement(node, i)};
+      ASSERT_MSG(
+          source <= element && element < source + num_elements,
+          "Copied sequences contain elements outside of the copied range");
+      const int64_t index{
+        destination_indices == nullptr
+          ? element - source
+          : destination_indices[element - source]};
+      ASSERT_MSG(index >= 0, "Copied sequences contain uncopied elements");
+      SetChild(copy, i, destination + index);
+    } else {
+      SetChild(
+          copy,
+          i,
+          CloneTree(
+              ChildNode(node, i),
+              source,
+              destination,
+              num_elements,
+              destination_indices,
+              allocator));
+    }
+  }
+  return copy;
+}
+
+template <typename Monoid>
+void BTreeElement<Monoid>::CopySequences(
+    const BTreeElement* source,
+    BTreeElement* destination,
+    int64_t num_elements,
+    const int64_t* destination_indices) {
+  const auto get_destination_index{[&](int64_t i) {
+    return destination_indices == nullptr ? i : destination_indices[i];
+  }};
+  // This loop only checks the arguments, so it is compiled out along with the
+  // assertions in Release builds.
+#ifndef NDEBUG
+  for (int64_t i = 0; i < num_elements; i++) {
+    const int64_t destination_index{get_destination_index(i)};
+    ASSERT_MSG(
+        destination_index >= 0 || source[i].leaf_ == nullptr,
+        "Uncopied elements must live in single-element sequences");
+    ASSERT_MSG(
+        destination_index < 0
+          || destination[destination_index].leaf_ == nullptr,
+        "Copied sequences cannot overwrite a sequence of multiple elements");
+  }
+#endif  // ifndef NDEBUG
+  for (int64_t i = 0; i < num_elements; i++) {
+    const int64_t destination_index{get_destination_index(i)};
+    if (destination_index < 0) {
+      continue;
+    }
+    const BTreeElement& from{source[i]};
+    BTreeElement& to{destination[destination_index]};
+    to.id_ = from.id_;
+    to.marked_ = from.marked_;
+    to.value_ = from.value_;
+    // Copy each tree once, from its first element.
+    if (from.leaf_ != nullptr && from.GetPredecessor() == nullptr) {
+      CloneTree(
+          from.GetRoot(),
+          source,
+          destination,
+          num_elements,
+          destination_indices,
+          to.allocator_);
+    }
+  }
+}
+
+template <typename Monoid>
+std::size_t BTreeElement<Monoid>::GetNodeBytes(
+    const BTreeElement* elements, int64_t num_elements) {
+  // Count each node once, from the first element below it: walk up from each
+  // element that is the first child of its leaf for as long as the node
+  // reached is the first child of its parent.
+  int64_t num_nodes{0};
+  for (int64_t i = 0; i < num_elements; i++) {
+    if (elements[i].leaf_ == nullptr || elements[i].index_ != 0) {
+      continue;
+    }
+    num_nodes++;
+    for (const Node* node = elements[i].leaf_;
+         node->parent != nullptr && node->index == 0;
+         node = node->parent) {
+      num_nodes++;
+    }
+  }
+  return num_nodes * sizeof(Node);
+}
+
+template <typename Monoid>
+void BTreeElement<Monoid>::SequenceIds(
+    const Node* node, std::vector<Id>* output) const {
+  for (int32_t i = 0; i < node->num_children; i++) {
+    if (node->height == 0) {
+      output->push_back(ChildElement(node, i)->id_);
+    } else {
+      SequenceIds(ChildNode(node, i), output);
+    }
+  }
+}
+
+template <typename Monoid>
+std::vector<Id> BTreeElement<Monoid>::SequenceIds() const {
+  if (leaf_ == nullptr) {
+    return {id_};
+  }
+  std::vector<Id> output;
+  SequenceIds(GetRoot(), &output);
+  return output;
+}
+
+}  // namespace sequence
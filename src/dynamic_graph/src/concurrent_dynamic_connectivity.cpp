@@ -0,0 +1,38 @@
+#include <dynamic_graph/concurrent_dynamic_connectivity.hpp>
+
+namespace detail {
+
+namespace {
+
+// Returns the index of the read indicator counter that the calling thread
+// uses. Threads take counters round-robin.
+int32_t GetCounterIndex(int32_t num_counters) {
+  static std::atomic<int32_t> next_index{0};
+  thread_local const int32_t index{next_index.fetch_add(1) % num_counters};
+  return index;
+}
+
+}  // namespace
+
+ReadIndicator::ReadIndicator() {}
+
+void ReadIndicator::Arrive() {
+  counters_[GetCounterIndex(kNumCounters)].count.fetch_add(1);
+}
+
+void ReadIndicator::Depart() {
+  counters_[GetCounterIndex(kNumCounters)].count.fetch_sub(1);
+}
+
+bool ReadIndicator::IsEmpty() const {
+  for (const Counter& counter : counters_) {
+    if (counter.count.load() != 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
+}  // namespace detail
+
+template class BasicConcurrentDynamicConnectivity<NoAggregate>;
@@ -0,0 +1,144 @@
+// Each update goes through the following steps, where L is the graph readers
+// currently read and R is the other graph:
+// 1. Apply the update to R, which no reader is reading.
+// 2. Point new readers at R.
+// 3. Wait for readers that may still be reading L to finish. Readers announce
+//    themselves in the read indicator for the current version, so the writer
+//    switches versions and waits for both read indicators to drain in turn.
+// 4. Apply the update to L, which no reader is reading any more.
+//
+// This file holds the definitions of the templates declared in
+// <dynamic_graph/concurrent_dynamic_connectivity.hpp> and should only be
+// included from there.
+#pragma once
+
+#include <dynamic_graph/concurrent_dynamic_connectivity.hpp>
+
+#include <thread>
+
+template <typename Monoid>
+BasicConcurrentDynamicConnectivity<Monoid>::BasicConcurrentDynamicConnectivity(
+    int64_t num_vertices)
+    : graphs_{{Graph{num_vertices}, Graph{num_vertices}}} {}
+
+template <typename Monoid>
+BasicConcurrentDynamicConnectivity<Monoid>::
+~BasicConcurrentDynamicConnectivity() {}
+
+// Runs `query` on the graph that readers currently read and returns its
+// result.
+template <typename Monoid>
+template <typename Query>
+auto BasicConcurrentDynamicConnectivity<Monoid>::Read(Query query) const {
+  detail::ReadIndicator& read_indicator{
+    read_indicators_[version_index_.load()]};
+  read_indicator.Arrive();
+  const auto result{query(graphs_[read_index_.load()])};
+  read_indicator.Depart();
+  return result;
+}
+
+// Runs `update` on both graphs.
+template <typename Monoid>
+template <typename Update>
+void BasicConcurrentDynamicConnectivity<Monoid>::Write(Update update) {
+  const std::lock_guard<std::mutex> lock{writer_mutex_};
+  const int32_t read_index{read_index_.load()};
+  update(&graphs_[1 - read_index]);
+  read_index_.store(1 - read_index);
+
+  const int32_t version_index{version_index_.load()};
+  while (!read_indicators_[1 - version_index].IsEmpty()) {
+    std::this_thread::yield();
+  }
+  version_index_.store(1 - version_index);
+  while (!read_indicators_[version_index].IsEmpty()) {
+    std::this_thread::yield();
+  }
+
+  update(&graphs_[read_index]);
+}
+
+template <typename Monoid>
+bool BasicConcurrentDynamicConnectivity<Monoid>::IsConnected(
+    Vertex u, Vertex v) const {
+  return Read([&](const Graph& graph) { return graph.IsConnected(u, v); });
+}
+
+template <typename Monoid>
+bool BasicConcurrentDynamicConnectivity<Monoid>::HasEdge(
+    const UndirectedEdge& edge) const {
+  return Read([&](const Graph& graph) { return graph.HasEdge(edge); });
+}
+
+template <typename Monoid>
+int64_t BasicConcurrentDynamicConnectivity<Monoid>::GetSizeOfConnectedComponent(
+    Vertex v) const {
+  return Read([&](const Graph& graph) {
+    return graph.GetSizeOfConnectedComponent(v);
+  });
+}
+
+template <typename Monoid>
+int64_t
+BasicConcurrentDynamicConnectivity<Monoid>::GetNumberOfConnectedComponents()
+    const {
+  return Read([](const Graph& graph) {
+    return graph.GetNumberOfConnectedComponents();
+  });
+}
+
+template <typename Monoid>
+typename BasicConcurrentDynamicConnectivity<Monoid>::Value
+BasicConcurrentDynamicConnectivity<Monoid>::GetVertexValue(Vertex v) const {
+  return Read([&](const Graph& graph) { return graph.GetVertexValue(v); });
+}
+
+template <typename Monoid>
+typename BasicConcurrentDynamicConnectivity<Monoid>::Value
+BasicConcurrentDynamicConnectivity<Monoid>::GetComponentAggregate(
+    Vertex v) const {
+  return Read([&](const Graph& graph) {
+    return graph.GetComponentAggregate(v);
+  });
+}
+
+template <typename Monoid>
+bool BasicConcurrentDynamicConnectivity<Monoid>::IsBridge(
+    const UndirectedEdge& edge) const {
+  return Read([&](const Graph& graph) { return graph.IsBridge(edge); });
+}
+
+template <typename Monoid>
+bool BasicConcurrentDynamicConnectivity<Monoid>::Is2EdgeConnected(
+    Vertex u, Vertex v) const {
+  return Read([&](const Graph& graph) {
+    return graph.Is2EdgeConnected(u, v);
+  });
+}
+
+template <typename Monoid>
+void BasicConcurrentDynamicConnectivity<Monoid>::AddEdge(
+    const UndirectedEdge& edge) {
+  Write([&](Graph* graph) { graph->AddEdge(edge); });
+}
+
+template <typename Monoid>
+void BasicConcurrentDynamicConnectivity<Monoid>::DeleteEdge(
+    const UndirectedEdge& edge) {
+  Write([&](Graph* graph) { graph->DeleteEdge(edge); });
+}
+
+template <typename Monoid>
+void BasicConcurrentDynamicConnectivity<Monoid>::SetVertexValue(
+    Vertex v, const Value& value) {
+  Write([&](Graph* graph) { graph->SetVertexValue(v, value); });
+}
+
+template <typename Monoid>
+void BasicConcurrentDynamicConnectivity<Monoid>::SetTwoEdgeConnectivityTracking(
+    bool is_tracked) {
+  Write([&](Graph* graph) {
+    graph->SetTwoEdgeConnectivityTracking(is_tracked);
+  });
+}
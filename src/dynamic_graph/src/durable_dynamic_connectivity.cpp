@@ -0,0 +1,348 @@
+// Files in the directory:
+//   snapshot: the graph as of the start of generation g. It holds a header of
+//     four 64-bit words (magic number, number of vertices, g, number of
+//     edges), then three words per edge (its endpoints and its level ORed with
+//     0x100 if it is a tree edge), then a checksum of everything before it.
+//     It is written to snapshot.tmp and renamed into place, so it is never
+//     seen half-written.
+//   log.<g>: the updates made in generation g, in batches. Each batch is a
+//     header of two 64-bit words (number of updates and their checksum)
+//     followed by the encoded updates.
+// Saving a snapshot starts generation g + 1 and deletes log.<g>. A crash
+// between the two leaves log.<g> behind, which recovery deletes.
+//
+// All integers are little-endian, like the encoding of operation.hpp.
+#include <dynamic_graph/durable_dynamic_connectivity.hpp>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <optional>
+#include <unordered_map>
+
+#include <utilities/assert.hpp>
+#include <utilities/hash.hpp>
+
+namespace {
+
+constexpr uint64_t kSnapshotMagic{0x3130'5041'4E53'4744};  // "DGSNAP01"
+constexpr std::size_t kSnapshotHeaderSize{4 * sizeof(int64_t)};
+constexpr std::size_t kSnapshotEdgeSize{3 * sizeof(int64_t)};
+constexpr std::size_t kBatchHeaderSize{2 * sizeof(uint64_t)};
+constexpr int64_t kTreeEdgeFlag{0x100};
+
+int64_t ReadWord(const char* in) {
+  int64_t word;
+  std::memcpy(&word, in, sizeof(word));
+  return word;
+}
+
+void AppendWord(int64_t word, std::vector<char>* out) {
+  const char* const bytes{reinterpret_cast<const char*>(&word)};
+  out->insert(out->end(), bytes, bytes + sizeof(word));
+}
+
+// Checksum of `size` bytes, where `size` is a multiple of 8.
+uint64_t Checksum(const char* data, std::size_t size) {
+  std::size_t checksum{0};
+  for (std::size_t i = 0; i < size; i += sizeof(int64_t)) {
+    checksum = CombineHashes(checksum, Hash(ReadWord(data + i)));
+  }
+  return checksum;
+}
+
+// Returns the contents of the file at `path`, or nothing if it does not exist.
+std::optional<std::vector<char>> ReadFile(const std::string& path) {
+  const int file_descriptor{open(path.c_str(), O_RDONLY)};
+  if (file_descriptor == -1) {
+    ASSERT_MSG_ALWAYS(errno == ENOENT, "Failed to open " << path);
+    return std::nullopt;
+  }
+  std::vector<char> contents;
+  char chunk[1 << 16];
+  while (true) {
+    const ssize_t num_read{read(file_descriptor, chunk, sizeof(chunk))};
+    ASSERT_MSG_ALWAYS(num_read >= 0, "Failed to read " << path);
+    if (num_read == 0) {
+      break;
+    }
+    contents.insert(contents.end(), chunk, chunk + num_read);
+  }
+  close(file_descriptor);
+  return contents;
+}
+
+void WriteAll(int file_descriptor, const char* data, std::size_t size) {
+  while (size > 0) {
+    const ssize_t num_written{write(file_descriptor, data, size)};
+    ASSERT_MSG_ALWAYS(num_written >= 0, "Failed to write to the log");
+    data += num_written;
+    size -= num_written;
+  }
+}
+
+// Syncs a directory so that renames and deletions in it are durable.
+void SyncDirectory(const std::string& directory) {
+  const int file_descriptor{open(directory.c_str(), O_RDONLY | O_DIRECTORY)};
+  ASSERT_MSG_ALWAYS(file_descriptor != -1, "Failed to open " << directory);
+  const int sync_result{fsync(file_descriptor)};
+  ASSERT_MSG_ALWAYS(sync_result == 0, "Failed to sync " << directory);
+  close(file_descriptor);
+}
+
+}  // namespace
+
+DurableDynamicConnectivity::DurableDynamicConnectivity(
+    int64_t num_vertices,
+    const std::string& directory,
+    int64_t batch_size,
+    SyncPolicy sync_policy,
+    int64_t snapshot_interval)
+    : num_vertices_{num_vertices}
+    , directory_{directory}
+    , batch_size_{batch_size}
+    , sync_policy_{sync_policy}
+    , snapshot_interval_{snapshot_interval}
+    , graph_{num_vertices} {
+  ASSERT_MSG_ALWAYS(batch_size_ > 0, "The batch size must be positive");
+  LoadSnapshot();
+  ReplayLog();
+  OpenLog();
+  buffer_.resize(kBatchHeaderSize);
+  buffer_.reserve(kBatchHeaderSize + batch_size_ * kEncodedOperationSize);
+}
+
+DurableDynamicConnectivity::~DurableDynamicConnectivity() {
+  Flush();
+  close(log_file_descriptor_);
+}
+
+// Restores the graph from the snapshot, if there is one, and sets
+// `generation_` to the generation that the snapshot starts.
+void DurableDynamicConnectivity::LoadSnapshot() {
+  const std::optional<std::vector<char>> snapshot{
+    ReadFile(directory_ + "/snapshot")};
+  if (!snapshot.has_value()) {
+    return;
+  }
+  const char* const data{snapshot->data()};
+  ASSERT_MSG_ALWAYS(
+      snapshot->size() >= kSnapshotHeaderSize + sizeof(uint64_t)
+        && static_cast<uint64_t>(ReadWord(data)) == kSnapshotMagic,
+      "The snapshot in " << directory_ << " is not a snapshot");
+  const std::size_t checksum_offset{snapshot->size() - sizeof(uint64_t)};
+  ASSERT_MSG_ALWAYS(
+      static_cast<uint64_t>(ReadWord(data + checksum_offset))
+        == Checksum(data, checksum_offset),
+      "The snapshot in " << directory_ << " is corrupt");
+  ASSERT_MSG_ALWAYS(
+      ReadWord(data + 8) == num_vertices_,
+      "The snapshot in " << directory_ << " has " << ReadWord(data + 8)
+        << " vertices, not " << num_vertices_);
+  generation_ = ReadWord(data + 16);
+  const int64_t num_edges{ReadWord(data + 24)};
+  ASSERT_MSG_ALWAYS(
+      checksum_offset == kSnapshotHeaderSize + num_edges * kSnapshotEdgeSize,
+      "The snapshot in " << directory_ << " has the wrong size");
+  for (int64_t i = 0; i < num_edges; i++) {
+    const char* const edge_data{
+      data + kSnapshotHeaderSize + i * kSnapshotEdgeSize};
+    const int64_t level_and_type{ReadWord(edge_data + 16)};
+    graph_.RestoreEdge(
+        {ReadWord(edge_data), ReadWord(edge_data + 8)},
+        static_cast<int8_t>(level_and_type & 0xff),
+        (level_and_type & kTreeEdgeFlag) != 0);
+  }
+}
+
+// Applies the updates in the log of the current generation and cuts off a
+// batch torn by a crash, if any.
+void DurableDynamicConnectivity::ReplayLog() {
+  // The snapshot of `generation_` was saved, so the previous log is stale.
+  if (generation_ > 0) {
+    unlink((directory_ + "/log." + std::to_string(generation_ - 1)).c_str());
+  }
+
+  const std::string path{directory_ + "/log." + std::to_string(generation_)};
+  const std::optional<std::vector<char>> log{ReadFile(path)};
+  if (!log.has_value()) {
+    return;
+  }
+  // Only the last update to each edge matters.
+  std::unordered_map<UndirectedEdge, bool, UndirectedEdgeHash> final_states;
+  std::size_t offset{0};
+  while (offset + kBatchHeaderSize <= log->size()) {
+    const char* const header{log->data() + offset};
+    const int64_t num_updates{ReadWord(header)};
+    const std::size_t max_num_updates{
+      (log->size() - offset - kBatchHeaderSize) / kEncodedOperationSize};
+    if (num_updates <= 0
+        || static_cast<std::size_t>(num_updates) > max_num_updates) {
+      break;
+    }
+    const std::size_t batch_size{num_updates * kEncodedOperationSize};
+    const char* const updates{header + kBatchHeaderSize};
+    if (static_cast<uint64_t>(ReadWord(header + 8))
+        != Checksum(updates, batch_size)) {
+      break;
+    }
+    for (int64_t i = 0; i < num_updates; i++) {
+      const std::optional<Operation> operation{
+        DecodeOperation(updates + i * kEncodedOperationSize)};
+      ASSERT_MSG_ALWAYS(
+          operation.has_value()
+            && operation->type != Operation::Type::kIsConnected,
+          "The log in " << directory_ << " holds an invalid update");
+      final_states.insert_or_assign(
+          operation->edge, operation->type == Operation::Type::kAddEdge);
+    }
+    num_logged_updates_ += num_updates;
+    offset += kBatchHeaderSize + batch_size;
+  }
+  if (offset < log->size()) {
+    const int truncate_result{truncate(path.c_str(), offset)};
+    ASSERT_MSG_ALWAYS(truncate_result == 0, "Failed to truncate " << path);
+  }
+
+  std::vector<UndirectedEdge> deletions;
+  std::vector<UndirectedEdge> additions;
+  for (const auto& [edge, should_have_edge] : final_states) {
+    if (graph_.HasEdge(edge) != should_have_edge) {
+      (should_have_edge ? additions : deletions).emplace_back(edge);
+    }
+  }
+  // Deleting first keeps the graph smaller while inserting.
+  for (const UndirectedEdge& edge : deletions) {
+    graph_.DeleteEdge(edge);
+  }
+  for (const UndirectedEdge& edge : additions) {
+    graph_.AddEdge(edge);
+  }
+}
+
+// Opens the log of the current generation for appending, creating it if
+// needed.
+void DurableDynamicConnectivity::OpenLog() {
+  const std::string path{directory_ + "/log." + std::to_string(generation_)};
+  log_file_descriptor_ = open(
+      path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+  ASSERT_MSG_ALWAYS(log_file_descriptor_ != -1, "Failed to open " << path);
+  is_log_entry_synced_ = false;
+}
+
+bool DurableDynamicConnectivity::IsConnected(Vertex u, Vertex v) const {
+  return graph_.IsConnected(u, v);
+}
+
+bool DurableDynamicConnectivity::HasEdge(const UndirectedEdge& edge) const {
+  return graph_.HasEdge(edge);
+}
+
+int64_t DurableDynamicConnectivity::GetSizeOfConnectedComponent(
+    Vertex v) const {
+  return graph_.GetSizeOfConnectedComponent(v);
+}
+
+int64_t DurableDynamicConnectivity::GetNumberOfConnectedComponents() const {
+  return graph_.GetNumberOfConnectedComponents();
+}
+
+void DurableDynamicConnectivity::AddEdge(const UndirectedEdge& edge) {
+  // Update the graph first so that invalid updates fail before being logged.
+  graph_.AddEdge(edge);
+  LogUpdate(Operation::Type::kAddEdge, edge);
+}
+
+void DurableDynamicConnectivity::DeleteEdge(const UndirectedEdge& edge) {
+  graph_.DeleteEdge(edge);
+  LogUpdate(Operation::Type::kDeleteEdge, edge);
+}
+
+void DurableDynamicConnectivity::LogUpdate(
+    Operation::Type type, const UndirectedEdge& edge) {
+  const std::size_t offset{buffer_.size()};
+  buffer_.resize(offset + kEncodedOperationSize);
+  EncodeOperation({type, edge}, buffer_.data() + offset);
+  num_buffered_updates_++;
+  num_logged_updates_++;
+  if (snapshot_interval_ > 0 && num_logged_updates_ >= snapshot_interval_) {
+    SaveSnapshot();
+  } else if (num_buffered_updates_ >= batch_size_) {
+    Flush();
+  }
+}
+
+void DurableDynamicConnectivity::Flush() {
+  if (num_buffered_updates_ == 0) {
+    return;
+  }
+  char* const header{buffer_.data()};
+  const int64_t checksum{static_cast<int64_t>(Checksum(
+      header + kBatchHeaderSize, buffer_.size() - kBatchHeaderSize))};
+  std::memcpy(header, &num_buffered_updates_, sizeof(int64_t));
+  std::memcpy(header + 8, &checksum, sizeof(int64_t));
+  WriteAll(log_file_descriptor_, buffer_.data(), buffer_.size());
+  if (sync_policy_ == SyncPolicy::kEveryBatch) {
+    const int sync_result{fdatasync(log_file_descriptor_)};
+    ASSERT_MSG_ALWAYS(sync_result == 0, "Failed to sync the log");
+    // The log may have just been created, and a crash would lose it unless
+    // its directory entry is durable too.
+    if (!is_log_entry_synced_) {
+      SyncDirectory(directory_);
+      is_log_entry_synced_ = true;
+    }
+  }
+  buffer_.resize(kBatchHeaderSize);
+  num_buffered_updates_ = 0;
+}
+
+void DurableDynamicConnectivity::SaveSnapshot() {
+  // The buffered updates are already in the graph, so they go into the
+  // snapshot rather than the log.
+  buffer_.resize(kBatchHeaderSize);
+  num_buffered_updates_ = 0;
+
+  std::vector<char> snapshot;
+  AppendWord(static_cast<int64_t>(kSnapshotMagic), &snapshot);
+  AppendWord(num_vertices_, &snapshot);
+  AppendWord(generation_ + 1, &snapshot);
+  const std::size_t num_edges_offset{snapshot.size()};
+  AppendWord(0, &snapshot);
+  int64_t num_edges{0};
+  graph_.ForEachEdgeWithLevel(
+      [&](const UndirectedEdge& edge, int8_t level, bool is_tree_edge) {
+        AppendWord(edge.first, &snapshot);
+        AppendWord(edge.second, &snapshot);
+        AppendWord(level | (is_tree_edge ? kTreeEdgeFlag : 0), &snapshot);
+        num_edges++;
+      });
+  std::memcpy(snapshot.data() + num_edges_offset, &num_edges, sizeof(int64_t));
+  AppendWord(
+      static_cast<int64_t>(Checksum(snapshot.data(), snapshot.size())),
+      &snapshot);
+
+  const std::string temporary_path{directory_ + "/snapshot.tmp"};
+  const int file_descriptor{open(
+      temporary_path.c_str(),
+      O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC,
+      0644)};
+  ASSERT_MSG_ALWAYS(
+      file_descriptor != -1, "Failed to open " << temporary_path);
+  WriteAll(file_descriptor, snapshot.data(), snapshot.size());
+  const int sync_result{fsync(file_descriptor)};
+  ASSERT_MSG_ALWAYS(sync_result == 0, "Failed to sync " << temporary_path);
+  close(file_descriptor);
+  const int rename_result{
+    rename(temporary_path.c_str(), (directory_ + "/snapshot").c_str())};
+  ASSERT_MSG_ALWAYS(rename_result == 0, "Failed to rename " << temporary_path);
+  SyncDirectory(directory_);
+
+  close(log_file_descriptor_);
+  unlink((directory_ + "/log." + std::to_string(generation_)).c_str());
+  generation_++;
+  num_logged_updates_ = 0;
+  OpenLog();
+}
@@ -0,0 +1,1280 @@
+// This is implemented using the data structure described in the following
+// paper:
+//   Jacob Holm, Kristian de Lichtenberg, and Mikkel Thorup. "Poly-logarithmic
+//   deterministic fully-dynamic algorithms for connectivity, minimum spanning
+//   tree, 2-edge, and biconnectivity." Journal of the ACM, 48(4):723–760, 2001.
+//
+// The data structure takes several subgraphs of the represented graph, each
+// subgraph having fewer and fewer edges. It maintains a spanning forest on each
+// subgraph. Edge insertions and connectivity queries are handled by looking at
+// the spanning forest on the whole graph. For edge deletions, the difficult
+// part comes if we delete an edge in the spanning forest for the whole graph.
+// Then we have to determine whether there is a replacement edge that can
+// reconnect the spanning forest. We look at the edges in the subgraphs,
+// amortizing the cost of looking at an edge in a subgraph by moving it into
+// another subgraph and making sure that no edge can be moved too many times.
+//
+// The comments in the file won't make much sense without reading the
+// description of the data structure in the above paper.
+//
+// ---
+//
+// Some implementation details:
+//
+// F_0 is stored in `spanning_forest_`, and F_i for i > 0 is stored in
+// `upper_spanning_forests_[i - 1]`. Only F_0 carries the per-vertex values.
+// F_0 also carries random cut labels for answering `IsBridge()` when 2-edge
+// connectivity is not tracked, as in the following paper:
+//   Bruce M. Kapron, Valerie King, and Ben Mountjoy. "Dynamic graph
+//   connectivity in polylogarithmic worst case time." SODA 2013.
+// `Is2EdgeConnected()`, and `IsBridge()` when tracking is on, are answered by a
+// separate `TwoEdgeConnectivity`, which implements the 2-edge connectivity
+// structure of the first paper, since cut labels can't tell whether any edge
+// on a path is a bridge.
+// We use `DynamicForest::void MarkEdge()` to mark level-i tree edges in F_i.
+// We use `DynamicForest::void MarkVertex()` to mark vertices in F_i that are
+// incident to level-i non-tree edges.
+//
+// TODO(tomtseng): Two practical optimizations are in Iyer et al.'s paper "An
+// Experimental Study of Polylogarithmic, Fully Dynamic, Connectivity
+// Algorithms".
+// 1. If a tree edge is deleted, it's costly to push all the tree edges to the
+// next level. So before doing that, randomly look at O(log n) incident edges
+// and quit early if we find a replacement edge.
+// 2. Once we get to high levels, the subgraphs and corresponding spanning
+// forests are small. It's not worth it to do anything sophisticated at that
+// point -- brute force search instead.
+//
+// ---
+//
+// This file holds the definitions of the templates declared in
+// <dynamic_graph/dynamic_connectivity.hpp> and should only be included from
+// there.
+#pragma once
+
+#include <dynamic_graph/dynamic_connectivity.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <random>
+#include <utility>
+
+#include <utilities/assert.hpp>
+
+namespace detail {
+
+// A search for a replacement edge only uses several threads if it has at least
+// this many candidate edges per thread. Threads claim candidates in blocks of
+// `kSearchBlockSize`.
+constexpr std::size_t kMinCandidatesPerSearchThread{1024};
+constexpr std::size_t kSearchBlockSize{256};
+
+// Returns floor(log_2(x)) for x > 0.
+inline int8_t FloorLog2(int64_t x) {
+  int8_t a{0};
+  while (x > 1) {
+    x >>= 1;
+    a++;
+  }
+  return a;
+}
+
+// Returns a generator for cut labels seeded with 256 bits from
+// `std::random_device`.
+inline std::mt19937_64 MakeCutLabelGenerator() {
+  std::random_device random_device;
+  std::seed_seq seed{
+    random_device(), random_device(), random_device(), random_device(),
+    random_device(), random_device(), random_device(), random_device()};
+  return std::mt19937_64{seed};
+}
+
+}  // namespace detail
+
+template <typename Monoid>
+BasicDynamicConnectivity<Monoid>::BasicDynamicConnectivity(
+    int64_t num_vertices,
+    std::shared_ptr<MemoryArena> arena,
+    std::shared_ptr<MemoryArena> upper_level_arena)
+    : arena_{std::move(arena)}
+    , upper_level_arena_{
+        upper_level_arena != nullptr ? std::move(upper_level_arena) : arena_}
+    , num_vertices_{num_vertices}
+    , cut_label_generator_{detail::MakeCutLabelGenerator()}
+    , spanning_forest_{num_vertices, arena_.get()}
+    , component_size_histogram_(detail::FloorLog2(num_vertices) + 1, 0)
+    , edges_(
+        0,
+        UndirectedEdgeHash{},
+        std::equal_to<UndirectedEdge>{},
+        arena_.get())
+    , undo_log_(arena_.get()) {
+  ASSERT_MSG_ALWAYS(
+      num_vertices_ > 0,
+      "The number of vertices must be positive");
+  // The upper levels are added as edges get promoted to them.
+  AddLevelsUpTo(0);
+  CountComponent(1, num_vertices_);
+}
+
+// Makes sure that F_`level` and the level-`level` adjacency lists exist.
+//
+// Levels above 0 are only allocated once an edge reaches them. Graphs that see
+// few deletions never reach the upper levels, which saves the memory of
+// FloorLog2(n) forests for small graphs.
+template <typename Monoid>
+void BasicDynamicConnectivity<Monoid>::AddLevelsUpTo(detail::Level level) {
+  ASSERT_MSG(
+      level <= detail::FloorLog2(num_vertices_),
+      "Level " << static_cast<int32_t>(level) << " is too high");
+  while (static_cast<int64_t>(non_tree_adjacency_lists_.size()) <= level) {
+    MemoryArena* const arena{
+      non_tree_adjacency_lists_.empty()
+        ? arena_.get()
+        : upper_level_arena_.get()};
+    if (!non_tree_adjacency_lists_.empty()) {
+      upper_spanning_forests_.emplace_back(num_vertices_, arena);
+    }
+    non_tree_adjacency_lists_.emplace_back(
+        static_cast<std::size_t>(num_vertices_),
+        detail::AdjacencyList(
+            0, std::hash<Vertex>{}, std::equal_to<Vertex>{}, arena),
+        arena);
+  }
+}
+
+// Returns true if F_`level` has been allocated. Every vertex is alone in its
+// tree on a level that has not been allocated.
+template <typename Monoid>
+bool BasicDynamicConnectivity<Monoid>::HasLevel(detail::Level level) const {
+  return static_cast<int64_t>(non_tree_adjacency_lists_.size()) > level;
+}
+
+template <typename Monoid>
+BasicDynamicConnectivity<Monoid>::~BasicDynamicConnectivity() {}
+
+template <typename Monoid>
+BasicDynamicConnectivity<Monoid>::BasicDynamicConnectivity(
+    const BasicDynamicConnectivity& other)
+    : arena_{other.arena_}
+    , upper_level_arena_{other.upper_level_arena_}
+    , num_vertices_{other.num_vertices_}
+    , cut_label_generator_{other.cut_label_generator_}
+    , spanning_forest_{other.spanning_forest_}
+    , upper_spanning_forests_{other.upper_spanning_forests_}
+    , two_edge_connectivity_{
+        other.two_edge_connectivity_ == nullptr
+          ? nullptr
+          : std::make_unique<TwoEdgeConnectivity>(
+              *other.two_edge_connectivity_)}
+    , component_size_counts_{other.component_size_counts_}
+    , component_size_histogram_{other.component_size_histogram_}
+    , non_tree_adjacency_lists_{other.non_tree_adjacency_lists_}
+    , edges_{other.edges_}
+    , undo_log_{other.undo_log_}
+    , checkpoints_{other.checkpoints_}
+    , max_promotions_per_update_{other.max_promotions_per_update_}
+    , deferred_promotions_{other.deferred_promotions_}
+    , num_search_threads_{other.num_search_threads_}
+    , search_thread_pool_{
+        other.search_thread_pool_ == nullptr
+          ? nullptr
+          : std::make_unique<ThreadPool>(
+              other.search_thread_pool_->GetNumberOfWorkers())}
+    , compaction_threshold_{other.compaction_threshold_} {}
+
+template <typename Monoid>
+BasicDynamicConnectivity<Monoid>::BasicDynamicConnectivity(
+    BasicDynamicConnectivity&& other) noexcept
+    : arena_{other.arena_}
+    , upper_level_arena_{other.upper_level_arena_}
+    , num_vertices_{other.num_vertices_}
+    , cut_label_generator_{other.cut_label_generator_}
+    , spanning_forest_{std::move(other.spanning_forest_)}
+    , upper_spanning_forests_{std::move(other.upper_spanning_forests_)}
+    , two_edge_connectivity_{std::move(other.two_edge_connectivity_)}
+    , component_size_counts_{std::move(other.component_size_counts_)}
+    , component_size_histogram_{std::move(other.component_size_histogram_)}
+    , non_tree_adjacency_lists_{std::move(other.non_tree_adjacency_lists_)}
+    , edges_{std::move(other.edges_)}
+    , undo_log_{std::move(other.undo_log_)}
+    , checkpoints_{std::move(other.checkpoints_)}
+    , max_promotions_per_update_{other.max_promotions_per_update_}
+    , deferred_promotions_{std::move(other.deferred_promotions_)}
+    , num_search_threads_{other.num_search_threads_}
+    , search_thread_pool_{std::move(other.search_thread_pool_)}
+    , compaction_threshold_{other.compaction_threshold_}
+    , component_subscribers_{std::move(other.component_subscribers_)}
+    , next_subscription_{other.next_subscription_} {}
+
+template <typename Monoid>
+bool BasicDynamicConnectivity<Monoid>::IsConnected(Vertex u, Vertex v) const {
+  return spanning_forest_.IsConnected(u, v);
+}
+
+template <typename Monoid>
+bool BasicDynamicConnectivity<Monoid>::HasEdge(
+    const UndirectedEdge& edge) const {
+  return edges_.find(edge) != edges_.end();
+}
+
+template <typename Monoid>
+int64_t
+BasicDynamicConnectivity<Monoid>::GetSizeOfConnectedComponent(Vertex v) const {
+  return spanning_forest_.GetSizeOfTree(v);
+}
+
+template <typename Monoid>
+int64_t BasicDynamicConnectivity<Monoid>::GetNumberOfConnectedComponents()
+    const {
+  return spanning_forest_.GetNumberOfTrees();
+}
+
+template <typename Monoid>
+std::vector<int64_t>
+BasicDynamicConnectivity<Monoid>::GetLargestComponentSizes(int64_t k) const {
+  std::vector<int64_t> sizes;
+  for (auto it{component_size_counts_.rbegin()};
+       it != component_size_counts_.rend()
+         && static_cast<int64_t>(sizes.size()) < k;
+       ++it) {
+    const auto [size, count]{*it};
+    sizes.insert(
+        sizes.end(),
+        std::min(count, k - static_cast<int64_t>(sizes.size())),
+        size);
+  }
+  return sizes;
+}
+
+template <typename Monoid>
+const std::vector<int64_t>&
+BasicDynamicConnectivity<Monoid>::GetComponentSizeHistogram() const {
+  return component_size_histogram_;
+}
+
+template <typename Monoid>
+int64_t BasicDynamicConnectivity<Monoid>::GetNumberOfVertices() const {
+  return num_vertices_;
+}
+
+template <typename Monoid>
+GraphMemoryUsage BasicDynamicConnectivity<Monoid>::GetMemoryUsage() const {
+  GraphMemoryUsage usage;
+  usage.levels.resize(std::max<std::size_t>(
+      non_tree_adjacency_lists_.size(), 1));
+  for (std::size_t level = 0; level < usage.levels.size(); level++) {
+    GraphMemoryUsage::Level& level_usage{usage.levels[level]};
+    const detail::ForestMemoryUsage forest_usage{
+      level == 0
+        ? spanning_forest_.GetMemoryUsage()
+        : upper_spanning_forests_[level - 1].GetMemoryUsage()};
+    level_usage.vertex_elements = forest_usage.vertex_elements;
+    level_usage.edge_element_pool = forest_usage.edge_element_pool;
+    level_usage.sequence_nodes = forest_usage.sequence_nodes;
+    level_usage.forest_edges = forest_usage.edges;
+    if (level < non_tree_adjacency_lists_.size()) {
+      const auto& adjacency_lists{non_tree_adjacency_lists_[level]};
+      level_usage.non_tree_adjacency_lists =
+        adjacency_lists.capacity() * sizeof(detail::AdjacencyList);
+      for (const detail::AdjacencyList& adjacency_list : adjacency_lists) {
+        level_usage.non_tree_adjacency_lists +=
+          detail::GetHashTableBytes(adjacency_list);
+      }
+    }
+  }
+  if (two_edge_connectivity_ != nullptr) {
+    usage.two_edge_connectivity = two_edge_connectivity_->GetMemoryUsage();
+  }
+  usage.edges = detail::GetHashTableBytes(edges_);
+  // Each node of `component_size_counts_` holds three pointers and a color
+  // besides its value.
+  usage.other =
+    component_size_counts_.size()
+      * (4 * sizeof(void*) + sizeof(std::pair<const int64_t, int64_t>))
+    + component_size_histogram_.capacity() * sizeof(int64_t)
+    + upper_spanning_forests_.capacity() * sizeof(DynamicForest)
+    + non_tree_adjacency_lists_.capacity()
+      * sizeof(typename decltype(non_tree_adjacency_lists_)::value_type)
+    + undo_log_.capacity() * sizeof(detail::UndoRecord<Value>)
+    + checkpoints_.capacity() * sizeof(std::size_t)
+    + deferred_promotions_.size() * sizeof(detail::DeferredPromotion);
+  return usage;
+}
+
+template <typename Monoid>
+void BasicDynamicConnectivity<Monoid>::SetVertexValue(
+    Vertex v, const Value& value) {
+  RecordUndo(
+      detail::UndoRecord<Value>::Type::kSetVertexValue,
+      UndirectedEdge{v, v},
+      0,
+      {},
+      false,
+      GetVertexValue(v));
+  spanning_forest_.SetVertexValue(
+      v, {value, spanning_forest_.GetVertexValue(v).cut_label});
+}
+
+template <typename Monoid>
+const typename BasicDynamicConnectivity<Monoid>::Value&
+BasicDynamicConnectivity<Monoid>::GetVertexValue(Vertex v) const {
+  return spanning_forest_.GetVertexValue(v).GetUserValue();
+}
+
+template <typename Monoid>
+const typename BasicDynamicConnectivity<Monoid>::Value&
+BasicDynamicConnectivity<Monoid>::GetComponentAggregate(Vertex v) const {
+  return spanning_forest_.GetTreeAggregate(v).GetUserValue();
+}
+
+template <typename Monoid>
+bool BasicDynamicConnectivity<Monoid>::IsTreeEdge(
+    const UndirectedEdge& edge) const {
+  const auto& edge_it{edges_.find(edge)};
+  ASSERT_MSG_ALWAYS(
+      edge_it != edges_.end(),
+      "Edge " << edge << " is not in the graph");
+  return edge_it->second.type == detail::EdgeType::kTree;
+}
+
+template <typename Monoid>
+bool BasicDynamicConnectivity<Monoid>::IsBridge(
+    const UndirectedEdge& edge) const {
+  const auto& edge_it{edges_.find(edge)};
+  ASSERT_MSG_ALWAYS(
+      edge_it != edges_.end(),
+      "Edge " << edge << " is not in the graph");
+  if (edge_it->second.type == detail::EdgeType::kNonTree) {
+    return false;
+  }
+  if (two_edge_connectivity_ != nullptr) {
+    return !Is2EdgeConnected(edge.first, edge.second);
+  }
+  // The vertices between the edge's two elements in the Euler tour of F_0 are
+  // one side of the edge's cut.
+  const auto [prefix_1, prefix_2]{
+    spanning_forest_.GetEdgePrefixAggregates(edge)};
+  return (prefix_1.cut_label ^ prefix_2.cut_label) == 0;
+}
+
+template <typename Monoid>
+bool BasicDynamicConnectivity<Monoid>::Is2EdgeConnected(
+    Vertex u, Vertex v) const {
+  ASSERT_MSG_ALWAYS(
+      two_edge_connectivity_ != nullptr,
+      "2-edge connectivity is not tracked");
+  const std::lock_guard<std::mutex> lock{two_edge_connectivity_mutex_};
+  return two_edge_connectivity_->Is2EdgeConnected(u, v);
+}
+
+template <typename Monoid>
+void BasicDynamicConnectivity<Monoid>::SetTwoEdgeConnectivityTracking(
+    bool is_tracked) {
+  if (!is_tracked) {
+    two_edge_connectivity_.reset();
+  } else if (two_edge_connectivity_ == nullptr) {
+    two_edge_connectivity_ =
+      std::make_unique<TwoEdgeConnectivity>(num_vertices_);
+    for (const auto& [edge, info] : edges_) {
+      two_edge_connectivity_->AddEdge(edge);
+    }
+  }
+}
+
+template <typename Monoid>
+template <typename Function>
+void BasicDynamicConnectivity<Monoid>::ForEachEdge(Function function) const {
+  for (const auto& [edge, info] : edges_) {
+    function(edge);
+  }
+}
+
+template <typename Monoid>
+template <typename Function>
+void BasicDynamicConnectivity<Monoid>::ForEachEdgeWithLevel(
+    Function function) const {
+  for (const auto& [edge, info] : edges_) {
+    function(edge, info.level, info.type == detail::EdgeType::kTree);
+  }
+}
+
+// XORs `label`, the cut label of `edge`, into the values of its endpoints in
+// F_0. Called whenever `edge` becomes or stops being a non-tree edge.
+template <typename Monoid>
+void BasicDynamicConnectivity<Monoid>::ToggleCutLabel(
+    const UndirectedEdge& edge, uint64_t label) {
+  RecordUndo(
+      detail::UndoRecord<Value>::Type::kToggleCutLabel,
+      edge,
+      0,
+      {.level = 0, .type = detail::EdgeType::kNonTree, .cut_label = label});
+  for (const Vertex v : {edge.first, edge.second}) {
+    typename LevelZeroMonoid::Value value{spanning_forest_.GetVertexValue(v)};
+    value.cut_label ^= label;
+    spanning_forest_.SetVertexValue(v, value);
+  }
+}
+
+template <typename Monoid>
+void BasicDynamicConnectivity<Monoid>::AddEdgeToAdjacencyList(
+    const UndirectedEdge& edge, detail::Level level) {
+  RecordUndo(detail::UndoRecord<Value>::Type::kAddToAdjacencyList, edge, level);
+  AddLevelsUpTo(level);
+  {
+    auto& adj_list_1{non_tree_adjacency_lists_[level][edge.first]};
+    if (adj_list_1.empty()) {
+      MarkVertexInForest(edge.first, level, true);
+    }
+    adj_list_1.emplace(edge.second);
+  }
+  {
+    auto& adj_list_2{non_tree_adjacency_lists_[level][edge.second]};
+    if (adj_list_2.empty()) {
+      MarkVertexInForest(edge.second, level, true);
+    }
+    adj_list_2.emplace(edge.first);
+  }
+}
+
+template <typename Monoid>
+void BasicDynamicConnectivity<Monoid>::DeleteEdgeFromAdjacencyList(
+    const UndirectedEdge& edge, detail::Level level) {
+  RecordUndo(
+      detail::UndoRecord<Value>::Type::kDeleteFromAdjacencyList, edge, level);
+  {
+    auto& adj_list_1{non_tree_adjacency_lists_[level][edge.first]};
+    adj_list_1.erase(adj_list_1.find(edge.second));
+    if (adj_list_1.empty()) {
+      MarkVertexInForest(edge.first, level, false);
+    }
+  }
+  {
+    auto& adj_list_2{non_tree_adjacency_lists_[level][edge.second]};
+    adj_list_2.erase(adj_list_2.find(edge.first));
+    if (adj_list_2.empty()) {
+      MarkVertexInForest(edge.second, level, false);
+    }
+  }
+}
+
+// Adds `edge` to `edges_`, recording the change for `Rollback()`.
+template <typename Monoid>
+void BasicDynamicConnectivity<Monoid>::AddEdgeInfo(
+    const UndirectedEdge& edge, const detail::EdgeInfo& info) {
+  RecordUndo(detail::UndoRecord<Value>::Type::kAddEdgeInfo, edge);
+  edges_.emplace(edge, info);
+  if (two_edge_connectivity_ != nullptr) {
+    two_edge_connectivity_->AddEdge(edge);
+  }
+}
+
+// Removes `edge` from `edges_` and returns its info, recording the change for
+// `Rollback()`.
+template <typename Monoid>
+detail::EdgeInfo
+BasicDynamicConnectivity<Monoid>::DeleteEdgeInfo(const UndirectedEdge& edge) {
+  const auto& edge_it{edges_.find(edge)};
+  ASSERT_MSG_ALWAYS(
+      edge_it != edges_.end(),
+      "Edge " << edge << " is not in the graph");
+  const detail::EdgeInfo info{edge_it->second};
+  RecordUndo(detail::UndoRecord<Value>::Type::kDeleteEdgeInfo, edge, 0, info);
+  edges_.erase(edge_it);
+  if (two_edge_connectivity_ != nullptr) {
+    two_edge_connectivity_->DeleteEdge(edge);
+  }
+  return info;
+}
+
+// Changes the level and type of `edge` in `edges_` to those of `info`, keeping
+// its cut label, and records the change for `Rollback()`.
+template <typename Monoid>
+void BasicDynamicConnectivity<Monoid>::SetEdgeInfo(
+    const UndirectedEdge& edge, const detail::EdgeInfo& info) {
+  detail::EdgeInfo& stored_info{edges_.at(edge)};
+  RecordUndo(
+      detail::UndoRecord<Value>::Type::kChangeEdgeInfo, edge, 0, stored_info);
+  stored_info.level = info.level;
+  stored_info.type = info.type;
+}
+
+// Adds `count` connected components of `size` vertices to the component size
+// statistics, or removes them if `count` is negative.
+template <typename Monoid>
+void BasicDynamicConnectivity<Monoid>::CountComponent(
+    int64_t size, int64_t count) {
+  const auto size_it{component_size_counts_.try_emplace(size, 0).first};
+  size_it->second += count;
+  if (size_it->second == 0) {
+    component_size_counts_.erase(size_it);
+  }
+  component_size_histogram_[detail::FloorLog2(size)] += count;
+}
+
+// Queues an event for subscribers about the merge that adding `edge` to F_0 is
+// about to cause or the split that deleting `edge` from F_0 just caused.
+template <typename Monoid>
+void BasicDynamicConnectivity<Monoid>::QueueComponentEvent(
+    ComponentEvent::Type type, const UndirectedEdge& edge) {
+  if (component_subscribers_.empty()) {
+    return;
+  }
+  pending_component_events_.push_back(ComponentEvent{
+    .type = type,
+    .first_vertex = edge.first,
+    .second_vertex = edge.second,
+    .first_size = spanning_forest_.GetSizeOfTree(edge.first),
+    .second_size = spanning_forest_.GetSizeOfTree(edge.second),
+  });
+}
+
+// Calls the subscribers with the events queued by the current update.
+template <typename Monoid>
+void BasicDynamicConnectivity<Monoid>::PublishComponentEvents() {
+  if (pending_component_events_.empty()) {
+    return;
+  }
+  std::vector<ComponentEvent> events;
+  std::swap(events, pending_component_events_);
+  for (const ComponentEvent& event : events) {
+    for (const auto& [subscription, callback] : component_subscribers_) {
+      callback(event);
+    }
+  }
+}
+
+// Adds `edge` to F_`level`, recording the change for `Rollback()`.
+template <typename Monoid>
+void BasicDynamicConnectivity<Monoid>::AddEdgeToForest(
+    const UndirectedEdge& edge, detail::Level level) {
+  RecordUndo(detail::UndoRecord<Value>::Type::kAddForestEdge, edge, level);
+  AddLevelsUpTo(level);
+  if (level == 0) {
+    // Adding an edge to F_0 merges two components.
+    const int64_t first_size{spanning_forest_.GetSizeOfTree(edge.first)};
+    const int64_t second_size{spanning_forest_.GetSizeOfTree(edge.second)};
+    CountComponent(first_size, -1);
+    CountComponent(second_size, -1);
+    CountComponent(first_size + second_size, 1);
+    spanning_forest_.AddEdge(edge);
+  } else {
+    upper_spanning_forests_[level - 1].AddEdge(edge);
+  }
+}
+
+// Deletes `edge` from F_`level`, recording the change for `Rollback()`. The
+// edge must be unmarked in that forest.
+template <typename Monoid>
+void BasicDynamicConnectivity<Monoid>::DeleteEdgeFromForest(
+    const UndirectedEdge& edge, detail::Level level) {
+  RecordUndo(detail::UndoRecord<Value>::Type::kDeleteForestEdge, edge, level);
+  if (level == 0) {
+    spanning_forest_.DeleteEdge(edge);
+    // Deleting an edge from F_0 splits a component, though a replacement edge
+    // may merge it back right away.
+    const int64_t first_size{spanning_forest_.GetSizeOfTree(edge.first)};
+    const int64_t second_size{spanning_forest_.GetSizeOfTree(edge.second)};
+    CountComponent(first_size + second_size, -1);
+    CountComponent(first_size, 1);
+    CountComponent(second_size, 1);
+  } else {
+    upper_spanning_forests_[level - 1].DeleteEdge(edge);
+  }
+}
+
+// Marks or unmarks `edge` in F_`level`, recording the change for `Rollback()`.
+// `mark` must differ from the edge's current mark.
+template <typename Monoid>
+void BasicDynamicConnectivity<Monoid>::MarkEdgeInForest(
+    const UndirectedEdge& edge, detail::Level level, bool mark) {
+  RecordUndo(
+      detail::UndoRecord<Value>::Type::kMarkForestEdge, edge, level, {}, mark);
+  if (level == 0) {
+    spanning_forest_.MarkEdge(edge, mark);
+  } else {
+    upper_spanning_forests_[level - 1].MarkEdge(edge, mark);
+  }
+}
+
+// Marks or unmarks vertex `v` in F_`level`. Vertex marks are derived from the
+// adjacency lists, so they need no record for `Rollback()`.
+template <typename Monoid>
+void BasicDynamicConnectivity<Monoid>::MarkVertexInForest(
+    Vertex v, detail::Level level, bool mark) {
+  if (level == 0) {
+    spanning_forest_.MarkVertex(v, mark);
+  } else {
+    upper_spanning_forests_[level - 1].MarkVertex(v, mark);
+  }
+}
+
+template <typename Monoid>
+bool BasicDynamicConnectivity<Monoid>::IsConnectedInForest(
+    Vertex u, Vertex v, detail::Level level) const {
+  if (!HasLevel(level)) {
+    return u == v;
+  }
+  return level == 0
+    ? spanning_forest_.IsConnected(u, v)
+    : upper_spanning_forests_[level - 1].IsConnected(u, v);
+}
+
+template <typename Monoid>
+int64_t BasicDynamicConnectivity<Monoid>::GetSizeOfTreeInForest(
+    Vertex v, detail::Level level) const {
+  if (!HasLevel(level)) {
+    return 1;
+  }
+  return level == 0
+    ? spanning_forest_.GetSizeOfTree(v)
+    : upper_spanning_forests_[level - 1].GetSizeOfTree(v);
+}
+
+template <typename Monoid>
+std::optional<UndirectedEdge>
+BasicDynamicConnectivity<Monoid>::GetMarkedEdgeInForest(
+    Vertex v, detail::Level level) const {
+  return level == 0
+    ? spanning_forest_.GetMarkedEdgeInTree(v)
+    : upper_spanning_forests_[level - 1].GetMarkedEdgeInTree(v);
+}
+
+// Unmarks up to `max_edges` marked edges in `v`'s tree in F_`level` and returns
+// them, recording the changes for `Rollback()`.
+template <typename Monoid>
+std::vector<UndirectedEdge>
+BasicDynamicConnectivity<Monoid>::TakeMarkedEdgesInForest(
+    Vertex v, detail::Level level, int64_t max_edges) {
+  std::vector<UndirectedEdge> edges{
+    level == 0
+      ? spanning_forest_.TakeMarkedEdgesInTree(v, max_edges)
+      : upper_spanning_forests_[level - 1].TakeMarkedEdgesInTree(
+          v, max_edges)};
+  for (const UndirectedEdge& edge : edges) {
+    RecordUndo(
+        detail::UndoRecord<Value>::Type::kMarkForestEdge,
+        edge,
+        level,
+        {},
+        false);
+  }
+  return edges;
+}
+
+template <typename Monoid>
+std::vector<Vertex>
+BasicDynamicConnectivity<Monoid>::GetMarkedVerticesInForest(
+    Vertex v, detail::Level level) const {
+  return level == 0
+    ? spanning_forest_.GetMarkedVerticesInTree(v)
+    : upper_spanning_forests_[level - 1].GetMarkedVerticesInTree(v);
+}
+
+// Add edge `edge` as a level-0 non-tree edge.
+template <typename Monoid>
+void BasicDynamicConnectivity<Monoid>::AddNonTreeEdge(
+    const UndirectedEdge& edge) {
+  const detail::EdgeInfo edge_info{
+    .level = 0,
+    .type = detail::EdgeType::kNonTree,
+    .cut_label = cut_label_generator_(),
+  };
+  AddEdgeInfo(edge, edge_info);
+  AddEdgeToAdjacencyList(edge, 0);
+  ToggleCutLabel(edge, edge_info.cut_label);
+}
+
+// Add edge `edge` as a level-0 tree edge.
+template <typename Monoid>
+void BasicDynamicConnectivity<Monoid>::AddTreeEdge(const UndirectedEdge& edge) {
+  const detail::EdgeInfo edge_info{
+    .level = 0,
+    .type = detail::EdgeType::kTree,
+  };
+  AddEdgeInfo(edge, edge_info);
+  QueueComponentEvent(ComponentEvent::Type::kMerge, edge);
+  AddEdgeToForest(edge, 0);
+  // We mark level-i edges in F_i.
+  MarkEdgeInForest(edge, 0, true);
+}
+
+template <typename Monoid>
+void BasicDynamicConnectivity<Monoid>::RestoreEdge(
+    const UndirectedEdge& edge, detail::Level level, bool is_tree_edge) {
+  detail::ValidateEdge(edge, num_vertices_);
+  ASSERT_MSG(edge.first != edge.second, edge << " is a self-loop edge");
+  ASSERT_MSG(!HasEdge(edge), "Edge " << edge << " is already in the graph");
+  ASSERT_MSG_ALWAYS(
+      0 <= level && level <= detail::FloorLog2(num_vertices_),
+      "Level " << static_cast<int32_t>(level) << " of " << edge
+        << " is out of range");
+  if (is_tree_edge) {
+    // A level-i tree edge is in F_0, ..., F_i and is marked in F_i.
+    AddEdgeInfo(edge, {.level = level, .type = detail::EdgeType::kTree});
+    for (detail::Level i = 0; i <= level; i++) {
+      AddEdgeToForest(edge, i);
+    }
+    MarkEdgeInForest(edge, level, true);
+  } else {
+    const detail::EdgeInfo edge_info{
+      .level = level,
+      .type = detail::EdgeType::kNonTree,
+      .cut_label = cut_label_generator_(),
+    };
+    AddEdgeInfo(edge, edge_info);
+    AddEdgeToAdjacencyList(edge, level);
+    ToggleCutLabel(edge, edge_info.cut_label);
+  }
+}
+
+template <typename Monoid>
+void BasicDynamicConnectivity<Monoid>::AddEdge(const UndirectedEdge& edge) {
+  detail::ValidateEdge(edge, num_vertices_);
+  ASSERT_MSG(edge.first != edge.second, edge << " is a self-loop edge");
+  ASSERT_MSG(!HasEdge(edge), "Edge " << edge << " is already in the graph");
+  promotion_budget_ = max_promotions_per_update_;
+
+  if (IsConnected(edge.first, edge.second)) {
+    AddNonTreeEdge(edge);
+  } else {
+    AddTreeEdge(edge);
+  }
+  RunDeferredPromotions();
+  PublishComponentEvents();
+}
+
+// Returns true and uses up one promotion from `promotion_budget_` if there is
+// one left.
+template <typename Monoid>
+bool BasicDynamicConnectivity<Monoid>::TrySpendPromotion() {
+  if (!promotion_budget_.has_value()) {
+    return true;
+  }
+  if (*promotion_budget_ <= 0) {
+    return false;
+  }
+  (*promotion_budget_)--;
+  return true;
+}
+
+// Promotes the level-`level` tree edges of `v`'s tree in F_`level` to level
+// (`level` + 1). Returns false if `promotion_budget_` ran out before all of
+// them were promoted.
+template <typename Monoid>
+bool BasicDynamicConnectivity<Monoid>::PromoteTreeEdges(
+    Vertex v, detail::Level level) {
+  const detail::Level next_level = level + 1;
+  // Collect and unmark the tree edges in one pass over the Euler tour rather
+  // than searching for them one at a time.
+  const int64_t max_edges{
+    promotion_budget_.value_or(std::numeric_limits<int64_t>::max())};
+  const std::vector<UndirectedEdge> tree_edges{
+    TakeMarkedEdgesInForest(v, level, max_edges)};
+  if (promotion_budget_.has_value()) {
+    *promotion_budget_ -= static_cast<int64_t>(tree_edges.size());
+  }
+  for (const UndirectedEdge& tree_edge : tree_edges) {
+    // Promote the tree edge -- increase its level by one.
+    SetEdgeInfo(
+        tree_edge,
+        {.level = next_level, .type = detail::EdgeType::kTree});
+    AddEdgeToForest(tree_edge, next_level);
+    MarkEdgeInForest(tree_edge, next_level, true);
+  }
+  return static_cast<int64_t>(tree_edges.size()) < max_edges
+    || !GetMarkedEdgeInForest(v, level).has_value();
+}
+
+// Promotes level-`level` non-tree edge `edge` to level (`level` + 1). Its
+// endpoints must be connected in F_(`level` + 1).
+template <typename Monoid>
+void BasicDynamicConnectivity<Monoid>::PromoteNonTreeEdge(
+    const UndirectedEdge& edge, detail::Level level) {
+  const detail::Level next_level = level + 1;
+  SetEdgeInfo(edge, {.level = next_level, .type = detail::EdgeType::kNonTree});
+  DeleteEdgeFromAdjacencyList(edge, level);
+  AddEdgeToAdjacencyList(edge, next_level);
+}
+
+// Runs deferred promotions, oldest first, until they or `promotion_budget_`
+// run out.
+template <typename Monoid>
+void BasicDynamicConnectivity<Monoid>::RunDeferredPromotions() {
+  while (!deferred_promotions_.empty()
+      && (!promotion_budget_.has_value() || *promotion_budget_ > 0)) {
+    const detail::DeferredPromotion promotion{deferred_promotions_.front()};
+    // Promoting a tree's edges merges trees of F_(`level` + 1) into that tree,
+    // so it may only be done if the tree is small enough to live on the next
+    // level. The tree may have grown since the promotion was deferred, in
+    // which case we drop the promotion. Leaving tree edges on a lower level
+    // is always valid, so this only costs the amortized bound; see
+    // `SetMaxPromotionsPerUpdate()`. The level may also have lost all its
+    // edges, in which case there is nothing left to promote.
+    if (!HasLevel(promotion.level)
+        || GetSizeOfTreeInForest(promotion.vertex, promotion.level)
+        > (num_vertices_ >> (promotion.level + 1))
+        || PromoteTreeEdges(promotion.vertex, promotion.level)) {
+      deferred_promotions_.pop_front();
+      RecordUndo(
+          detail::UndoRecord<Value>::Type::kPopDeferredPromotion,
+          {promotion.vertex, promotion.vertex},
+          promotion.level);
+    }
+  }
+}
+
+// Promotes `edge`, a level-`level` non-tree edge that turned out not to be a
+// replacement edge, to level (`level` + 1) if the budget allows and doing so
+// keeps the invariants. `promoted_tree` says whether the tree edges of the
+// tree being searched have all been promoted.
+template <typename Monoid>
+void BasicDynamicConnectivity<Monoid>::TryPromoteFailedCandidate(
+    const UndirectedEdge& edge, detail::Level level, bool promoted_tree) {
+  if ((promoted_tree || IsConnectedInForest(edge.first, edge.second, level + 1))
+      && TrySpendPromotion()) {
+    PromoteNonTreeEdge(edge, level);
+  }
+}
+
+// Looks at level-`level` non-tree edges incident to `u`'s tree in F_`level`
+// for one that leaves the tree and returns it. Candidates looked at before it
+// are promoted if possible.
+//
+// `vertices_with_incident_edges` lists the vertices of `u`'s tree that have
+// level-`level` non-tree edges. No vertex of u's tree gains such edges during
+// the search, so the list stays complete.
+template <typename Monoid>
+std::optional<UndirectedEdge>
+BasicDynamicConnectivity<Monoid>::FindReplacementEdge(
+    Vertex u,
+    detail::Level level,
+    bool promoted_tree,
+    const std::vector<Vertex>& vertices_with_incident_edges) {
+  for (const Vertex vertex_with_incident_edges :
+       vertices_with_incident_edges) {
+    detail::AdjacencyList& adj_list{
+      non_tree_adjacency_lists_[level][vertex_with_incident_edges]
+    };
+    auto adj_it{adj_list.begin()};
+    while (adj_it != adj_list.end()) {
+      const Vertex endpoint{*adj_it};
+      // Promoting the candidate erases it from `adj_list`, so advance first.
+      ++adj_it;
+      const UndirectedEdge replacement_candidate{
+        vertex_with_incident_edges, endpoint};
+      if (IsConnectedInForest(u, endpoint, level)) {
+        TryPromoteFailedCandidate(replacement_candidate, level, promoted_tree);
+      } else {
+        // Candidate must be a replacement edge connecting `u`'s tree to
+        // the other tree.  It cannot connect `u`'s tree to any other tree
+        // because that would mean that F_`level` was not actually a spanning
+        // forest over edges of level at least `level` (`{u, endpoint}`
+        // could've been added to the forest).
+        return replacement_candidate;
+      }
+    }
+  }
+  return {};
+}
+
+// Same as `FindReplacementEdge()`, but checks candidates on up to
+// `num_search_threads_` threads: the calling thread and the workers of
+// `search_thread_pool_`.
+//
+// Searches with too few candidates to be worth splitting are left to
+// `FindReplacementEdge()`, which can stop at the first replacement edge. To
+// keep those searches cheap, the candidates are only counted up to the number
+// needed for two threads before any of them are listed.
+//
+// Otherwise, the candidates are listed in the order in which `FindReplacementEdge()`
+// would look at them, and the threads only read the forest while checking
+// them. The first replacement edge in the list is the one
+// `FindReplacementEdge()` would find. The candidates before it are then
+// promoted on the calling thread in list order, so the result is the same as
+// that of `FindReplacementEdge()`.
+template <typename Monoid>
+std::optional<UndirectedEdge>
+BasicDynamicConnectivity<Monoid>::FindReplacementEdgeInParallel(
+    Vertex u,
+    detail::Level level,
+    bool promoted_tree,
+    const std::vector<Vertex>& vertices_with_incident_edges) {
+  constexpr std::size_t kMinParallelCandidates{
+    2 * detail::kMinCandidatesPerSearchThread};
+  std::size_t num_candidates{0};
+  for (const Vertex vertex_with_incident_edges :
+       vertices_with_incident_edges) {
+    num_candidates +=
+      non_tree_adjacency_lists_[level][vertex_with_incident_edges].size();
+    if (num_candidates >= kMinParallelCandidates) {
+      break;
+    }
+  }
+  if (num_candidates < kMinParallelCandidates) {
+    return FindReplacementEdge(
+        u, level, promoted_tree, vertices_with_incident_edges);
+  }
+
+  std::vector<std::pair<Vertex, Vertex>> candidates;
+  for (const Vertex vertex_with_incident_edges :
+       vertices_with_incident_edges) {
+    for (const Vertex endpoint :
+         non_tree_adjacency_lists_[level][vertex_with_incident_edges]) {
+      candidates.emplace_back(vertex_with_incident_edges, endpoint);
+    }
+  }
+  const std::size_t num_threads{std::min<std::size_t>(
+      num_search_threads_,
+      candidates.size() / detail::kMinCandidatesPerSearchThread)};
+
+  // Threads claim blocks of candidates in order and stop once every candidate
+  // before the earliest replacement edge found so far has been checked.
+  std::atomic<std::size_t> next_block{0};
+  std::atomic<std::size_t> first_replacement{candidates.size()};
+  const auto check_candidates{[&] {
+    while (true) {
+      const std::size_t begin{next_block.fetch_add(detail::kSearchBlockSize)};
+      const std::size_t end{std::min(
+          begin + detail::kSearchBlockSize, first_replacement.load())};
+      if (begin >= end) {
+        return;
+      }
+      for (std::size_t i = begin; i < end; i++) {
+        if (!IsConnectedInForest(u, candidates[i].second, level)) {
+          std::size_t current{first_replacement.load()};
+          while (i < current
+              && !first_replacement.compare_exchange_weak(current, i)) {}
+          break;
+        }
+      }
+    }
+  }};
+  search_thread_pool_->Run(
+      static_cast<int32_t>(num_threads) - 1, check_candidates);
+
+  const std::size_t replacement_index{first_replacement.load()};
+  for (std::size_t i = 0; i < replacement_index; i++) {
+    const UndirectedEdge candidate{candidates[i].first, candidates[i].second};
+    // A non-tree edge with both endpoints in `u`'s tree is listed twice, once
+    // per endpoint. Skip it the second time if it was promoted the first time.
+    if (edges_.at(candidate).level == level) {
+      TryPromoteFailedCandidate(candidate, level, promoted_tree);
+    }
+  }
+  if (replacement_index < candidates.size()) {
+    return UndirectedEdge{
+      candidates[replacement_index].first,
+      candidates[replacement_index].second};
+  }
+  return {};
+}
+
+// Searches on levels `level` and lower for a non-tree edge of maximum level
+// that reconnects the endpoints of `edge`. Converts that non-tree edge into a
+// tree edge if any such edge is found.
+template <typename Monoid>
+void BasicDynamicConnectivity<Monoid>::ReplaceTreeEdge(
+    const UndirectedEdge& edge, detail::Level level) {
+  Vertex u{edge.first};
+  Vertex v{edge.second};
+  if (GetSizeOfTreeInForest(u, level) > GetSizeOfTreeInForest(v, level)) {
+    std::swap(u, v);
+  }
+
+  // `u` lives in a relatively small tree. We promote all of its level-`level`
+  // tree edges to level (`level` + 1). Otherwise, we'll fail to maintain the
+  // invariant that F_(`level` + 1) is a spanning forest over all edges of level
+  // at least (`level` + 1) once we promote non-tree edges.
+  //
+  // If `promotion_budget_` runs out first, we leave the rest of the tree edges
+  // for later and only promote the non-tree edges whose endpoints are already
+  // connected in F_(`level` + 1).
+  const bool promoted_tree{PromoteTreeEdges(u, level)};
+  if (!promoted_tree) {
+    deferred_promotions_.push_back({.vertex = u, .level = level});
+    RecordUndo(
+        detail::UndoRecord<Value>::Type::kPushDeferredPromotion,
+        {u, u},
+        level);
+  }
+
+  const std::vector<Vertex> vertices_with_incident_edges{
+    GetMarkedVerticesInForest(u, level)};
+  const std::optional<UndirectedEdge> replacement_edge{
+    search_thread_pool_ != nullptr
+      ? FindReplacementEdgeInParallel(
+          u, level, promoted_tree, vertices_with_incident_edges)
+      : FindReplacementEdge(
+          u, level, promoted_tree, vertices_with_incident_edges)};
+  if (replacement_edge.has_value()) {
+    // Change the replacement edge from a non-tree edge to a tree edge.
+    SetEdgeInfo(
+        *replacement_edge,
+        {.level = level, .type = detail::EdgeType::kTree});
+    DeleteEdgeFromAdjacencyList(*replacement_edge, level);
+    ToggleCutLabel(
+        *replacement_edge, edges_.at(*replacement_edge).cut_label);
+    for (detail::Level l = level; l >= 0; l--) {
+      AddEdgeToForest(*replacement_edge, l);
+    }
+    MarkEdgeInForest(*replacement_edge, level, true);
+    return;
+  }
+
+  // No replacement edge on level `level` found.
+  if (level > 0) {
+    // Search on lower level.
+    ReplaceTreeEdge(edge, level - 1);
+  } else {
+    // There is no replacement edge. `u` and `v` are disconnected.
+    QueueComponentEvent(ComponentEvent::Type::kSplit, edge);
+  }
+}
+
+template <typename Monoid>
+void BasicDynamicConnectivity<Monoid>::DeleteEdge(const UndirectedEdge& edge) {
+  detail::ValidateEdge(edge, num_vertices_);
+  promotion_budget_ = max_promotions_per_update_;
+  const detail::EdgeInfo edge_info{DeleteEdgeInfo(edge)};
+  switch (edge_info.type) {
+    case detail::EdgeType::kNonTree:
+      DeleteEdgeFromAdjacencyList(edge, edge_info.level);
+      ToggleCutLabel(edge, edge_info.cut_label);
+      break;
+    case detail::EdgeType::kTree:
+      MarkEdgeInForest(edge, edge_info.level, false);
+      for (detail::Level l{edge_info.level}; l >= 0; l--) {
+        DeleteEdgeFromForest(edge, l);
+      }
+      ReplaceTreeEdge(edge, edge_info.level);
+      break;
+  }
+  RunDeferredPromotions();
+  if (compaction_threshold_.has_value()
+      && edges_.bucket_count() >= static_cast<std::size_t>(num_vertices_)
+      && static_cast<double>(edges_.load_factor()) < *compaction_threshold_) {
+    Compact();
+  }
+  PublishComponentEvents();
+}
+
+template <typename Monoid>
+void BasicDynamicConnectivity<Monoid>::SetMaxPromotionsPerUpdate(
+    std::optional<int64_t> max_promotions) {
+  ASSERT_MSG_ALWAYS(
+      !max_promotions.has_value() || *max_promotions >= 0,
+      "The maximum number of promotions must be non-negative");
+  max_promotions_per_update_ = max_promotions;
+}
+
+template <typename Monoid>
+void BasicDynamicConnectivity<Monoid>::SetNumberOfSearchThreads(
+    int32_t num_threads) {
+  ASSERT_MSG_ALWAYS(
+      num_threads > 0, "The number of search threads must be positive");
+  if (num_threads != num_search_threads_) {
+    num_search_threads_ = num_threads;
+    search_thread_pool_ =
+      num_threads > 1 ? std::make_unique<ThreadPool>(num_threads - 1) : nullptr;
+  }
+}
+
+template <typename Monoid>
+void BasicDynamicConnectivity<Monoid>::Compact() {
+  // Levels above the highest level of any edge hold no edges. Undoing a change
+  // to such a level re-adds the level first, so this is safe even while
+  // checkpoints are held.
+  detail::Level max_level{0};
+  for (const auto& [edge, info] : edges_) {
+    max_level = std::max(max_level, info.level);
+  }
+  while (static_cast<int64_t>(non_tree_adjacency_lists_.size())
+         > max_level + 1) {
+    non_tree_adjacency_lists_.pop_back();
+    upper_spanning_forests_.pop_back();
+  }
+  non_tree_adjacency_lists_.shrink_to_fit();
+  upper_spanning_forests_.shrink_to_fit();
+  // `Rollback()` undoes changes to the deferred promotions by their position in
+  // the queue, so promotions on removed levels are only dropped here while no
+  // checkpoints are held. Otherwise `RunDeferredPromotions()` drops them.
+  if (checkpoints_.empty()) {
+    deferred_promotions_.erase(
+        std::remove_if(
+            deferred_promotions_.begin(),
+            deferred_promotions_.end(),
+            [&](const detail::DeferredPromotion& promotion) {
+              return !HasLevel(promotion.level);
+            }),
+        deferred_promotions_.end());
+  }
+  deferred_promotions_.shrink_to_fit();
+
+  spanning_forest_.Compact();
+  for (DynamicForest& forest : upper_spanning_forests_) {
+    forest.Compact();
+  }
+  if (two_edge_connectivity_ != nullptr) {
+    two_edge_connectivity_->Compact();
+  }
+  for (auto& adjacency_lists : non_tree_adjacency_lists_) {
+    for (detail::AdjacencyList& adjacency_list : adjacency_lists) {
+      if (adjacency_list.empty()) {
+        // An empty table still holds its buckets after rehashing, so replace
+        // it with a new one.
+        detail::AdjacencyList(
+            0,
+            std::hash<Vertex>{},
+            std::equal_to<Vertex>{},
+            adjacency_list.get_allocator()).swap(adjacency_list);
+      } else {
+        adjacency_list.rehash(0);
+      }
+    }
+  }
+  edges_.rehash(0);
+  if (checkpoints_.empty()) {
+    undo_log_.shrink_to_fit();
+  }
+}
+
+template <typename Monoid>
+void BasicDynamicConnectivity<Monoid>::SetCompactionThreshold(
+    std::optional<double> load_factor) {
+  ASSERT_MSG_ALWAYS(
+      !load_factor.has_value() || (0 < *load_factor && *load_factor < 1),
+      "The compaction threshold must be between 0 and 1");
+  compaction_threshold_ = load_factor;
+}
+
+template <typename Monoid>
+int64_t BasicDynamicConnectivity<Monoid>::SubscribeToComponentEvents(
+    std::function<void(const ComponentEvent&)> callback) {
+  const int64_t subscription{next_subscription_++};
+  component_subscribers_.emplace(subscription, std::move(callback));
+  return subscription;
+}
+
+template <typename Monoid>
+void BasicDynamicConnectivity<Monoid>::UnsubscribeFromComponentEvents(
+    int64_t subscription) {
+  const std::size_t num_erased{component_subscribers_.erase(subscription)};
+  ASSERT_MSG_ALWAYS(
+      num_erased == 1, "No subscription " << subscription << " to cancel");
+}
+
+template <typename Monoid>
+bool BasicDynamicConnectivity<Monoid>::RunDeferredWork(int64_t max_promotions) {
+  ASSERT_MSG_ALWAYS(
+      max_promotions >= 0,
+      "The maximum number of promotions must be non-negative");
+  promotion_budget_ = max_promotions;
+  RunDeferredPromotions();
+  return !deferred_promotions_.empty();
+}
+
+template <typename Monoid>
+void BasicDynamicConnectivity<Monoid>::RecordUndo(
+    typename detail::UndoRecord<Value>::Type type,
+    const UndirectedEdge& edge,
+    detail::Level level,
+    detail::EdgeInfo edge_info,
+    bool mark,
+    const Value& value) {
+  if (!checkpoints_.empty()) {
+    undo_log_.push_back(detail::UndoRecord<Value>{
+      .type = type,
+      .edge = edge,
+      .level = level,
+      .edge_info = edge_info,
+      .mark = mark,
+      .value = value,
+    });
+  }
+}
+
+// Reverts the change described by `record`. Must be called with no
+// checkpoints held so that the reversion is not itself recorded.
+template <typename Monoid>
+void BasicDynamicConnectivity<Monoid>::Undo(
+    const detail::UndoRecord<Value>& record) {
+  typedef typename detail::UndoRecord<Value>::Type Type;
+  const UndirectedEdge& edge{record.edge};
+  switch (record.type) {
+    case Type::kAddEdgeInfo:
+      DeleteEdgeInfo(edge);
+      break;
+    case Type::kDeleteEdgeInfo:
+      AddEdgeInfo(edge, record.edge_info);
+      break;
+    case Type::kChangeEdgeInfo:
+      SetEdgeInfo(edge, record.edge_info);
+      break;
+    case Type::kAddForestEdge:
+      DeleteEdgeFromForest(edge, record.level);
+      if (record.level == 0) {
+        QueueComponentEvent(ComponentEvent::Type::kSplit, edge);
+      }
+      break;
+    case Type::kDeleteForestEdge:
+      if (record.level == 0) {
+        QueueComponentEvent(ComponentEvent::Type::kMerge, edge);
+      }
+      AddEdgeToForest(edge, record.level);
+      break;
+    case Type::kMarkForestEdge:
+      MarkEdgeInForest(edge, record.level, !record.mark);
+      break;
+    case Type::kAddToAdjacencyList:
+      DeleteEdgeFromAdjacencyList(edge, record.level);
+      break;
+    case Type::kDeleteFromAdjacencyList:
+      AddEdgeToAdjacencyList(edge, record.level);
+      break;
+    case Type::kSetVertexValue:
+      SetVertexValue(edge.first, record.value);
+      break;
+    case Type::kToggleCutLabel:
+      ToggleCutLabel(edge, record.edge_info.cut_label);
+      break;
+    case Type::kPushDeferredPromotion:
+      deferred_promotions_.pop_back();
+      break;
+    case Type::kPopDeferredPromotion:
+      deferred_promotions_.push_front(
+          {.vertex = edge.first, .level = record.level});
+      break;
+  }
+}
+
+template <typename Monoid>
+void BasicDynamicConnectivity<Monoid>::Checkpoint() {
+  checkpoints_.push_back(undo_log_.size());
+}
+
+template <typename Monoid>
+void BasicDynamicConnectivity<Monoid>::Rollback() {
+  ASSERT_MSG_ALWAYS(!checkpoints_.empty(), "No checkpoint to roll back to");
+  const std::size_t checkpoint{checkpoints_.back()};
+  checkpoints_.pop_back();
+  // Stop recording while undoing so that the undo operations don't add to the
+  // log.
+  std::vector<std::size_t> held_checkpoints;
+  std::swap(held_checkpoints, checkpoints_);
+  while (undo_log_.size() > checkpoint) {
+    Undo(undo_log_.back());
+    undo_log_.pop_back();
+  }
+  std::swap(held_checkpoints, checkpoints_);
+  PublishComponentEvents();
+}
+
+template <typename Monoid>
+void BasicDynamicConnectivity<Monoid>::DiscardCheckpoint() {
+  ASSERT_MSG_ALWAYS(!checkpoints_.empty(), "No checkpoint to discard");
+  checkpoints_.pop_back();
+  if (checkpoints_.empty()) {
+    undo_log_.clear();
+  }
+}
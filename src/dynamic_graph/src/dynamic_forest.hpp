@@ -1,24 +1,43 @@
 #pragma once
 
+#include <algorithm>
+#include <cstddef>
 #include <cstdint>
+#include <functional>
+#include <limits>
+#include <optional>
 #include <unordered_map>
 #include <utility>
 #include <vector>
 
 #include <sequence.hpp>
 #include <dynamic_graph/graph.hpp>
+#include <dynamic_graph/memory_arena.hpp>
 
 namespace detail {
 
 // This is for holding elements for a pair of directed edges (u, v) and (v, u).
+template <typename Element>
 struct UndirectedEdgeElements {
-  UndirectedEdgeElements(
-      sequence::Element* _forward_edge,
-      sequence::Element* _backward_edge);
+  UndirectedEdgeElements(Element* _forward_edge, Element* _backward_edge);
   UndirectedEdgeElements() = delete;
 
-  sequence::Element* const forward_edge;
-  sequence::Element* const backward_edge;
+  Element* const forward_edge;
+  Element* const backward_edge;
+};
+
+// Bytes of memory held by a `BasicDynamicForest`, broken down by part.
+struct ForestMemoryUsage {
+  // Euler tour elements representing vertices.
+  std::size_t vertex_elements{0};
+  // Euler tour elements preallocated for edges, used or not, and the list of
+  // unused ones.
+  std::size_t edge_element_pool{0};
+  // Nodes of the search trees holding the Euler tours, other than the elements
+  // themselves.
+  std::size_t sequence_nodes{0};
+  // Map from edges to their Euler tour elements.
+  std::size_t edges{0};
 };
 
 }  // namespace detail
@@ -30,22 +49,34 @@ struct UndirectedEdgeElements {
 // The implementation is specialized for use in Holm et al.'s dynamic
 // connectivity algorithm, which is why we have the functions `MarkEdge()` and
 // `MarkVertex()`.
-class DynamicForest {
+//
+// `Element` is the type of Euler tour sequence element, which is
+// `sequence::AugmentedElement<Monoid>` or `sequence::BTreeElement<Monoid>` for
+// some monoid `Monoid`. Each vertex holds a value of that monoid, and the
+// forest can report the combination of the values over any tree.
+template <typename Element>
+class BasicDynamicForest {
  public:
-  // Initializes forest with `num_vertices` vertices and no edges.
+  typedef typename Element::Value Value;
+
+  // Initializes forest with `num_vertices` vertices and no edges. If `arena` is
+  // not null, the forest's storage is allocated from it.
   //
   // Efficiency: linear in the size of the forest.
-  explicit DynamicForest(int64_t num_vertices);
-  DynamicForest() = delete;
+  explicit BasicDynamicForest(
+      int64_t num_vertices, MemoryArena* arena = nullptr);
+  BasicDynamicForest() = delete;
 
-  ~DynamicForest();
+  ~BasicDynamicForest();
 
-  // Only copies forests that have no edges.
-  DynamicForest(const DynamicForest& other);
-  DynamicForest& operator=(const DynamicForest& other) = delete;
+  // Copies the forest, including its edges and marks.
+  //
+  // Efficiency: linear in the size of the forest.
+  BasicDynamicForest(const BasicDynamicForest& other);
+  BasicDynamicForest& operator=(const BasicDynamicForest& other) = delete;
 
-  DynamicForest(DynamicForest&& other) noexcept;
-  DynamicForest& operator=(DynamicForest&& other) noexcept = delete;
+  BasicDynamicForest(BasicDynamicForest&& other) noexcept;
+  BasicDynamicForest& operator=(BasicDynamicForest&& other) noexcept = delete;
 
   // Returns true if vertices `u` and `v` are connected, i.e. are in the same
   // tree.
@@ -81,6 +112,18 @@ class DynamicForest {
   //
   // Efficiency: constant.
   int64_t GetNumberOfTrees() const;
+  // Releases the edge elements that the forest's edges do not use and shrinks
+  // the map of edges to fit. The remaining elements are renumbered in Euler
+  // tour order so that each tour occupies contiguous memory. The pool of edge
+  // elements grows back as edges are added.
+  //
+  // Efficiency: linear in the size of the forest.
+  void Compact();
+  // Returns the number of bytes of memory that the forest holds, broken down by
+  // part. Hash table sizes are estimates.
+  //
+  // Efficiency: linear in the size of the forest.
+  detail::ForestMemoryUsage GetMemoryUsage() const;
 
   // Mark (if `mark` is true) or unmark (if `mark` is false) an edge. See
   // `GetMarkedEdgeInTree`.
@@ -96,24 +139,76 @@ class DynamicForest {
   std::optional<UndirectedEdge> GetMarkedEdgeInTree(Vertex v) const;
   // Analagous to `GetMarkedVertexInTree`.
   std::optional<Vertex> GetMarkedVertexInTree(Vertex v) const;
+  // Finds up to `max_edges` marked edges in the tree that vertex `v` resides in
+  // and unmarks them.
+  //
+  // Efficiency: O(k log(n / k)) where n is the size of the forest and k is the
+  // number of edges returned.
+  std::vector<UndirectedEdge>
+  TakeMarkedEdgesInTree(Vertex v, int64_t max_edges);
+  // Finds all marked vertices in the tree that vertex `v` resides in.
+  //
+  // Efficiency: O(k log(n / k)) where n is the size of the forest and k is the
+  // number of vertices returned.
+  std::vector<Vertex> GetMarkedVerticesInTree(Vertex v) const;
+
+  // Sets the value held by vertex `v`. Every vertex starts with the monoid's
+  // identity as its value.
+  //
+  // Efficiency: logarithmic in the size of the forest.
+  void SetVertexValue(Vertex v, const Value& value);
+  // Returns the value held by vertex `v`.
+  //
+  // Efficiency: constant.
+  const Value& GetVertexValue(Vertex v) const;
+  // Returns the combination of the values of all vertices in the tree that
+  // vertex `v` resides in.
+  //
+  // Efficiency: logarithmic in the size of the forest.
+  const Value& GetTreeAggregate(Vertex v) const;
+  // Returns the combinations of the values of the Euler tour elements up to and
+  // including each of the two elements representing `edge` in the tour of its
+  // tree. For a monoid whose values are their own inverses, like XOR,
+  // combining the two gives the combination of the values of the vertices on
+  // one side of `edge`, since those vertices lie between the two elements.
+  //
+  // The edge must be in the forest.
+  //
+  // Efficiency: logarithmic in the size of the forest.
+  std::pair<Value, Value> GetEdgePrefixAggregates(
+      const UndirectedEdge& edge) const;
 
  private:
-  detail::UndirectedEdgeElements
+  detail::UndirectedEdgeElements<Element>
   AllocateEdgeElements(const UndirectedEdge& edge);
-  void FreeEdgeElements(const detail::UndirectedEdgeElements& edge_elements);
+  void FreeEdgeElements(
+      const detail::UndirectedEdgeElements<Element>& edge_elements);
+  void ReallocateEdgeElements(int64_t num_edge_elements);
 
   const int64_t num_vertices_;
-  std::vector<sequence::Element> vertices_;
-  // We preallocate all sequence elements for edges in `edge_elements_` and
-  // maintain a list of unused elements in `free_edge_elements_`. The used
-  // elements are stored in `edges_`, which maps an undirected edge to sequence
-  // elements in `edge_elements_`.
-  std::vector<sequence::Element> edge_elements_;
-  std::vector<sequence::Element*> free_edge_elements_;
+  // All sequence elements live contiguously in `elements_` so that the forest
+  // can be copied in bulk. The first `num_vertices_` elements represent
+  // vertices. The rest are preallocated elements for edges, enough for a
+  // spanning tree until `Compact()` shrinks them, after which they are
+  // reallocated as needed. We maintain a list of unused edge elements in
+  // `free_edge_elements_`. The used elements are stored in `edges_`, which maps
+  // an undirected edge to sequence elements in `elements_`.
+  std::vector<Element, ArenaAllocator<Element>> elements_;
+  std::vector<Element*, ArenaAllocator<Element*>> free_edge_elements_;
   // Maps undirected edge {u, v} to elements representing directed edges (u, v)
   // and (v, u).
   std::unordered_map<
     UndirectedEdge,
-    detail::UndirectedEdgeElements,
-    UndirectedEdgeHash> edges_;
+    detail::UndirectedEdgeElements<Element>,
+    UndirectedEdgeHash,
+    std::equal_to<UndirectedEdge>,
+    ArenaAllocator<std::pair<
+      const UndirectedEdge, detail::UndirectedEdgeElements<Element>>>> edges_;
 };
+
+// Dynamic forest whose vertices hold no values.
+typedef BasicDynamicForest<sequence::Element> DynamicForest;
+
+extern template class BasicDynamicForest<sequence::Element>;
+
+#include <dynamic_forest_impl.hpp>
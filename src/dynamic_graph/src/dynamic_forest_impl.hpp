@@ -0,0 +1,448 @@
+// This is implemented using a variant of Euler tour trees described in the
+// following paper:
+//   Robert E. Tarjan. "Dynamic trees as search trees via Euler tours, applied
+//   to the network simplex algorithm." Mathematical Programming, 78(2), 1997.
+//
+// The idea of Euler tour trees is that given a forest, we can represent each
+// tree in the forest by replacing each edge with two directed edges, taking an
+// Euler tour on the tree, breaking the cyclic Euler tour at an arbitrary point,
+// and storing the tour as a linear sequence. Adding and deleting edges
+// corresponds to a small number of splits and concatenations on the tours.
+// Tarjan's variant adds self-loop edges to each vertex and includes them in the
+// Euler tour to make it convenient to look up where a vertex is in the tours.
+//
+// This file holds the definitions of the templates declared in
+// <dynamic_forest.hpp> and should only be included from there.
+#pragma once
+
+#include <dynamic_forest.hpp>
+
+#include <utilities/assert.hpp>
+
+namespace detail {
+
+constexpr int32_t kEdgeMark{0};
+constexpr int32_t kVertexMark{1};
+// When a compacted forest runs out of edge elements, it grows its pool of them
+// by at least this fraction of the number of vertices, since growing copies
+// the vertex elements too.
+constexpr int64_t kMinEdgeElementGrowthDivisor{16};
+
+inline void ValidateEdge(
+    [[maybe_unused]] const UndirectedEdge& edge,
+    [[maybe_unused]] int64_t num_vertices) {
+  ASSERT_MSG(
+      0 <= edge.first && edge.first < num_vertices
+        && 0 <= edge.second && edge.second < num_vertices,
+      "Edge " << edge << " out of bounds");
+}
+
+inline void ValidateVertex(
+    [[maybe_unused]] Vertex v, [[maybe_unused]] int64_t num_vertices) {
+  ASSERT_MSG(0 <= v && v < num_vertices, "Vertex " << v << " out of bounds");
+}
+
+template <typename Element>
+UndirectedEdgeElements<Element>::UndirectedEdgeElements(
+      Element* _forward_edge,
+      Element* _backward_edge)
+  : forward_edge(_forward_edge), backward_edge(_backward_edge) {}
+
+}  // namespace detail
+
+template <typename Element>
+BasicDynamicForest<Element>::BasicDynamicForest(
+    int64_t num_vertices, MemoryArena* arena)
+    : num_vertices_(num_vertices)
+    , elements_(arena)
+    , free_edge_elements_(arena)
+    , edges_(0, UndirectedEdgeHash{}, std::equal_to<UndirectedEdge>{}, arena) {
+  ASSERT_MSG_ALWAYS(
+      num_vertices_ > 0,
+      "The number of vertices must be positive");
+
+  const int64_t max_num_edges{2 * (num_vertices_ - 1)};
+  elements_.reserve(num_vertices_ + max_num_edges);
+  for (int64_t i = 0; i < num_vertices_; i++) {
+    elements_.emplace_back(std::make_pair(i, i), arena);
+  }
+  for (int64_t i = 0; i < max_num_edges; i++) {
+    elements_.emplace_back(std::make_pair(-1, -1), arena);
+  }
+  free_edge_elements_.reserve(max_num_edges);
+  for (int64_t i = num_vertices_; i < num_vertices_ + max_num_edges; i++) {
+    free_edge_elements_.emplace_back(&elements_[i]);
+  }
+  edges_.reserve(max_num_edges);
+}
+
+template <typename Element>
+BasicDynamicForest<Element>::~BasicDynamicForest() {}
+
+template <typename Element>
+BasicDynamicForest<Element>::BasicDynamicForest(
+    const BasicDynamicForest& other)
+    : num_vertices_{other.num_vertices_}
+    , elements_(
+        other.elements_.size(),
+        Element{
+          std::make_pair(-1, -1), other.elements_.get_allocator().GetArena()},
+        other.elements_.get_allocator())
+    , free_edge_elements_(other.free_edge_elements_.get_allocator())
+    , edges_(
+        0,
+        UndirectedEdgeHash{},
+        std::equal_to<UndirectedEdge>{},
+        other.edges_.get_allocator()) {
+  const Element* const other_elements{other.elements_.data()};
+  Element* const elements{elements_.data()};
+  Element::CopySequences(other_elements, elements, elements_.size());
+
+  free_edge_elements_.reserve(other.free_edge_elements_.capacity());
+  for (const Element* element : other.free_edge_elements_) {
+    free_edge_elements_.emplace_back(elements + (element - other_elements));
+  }
+  edges_.reserve(other.elements_.size() - num_vertices_);
+  for (const auto& [edge, edge_elements] : other.edges_) {
+    edges_.emplace(
+        edge,
+        detail::UndirectedEdgeElements<Element>{
+          elements + (edge_elements.forward_edge - other_elements),
+          elements + (edge_elements.backward_edge - other_elements)});
+  }
+}
+
+template <typename Element>
+BasicDynamicForest<Element>::BasicDynamicForest(
+    BasicDynamicForest&& other) noexcept
+    : num_vertices_{other.num_vertices_}
+    , elements_{std::move(other.elements_)}
+    , free_edge_elements_{std::move(other.free_edge_elements_)}
+    , edges_{std::move(other.edges_)} {}
+
+// Allocates Euler tour sequence elements for an edge in the forest.
+template <typename Element>
+detail::UndirectedEdgeElements<Element>
+BasicDynamicForest<Element>::AllocateEdgeElements(const UndirectedEdge& edge) {
+  if (free_edge_elements_.empty()) {
+    const int64_t num_edge_elements{
+      static_cast<int64_t>(elements_.size()) - num_vertices_};
+    const int64_t min_growth{
+      2 * (num_vertices_ / detail::kMinEdgeElementGrowthDivisor + 1)};
+    ReallocateEdgeElements(std::min(
+        2 * (num_vertices_ - 1),
+        num_edge_elements + std::max(num_edge_elements, min_growth)));
+  }
+  detail::UndirectedEdgeElements<Element> edge_elements{
+    free_edge_elements_[free_edge_elements_.size() - 1],
+    free_edge_elements_[free_edge_elements_.size() - 2]
+  };
+  free_edge_elements_.pop_back();
+  free_edge_elements_.pop_back();
+  edge_elements.forward_edge->id_ = std::make_pair(edge.first, edge.second);
+  edge_elements.backward_edge->id_ = std::make_pair(edge.second, edge.first);
+  return edge_elements;
+}
+
+template <typename Element>
+void BasicDynamicForest<Element>::FreeEdgeElements(
+    const detail::UndirectedEdgeElements<Element>& edge_elements) {
+  edge_elements.forward_edge->id_ = std::make_pair(-1, -1);
+  edge_elements.backward_edge->id_ = std::make_pair(-1, -1);
+  edge_elements.forward_edge->Mark(detail::kEdgeMark, false);
+  edge_elements.backward_edge->Mark(detail::kEdgeMark, false);
+  free_edge_elements_.emplace_back(edge_elements.forward_edge);
+  free_edge_elements_.emplace_back(edge_elements.backward_edge);
+}
+
+// Moves the elements into a new `elements_` with room for `num_edge_elements`
+// edge elements, numbering the elements of each Euler tour consecutively in
+// tour order.
+template <typename Element>
+void BasicDynamicForest<Element>::ReallocateEdgeElements(
+    int64_t num_edge_elements) {
+  const int64_t num_used_edge_elements{
+    2 * static_cast<int64_t>(edges_.size())};
+  ASSERT_MSG(
+      num_used_edge_elements <= num_edge_elements
+        && num_edge_elements <= 2 * (num_vertices_ - 1),
+      "Cannot hold " << num_used_edge_elements << " edge elements in a pool of "
+      << num_edge_elements);
+
+  Element* const old_elements{elements_.data()};
+  // Vertex elements keep their indices. Edge elements are numbered by walking
+  // each tour once, from its lowest-numbered vertex.
+  std::vector<int64_t> new_indices(elements_.size(), -1);
+  std::vector<bool> is_vertex_visited(num_vertices_, false);
+  int64_t next_index{num_vertices_};
+  for (Vertex v = 0; v < num_vertices_; v++) {
+    new_indices[v] = v;
+    if (is_vertex_visited[v]) {
+      continue;
+    }
+    for (const auto& [first, second] : elements_[v].SequenceIds()) {
+      if (first == second) {
+        is_vertex_visited[first] = true;
+        continue;
+      }
+      const UndirectedEdge edge{first, second};
+      const detail::UndirectedEdgeElements<Element>& edge_elements{
+        edges_.at(edge)};
+      const Element* const element{
+        first == edge.first
+          ? edge_elements.forward_edge
+          : edge_elements.backward_edge};
+      new_indices[element - old_elements] = next_index++;
+    }
+  }
+
+  std::vector<Element, ArenaAllocator<Element>> elements(
+      num_vertices_ + num_edge_elements,
+      Element{std::make_pair(-1, -1), elements_.get_allocator().GetArena()},
+      elements_.get_allocator());
+  Element::CopySequences(
+      old_elements, elements.data(), elements_.size(), new_indices.data());
+  const auto relocate{[&](const Element* element) {
+    return elements.data() + new_indices[element - old_elements];
+  }};
+
+  std::vector<Element*, ArenaAllocator<Element*>> free_edge_elements(
+      free_edge_elements_.get_allocator());
+  free_edge_elements.reserve(num_edge_elements - num_used_edge_elements);
+  // List the free elements from the back so that new edges take the elements
+  // right after the used ones first.
+  for (int64_t i = num_vertices_ + num_edge_elements - 1; i >= next_index;
+       i--) {
+    free_edge_elements.emplace_back(&elements[i]);
+  }
+  decltype(edges_) edges(
+      0,
+      UndirectedEdgeHash{},
+      std::equal_to<UndirectedEdge>{},
+      edges_.get_allocator());
+  edges.reserve(edges_.size());
+  for (const auto& [edge, edge_elements] : edges_) {
+    edges.emplace(
+        edge,
+        detail::UndirectedEdgeElements<Element>{
+          relocate(edge_elements.forward_edge),
+          relocate(edge_elements.backward_edge)});
+  }
+
+  // The old elements are destroyed along with the swapped-out containers.
+  elements_.swap(elements);
+  free_edge_elements_.swap(free_edge_elements);
+  edges_.swap(edges);
+}
+
+template <typename Element>
+bool BasicDynamicForest<Element>::IsConnected(Vertex u, Vertex v) const {
+  detail::ValidateVertex(u, num_vertices_);
+  detail::ValidateVertex(v, num_vertices_);
+  return elements_[u].GetRepresentative() == elements_[v].GetRepresentative();
+}
+
+template <typename Element>
+bool BasicDynamicForest<Element>::HasEdge(const UndirectedEdge& edge) const {
+  detail::ValidateEdge(edge, num_vertices_);
+  return edges_.find(edge) != edges_.end();
+}
+
+template <typename Element>
+void BasicDynamicForest<Element>::AddEdge(const UndirectedEdge& edge) {
+  detail::ValidateEdge(edge, num_vertices_);
+
+  detail::UndirectedEdgeElements<Element> edge_elements{
+    AllocateEdgeElements(edge)};
+  edges_.emplace(edge, edge_elements);
+
+  const Vertex u{edge.first};
+  const Vertex v{edge.second};
+  Element* const uv{edge_elements.forward_edge};
+  Element* const vu{edge_elements.backward_edge};
+  Element& u_element{elements_[u]};
+  Element* const u_successor{elements_[u].Split()};
+  Element& v_element{elements_[v]};
+  Element* const& v_successor{elements_[v].Split()};
+  Element::Join(&u_element, uv);
+  Element::Join(&u_element, v_successor);
+  Element::Join(&u_element, &v_element);
+  Element::Join(&u_element, vu);
+  Element::Join(&u_element, u_successor);
+}
+
+template <typename Element>
+void BasicDynamicForest<Element>::DeleteEdge(const UndirectedEdge& edge) {
+  const auto& edge_it{edges_.find(edge)};
+  ASSERT_MSG(
+      edge_it != edges_.end(),
+      "Edge " << edge << " is not in the forest.");
+  detail::UndirectedEdgeElements<Element> edge_elements{edge_it->second};
+  Element* const uv{edge_elements.forward_edge};
+  Element* const vu{edge_elements.backward_edge};
+  edges_.erase(edge_it);
+
+  Element* const uv_successor{uv->Split()};
+  // After splitting the tour, we'll need to know whether edge (u, v) appeared
+  // before (v, u) or not in the tour in order to know how to join everything
+  // back together.
+  const bool is_uv_before_vu_in_tour{
+    uv->GetRepresentative() != vu->GetRepresentative()};
+  Element* const vu_successor{vu->Split()};
+  Element* const uv_predecessor{uv->GetPredecessor()};
+  if (uv_predecessor != nullptr) {
+    uv_predecessor->Split();
+  }
+  Element* const vu_predecessor{vu->GetPredecessor()};
+  if (vu_predecessor != nullptr) {
+    vu_predecessor->Split();
+  }
+  if (is_uv_before_vu_in_tour) {
+    Element::Join(uv_predecessor, vu_successor);
+  } else {
+    Element::Join(vu_predecessor, uv_successor);
+  }
+  // We're freeing `uv` and `vu` here. How do we know that none of
+  // `uv_predecessor`, `vu_predecessor`, `uv_successor`, and `vu_successor`
+  // point to either of them?
+  // Answer: Edge (u, v) can't immediately precede (v, u) in the tour because
+  // the element for vertex v must fall somewhere in between. Likewise for
+  // (v, u) preceding (u, v). Thus the two edge elements are not adjacent.
+  FreeEdgeElements(edge_elements);
+}
+
+template <typename Element>
+int64_t BasicDynamicForest<Element>::GetSizeOfTree(Vertex v) const {
+  detail::ValidateVertex(v, num_vertices_);
+  // A tree of n vertices will have a sequence of 3n - 2 elements: 1 element for
+  // each of n vertices and 2 elements for each of n - 1 edges.
+  return (elements_[v].GetSize() + 2) / 3;
+}
+
+template <typename Element>
+int64_t BasicDynamicForest<Element>::GetNumberOfTrees() const {
+  return num_vertices_ - edges_.size();
+}
+
+template <typename Element>
+void BasicDynamicForest<Element>::Compact() {
+  ReallocateEdgeElements(2 * static_cast<int64_t>(edges_.size()));
+}
+
+template <typename Element>
+detail::ForestMemoryUsage BasicDynamicForest<Element>::GetMemoryUsage() const {
+  return {
+    .vertex_elements = num_vertices_ * sizeof(Element),
+    .edge_element_pool =
+      (elements_.capacity() - num_vertices_) * sizeof(Element)
+        + free_edge_elements_.capacity() * sizeof(Element*),
+    .sequence_nodes = Element::GetNodeBytes(elements_.data(), elements_.size()),
+    .edges = detail::GetHashTableBytes(edges_),
+  };
+}
+
+template <typename Element>
+void BasicDynamicForest<Element>::MarkEdge(
+    const UndirectedEdge& edge, bool mark) {
+  detail::ValidateEdge(edge, num_vertices_);
+  const auto& edge_it{edges_.find(edge)};
+  ASSERT_MSG(
+      edge_it != edges_.end(),
+      "Edge " << edge << " is not in the forest.");
+  // Only one of the edge's two elements carries the mark so that each marked
+  // element found corresponds to a distinct edge.
+  edge_it->second.forward_edge->Mark(detail::kEdgeMark, mark);
+}
+
+template <typename Element>
+void BasicDynamicForest<Element>::MarkVertex(Vertex v, bool mark) {
+  detail::ValidateVertex(v, num_vertices_);
+  elements_[v].Mark(detail::kVertexMark, mark);
+}
+
+template <typename Element>
+std::optional<UndirectedEdge>
+BasicDynamicForest<Element>::GetMarkedEdgeInTree(Vertex v) const {
+  detail::ValidateVertex(v, num_vertices_);
+  std::optional<Element*> edge{
+    elements_[v].FindMarkedElement(detail::kEdgeMark)};
+  if (edge.has_value()) {
+    const auto [edge_endpoint, edge_endpoint2]{(*edge)->id_};
+    return UndirectedEdge{edge_endpoint, edge_endpoint2};
+  } else {
+    return {};
+  }
+}
+
+template <typename Element>
+std::optional<Vertex>
+BasicDynamicForest<Element>::GetMarkedVertexInTree(Vertex v) const {
+  detail::ValidateVertex(v, num_vertices_);
+  std::optional<Element*> edge{
+    elements_[v].FindMarkedElement(detail::kVertexMark)};
+  if (edge.has_value()) {
+    return (*edge)->id_.first;
+  } else {
+    return {};
+  }
+}
+
+template <typename Element>
+std::vector<UndirectedEdge> BasicDynamicForest<Element>::TakeMarkedEdgesInTree(
+    Vertex v, int64_t max_edges) {
+  detail::ValidateVertex(v, num_vertices_);
+  std::vector<UndirectedEdge> edges;
+  for (const Element* element :
+       elements_[v].TakeMarkedElements(detail::kEdgeMark, max_edges)) {
+    edges.emplace_back(element->id_.first, element->id_.second);
+  }
+  return edges;
+}
+
+template <typename Element>
+std::vector<Vertex>
+BasicDynamicForest<Element>::GetMarkedVerticesInTree(Vertex v) const {
+  detail::ValidateVertex(v, num_vertices_);
+  std::vector<Vertex> vertices;
+  for (const Element* element : elements_[v].FindMarkedElements(
+         detail::kVertexMark, std::numeric_limits<int64_t>::max())) {
+    vertices.push_back(element->id_.first);
+  }
+  return vertices;
+}
+
+template <typename Element>
+void BasicDynamicForest<Element>::SetVertexValue(
+    Vertex v, const Value& value) {
+  detail::ValidateVertex(v, num_vertices_);
+  elements_[v].SetValue(value);
+}
+
+template <typename Element>
+const typename BasicDynamicForest<Element>::Value&
+BasicDynamicForest<Element>::GetVertexValue(Vertex v) const {
+  detail::ValidateVertex(v, num_vertices_);
+  return elements_[v].GetValue();
+}
+
+template <typename Element>
+const typename BasicDynamicForest<Element>::Value&
+BasicDynamicForest<Element>::GetTreeAggregate(Vertex v) const {
+  detail::ValidateVertex(v, num_vertices_);
+  return elements_[v].GetAggregate();
+}
+
+template <typename Element>
+std::pair<
+  typename BasicDynamicForest<Element>::Value,
+  typename BasicDynamicForest<Element>::Value>
+BasicDynamicForest<Element>::GetEdgePrefixAggregates(
+    const UndirectedEdge& edge) const {
+  const auto& edge_it{edges_.find(edge)};
+  ASSERT_MSG(
+      edge_it != edges_.end(),
+      "Edge " << edge << " is not in the forest.");
+  return {
+    edge_it->second.forward_edge->GetPrefixAggregate(),
+    edge_it->second.backward_edge->GetPrefixAggregate()};
+}
@@ -0,0 +1,415 @@
+// This is implemented using the level structure of Holm et al.'s dynamic
+// connectivity algorithm (see dynamic_connectivity_impl.hpp), following the
+// minimum spanning forest variant in section 4 of the same paper:
+//   Jacob Holm, Kristian de Lichtenberg, and Mikkel Thorup. "Poly-logarithmic
+//   deterministic fully-dynamic algorithms for connectivity, minimum spanning
+//   tree, 2-edge, and biconnectivity." Journal of the ACM, 48(4):723–760, 2001.
+//
+// The spanning forests F_i and the non-tree edge levels satisfy the same
+// invariants as in `DynamicConnectivity`, and F_0 is additionally a minimum
+// spanning forest. When a forest edge of level l is deleted, we search each
+// level i = l, l - 1, ..., 0 for the lightest level-i replacement edge. At each
+// level, the lightest non-tree edge incident to the smaller tree is found from
+// the tree's aggregate; it is either a replacement edge or it gets promoted as
+// in `DynamicConnectivity`. The lightest replacement over all levels
+// reconnects the forest.
+//
+// The paper avoids looking past the highest level with a replacement edge by
+// keeping heavier edges on lower levels, which only survives insertions through
+// an involved reduction. Instead, we keep looking on lower levels for lighter
+// replacement edges, skipping levels whose lightest edge can't beat the best
+// replacement found so far. If the lightest replacement ends up on a level j
+// below the highest level with a replacement edge, the replacement edges above
+// level j move down to level j so that their endpoints stay connected in the
+// forest of their level. Since the search revisits levels, the promotions it
+// calls for wait until every level has been searched. They then run from the
+// highest level down, so each level's smaller tree is promoted before the
+// level below it merges more vertices into that tree.
+//
+// Lowering edges breaks the potential argument behind HDT's amortized bound:
+// an edge can climb and fall back repeatedly, so the O(log n) levels an edge
+// can climb no longer pay for its promotions. DeleteEdge is therefore not
+// polylogarithmic, even amortized. Getting the paper's O(log^4 n) bound would
+// mean replacing this scheme with its decremental-to-fully-dynamic reduction.
+//
+// Inserting an edge that is lighter than the heaviest forest edge on the cycle
+// it closes is handled by inserting it as a non-tree edge and then deleting and
+// reinserting that heaviest edge. `path_forest_`, a link-cut tree mirroring
+// F_0, finds the heaviest edge on the cycle.
+#include <dynamic_graph/dynamic_minimum_spanning_forest.hpp>
+
+#include <utility>
+
+#include <utilities/assert.hpp>
+
+namespace {
+
+detail::WeightedEdgeKey GetKey(
+    const UndirectedEdge& edge, DynamicMinimumSpanningForest::Weight weight) {
+  return {weight, edge.first, edge.second};
+}
+
+UndirectedEdge GetEdge(const detail::WeightedEdgeKey& key) {
+  return {std::get<1>(key), std::get<2>(key)};
+}
+
+}  // namespace
+
+DynamicMinimumSpanningForest::DynamicMinimumSpanningForest(
+    int64_t num_vertices, std::shared_ptr<MemoryArena> arena)
+    : arena_{std::move(arena)}
+    , num_vertices_{num_vertices}
+    , path_forest_{num_vertices, arena_.get()}
+    , edges_(
+        0,
+        UndirectedEdgeHash{},
+        std::equal_to<UndirectedEdge>{},
+        arena_.get()) {
+  ASSERT_MSG_ALWAYS(
+      num_vertices_ > 0,
+      "The number of vertices must be positive");
+  const int8_t num_levels = detail::FloorLog2(num_vertices_) + 1;
+  spanning_forests_ =
+    std::vector<Forest>{
+      static_cast<std::size_t>(num_levels),
+      Forest{num_vertices_, arena_.get()}};
+  non_tree_adjacency_lists_.reserve(num_levels);
+  for (int8_t i = 0; i < num_levels; i++) {
+    non_tree_adjacency_lists_.emplace_back(
+        static_cast<std::size_t>(num_vertices_),
+        AdjacencyList(arena_.get()),
+        arena_.get());
+  }
+}
+
+DynamicMinimumSpanningForest::~DynamicMinimumSpanningForest() {}
+
+DynamicMinimumSpanningForest::DynamicMinimumSpanningForest(
+    DynamicMinimumSpanningForest&& other) noexcept
+    : arena_{other.arena_}
+    , num_vertices_{other.num_vertices_}
+    , spanning_forests_{std::move(other.spanning_forests_)}
+    , non_tree_adjacency_lists_{std::move(other.non_tree_adjacency_lists_)}
+    , path_forest_{std::move(other.path_forest_)}
+    , edges_{std::move(other.edges_)}
+    , forest_weight_{other.forest_weight_} {}
+
+bool DynamicMinimumSpanningForest::IsConnected(Vertex u, Vertex v) const {
+  return spanning_forests_[0].IsConnected(u, v);
+}
+
+bool DynamicMinimumSpanningForest::HasEdge(const UndirectedEdge& edge) const {
+  return edges_.find(edge) != edges_.end();
+}
+
+bool DynamicMinimumSpanningForest::IsInForest(
+    const UndirectedEdge& edge) const {
+  const auto& edge_it{edges_.find(edge)};
+  ASSERT_MSG_ALWAYS(
+      edge_it != edges_.end(),
+      "Edge " << edge << " is not in the graph");
+  return edge_it->second.type == detail::EdgeType::kTree;
+}
+
+DynamicMinimumSpanningForest::Weight
+DynamicMinimumSpanningForest::GetEdgeWeight(const UndirectedEdge& edge) const {
+  const auto& edge_it{edges_.find(edge)};
+  ASSERT_MSG_ALWAYS(
+      edge_it != edges_.end(),
+      "Edge " << edge << " is not in the graph");
+  return edge_it->second.weight;
+}
+
+int64_t
+DynamicMinimumSpanningForest::GetSizeOfConnectedComponent(Vertex v) const {
+  return spanning_forests_[0].GetSizeOfTree(v);
+}
+
+int64_t DynamicMinimumSpanningForest::GetNumberOfConnectedComponents() const {
+  return spanning_forests_[0].GetNumberOfTrees();
+}
+
+DynamicMinimumSpanningForest::Weight
+DynamicMinimumSpanningForest::GetForestWeight() const {
+  return forest_weight_;
+}
+
+// Sets the value of `v` in F_`level` to its lightest incident level-`level`
+// non-tree edge.
+void DynamicMinimumSpanningForest::UpdateVertexValue(
+    Vertex v, detail::Level level) {
+  const AdjacencyList& adj_list{non_tree_adjacency_lists_[level][v]};
+  const detail::WeightedEdgeKey lightest{
+    adj_list.empty() ? detail::LightestEdge::Identity() : *adj_list.begin()};
+  Forest& forest{spanning_forests_[level]};
+  if (forest.GetVertexValue(v) != lightest) {
+    forest.SetVertexValue(v, lightest);
+  }
+}
+
+void DynamicMinimumSpanningForest::AddEdgeToAdjacencyList(
+    const UndirectedEdge& edge, Weight weight, detail::Level level) {
+  const detail::WeightedEdgeKey key{GetKey(edge, weight)};
+  for (const Vertex endpoint : {edge.first, edge.second}) {
+    non_tree_adjacency_lists_[level][endpoint].emplace(key);
+    UpdateVertexValue(endpoint, level);
+  }
+}
+
+void DynamicMinimumSpanningForest::DeleteEdgeFromAdjacencyList(
+    const UndirectedEdge& edge, Weight weight, detail::Level level) {
+  const detail::WeightedEdgeKey key{GetKey(edge, weight)};
+  for (const Vertex endpoint : {edge.first, edge.second}) {
+    non_tree_adjacency_lists_[level][endpoint].erase(key);
+    UpdateVertexValue(endpoint, level);
+  }
+}
+
+// Changes the level of non-tree edge `edge` from `old_level` to `new_level`.
+void DynamicMinimumSpanningForest::MoveNonTreeEdge(
+    const UndirectedEdge& edge,
+    detail::Level old_level,
+    detail::Level new_level) {
+  detail::WeightedEdgeInfo& info{edges_.at(edge)};
+  DeleteEdgeFromAdjacencyList(edge, info.weight, old_level);
+  AddEdgeToAdjacencyList(edge, info.weight, new_level);
+  info.level = new_level;
+}
+
+// Add edge `edge` as a level-0 non-tree edge.
+void DynamicMinimumSpanningForest::AddNonTreeEdge(
+    const UndirectedEdge& edge, Weight weight) {
+  const detail::WeightedEdgeInfo edge_info{
+    .level = 0,
+    .type = detail::EdgeType::kNonTree,
+    .weight = weight,
+  };
+  edges_.emplace(edge, edge_info);
+  AddEdgeToAdjacencyList(edge, weight, 0);
+}
+
+// Add edge `edge` as a level-0 tree edge.
+void DynamicMinimumSpanningForest::AddTreeEdge(
+    const UndirectedEdge& edge, Weight weight) {
+  const detail::WeightedEdgeInfo edge_info{
+    .level = 0,
+    .type = detail::EdgeType::kTree,
+    .weight = weight,
+  };
+  edges_.emplace(edge, edge_info);
+  spanning_forests_[0].AddEdge(edge);
+  // We mark level-i edges in F_i.
+  spanning_forests_[0].MarkEdge(edge, true);
+  path_forest_.AddEdge(edge, weight);
+  forest_weight_ += weight;
+}
+
+void DynamicMinimumSpanningForest::AddEdge(
+    const UndirectedEdge& edge, Weight weight) {
+  detail::ValidateEdge(edge, num_vertices_);
+  ASSERT_MSG(edge.first != edge.second, edge << " is a self-loop edge");
+  ASSERT_MSG(!HasEdge(edge), "Edge " << edge << " is already in the graph");
+
+  if (!IsConnected(edge.first, edge.second)) {
+    AddTreeEdge(edge, weight);
+    return;
+  }
+
+  const UndirectedEdge heaviest_edge{
+    path_forest_.GetHeaviestEdgeOnPath(edge.first, edge.second)};
+  const Weight heaviest_weight{edges_.at(heaviest_edge).weight};
+  AddNonTreeEdge(edge, weight);
+  if (GetKey(edge, weight) < GetKey(heaviest_edge, heaviest_weight)) {
+    // `edge` belongs in the minimum spanning forest in place of
+    // `heaviest_edge`. Every other edge crossing the cut left by deleting
+    // `heaviest_edge` is heavier than `heaviest_edge`, so `edge` is picked as
+    // the replacement.
+    DeleteEdge(heaviest_edge);
+    AddNonTreeEdge(heaviest_edge, heaviest_weight);
+  }
+}
+
+// Promotes the level-`level` tree edges in `v`'s tree in F_`level` to level
+// (`level` + 1).
+void DynamicMinimumSpanningForest::PromoteTreeEdges(
+    Vertex v, detail::Level level) {
+  const detail::Level next_level = level + 1;
+  Forest& forest{spanning_forests_[level]};
+  ASSERT_MSG(
+      forest.GetSizeOfTree(v) <= (num_vertices_ >> next_level),
+      "Promoting a tree of size " << forest.GetSizeOfTree(v)
+        << " to level " << static_cast<int32_t>(next_level));
+  Forest& next_forest{spanning_forests_[next_level]};
+  for (const UndirectedEdge& tree_edge : forest.TakeMarkedEdgesInTree(
+         v, std::numeric_limits<int64_t>::max())) {
+    edges_.at(tree_edge).level = next_level;
+    next_forest.AddEdge(tree_edge);
+    next_forest.MarkEdge(tree_edge, true);
+  }
+}
+
+// Looks at level-`level` non-tree edges incident to `v`'s tree in F_`level`
+// from lightest to heaviest and returns the first one that leaves the tree,
+// stopping early at edges heavier than `bound`. The edges before it don't leave
+// the tree. They are taken out of the level-`level` adjacency lists and
+// appended to `non_replacement_edges` so that the caller can promote them once
+// the tree's tree edges are promoted.
+std::optional<detail::WeightedEdgeKey>
+DynamicMinimumSpanningForest::FindReplacementEdge(
+    Vertex v,
+    detail::Level level,
+    const std::optional<detail::WeightedEdgeKey>& bound,
+    std::vector<UndirectedEdge>* non_replacement_edges) {
+  const Forest& forest{spanning_forests_[level]};
+  while (true) {
+    const detail::WeightedEdgeKey lightest{forest.GetTreeAggregate(v)};
+    if (lightest == detail::LightestEdge::Identity()
+        || (bound.has_value() && *bound < lightest)) {
+      return {};
+    }
+    const UndirectedEdge candidate{GetEdge(lightest)};
+    if (!forest.IsConnected(candidate.first, candidate.second)) {
+      return lightest;
+    }
+    DeleteEdgeFromAdjacencyList(candidate, std::get<0>(lightest), level);
+    non_replacement_edges->push_back(candidate);
+  }
+}
+
+// Moves every level-`level` non-tree edge that leaves `v`'s tree in F_`level`
+// down to level `new_level`, promoting the edges that don't leave the tree
+// along the way.
+//
+// The tree edges of `v`'s tree must already be promoted.
+void DynamicMinimumSpanningForest::LowerReplacementEdges(
+    Vertex v, detail::Level level, detail::Level new_level) {
+  const Forest& forest{spanning_forests_[level]};
+  while (true) {
+    const detail::WeightedEdgeKey lightest{forest.GetTreeAggregate(v)};
+    if (lightest == detail::LightestEdge::Identity()) {
+      return;
+    }
+    const UndirectedEdge candidate{GetEdge(lightest)};
+    MoveNonTreeEdge(
+        candidate,
+        level,
+        forest.IsConnected(candidate.first, candidate.second)
+          ? level + 1
+          : new_level);
+  }
+}
+
+// Searches on levels `level` and lower for the lightest non-tree edge that
+// reconnects the endpoints of `edge` and converts it into a tree edge if any
+// such edge is found.
+void DynamicMinimumSpanningForest::ReplaceTreeEdge(
+    const UndirectedEdge& edge, detail::Level level) {
+  // `smaller_endpoints[i]` is the endpoint of `edge` in the smaller of the two
+  // trees of F_i that deleting `edge` leaves.
+  std::vector<Vertex> smaller_endpoints(level + 1);
+  // `non_replacement_edges[i]` holds the level-i non-tree edges that the search
+  // on level i looked at and found not to leave the smaller tree.
+  std::vector<std::vector<UndirectedEdge>> non_replacement_edges(level + 1);
+  std::vector<bool> is_searched(level + 1, false);
+  std::optional<detail::WeightedEdgeKey> replacement;
+  // Lowest searched level.
+  detail::Level lowest_searched_level = level + 1;
+  // Search without promoting any tree edges yet. Promoting the smaller tree of
+  // a level merges trees on the level above, and the trees of every level
+  // must still be the ones that deleting `edge` left when their edges get
+  // promoted or lowered below.
+  for (detail::Level i = level; i >= 0; i--) {
+    const Forest& forest{spanning_forests_[i]};
+    Vertex u{edge.first};
+    Vertex v{edge.second};
+    if (forest.GetSizeOfTree(u) > forest.GetSizeOfTree(v)) {
+      std::swap(u, v);
+    }
+    smaller_endpoints[i] = u;
+
+    // Skip the level if none of its edges can beat the replacement found so
+    // far. Any level-i replacement edge is incident to both trees.
+    const detail::WeightedEdgeKey lightest{
+      detail::LightestEdge::Combine(
+          forest.GetTreeAggregate(u), forest.GetTreeAggregate(v))};
+    if (lightest == detail::LightestEdge::Identity()
+        || (replacement.has_value() && *replacement < lightest)) {
+      continue;
+    }
+    lowest_searched_level = i;
+    is_searched[i] = true;
+    const std::optional<detail::WeightedEdgeKey> level_replacement{
+      FindReplacementEdge(u, i, replacement, &non_replacement_edges[i])};
+    if (level_replacement.has_value()) {
+      replacement = level_replacement;
+    }
+  }
+
+  // The replacement edge goes on the lowest searched level. Putting it any
+  // higher would join a tree promoted from that level with the other side of
+  // the cut and break the bound on tree sizes. The replacement edges on higher
+  // levels then move down to that level so that their endpoints stay
+  // connected in the forest of their level.
+  //
+  // Levels are handled from highest to lowest so that promoting the smaller
+  // tree of a level happens before the level below merges trees into it.
+  const detail::Level new_level{lowest_searched_level};
+  for (detail::Level i = level; i >= new_level; i--) {
+    const bool is_lowered{replacement.has_value() && i > new_level};
+    if (!is_searched[i] && !is_lowered) {
+      continue;
+    }
+    PromoteTreeEdges(smaller_endpoints[i], i);
+    for (const UndirectedEdge& non_tree_edge : non_replacement_edges[i]) {
+      detail::WeightedEdgeInfo& info{edges_.at(non_tree_edge)};
+      AddEdgeToAdjacencyList(non_tree_edge, info.weight, i + 1);
+      info.level = i + 1;
+    }
+    if (is_lowered) {
+      LowerReplacementEdges(smaller_endpoints[i], i, new_level);
+    }
+  }
+
+  if (!replacement.has_value()) {
+    // There is no replacement edge. The endpoints of `edge` are disconnected.
+    return;
+  }
+
+  const UndirectedEdge replacement_edge{GetEdge(*replacement)};
+  const Weight weight{std::get<0>(*replacement)};
+  DeleteEdgeFromAdjacencyList(replacement_edge, weight, new_level);
+  detail::WeightedEdgeInfo& info{edges_.at(replacement_edge)};
+  info.level = new_level;
+  info.type = detail::EdgeType::kTree;
+  for (detail::Level l = new_level; l >= 0; l--) {
+    spanning_forests_[l].AddEdge(replacement_edge);
+  }
+  spanning_forests_[new_level].MarkEdge(replacement_edge, true);
+  path_forest_.AddEdge(replacement_edge, weight);
+  forest_weight_ += weight;
+}
+
+void DynamicMinimumSpanningForest::DeleteEdge(const UndirectedEdge& edge) {
+  detail::ValidateEdge(edge, num_vertices_);
+  const auto& edge_it{edges_.find(edge)};
+  ASSERT_MSG_ALWAYS(
+      edge_it != edges_.end(),
+      "Edge " << edge << " is not in the graph");
+  const detail::WeightedEdgeInfo edge_info{edge_it->second};
+  edges_.erase(edge_it);
+
+  switch (edge_info.type) {
+    case detail::EdgeType::kNonTree:
+      DeleteEdgeFromAdjacencyList(edge, edge_info.weight, edge_info.level);
+      break;
+    case detail::EdgeType::kTree:
+      forest_weight_ -= edge_info.weight;
+      path_forest_.DeleteEdge(edge);
+      spanning_forests_[edge_info.level].MarkEdge(edge, false);
+      for (detail::Level l{edge_info.level}; l >= 0; l--) {
+        spanning_forests_[l].DeleteEdge(edge);
+      }
+      ReplaceTreeEdge(edge, edge_info.level);
+      break;
+  }
+}
@@ -1,6 +1,7 @@
 #include <dynamic_graph/graph.hpp>
 
 #include <algorithm>
+#include <vector>
 
 #include <utilities/hash.hpp>
 
@@ -20,3 +21,55 @@ bool operator==(const UndirectedEdge& e1, const UndirectedEdge& e2) {
 std::size_t UndirectedEdgeHash::operator()(const UndirectedEdge& edge) const {
   return CombineHashes(Hash(edge.first), Hash(edge.second));
 }
+
+std::vector<Vertex> ComputeLocalityOrder(
+    int64_t num_vertices, const std::vector<UndirectedEdge>& edges) {
+  // Store the adjacency lists contiguously: the neighbors of v are
+  // `neighbors[offsets[v]]` through `neighbors[offsets[v + 1] - 1]`.
+  std::vector<int64_t> offsets(num_vertices + 1, 0);
+  for (const UndirectedEdge& edge : edges) {
+    offsets[edge.first + 1]++;
+    offsets[edge.second + 1]++;
+  }
+  for (Vertex v = 0; v < num_vertices; v++) {
+    offsets[v + 1] += offsets[v];
+  }
+  std::vector<Vertex> neighbors(offsets[num_vertices]);
+  {
+    std::vector<int64_t> next_slot(offsets.begin(), offsets.end() - 1);
+    for (const UndirectedEdge& edge : edges) {
+      neighbors[next_slot[edge.first]++] = edge.second;
+      neighbors[next_slot[edge.second]++] = edge.first;
+    }
+  }
+
+  std::vector<Vertex> new_ids(num_vertices, -1);
+  Vertex next_id{0};
+  // Depth-first search stack of (vertex, index of next neighbor to look at).
+  std::vector<std::pair<Vertex, int64_t>> stack;
+  for (Vertex root = 0; root < num_vertices; root++) {
+    if (new_ids[root] != -1 || offsets[root] == offsets[root + 1]) {
+      continue;
+    }
+    new_ids[root] = next_id++;
+    stack.emplace_back(root, offsets[root]);
+    while (!stack.empty()) {
+      auto& [v, next_neighbor_index] = stack.back();
+      if (next_neighbor_index == offsets[v + 1]) {
+        stack.pop_back();
+        continue;
+      }
+      const Vertex neighbor{neighbors[next_neighbor_index++]};
+      if (new_ids[neighbor] == -1) {
+        new_ids[neighbor] = next_id++;
+        stack.emplace_back(neighbor, offsets[neighbor]);
+      }
+    }
+  }
+  for (Vertex v = 0; v < num_vertices; v++) {
+    if (new_ids[v] == -1) {
+      new_ids[v] = next_id++;
+    }
+  }
+  return new_ids;
+}
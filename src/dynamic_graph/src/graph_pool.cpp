@@ -0,0 +1,76 @@
+#include <dynamic_graph/graph_pool.hpp>
+
+#include <memory>
+#include <utility>
+
+#include <utilities/assert.hpp>
+
+GraphPool::GraphPool(std::shared_ptr<MemoryArena> arena)
+  : arena_{std::move(arena)} {}
+
+GraphPool::GraphId GraphPool::AddGraph(int64_t num_vertices) {
+  GraphId id;
+  {
+    std::lock_guard<std::mutex> lock{pool_mutex_};
+    if (free_ids_.empty()) {
+      const GraphId first_id{
+        static_cast<GraphId>(slabs_.size()) * kSlabSize};
+      slabs_.emplace_back(std::make_unique<Slab>());
+      // Hand out the lowest identifiers of the new slab first.
+      for (GraphId i = kSlabSize - 1; i >= 0; i--) {
+        free_ids_.push_back(first_id + i);
+      }
+    }
+    id = free_ids_.back();
+    free_ids_.pop_back();
+    num_graphs_++;
+  }
+  // Construct the graph outside of `pool_mutex_` so that tenants can be added
+  // in parallel.
+  Slot& slot{GetSlot(id)};
+  std::lock_guard<std::mutex> lock{slot.mutex};
+  slot.graph.emplace(
+      num_vertices,
+      arena_ == nullptr
+        ? nullptr
+        : std::make_shared<SubArena>(arena_, kGraphArenaChunkSize));
+  return id;
+}
+
+void GraphPool::RemoveGraph(GraphId id) {
+  Slot& slot{GetSlot(id)};
+  {
+    std::lock_guard<std::mutex> lock{slot.mutex};
+    ASSERT_MSG_ALWAYS(
+        slot.graph.has_value(), "Graph " << id << " is not in the pool");
+    slot.graph.reset();
+  }
+  std::lock_guard<std::mutex> lock{pool_mutex_};
+  free_ids_.push_back(id);
+  num_graphs_--;
+}
+
+bool GraphPool::HasGraph(GraphId id) const {
+  {
+    std::lock_guard<std::mutex> lock{pool_mutex_};
+    if (id < 0 || id >= static_cast<GraphId>(slabs_.size()) * kSlabSize) {
+      return false;
+    }
+  }
+  Slot& slot{GetSlot(id)};
+  std::lock_guard<std::mutex> lock{slot.mutex};
+  return slot.graph.has_value();
+}
+
+int64_t GraphPool::GetNumberOfGraphs() const {
+  std::lock_guard<std::mutex> lock{pool_mutex_};
+  return num_graphs_;
+}
+
+GraphPool::Slot& GraphPool::GetSlot(GraphId id) const {
+  std::lock_guard<std::mutex> lock{pool_mutex_};
+  ASSERT_MSG_ALWAYS(
+      0 <= id && id < static_cast<GraphId>(slabs_.size()) * kSlabSize,
+      "Graph " << id << " is not in the pool");
+  return (*slabs_[id / kSlabSize])[id % kSlabSize];
+}
@@ -0,0 +1,4 @@
+#include <dynamic_graph/keyed_dynamic_connectivity.hpp>
+
+template class KeyedDynamicConnectivity<int64_t>;
+template class KeyedDynamicConnectivity<std::string>;
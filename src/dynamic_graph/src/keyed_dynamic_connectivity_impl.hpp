@@ -0,0 +1,306 @@
+// Keys are mapped to dense vertices with a linear-probing hash table. Since
+// the graph holds at most `max_num_vertices` keys at once, the table is sized
+// once, to a power of two at least twice that, and never grows. Entries of
+// removed keys are filled by shifting later entries of the same probe run back
+// (Knuth's Algorithm R), so there are no tombstones and a lookup stops at the
+// first empty entry.
+//
+// This file holds the definitions of the templates declared in
+// <dynamic_graph/keyed_dynamic_connectivity.hpp> and should only be included
+// from there.
+#include <dynamic_graph/keyed_dynamic_connectivity.hpp>
+
+#include <algorithm>
+#include <unordered_set>
+#include <utility>
+
+#include <utilities/assert.hpp>
+#include <utilities/hash.hpp>
+
+namespace detail {
+
+template <typename Key, typename KeyHash>
+VertexTable<Key, KeyHash>::VertexTable(int64_t max_num_keys) {
+  std::size_t num_entries{2};
+  while (num_entries < 2 * static_cast<std::size_t>(max_num_keys)) {
+    num_entries *= 2;
+  }
+  entries_.resize(num_entries, Entry{Key{}, -1});
+  index_mask_ = num_entries - 1;
+}
+
+// Returns the index at which probing for `key` starts.
+template <typename Key, typename KeyHash>
+std::size_t VertexTable<Key, KeyHash>::GetHomeIndex(const Key& key) const {
+  // `std::hash` is often the identity on integers, which makes linear probing
+  // cluster badly on sequential or aligned keys, so mix the hash first.
+  return Hash(static_cast<int64_t>(key_hash_(key))) & index_mask_;
+}
+
+template <typename Key, typename KeyHash>
+std::size_t VertexTable<Key, KeyHash>::Probe(const Key& key) const {
+  std::size_t index{GetHomeIndex(key)};
+  while (entries_[index].vertex != -1 && !(entries_[index].key == key)) {
+    index = (index + 1) & index_mask_;
+  }
+  return index;
+}
+
+template <typename Key, typename KeyHash>
+Vertex VertexTable<Key, KeyHash>::Find(const Key& key) const {
+  return entries_[Probe(key)].vertex;
+}
+
+template <typename Key, typename KeyHash>
+void VertexTable<Key, KeyHash>::Insert(const Key& key, Vertex v) {
+  Entry& entry{entries_[Probe(key)]};
+  ASSERT_MSG(entry.vertex == -1, "Key is already in the table");
+  entry.key = key;
+  entry.vertex = v;
+}
+
+template <typename Key, typename KeyHash>
+void VertexTable<Key, KeyHash>::Erase(const Key& key) {
+  std::size_t hole{Probe(key)};
+  ASSERT_MSG(entries_[hole].vertex != -1, "Key is not in the table");
+  std::size_t index{hole};
+  while (true) {
+    index = (index + 1) & index_mask_;
+    Entry& entry{entries_[index]};
+    if (entry.vertex == -1) {
+      break;
+    }
+    // The entry can fill the hole unless its home index lies cyclically in
+    // (`hole`, `index`], in which case moving it would put it before its home.
+    const std::size_t home{GetHomeIndex(entry.key)};
+    const bool is_home_after_hole{
+      ((home - hole - 1) & index_mask_) < ((index - hole) & index_mask_)};
+    if (!is_home_after_hole) {
+      entries_[hole] = std::move(entry);
+      hole = index;
+    }
+  }
+  entries_[hole] = Entry{Key{}, -1};
+}
+
+template <typename Key, typename KeyHash>
+void VertexTable<Key, KeyHash>::Clear() {
+  for (Entry& entry : entries_) {
+    entry = Entry{Key{}, -1};
+  }
+}
+
+}  // namespace detail
+
+template <typename Key, typename KeyHash>
+KeyedDynamicConnectivity<Key, KeyHash>::KeyedDynamicConnectivity(
+    int64_t max_num_vertices)
+    : max_num_vertices_{max_num_vertices}
+    , graph_{std::in_place, max_num_vertices}
+    , vertices_{max_num_vertices}
+    , keys_(max_num_vertices)
+    , degrees_(max_num_vertices, 0) {
+  free_vertices_.reserve(max_num_vertices);
+  // Hand out low vertices first.
+  for (Vertex v = max_num_vertices - 1; v >= 0; v--) {
+    free_vertices_.push_back(v);
+  }
+}
+
+template <typename Key, typename KeyHash>
+KeyedDynamicConnectivity<Key, KeyHash>::KeyedDynamicConnectivity(
+    int64_t max_num_vertices,
+    const std::vector<std::pair<Key, Key>>& edges)
+    : KeyedDynamicConnectivity{max_num_vertices} {
+  // Map the keys to vertices in the order they appear, then let `Rebuild()`
+  // renumber them before adding any edges to the graph.
+  std::vector<UndirectedEdge> vertex_edges;
+  vertex_edges.reserve(edges.size());
+  std::unordered_set<UndirectedEdge, UndirectedEdgeHash> edge_set;
+  edge_set.reserve(edges.size());
+  for (const auto& [u, v] : edges) {
+    ASSERT_MSG_ALWAYS(!(u == v), "Self-loop edges are not allowed");
+    Vertex u_vertex{vertices_.Find(u)};
+    Vertex v_vertex{vertices_.Find(v)};
+    CheckForFreeVertices((u_vertex == -1) + (v_vertex == -1));
+    if (u_vertex == -1) {
+      u_vertex = MapToFreeVertex(u);
+    }
+    if (v_vertex == -1) {
+      v_vertex = MapToFreeVertex(v);
+    }
+    const UndirectedEdge edge{u_vertex, v_vertex};
+    ASSERT_MSG_ALWAYS(
+        edge_set.insert(edge).second, "Edge is already in the graph");
+    degrees_[u_vertex]++;
+    degrees_[v_vertex]++;
+    vertex_edges.push_back(edge);
+  }
+  Rebuild(vertex_edges);
+}
+
+template <typename Key, typename KeyHash>
+bool KeyedDynamicConnectivity<Key, KeyHash>::IsConnected(
+    const Key& u, const Key& v) const {
+  if (u == v) {
+    return true;
+  }
+  const Vertex u_vertex{vertices_.Find(u)};
+  const Vertex v_vertex{vertices_.Find(v)};
+  return u_vertex != -1 && v_vertex != -1
+    && graph_->IsConnected(u_vertex, v_vertex);
+}
+
+template <typename Key, typename KeyHash>
+bool KeyedDynamicConnectivity<Key, KeyHash>::HasEdge(
+    const Key& u, const Key& v) const {
+  const Vertex u_vertex{vertices_.Find(u)};
+  const Vertex v_vertex{vertices_.Find(v)};
+  return u_vertex != -1 && v_vertex != -1 && u_vertex != v_vertex
+    && graph_->HasEdge({u_vertex, v_vertex});
+}
+
+template <typename Key, typename KeyHash>
+int64_t KeyedDynamicConnectivity<Key, KeyHash>::GetSizeOfConnectedComponent(
+    const Key& v) const {
+  const Vertex vertex{vertices_.Find(v)};
+  return vertex == -1 ? 1 : graph_->GetSizeOfConnectedComponent(vertex);
+}
+
+template <typename Key, typename KeyHash>
+int64_t KeyedDynamicConnectivity<Key, KeyHash>::
+GetNumberOfNonIsolatedVertices() const {
+  return static_cast<int64_t>(keys_.size() - free_vertices_.size());
+}
+
+// Checks that `num_vertices` keys can be mapped to free vertices. Updates call
+// this before mapping any key so that a failed update maps none.
+template <typename Key, typename KeyHash>
+void KeyedDynamicConnectivity<Key, KeyHash>::CheckForFreeVertices(
+    int64_t num_vertices) const {
+  ASSERT_MSG_ALWAYS(
+      static_cast<int64_t>(free_vertices_.size()) >= num_vertices,
+      "More than " << keys_.size() << " vertices have edges");
+}
+
+// Maps `key`, which must not be mapped yet, to a free vertex and returns the
+// vertex.
+template <typename Key, typename KeyHash>
+Vertex KeyedDynamicConnectivity<Key, KeyHash>::MapToFreeVertex(
+    const Key& key) {
+  CheckForFreeVertices(1);
+  const Vertex v{free_vertices_.back()};
+  free_vertices_.pop_back();
+  vertices_.Insert(key, v);
+  keys_[v] = key;
+  return v;
+}
+
+// Unmaps vertex `v` from its key if `v` has no edges left.
+template <typename Key, typename KeyHash>
+void KeyedDynamicConnectivity<Key, KeyHash>::ReleaseVertexIfIsolated(
+    Vertex v) {
+  if (degrees_[v] > 0) {
+    return;
+  }
+  vertices_.Erase(keys_[v]);
+  keys_[v] = Key{};
+  free_vertices_.push_back(v);
+}
+
+template <typename Key, typename KeyHash>
+void KeyedDynamicConnectivity<Key, KeyHash>::AddEdge(
+    const Key& u, const Key& v) {
+  ASSERT_MSG_ALWAYS(!(u == v), "Self-loop edges are not allowed");
+  Vertex u_vertex{vertices_.Find(u)};
+  Vertex v_vertex{vertices_.Find(v)};
+  ASSERT_MSG_ALWAYS(
+      u_vertex == -1 || v_vertex == -1
+        || !graph_->HasEdge({u_vertex, v_vertex}),
+      "Edge is already in the graph");
+  CheckForFreeVertices((u_vertex == -1) + (v_vertex == -1));
+  if (u_vertex == -1) {
+    u_vertex = MapToFreeVertex(u);
+  }
+  if (v_vertex == -1) {
+    v_vertex = MapToFreeVertex(v);
+  }
+  graph_->AddEdge({u_vertex, v_vertex});
+  degrees_[u_vertex]++;
+  degrees_[v_vertex]++;
+}
+
+template <typename Key, typename KeyHash>
+void KeyedDynamicConnectivity<Key, KeyHash>::DeleteEdge(
+    const Key& u, const Key& v) {
+  const Vertex u_vertex{vertices_.Find(u)};
+  const Vertex v_vertex{vertices_.Find(v)};
+  ASSERT_MSG_ALWAYS(
+      u_vertex != -1 && v_vertex != -1 && u_vertex != v_vertex
+        && graph_->HasEdge({u_vertex, v_vertex}),
+      "Edge is not in the graph");
+  graph_->DeleteEdge({u_vertex, v_vertex});
+  degrees_[u_vertex]--;
+  degrees_[v_vertex]--;
+  ReleaseVertexIfIsolated(u_vertex);
+  ReleaseVertexIfIsolated(v_vertex);
+}
+
+template <typename Key, typename KeyHash>
+void KeyedDynamicConnectivity<Key, KeyHash>::ReorderVertices() {
+  std::vector<UndirectedEdge> edges;
+  graph_->ForEachEdge([&](const UndirectedEdge& edge) {
+    edges.push_back(edge);
+  });
+  Rebuild(edges);
+}
+
+// Renumbers the vertices with `ComputeLocalityOrder()` and replaces the graph
+// with one holding `edges`, which are given in the old numbering. `degrees_`
+// must already count `edges`.
+template <typename Key, typename KeyHash>
+void KeyedDynamicConnectivity<Key, KeyHash>::Rebuild(
+    const std::vector<UndirectedEdge>& edges) {
+  // Vertices without edges are numbered last, so the vertices with keys end up
+  // at the front and the free vertices at the back.
+  const std::vector<Vertex> new_ids{
+    ComputeLocalityOrder(max_num_vertices_, edges)};
+  const int64_t num_mapped_vertices{GetNumberOfNonIsolatedVertices()};
+
+  std::vector<Key> new_keys(max_num_vertices_);
+  std::vector<int64_t> new_degrees(max_num_vertices_, 0);
+  vertices_.Clear();
+  for (Vertex v = 0; v < max_num_vertices_; v++) {
+    if (degrees_[v] > 0) {
+      const Vertex new_v{new_ids[v]};
+      new_keys[new_v] = std::move(keys_[v]);
+      new_degrees[new_v] = degrees_[v];
+      vertices_.Insert(new_keys[new_v], new_v);
+    }
+  }
+  keys_ = std::move(new_keys);
+  degrees_ = std::move(new_degrees);
+  free_vertices_.clear();
+  for (Vertex v = max_num_vertices_ - 1; v >= num_mapped_vertices; v--) {
+    free_vertices_.push_back(v);
+  }
+
+  // Add each vertex's edge to its parent in the depth-first search tree first,
+  // so that the spanning forest is the search tree. The Euler tour elements of
+  // consecutive edges are allocated next to each other, so the tour is then
+  // laid out roughly in the order it is traversed.
+  std::vector<std::pair<Vertex, Vertex>> new_edges;
+  new_edges.reserve(edges.size());
+  for (const UndirectedEdge& edge : edges) {
+    const UndirectedEdge new_edge{new_ids[edge.first], new_ids[edge.second]};
+    // Sorting by (higher endpoint, negated lower endpoint) puts the edge
+    // to a vertex's parent first among the edges to its earlier neighbors.
+    new_edges.emplace_back(new_edge.second, -new_edge.first);
+  }
+  std::sort(new_edges.begin(), new_edges.end());
+  graph_.reset();
+  graph_.emplace(max_num_vertices_);
+  for (const auto& [v, negated_u] : new_edges) {
+    graph_->AddEdge({-negated_u, v});
+  }
+}
@@ -0,0 +1,249 @@
+// This is implemented using Sleator and Tarjan's link-cut trees as described in
+// the following paper:
+//   Daniel D. Sleator and Robert E. Tarjan. "Self-adjusting binary search
+//   trees." Journal of the ACM, 32(3):652–686, 1985.
+//
+// The forest is decomposed into vertex-disjoint paths, and each path is stored
+// in a splay tree ordered by depth. Edges are represented by nodes of their own
+// placed between their endpoints so that edge weights can be aggregated over
+// paths.
+#include <link_cut_tree.hpp>
+
+#include <limits>
+#include <utility>
+
+#include <dynamic_forest.hpp>
+#include <utilities/assert.hpp>
+
+namespace {
+
+// Key held by vertex nodes. It is smaller than the key of every edge.
+const detail::WeightedEdgeKey kVertexKey{
+  std::numeric_limits<int64_t>::min(), -1, -1};
+
+}  // namespace
+
+LinkCutTree::LinkCutTree(int64_t num_vertices, MemoryArena* arena)
+    : num_vertices_{num_vertices}
+    , nodes_(arena)
+    , free_edge_nodes_(arena)
+    , edges_(0, UndirectedEdgeHash{}, std::equal_to<UndirectedEdge>{}, arena) {
+  ASSERT_MSG_ALWAYS(
+      num_vertices_ > 0,
+      "The number of vertices must be positive");
+
+  const int64_t max_num_edges{num_vertices_ - 1};
+  nodes_.resize(num_vertices_ + max_num_edges);
+  for (Node& node : nodes_) {
+    node.key = node.max_key = kVertexKey;
+  }
+  free_edge_nodes_.reserve(max_num_edges);
+  for (int64_t i = num_vertices_; i < num_vertices_ + max_num_edges; i++) {
+    free_edge_nodes_.emplace_back(&nodes_[i]);
+  }
+  edges_.reserve(max_num_edges);
+}
+
+LinkCutTree::~LinkCutTree() {}
+
+LinkCutTree::LinkCutTree(const LinkCutTree& other)
+    : num_vertices_{other.num_vertices_}
+    , nodes_{other.nodes_}
+    , free_edge_nodes_(other.free_edge_nodes_.get_allocator())
+    , edges_(
+        0,
+        UndirectedEdgeHash{},
+        std::equal_to<UndirectedEdge>{},
+        other.edges_.get_allocator()) {
+  const Node* const other_nodes{other.nodes_.data()};
+  Node* const nodes{nodes_.data()};
+  // Translates a pointer to a node of `other` into a pointer to the node at the
+  // same offset in `nodes_`.
+  const auto relocate{[&](const Node* node) -> Node* {
+    return node == nullptr ? nullptr : nodes + (node - other_nodes);
+  }};
+  for (Node& node : nodes_) {
+    node.children = {relocate(node.children[0]), relocate(node.children[1])};
+    node.parent = relocate(node.parent);
+  }
+  free_edge_nodes_.reserve(other.free_edge_nodes_.capacity());
+  for (const Node* node : other.free_edge_nodes_) {
+    free_edge_nodes_.emplace_back(relocate(node));
+  }
+  edges_.reserve(other.nodes_.size() - num_vertices_);
+  for (const auto& [edge, node] : other.edges_) {
+    edges_.emplace(edge, relocate(node));
+  }
+}
+
+LinkCutTree::LinkCutTree(LinkCutTree&& other) noexcept
+    : num_vertices_{other.num_vertices_}
+    , nodes_{std::move(other.nodes_)}
+    , free_edge_nodes_{std::move(other.free_edge_nodes_)}
+    , edges_{std::move(other.edges_)} {}
+
+bool LinkCutTree::IsSplayRoot(const Node* node) {
+  const Node* const parent{node->parent};
+  return parent == nullptr
+    || (parent->children[0] != node && parent->children[1] != node);
+}
+
+void LinkCutTree::PushReversal(Node* node) {
+  if (node->reversed) {
+    std::swap(node->children[0], node->children[1]);
+    for (Node* child : node->children) {
+      if (child != nullptr) {
+        child->reversed = !child->reversed;
+      }
+    }
+    node->reversed = false;
+  }
+}
+
+void LinkCutTree::UpdateMaxKey(Node* node) {
+  node->max_key = node->key;
+  for (const Node* child : node->children) {
+    if (child != nullptr && node->max_key < child->max_key) {
+      node->max_key = child->max_key;
+    }
+  }
+}
+
+// Rotates `node` above its parent in their splay tree.
+void LinkCutTree::Rotate(Node* node) {
+  Node* const parent{node->parent};
+  Node* const grandparent{parent->parent};
+  const int direction{parent->children[1] == node ? 1 : 0};
+  if (!IsSplayRoot(parent)) {
+    grandparent->children[grandparent->children[1] == parent ? 1 : 0] = node;
+  }
+  node->parent = grandparent;
+  Node* const middle_child{node->children[1 - direction]};
+  parent->children[direction] = middle_child;
+  if (middle_child != nullptr) {
+    middle_child->parent = parent;
+  }
+  node->children[1 - direction] = parent;
+  parent->parent = node;
+  UpdateMaxKey(parent);
+  UpdateMaxKey(node);
+}
+
+// Moves `node` to the root of its splay tree.
+void LinkCutTree::Splay(Node* node) {
+  // Pending reversals must be pushed down from the root before rotating.
+  splay_path_.clear();
+  for (Node* current = node; ; current = current->parent) {
+    splay_path_.emplace_back(current);
+    if (IsSplayRoot(current)) {
+      break;
+    }
+  }
+  for (auto it = splay_path_.rbegin(); it != splay_path_.rend(); it++) {
+    PushReversal(*it);
+  }
+
+  while (!IsSplayRoot(node)) {
+    Node* const parent{node->parent};
+    if (!IsSplayRoot(parent)) {
+      Node* const grandparent{parent->parent};
+      const bool is_zig_zig{
+        (parent->children[0] == node) == (grandparent->children[0] == parent)};
+      Rotate(is_zig_zig ? parent : node);
+    }
+    Rotate(node);
+  }
+}
+
+// Makes the path from `node` to the root of its tree into a single splay tree
+// rooted at `node`, with `node` the deepest node on the path.
+void LinkCutTree::Access(Node* node) {
+  Node* previous{nullptr};
+  for (Node* current = node; current != nullptr; current = current->parent) {
+    Splay(current);
+    current->children[1] = previous;
+    UpdateMaxKey(current);
+    previous = current;
+  }
+  Splay(node);
+}
+
+// Reroots the tree containing `node` at `node`.
+void LinkCutTree::MakeRoot(Node* node) {
+  Access(node);
+  node->reversed = !node->reversed;
+  PushReversal(node);
+}
+
+void LinkCutTree::Link(Node* child, Node* parent) {
+  MakeRoot(child);
+  child->parent = parent;
+}
+
+void LinkCutTree::Cut(Node* u, Node* v) {
+  MakeRoot(u);
+  Access(v);
+  // The path from `u` to `v` is just the two nodes, so `u` is `v`'s only
+  // descendant in the splay tree.
+  ASSERT_MSG(
+      v->children[0] == u && u->children[0] == nullptr
+        && u->children[1] == nullptr,
+      "Cut nodes are not adjacent");
+  v->children[0] = nullptr;
+  u->parent = nullptr;
+  UpdateMaxKey(v);
+}
+
+void LinkCutTree::AddEdge(const UndirectedEdge& edge, int64_t weight) {
+  detail::ValidateEdge(edge, num_vertices_);
+  ASSERT_MSG(
+      edges_.find(edge) == edges_.end(),
+      "Edge " << edge << " is already in the forest.");
+  Node* const edge_node{free_edge_nodes_.back()};
+  free_edge_nodes_.pop_back();
+  edge_node->key = edge_node->max_key =
+    detail::WeightedEdgeKey{weight, edge.first, edge.second};
+  edges_.emplace(edge, edge_node);
+
+  Link(edge_node, &nodes_[edge.first]);
+  Link(&nodes_[edge.second], edge_node);
+}
+
+void LinkCutTree::DeleteEdge(const UndirectedEdge& edge) {
+  const auto& edge_it{edges_.find(edge)};
+  ASSERT_MSG(
+      edge_it != edges_.end(),
+      "Edge " << edge << " is not in the forest.");
+  Node* const edge_node{edge_it->second};
+  edges_.erase(edge_it);
+
+  Cut(&nodes_[edge.first], edge_node);
+  Cut(edge_node, &nodes_[edge.second]);
+  *edge_node = Node{};
+  edge_node->key = edge_node->max_key = kVertexKey;
+  free_edge_nodes_.emplace_back(edge_node);
+}
+
+UndirectedEdge LinkCutTree::GetHeaviestEdgeOnPath(Vertex u, Vertex v) {
+  detail::ValidateVertex(u, num_vertices_);
+  detail::ValidateVertex(v, num_vertices_);
+  ASSERT_MSG(u != v, "Path endpoints must be distinct");
+  Node* const v_node{&nodes_[v]};
+  MakeRoot(&nodes_[u]);
+  Access(v_node);
+  // `v_node`'s splay tree now holds exactly the path from `u` to `v`.
+  const detail::WeightedEdgeKey& max_key{v_node->max_key};
+  return UndirectedEdge{std::get<1>(max_key), std::get<2>(max_key)};
+}
+
+void LinkCutTree::Compact() {
+  edges_.rehash(0);
+  splay_path_.shrink_to_fit();
+}
+
+std::size_t LinkCutTree::GetMemoryUsage() const {
+  return nodes_.capacity() * sizeof(Node)
+    + free_edge_nodes_.capacity() * sizeof(Node*)
+    + detail::GetHashTableBytes(edges_)
+    + splay_path_.capacity() * sizeof(Node*);
+}
@@ -0,0 +1,119 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+#include <dynamic_graph/graph.hpp>
+#include <dynamic_graph/memory_arena.hpp>
+
+namespace detail {
+
+// Orders weighted edges by weight, breaking ties by endpoints so that no two
+// distinct edges compare equal.
+typedef std::tuple<int64_t, Vertex, Vertex> WeightedEdgeKey;
+
+}  // namespace detail
+
+// This is a data structure for the dynamic trees problem that, unlike
+// `DynamicForest`, answers queries about the path between two vertices. Each
+// edge carries a weight, and the forest can report the heaviest edge on any
+// path.
+class LinkCutTree {
+ public:
+  // Initializes forest with `num_vertices` vertices and no edges. If `arena` is
+  // not null, the forest's storage is allocated from it.
+  //
+  // Efficiency: linear in the size of the forest.
+  explicit LinkCutTree(int64_t num_vertices, MemoryArena* arena = nullptr);
+  LinkCutTree() = delete;
+
+  ~LinkCutTree();
+
+  // Copies the forest.
+  //
+  // Efficiency: linear in the size of the forest.
+  LinkCutTree(const LinkCutTree& other);
+  LinkCutTree& operator=(const LinkCutTree& other) = delete;
+
+  LinkCutTree(LinkCutTree&& other) noexcept;
+  LinkCutTree& operator=(LinkCutTree&& other) noexcept = delete;
+
+  // Adds edge with weight `weight` to forest.
+  //
+  // Adding this edge must not create a cycle in the forest.
+  //
+  // Efficiency: logarithmic in the size of the forest, amortized.
+  void AddEdge(const UndirectedEdge& edge, int64_t weight);
+
+  // Removes edge from forest.
+  //
+  // The edge must be in the forest.
+  //
+  // Efficiency: logarithmic in the size of the forest, amortized.
+  void DeleteEdge(const UndirectedEdge& edge);
+
+  // Returns the heaviest edge on the path between vertices `u` and `v`, with
+  // ties broken as in `detail::WeightedEdgeKey`.
+  //
+  // `u` and `v` must be distinct and connected.
+  //
+  // Efficiency: logarithmic in the size of the forest, amortized.
+  UndirectedEdge GetHeaviestEdgeOnPath(Vertex u, Vertex v);
+
+  // Returns the number of bytes of memory that the forest holds. The size of
+  // the edge map is an estimate.
+  //
+  // Efficiency: constant.
+  std::size_t GetMemoryUsage() const;
+
+  // Shrinks the map of edges and scratch space to fit. The preallocated edge
+  // nodes are kept.
+  //
+  // Efficiency: linear in the number of edges in the forest.
+  void Compact();
+
+ private:
+  // Node in a splay tree representing a path in the forest. There is a node
+  // for each vertex and for each edge.
+  struct Node {
+    std::array<Node*, 2> children{{nullptr, nullptr}};
+    // Parent in the splay tree, or, for the root of a splay tree, the parent of
+    // the path in the forest.
+    Node* parent{nullptr};
+    // Whether the children of all nodes in this subtree should be swapped.
+    bool reversed{false};
+    detail::WeightedEdgeKey key;
+    // Largest key in this node's splay subtree.
+    detail::WeightedEdgeKey max_key;
+  };
+
+  static bool IsSplayRoot(const Node* node);
+  static void PushReversal(Node* node);
+  static void UpdateMaxKey(Node* node);
+  static void Rotate(Node* node);
+  void Splay(Node* node);
+  void Access(Node* node);
+  void MakeRoot(Node* node);
+  void Link(Node* child, Node* parent);
+  void Cut(Node* u, Node* v);
+
+  const int64_t num_vertices_;
+  // The first `num_vertices_` nodes represent vertices. The rest are
+  // preallocated nodes for edges, of which the unused ones are listed in
+  // `free_edge_nodes_`.
+  std::vector<Node, ArenaAllocator<Node>> nodes_;
+  std::vector<Node*, ArenaAllocator<Node*>> free_edge_nodes_;
+  std::unordered_map<
+    UndirectedEdge,
+    Node*,
+    UndirectedEdgeHash,
+    std::equal_to<UndirectedEdge>,
+    ArenaAllocator<std::pair<const UndirectedEdge, Node*>>> edges_;
+  // Scratch space for `Splay()`.
+  std::vector<Node*> splay_path_;
+};
@@ -0,0 +1,304 @@
+// Small allocations are rounded up to a size class, bumped out of the current
+// chunk, and, once freed, kept on the free list of their class for reuse; the
+// arena never returns chunk memory to the system before it is destroyed. Sizes
+// up to 4 * kGranularity are classes of their own, and each doubling above
+// that is split into four classes, so rounding wastes less than a fifth of an
+// allocation while memory freed by one size can be reused by nearby sizes.
+// The data structures that use the arena allocate most of their memory up
+// front in a few large arrays and then allocate and free small hash table
+// nodes, set nodes, and B-tree nodes, which suits this scheme.
+#include <dynamic_graph/memory_arena.hpp>
+
+#include <fcntl.h>
+#include <linux/falloc.h>
+#include <linux/mempolicy.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <cstddef>
+#include <cstdlib>
+#include <utility>
+#include <vector>
+
+#include <utilities/assert.hpp>
+
+namespace {
+
+constexpr std::size_t k2MbPageSize{std::size_t{1} << 21};
+constexpr std::size_t k1GbPageSize{std::size_t{1} << 30};
+// Not defined by older headers. `MAP_HUGETLB` takes the base-2 logarithm of
+// the page size in these bits.
+constexpr int kMapHugeShift{26};
+
+std::size_t RoundUp(std::size_t n, std::size_t multiple) {
+  return (n + multiple - 1) / multiple * multiple;
+}
+
+int GetLog2(std::size_t n) {
+  int log{0};
+  while ((std::size_t{1} << log) < n) {
+    log++;
+  }
+  return log;
+}
+
+// Asks the kernel to spread the pages of the range across all NUMA nodes.
+// Failure, e.g. on a kernel without NUMA support, leaves the default
+// placement, which is fine since placement only affects performance.
+void InterleaveAcrossNodes(void* address, std::size_t num_bytes) {
+  // The kernel ignores nodes that do not exist.
+  unsigned long node_mask[16];
+  for (unsigned long& word : node_mask) {
+    word = ~0UL;
+  }
+  syscall(
+      SYS_mbind,
+      address,
+      num_bytes,
+      MPOL_INTERLEAVE,
+      node_mask,
+      sizeof(node_mask) * 8,
+      0);
+}
+
+// Creates a file in `directory` and deletes it, returning a descriptor for the
+// file, which lives on until the descriptor is closed.
+int CreateUnlinkedFile(const std::string& directory) {
+  const std::string path{directory + "/dynamic_graph_arena_XXXXXX"};
+  std::vector<char> path_buffer(path.begin(), path.end());
+  path_buffer.push_back('\0');
+  const int file_descriptor{mkstemp(path_buffer.data())};
+  ASSERT_MSG_ALWAYS(
+      file_descriptor != -1,
+      "Failed to create an arena file in " << directory);
+  unlink(path_buffer.data());
+  return file_descriptor;
+}
+
+}  // namespace
+
+MemoryArena::~MemoryArena() {}
+
+ChunkedArena::ChunkedArena(std::size_t page_size, std::size_t chunk_size)
+    : page_size_{page_size}
+    , chunk_size_{RoundUp(chunk_size > 0 ? chunk_size : 1, page_size)} {
+  std::size_t class_size;
+  free_lists_.resize(GetSizeClass(chunk_size_ / 4, &class_size) + 1);
+}
+
+std::size_t ChunkedArena::GetSizeClass(
+    std::size_t num_bytes, std::size_t* class_size) {
+  constexpr std::size_t kClassesPerDoubling{4};
+  constexpr std::size_t kMaxLinearSize{kClassesPerDoubling * kGranularity};
+  if (num_bytes <= kMaxLinearSize) {
+    *class_size = RoundUp(num_bytes > 0 ? num_bytes : 1, kGranularity);
+    return *class_size / kGranularity - 1;
+  }
+  // 2^`log_size` < `num_bytes` <= 2^(`log_size` + 1). That range is split into
+  // `kClassesPerDoubling` classes of `step` bytes each.
+  const int log_size{63 - __builtin_clzll(num_bytes - 1)};
+  const std::size_t lower_bound{std::size_t{1} << log_size};
+  const std::size_t step{lower_bound / kClassesPerDoubling};
+  *class_size = RoundUp(num_bytes, step);
+  const std::size_t num_doublings{
+    static_cast<std::size_t>(log_size - GetLog2(kMaxLinearSize))};
+  return kClassesPerDoubling * (num_doublings + 1)
+    + (*class_size - lower_bound) / step - 1;
+}
+
+void ChunkedArena::UnmapAll() {
+  std::lock_guard<std::mutex> lock{mutex_};
+  for (const auto& [address, num_bytes] : mappings_) {
+    Unmap(address, num_bytes);
+  }
+  mappings_.clear();
+  num_mapped_bytes_ = 0;
+}
+
+void* ChunkedArena::Allocate(std::size_t num_bytes, std::size_t alignment) {
+  ASSERT_MSG_ALWAYS(
+      alignment <= kGranularity,
+      "Alignment " << alignment << " is not supported");
+  std::size_t size;
+  const std::size_t size_class{GetSizeClass(num_bytes, &size)};
+  std::lock_guard<std::mutex> lock{mutex_};
+  // Allocations of more than a quarter chunk would waste too much of the
+  // chunk they leave behind, so they get mappings of their own.
+  if (size > chunk_size_ / 4) {
+    const std::size_t mapping_size{RoundUp(size, page_size_)};
+    void* const address{Map(mapping_size)};
+    mappings_.emplace(address, mapping_size);
+    num_mapped_bytes_ += mapping_size;
+    return address;
+  }
+  std::vector<void*>& free_list{free_lists_[size_class]};
+  if (!free_list.empty()) {
+    void* const pointer{free_list.back()};
+    free_list.pop_back();
+    return pointer;
+  }
+  if (static_cast<std::size_t>(chunk_end_ - chunk_position_) < size) {
+    chunk_position_ = static_cast<char*>(Map(chunk_size_));
+    chunk_end_ = chunk_position_ + chunk_size_;
+    mappings_.emplace(chunk_position_, chunk_size_);
+    num_mapped_bytes_ += chunk_size_;
+  }
+  void* const pointer{chunk_position_};
+  chunk_position_ += size;
+  return pointer;
+}
+
+void ChunkedArena::Deallocate(
+    void* pointer, std::size_t num_bytes, std::size_t) {
+  std::size_t size;
+  const std::size_t size_class{GetSizeClass(num_bytes, &size)};
+  std::lock_guard<std::mutex> lock{mutex_};
+  if (size > chunk_size_ / 4) {
+    const auto mapping_it{mappings_.find(pointer)};
+    ASSERT_MSG_ALWAYS(
+        mapping_it != mappings_.end(),
+        "Pointer was not allocated by this arena");
+    Unmap(mapping_it->first, mapping_it->second);
+    num_mapped_bytes_ -= mapping_it->second;
+    mappings_.erase(mapping_it);
+    return;
+  }
+  free_lists_[size_class].push_back(pointer);
+}
+
+std::size_t ChunkedArena::GetNumberOfMappedBytes() const {
+  std::lock_guard<std::mutex> lock{mutex_};
+  return num_mapped_bytes_;
+}
+
+HugePageArena::HugePageArena(
+    PageSize page_size, NumaPlacement placement, std::size_t chunk_size)
+    : ChunkedArena{
+        page_size == PageSize::k1Gb ? k1GbPageSize : k2MbPageSize, chunk_size}
+    , placement_{placement} {}
+
+HugePageArena::~HugePageArena() {
+  UnmapAll();
+}
+
+void* HugePageArena::Map(std::size_t num_bytes) {
+  void* address{mmap(
+      nullptr,
+      num_bytes,
+      PROT_READ | PROT_WRITE,
+      MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB
+        | (GetLog2(page_size_) << kMapHugeShift),
+      -1,
+      0)};
+  if (address != MAP_FAILED) {
+    huge_tlb_mappings_.insert(address);
+    num_huge_tlb_bytes_ += num_bytes;
+  } else {
+    // No huge pages of this size are reserved, so fall back to transparent
+    // huge pages. Over-allocate so that the range can be aligned to a huge
+    // page, since the kernel only backs aligned ranges with huge pages.
+    const std::size_t padded_num_bytes{num_bytes + page_size_};
+    void* const padded_address{mmap(
+        nullptr,
+        padded_num_bytes,
+        PROT_READ | PROT_WRITE,
+        MAP_PRIVATE | MAP_ANONYMOUS,
+        -1,
+        0)};
+    ASSERT_MSG_ALWAYS(
+        padded_address != MAP_FAILED,
+        "Failed to map " << num_bytes << " bytes");
+    char* const begin{static_cast<char*>(padded_address)};
+    char* const aligned_begin{reinterpret_cast<char*>(RoundUp(
+        reinterpret_cast<std::uintptr_t>(begin), page_size_))};
+    char* const end{begin + padded_num_bytes};
+    if (aligned_begin > begin) {
+      munmap(begin, aligned_begin - begin);
+    }
+    if (end > aligned_begin + num_bytes) {
+      munmap(aligned_begin + num_bytes, end - (aligned_begin + num_bytes));
+    }
+    address = aligned_begin;
+    madvise(address, num_bytes, MADV_HUGEPAGE);
+  }
+  if (placement_ == NumaPlacement::kInterleave) {
+    InterleaveAcrossNodes(address, num_bytes);
+  }
+  return address;
+}
+
+void HugePageArena::Unmap(void* address, std::size_t num_bytes) {
+  munmap(address, num_bytes);
+  if (huge_tlb_mappings_.erase(address) > 0) {
+    num_huge_tlb_bytes_ -= num_bytes;
+  }
+}
+
+std::size_t HugePageArena::GetNumberOfHugeTlbBytes() const {
+  return num_huge_tlb_bytes_.load(std::memory_order_relaxed);
+}
+
+MappedFileArena::MappedFileArena(
+    const std::string& directory, std::size_t chunk_size)
+    : ChunkedArena{static_cast<std::size_t>(sysconf(_SC_PAGESIZE)), chunk_size}
+    , file_descriptor_{CreateUnlinkedFile(directory)} {}
+
+MappedFileArena::~MappedFileArena() {
+  UnmapAll();
+  close(file_descriptor_);
+}
+
+void* MappedFileArena::Map(std::size_t num_bytes) {
+  // Grow the file rather than reuse the holes of freed mappings so that each
+  // mapping is one contiguous range of the file.
+  const int64_t offset{file_size_};
+  const int truncate_result{ftruncate(file_descriptor_, offset + num_bytes)};
+  ASSERT_MSG_ALWAYS(
+      truncate_result == 0,
+      "Failed to grow the arena file to " << offset + num_bytes << " bytes");
+  void* const address{mmap(
+      nullptr,
+      num_bytes,
+      PROT_READ | PROT_WRITE,
+      MAP_SHARED,
+      file_descriptor_,
+      offset)};
+  ASSERT_MSG_ALWAYS(
+      address != MAP_FAILED,
+      "Failed to map " << num_bytes << " bytes of the arena file");
+  file_size_ += num_bytes;
+  file_offsets_.emplace(address, offset);
+  return address;
+}
+
+void MappedFileArena::Unmap(void* address, std::size_t num_bytes) {
+  munmap(address, num_bytes);
+  const auto offset_it{file_offsets_.find(address)};
+  // Give the disk space back. This is best effort since not every file system
+  // supports punching holes, and the file is deleted with the arena anyway.
+  fallocate(
+      file_descriptor_,
+      FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE,
+      offset_it->second,
+      num_bytes);
+  file_offsets_.erase(offset_it);
+}
+
+SubArena::SubArena(std::shared_ptr<MemoryArena> parent, std::size_t chunk_size)
+    : ChunkedArena{alignof(std::max_align_t), chunk_size}
+    , parent_{std::move(parent)} {
+  ASSERT_MSG_ALWAYS(parent_ != nullptr, "A sub-arena needs a parent arena");
+}
+
+SubArena::~SubArena() {
+  UnmapAll();
+}
+
+void* SubArena::Map(std::size_t num_bytes) {
+  return parent_->Allocate(num_bytes, alignof(std::max_align_t));
+}
+
+void SubArena::Unmap(void* address, std::size_t num_bytes) {
+  parent_->Deallocate(address, num_bytes, alignof(std::max_align_t));
+}
@@ -0,0 +1,29 @@
+#include <dynamic_graph/operation.hpp>
+
+#include <cstring>
+
+// Fields are copied as they lie in memory, which matches the little-endian
+// encoding only on little-endian machines.
+static_assert(
+    __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__,
+    "The operation encoding assumes a little-endian machine");
+
+void EncodeOperation(const Operation& operation, char* out) {
+  std::memset(out, 0, 8);
+  out[0] = static_cast<char>(operation.type);
+  std::memcpy(out + 8, &operation.edge.first, sizeof(Vertex));
+  std::memcpy(out + 16, &operation.edge.second, sizeof(Vertex));
+}
+
+std::optional<Operation> DecodeOperation(const char* in) {
+  const uint8_t op_code{static_cast<uint8_t>(in[0])};
+  if (op_code < static_cast<uint8_t>(Operation::Type::kAddEdge)
+      || op_code > static_cast<uint8_t>(Operation::Type::kIsConnected)) {
+    return std::nullopt;
+  }
+  Vertex u;
+  Vertex v;
+  std::memcpy(&u, in + 8, sizeof(Vertex));
+  std::memcpy(&v, in + 16, sizeof(Vertex));
+  return Operation{static_cast<Operation::Type>(op_code), UndirectedEdge{u, v}};
+}
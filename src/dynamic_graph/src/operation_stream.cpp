@@ -0,0 +1,272 @@
+#include <dynamic_graph/operation_stream.hpp>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstring>
+#include <mutex>
+#include <thread>
+
+#include <utilities/assert.hpp>
+
+namespace {
+
+constexpr std::size_t kWriteBufferSize{std::size_t{1} << 16};
+
+uint64_t ReadWord(const char* in) {
+  uint64_t word;
+  std::memcpy(&word, in, sizeof(word));
+  return word;
+}
+
+// Returns nonzero if the encoded operation is invalid.
+uint64_t IsInvalid(const char* in, uint64_t num_vertices) {
+  const uint64_t header{ReadWord(in)};
+  // Op codes 1, 2, and 3 are valid, and the bytes after the op code must be
+  // zero. Negative vertices wrap around to be at least `num_vertices`.
+  return static_cast<uint64_t>((header - 1) >= 3)
+    | static_cast<uint64_t>(ReadWord(in + 8) >= num_vertices)
+    | static_cast<uint64_t>(ReadWord(in + 16) >= num_vertices);
+}
+
+}  // namespace
+
+int64_t DecodeOperations(
+    const char* in,
+    int64_t num_operations,
+    int64_t num_vertices,
+    OperationBatch* batch) {
+  batch->types.resize(num_operations);
+  batch->first_vertices.resize(num_operations);
+  batch->second_vertices.resize(num_operations);
+  Operation::Type* const types{batch->types.data()};
+  Vertex* const first_vertices{batch->first_vertices.data()};
+  Vertex* const second_vertices{batch->second_vertices.data()};
+  // Decode and check every operation without branching on any of them, and
+  // only look for the culprit if some check failed.
+  uint64_t is_invalid{0};
+  for (int64_t i = 0; i < num_operations; i++) {
+    const char* const operation{in + i * kEncodedOperationSize};
+    types[i] = static_cast<Operation::Type>(operation[0]);
+    std::memcpy(&first_vertices[i], operation + 8, sizeof(Vertex));
+    std::memcpy(&second_vertices[i], operation + 16, sizeof(Vertex));
+    is_invalid |= IsInvalid(operation, num_vertices);
+  }
+  if (is_invalid == 0) {
+    return num_operations;
+  }
+  for (int64_t i = 0; i < num_operations; i++) {
+    if (IsInvalid(in + i * kEncodedOperationSize, num_vertices) != 0) {
+      return i;
+    }
+  }
+  return num_operations;
+}
+
+OperationStreamReader::OperationStreamReader(const std::string& path)
+    : path_{path} {
+  const int file_descriptor{open(path_.c_str(), O_RDONLY | O_CLOEXEC)};
+  ASSERT_MSG_ALWAYS(file_descriptor != -1, "Failed to open " << path_);
+  struct stat file_status;
+  const int stat_result{fstat(file_descriptor, &file_status)};
+  ASSERT_MSG_ALWAYS(stat_result == 0, "Failed to stat " << path_);
+  size_ = file_status.st_size;
+  ASSERT_MSG_ALWAYS(
+      size_ % kEncodedOperationSize == 0,
+      path_ << " is not an operation stream: its size " << size_
+        << " is not a multiple of " << kEncodedOperationSize);
+  if (size_ > 0) {
+    void* const data{
+      mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, file_descriptor, 0)};
+    ASSERT_MSG_ALWAYS(data != MAP_FAILED, "Failed to map " << path_);
+    madvise(data, size_, MADV_SEQUENTIAL);
+    data_ = static_cast<const char*>(data);
+  }
+  close(file_descriptor);
+}
+
+OperationStreamReader::~OperationStreamReader() {
+  if (data_ != nullptr) {
+    munmap(const_cast<char*>(data_), size_);
+  }
+}
+
+int64_t OperationStreamReader::GetNumberOfOperations() const {
+  return size_ / kEncodedOperationSize;
+}
+
+int64_t OperationStreamReader::Decode(
+    int64_t begin,
+    int64_t end,
+    int64_t num_vertices,
+    OperationBatch* batch) const {
+  ASSERT_MSG(
+      0 <= begin && begin <= end && end <= GetNumberOfOperations(),
+      "Invalid range [" << begin << ", " << end << ")");
+  return begin + DecodeOperations(
+      data_ + begin * kEncodedOperationSize, end - begin, num_vertices, batch);
+}
+
+void OperationStreamReader::Prefetch(int64_t begin, int64_t end) const {
+  if (begin >= end) {
+    return;
+  }
+  // `madvise()` needs a page-aligned address.
+  const std::size_t page_size{static_cast<std::size_t>(sysconf(_SC_PAGESIZE))};
+  const std::size_t offset{
+    begin * kEncodedOperationSize / page_size * page_size};
+  madvise(
+      const_cast<char*>(data_) + offset,
+      end * kEncodedOperationSize - offset,
+      MADV_WILLNEED);
+}
+
+OperationStreamWriter::OperationStreamWriter(const std::string& path)
+    : path_{path} {
+  file_descriptor_ = open(
+      path_.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+  ASSERT_MSG_ALWAYS(file_descriptor_ != -1, "Failed to open " << path_);
+  buffer_.reserve(kWriteBufferSize);
+}
+
+OperationStreamWriter::~OperationStreamWriter() {
+  Flush();
+  close(file_descriptor_);
+}
+
+void OperationStreamWriter::Append(const Operation& operation) {
+  const std::size_t offset{buffer_.size()};
+  buffer_.resize(offset + kEncodedOperationSize);
+  EncodeOperation(operation, buffer_.data() + offset);
+  if (buffer_.size() + kEncodedOperationSize > kWriteBufferSize) {
+    Flush();
+  }
+}
+
+void OperationStreamWriter::Flush() {
+  const char* data{buffer_.data()};
+  std::size_t size{buffer_.size()};
+  while (size > 0) {
+    const ssize_t num_written{write(file_descriptor_, data, size)};
+    ASSERT_MSG_ALWAYS(num_written >= 0, "Failed to write to " << path_);
+    data += num_written;
+    size -= num_written;
+  }
+  buffer_.clear();
+}
+
+IngestStatistics IngestOperationStream(
+    const OperationStreamReader& stream,
+    DynamicConnectivity* graph,
+    int64_t batch_size) {
+  ASSERT_MSG_ALWAYS(batch_size > 0, "The batch size must be positive");
+  const int64_t num_operations{stream.GetNumberOfOperations()};
+  const int64_t num_vertices{graph->GetNumberOfVertices()};
+
+  // The decoder fills the two slots in turn while the calling thread applies
+  // them in the same order, so one slot is decoded while the other is applied.
+  struct Slot {
+    OperationBatch batch;
+    // Index in the stream of the operation after the batch.
+    int64_t end{0};
+    // Whether the operation at `end` is invalid.
+    bool is_followed_by_invalid_operation{false};
+    // Whether the decoder has filled the slot and the applier has yet to
+    // empty it.
+    bool is_full{false};
+  };
+  Slot slots[2];
+  std::mutex mutex;
+  std::condition_variable slot_changed;
+
+  std::thread decoder{[&] {
+    int64_t begin{0};
+    for (int32_t slot_index = 0; ; slot_index ^= 1) {
+      Slot& slot{slots[slot_index]};
+      {
+        std::unique_lock<std::mutex> lock{mutex};
+        slot_changed.wait(lock, [&] { return !slot.is_full; });
+      }
+      const int64_t end{std::min(begin + batch_size, num_operations)};
+      // Have the next batch read from disk while this one is decoded.
+      stream.Prefetch(end, std::min(end + batch_size, num_operations));
+      slot.end = stream.Decode(begin, end, num_vertices, &slot.batch);
+      slot.is_followed_by_invalid_operation = slot.end < end;
+      if (slot.is_followed_by_invalid_operation) {
+        // Decode the valid operations before the invalid one again so that
+        // they are applied.
+        stream.Decode(begin, slot.end, num_vertices, &slot.batch);
+      }
+      {
+        const std::lock_guard<std::mutex> lock{mutex};
+        slot.is_full = true;
+      }
+      slot_changed.notify_all();
+      if (slot.end == num_operations || slot.is_followed_by_invalid_operation) {
+        return;
+      }
+      begin = end;
+    }
+  }};
+
+  IngestStatistics statistics;
+  for (int32_t slot_index = 0; ; slot_index ^= 1) {
+    Slot& slot{slots[slot_index]};
+    {
+      std::unique_lock<std::mutex> lock{mutex};
+      slot_changed.wait(lock, [&] { return slot.is_full; });
+    }
+    const OperationBatch& batch{slot.batch};
+    const int64_t size{batch.GetSize()};
+    for (int64_t i = 0; i < size; i++) {
+      const Vertex u{batch.first_vertices[i]};
+      const Vertex v{batch.second_vertices[i]};
+      switch (batch.types[i]) {
+        case Operation::Type::kAddEdge: {
+          const UndirectedEdge edge{u, v};
+          if (u == v || graph->HasEdge(edge)) {
+            statistics.num_updates_skipped++;
+          } else {
+            graph->AddEdge(edge);
+            statistics.num_edges_added++;
+          }
+          break;
+        }
+        case Operation::Type::kDeleteEdge: {
+          const UndirectedEdge edge{u, v};
+          if (graph->HasEdge(edge)) {
+            graph->DeleteEdge(edge);
+            statistics.num_edges_deleted++;
+          } else {
+            statistics.num_updates_skipped++;
+          }
+          break;
+        }
+        case Operation::Type::kIsConnected:
+          statistics.num_queries++;
+          statistics.num_connected_queries += graph->IsConnected(u, v);
+          break;
+      }
+    }
+    const int64_t end{slot.end};
+    if (slot.is_followed_by_invalid_operation) {
+      decoder.join();
+      ASSERT_MSG_ALWAYS(
+          false, "Operation " << end << " of the stream is invalid");
+    }
+    if (end == num_operations) {
+      break;
+    }
+    {
+      const std::lock_guard<std::mutex> lock{mutex};
+      slot.is_full = false;
+    }
+    slot_changed.notify_all();
+  }
+  decoder.join();
+  return statistics;
+}
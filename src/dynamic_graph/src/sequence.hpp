@@ -2,16 +2,21 @@
 //
 // It is augmented to be used for representing tours in Euler tour trees,
 // which are in turn specialized for use in Holm et al.'s dynamic connectivity
-// algorithm. This use-case-specific augmentation could be abstracted out, but
-// it's not worth the effort for this small project.
+// algorithm. Besides that fixed augmentation, each element holds a value of a
+// monoid `Monoid` (see <dynamic_graph/aggregate.hpp>), and each sequence
+// maintains the combination of all of its elements' values.
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
 #include <array>
 #include <optional>
 #include <utility>
 #include <vector>
 
+#include <dynamic_graph/aggregate.hpp>
+#include <dynamic_graph/memory_arena.hpp>
+
 namespace sequence {
 
 namespace detail {
@@ -23,6 +28,7 @@ enum Direction {
 
 // Augmented info for each node about the node's subtree.
 // Specialized for use in Holm et al.'s dynamic connectivity algorithm.
+template <typename Monoid>
 struct SubtreeData {
   // Size of this node's subtree.
   int64_t size{1};
@@ -30,35 +36,52 @@ struct SubtreeData {
   // `has_marked[i]` stores whether any node in this subtree has `marked[i]`
   // true.
   std::array<bool, 2> has_marked{{false, false}};
+
+  // Combination of the values of the nodes in this subtree, in order.
+  typename Monoid::Value aggregate{Monoid::Identity()};
 };
 // Specialized for use in Holm et al.'s dynamic connectivity algorithm.
+template <typename Monoid>
 struct NodeData {
   std::array<bool, 2> marked{{false, false}};
+
+  typename Monoid::Value value{Monoid::Identity()};
 };
 
+// Returns a random treap priority.
+int64_t GeneratePriority();
+
 }  // namespace detail
 
 typedef std::pair<int64_t, int64_t> Id;
 
-// Usage: create single-element sequences with the `Element()` constructor, and
-// build bigger sequences from there.
-class Element {
+// Usage: create single-element sequences with the `AugmentedElement()`
+// constructor, and build bigger sequences from there.
+template <typename Monoid>
+class AugmentedElement {
  public:
+  typedef typename Monoid::Value Value;
+
   // Initializes a single sequence element.
-  explicit Element(const std::pair<int64_t, int64_t>& id);
-  Element();
+  //
+  // Treap nodes are the elements themselves, so `arena` is never allocated
+  // from. It exists to match `BTreeElement`.
+  explicit AugmentedElement(
+      const std::pair<int64_t, int64_t>& id,
+      MemoryArena* arena = nullptr);
+  AugmentedElement();
 
-  ~Element();
+  ~AugmentedElement();
 
   // Copies elements that are in single-element sequences. Copying will throw an
   // exception if attempted on an element that lives in a sequence of several
   // elements.
-  Element(const Element &other);
-  Element& operator=(const Element& other) = delete;  // unimplemented
+  AugmentedElement(const AugmentedElement &other);
+  AugmentedElement& operator=(const AugmentedElement& other) = delete;
   // Moves element. Other elements that point to the moved element will be
   // changed to point to the new element.
-  Element(Element&& other) noexcept;
-  Element& operator=(Element&& other) noexcept = delete;  // unimplemented
+  AugmentedElement(AugmentedElement&& other) noexcept;
+  AugmentedElement& operator=(AugmentedElement&& other) noexcept = delete;
 
   // Returns a representative of the sequence that the element lives in.
   //
@@ -67,13 +90,13 @@ class Element {
   // modified.
   //
   // Efficiency: logarithmic in the size of the element's sequence.
-  Element* GetRepresentative() const;
+  AugmentedElement* GetRepresentative() const;
 
   // Get element immediately preceding this element in the sequence. Returns
   // null if this element is the first element in the sequence.
   //
   // Efficiency: logarithmic in the size of the element's sequence.
-  Element* GetPredecessor() const;
+  AugmentedElement* GetPredecessor() const;
 
   // Concatenates the sequence containing `lesser` and the sequence containing
   // `greater`.
@@ -82,7 +105,7 @@ class Element {
   //
   // Efficiency: logarithmic in the sum of the sizes of `lesser` and `greater`'s
   // sequences.
-  static void Join(Element* lesser, Element* greater);
+  static void Join(AugmentedElement* lesser, AugmentedElement* greater);
 
   // Splits the sequence that this element lives in immediately after the
   // element.
@@ -94,7 +117,7 @@ class Element {
   // Returns what was formerly the successor of this element.
   //
   // Efficiency: logarithmic in the size of the element's sequence.
-  Element* Split();
+  AugmentedElement* Split();
 
   // Returns size of the sequence that the element lives in.
   //
@@ -110,12 +133,71 @@ class Element {
   // `index`-th index if such an element exists.
   //
   // Efficiency: logarithmic in the size of the element's sequence.
-  std::optional<Element*> FindMarkedElement(int32_t index) const;
+  std::optional<AugmentedElement*> FindMarkedElement(int32_t index) const;
+  // Returns up to `max_elements` elements in the calling element's sequence
+  // that are marked at their `index`-th index, in sequence order.
+  //
+  // Efficiency: O(k log(n / k)) where n is the size of the element's
+  // sequence and k is the number of elements returned.
+  std::vector<AugmentedElement*>
+  FindMarkedElements(int32_t index, int64_t max_elements) const;
+  // Same as `FindMarkedElements()`, but also unmarks the returned elements at
+  // index `index` in the same pass.
+  std::vector<AugmentedElement*>
+  TakeMarkedElements(int32_t index, int64_t max_elements);
+
+  // Sets the value of this element.
+  //
+  // Efficiency: logarithmic in the size of the element's sequence.
+  void SetValue(const Value& value);
+  // Returns the value of this element.
+  //
+  // Efficiency: constant.
+  const Value& GetValue() const;
+  // Returns the combination of the values of all elements in this element's
+  // sequence, in sequence order.
+  //
+  // Efficiency: logarithmic in the size of the element's sequence.
+  const Value& GetAggregate() const;
+  // Returns the combination of the values of this element and all elements
+  // before it in its sequence, in sequence order.
+  //
+  // Efficiency: logarithmic in the size of the element's sequence.
+  Value GetPrefixAggregate() const;
 
   // Returns the ids of the elements of the sequence in which this
   // element lives.
   std::vector<Id> SequenceIds() const;
 
+  // Copies the `num_elements` contiguous elements starting at `source`, along
+  // with the sequences they form, into the `num_elements` contiguous elements
+  // starting at `destination`, overwriting whatever `destination` held.
+  //
+  // If `destination_indices` is not null, `source[i]` is instead copied to
+  // `destination[destination_indices[i]]`, or not at all if
+  // `destination_indices[i]` is negative. Uncopied elements must live in
+  // single-element sequences.
+  //
+  // Every element that shares a sequence with a source element must itself be
+  // a source element.
+  //
+  // Efficiency: linear in `num_elements`.
+  static void CopySequences(
+      const AugmentedElement* source,
+      AugmentedElement* destination,
+      int64_t num_elements,
+      const int64_t* destination_indices = nullptr);
+
+  // Returns the number of bytes held by the sequences of the `num_elements`
+  // contiguous elements starting at `elements`, not counting the elements
+  // themselves. Every element that shares a sequence with one of these
+  // elements must itself be one of them.
+  //
+  // Treap nodes are the elements themselves, so this is always zero. It exists
+  // to match `BTreeElement`.
+  static std::size_t GetNodeBytes(
+      const AugmentedElement* elements, int64_t num_elements);
+
   // Identifier for the element.
   //
   // This is specialized for storing Euler tour elements. The identifier can
@@ -123,21 +205,35 @@ class Element {
   Id id_{-1, -1};
 
  private:
-  void AssignChild(detail::Direction direction, Element* child);
-  detail::SubtreeData GetChildSubtreeData(detail::Direction direction) const;
-  Element* GetRoot() const;
-  static Element* JoinRoots(Element* lesser, Element* greater);
-  static Element* JoinWithRootReturned(Element* lesser, Element* greater);
+  void AssignChild(detail::Direction direction, AugmentedElement* child);
+  bool ChildHasMarked(detail::Direction direction, int32_t index) const;
+  AugmentedElement* GetRoot() const;
+  static AugmentedElement*
+  JoinRoots(AugmentedElement* lesser, AugmentedElement* greater);
+  static AugmentedElement*
+  JoinWithRootReturned(AugmentedElement* lesser, AugmentedElement* greater);
   void SequenceIds(std::vector<Id>* output) const;
+  void CollectMarkedElements(
+      int32_t index,
+      bool unmark,
+      int64_t max_elements,
+      std::vector<AugmentedElement*>* output);
   void UpdateSubtreeData();
 
-  std::array<Element*, 2> children_{nullptr, nullptr};
-  Element* parent_{nullptr};
+  std::array<AugmentedElement*, 2> children_{nullptr, nullptr};
+  AugmentedElement* parent_{nullptr};
   // Treap invariant: the priority of a node must be at least as great as the
   // priority of each of its children.
   int64_t priority_;
-  detail::NodeData node_data_{};
-  detail::SubtreeData subtree_data_{};
+  detail::NodeData<Monoid> node_data_{};
+  detail::SubtreeData<Monoid> subtree_data_{};
 };
 
+// Sequence element that holds no value.
+typedef AugmentedElement<NoAggregate> Element;
+
+extern template class AugmentedElement<NoAggregate>;
+
 }  // namespace sequence
+
+#include <sequence_impl.hpp>
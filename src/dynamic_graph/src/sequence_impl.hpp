@@ -0,0 +1,457 @@
+// This is implemented as a treap. The treap is a binary tree data structure
+// that has logarithmic height with respect to the number of elements in the
+// tree with high probability. Each element in the sequence is a treap node, and
+// the in-order traversal of the treap gives the sequence elements in order.
+//
+// This file holds the definitions of the templates declared in
+// <sequence.hpp> and should only be included from there.
+#pragma once
+
+#include <sequence.hpp>
+
+#include <utilities/assert.hpp>
+
+namespace sequence {
+
+template <typename Monoid>
+AugmentedElement<Monoid>::AugmentedElement(
+    const std::pair<int64_t, int64_t>& id, MemoryArena*)
+  : id_{id}
+  , priority_{detail::GeneratePriority()} {}
+template <typename Monoid>
+AugmentedElement<Monoid>::AugmentedElement()
+  : priority_{detail::GeneratePriority()} {}
+
+template <typename Monoid>
+AugmentedElement<Monoid>::~AugmentedElement() {}
+
+template <typename Monoid>
+AugmentedElement<Monoid>::AugmentedElement(const AugmentedElement &other)
+    : id_{other.id_}
+    , children_{nullptr, nullptr}
+    , parent_{nullptr}
+    , priority_{detail::GeneratePriority()}
+    , node_data_{other.node_data_}
+    , subtree_data_{other.subtree_data_} {
+  ASSERT_MSG_ALWAYS(
+      other.parent_ == nullptr
+        && other.children_[detail::kLeft] == nullptr
+        && other.children_[detail::kRight] == nullptr,
+      "Copied element cannot live in a sequence of multiple elements");
+}
+
+template <typename Monoid>
+AugmentedElement<Monoid>::AugmentedElement(AugmentedElement&& other) noexcept
+    : id_{other.id_}
+    , children_{other.children_}
+    , parent_{other.parent_}
+    , priority_{other.priority_}
+    , node_data_{other.node_data_}
+    , subtree_data_{other.subtree_data_} {
+  if (parent_ != nullptr) {
+    if (parent_->children_[detail::kLeft] == &other) {
+      parent_->children_[detail::kLeft] = this;
+    } else {
+      parent_->children_[detail::kRight] = this;
+    }
+  }
+  if (children_[detail::kLeft] != nullptr) {
+    children_[detail::kLeft]->parent_ = this;
+  }
+  if (children_[detail::kRight] != nullptr) {
+    children_[detail::kRight]->parent_ = this;
+  }
+}
+
+// Returns whether any node in the child subtree in direction `direction` is
+// marked at index `index`.
+template <typename Monoid>
+bool AugmentedElement<Monoid>::ChildHasMarked(
+    detail::Direction direction, int32_t index) const {
+  return children_[direction] != nullptr
+    && children_[direction]->subtree_data_.has_marked[index];
+}
+
+// Recomputes subtree data for this node assuming that childrens' subtree data
+// is correct.
+template <typename Monoid>
+void AugmentedElement<Monoid>::UpdateSubtreeData() {
+  subtree_data_.size = 1;
+  subtree_data_.has_marked = node_data_.marked;
+  subtree_data_.aggregate = node_data_.value;
+  const AugmentedElement* const left{children_[detail::kLeft]};
+  if (left != nullptr) {
+    subtree_data_.size += left->subtree_data_.size;
+    for (std::size_t i = 0; i < subtree_data_.has_marked.size(); i++) {
+      subtree_data_.has_marked[i] |= left->subtree_data_.has_marked[i];
+    }
+    subtree_data_.aggregate =
+      Monoid::Combine(left->subtree_data_.aggregate, subtree_data_.aggregate);
+  }
+  const AugmentedElement* const right{children_[detail::kRight]};
+  if (right != nullptr) {
+    subtree_data_.size += right->subtree_data_.size;
+    for (std::size_t i = 0; i < subtree_data_.has_marked.size(); i++) {
+      subtree_data_.has_marked[i] |= right->subtree_data_.has_marked[i];
+    }
+    subtree_data_.aggregate =
+      Monoid::Combine(subtree_data_.aggregate, right->subtree_data_.aggregate);
+  }
+}
+
+template <typename Monoid>
+void AugmentedElement<Monoid>::AssignChild(
+    detail::Direction direction, AugmentedElement* child) {
+  if (child != nullptr) {
+    child->parent_ = this;
+  }
+  children_[direction] = child;
+}
+
+template <typename Monoid>
+AugmentedElement<Monoid>* AugmentedElement<Monoid>::GetRoot() const {
+  const AugmentedElement* current{this};
+  while (current->parent_ != nullptr) {
+    current = current->parent_;
+  }
+  return const_cast<AugmentedElement*>(current);
+}
+
+template <typename Monoid>
+AugmentedElement<Monoid>*
+AugmentedElement<Monoid>::GetRepresentative() const {
+  return GetRoot();
+}
+
+template <typename Monoid>
+AugmentedElement<Monoid>* AugmentedElement<Monoid>::GetPredecessor() const {
+  const AugmentedElement* current{this};
+  if (current->children_[detail::kLeft] == nullptr) {
+    // No left child. The predecessor is the first ancestor for which the start
+    // element falls in the ancestor's right subtree.
+    while (true) {
+      if (current->parent_ == nullptr) {
+        return nullptr;
+      } else if (current->parent_->children_[detail::kRight] == current) {
+        return current->parent_;
+      } else {
+        current = current->parent_;
+      }
+    }
+  } else {
+    // The element has a left child. The predecessor is the right-most node in
+    // the left child's subtree.
+    current = current->children_[detail::kLeft];
+    while (current->children_[detail::kRight] != nullptr) {
+      current = current->children_[detail::kRight];
+    }
+    return const_cast<AugmentedElement*>(current);
+  }
+}
+
+// Joins the tree rooted at `lesser` to the tree rooted at `greater`. Returns
+// root of the joined tree.
+template <typename Monoid>
+AugmentedElement<Monoid>* AugmentedElement<Monoid>::JoinRoots(
+    AugmentedElement* lesser, AugmentedElement* greater) {
+  if (lesser == nullptr) {
+    return greater;
+  } else if (greater == nullptr) {
+    return lesser;
+  }
+
+  if (lesser->priority_ > greater->priority_) {
+    lesser->AssignChild(
+        detail::kRight,
+        JoinRoots(lesser->children_[detail::kRight], greater));
+    lesser->UpdateSubtreeData();
+    return lesser;
+  } else {
+    greater->AssignChild(
+        detail::kLeft,
+        JoinRoots(lesser, greater->children_[detail::kLeft]));
+    greater->UpdateSubtreeData();
+    return greater;
+  }
+}
+
+// Joins the tree that `lesser` lives in with the tree that `greater` lives in
+// and returns the root of the resulting tree.
+template <typename Monoid>
+AugmentedElement<Monoid>* AugmentedElement<Monoid>::JoinWithRootReturned(
+    AugmentedElement* lesser, AugmentedElement* greater) {
+  AugmentedElement* const lesser_root =
+    lesser == nullptr ? nullptr : lesser->GetRoot();
+  AugmentedElement* const greater_root =
+    greater == nullptr ? nullptr : greater->GetRoot();
+  ASSERT_MSG(
+      lesser_root != greater_root || lesser_root == nullptr,
+      "Input nodes live in the same sequence");
+  return JoinRoots(lesser_root, greater_root);
+}
+
+template <typename Monoid>
+void AugmentedElement<Monoid>::Join(
+    AugmentedElement* lesser, AugmentedElement* greater) {
+  JoinWithRootReturned(lesser, greater);
+}
+
+template <typename Monoid>
+AugmentedElement<Monoid>* AugmentedElement<Monoid>::Split() {
+  // `lesser` is the root of a sequence that will contain `this` and elements
+  // preceding `this`.
+  AugmentedElement* lesser{nullptr};
+  // `greater`is the root of a sequence that will contain all elements
+  // after `this`.
+  AugmentedElement* greater{children_[detail::kRight]};
+  if (children_[detail::kRight] != nullptr) {
+    children_[detail::kRight]->parent_ = nullptr;
+    AssignChild(detail::kRight, nullptr);
+  }
+
+  AugmentedElement* current{this};
+  bool traversed_up_from_left{false};
+  bool current_is_left_child{false};
+  while (current != nullptr) {
+    AugmentedElement* parent{current->parent_};
+    if (parent != nullptr) {
+      current_is_left_child = parent->children_[detail::kLeft] == current;
+      parent->AssignChild(
+          current_is_left_child ? detail::kLeft : detail::kRight,
+          nullptr);
+      current->parent_ = nullptr;
+    }
+    if (traversed_up_from_left) {
+      greater = JoinWithRootReturned(greater, current);
+    } else {
+      lesser = JoinWithRootReturned(current, lesser);
+    }
+
+    traversed_up_from_left = current_is_left_child;
+    current->UpdateSubtreeData();
+    current = parent;
+  }
+
+  // The former successor of `this` is the leftmost descendent of `greater`.
+  AugmentedElement* successor = greater;
+  while (successor != nullptr
+      && successor->children_[detail::kLeft] != nullptr) {
+    successor = successor->children_[detail::kLeft];
+  }
+  return successor;
+}
+
+template <typename Monoid>
+int64_t AugmentedElement<Monoid>::GetSize() const {
+  return GetRoot()->subtree_data_.size;
+}
+
+template <typename Monoid>
+void AugmentedElement<Monoid>::Mark(int32_t index, bool marked) {
+  node_data_.marked[index] = marked;
+  AugmentedElement* current{this};
+  while (current != nullptr) {
+    const bool old_subtree_has_marked{
+      current->subtree_data_.has_marked[index]};
+    current->subtree_data_.has_marked[index] =
+      current->node_data_.marked[index]
+      || current->ChildHasMarked(detail::kLeft, index)
+      || current->ChildHasMarked(detail::kRight, index);
+    if (current->subtree_data_.has_marked[index] == old_subtree_has_marked) {
+      break;
+    } else {
+      current = current->parent_;
+    }
+  }
+}
+
+template <typename Monoid>
+std::optional<AugmentedElement<Monoid>*>
+AugmentedElement<Monoid>::FindMarkedElement(int32_t index) const {
+  const AugmentedElement* current = GetRoot();
+  if (!current->subtree_data_.has_marked[index]) {
+    return {};
+  }
+  while (true) {
+    if (current->node_data_.marked[index]) {
+      return const_cast<AugmentedElement*>(current);
+    }
+    current =
+      current->ChildHasMarked(detail::kLeft, index)
+      ? current->children_[detail::kLeft]
+      : current->children_[detail::kRight];
+  }
+}
+
+// Appends the elements in this subtree that are marked at index `index` to
+// `output` in order until `output` holds `max_elements` elements. Unmarks them
+// if `unmark` is true. Only descends into subtrees holding marked elements.
+template <typename Monoid>
+void AugmentedElement<Monoid>::CollectMarkedElements(
+    int32_t index,
+    bool unmark,
+    int64_t max_elements,
+    std::vector<AugmentedElement*>* output) {
+  if (!subtree_data_.has_marked[index]
+      || static_cast<int64_t>(output->size()) >= max_elements) {
+    return;
+  }
+  if (children_[detail::kLeft] != nullptr) {
+    children_[detail::kLeft]->CollectMarkedElements(
+        index, unmark, max_elements, output);
+  }
+  if (node_data_.marked[index]
+      && static_cast<int64_t>(output->size()) < max_elements) {
+    output->push_back(this);
+    if (unmark) {
+      node_data_.marked[index] = false;
+    }
+  }
+  if (children_[detail::kRight] != nullptr) {
+    children_[detail::kRight]->CollectMarkedElements(
+        index, unmark, max_elements, output);
+  }
+  if (unmark) {
+    subtree_data_.has_marked[index] =
+      node_data_.marked[index]
+      || ChildHasMarked(detail::kLeft, index)
+      || ChildHasMarked(detail::kRight, index);
+  }
+}
+
+template <typename Monoid>
+std::vector<AugmentedElement<Monoid>*>
+AugmentedElement<Monoid>::FindMarkedElements(
+    int32_t index, int64_t max_elements) const {
+  std::vector<AugmentedElement*> marked_elements;
+  GetRoot()->CollectMarkedElements(
+      index, false, max_elements, &marked_elements);
+  return marked_elements;
+}
+
+template <typename Monoid>
+std::vector<AugmentedElement<Monoid>*>
+AugmentedElement<Monoid>::TakeMarkedElements(
+    int32_t index, int64_t max_elements) {
+  std::vector<AugmentedElement*> marked_elements;
+  GetRoot()->CollectMarkedElements(
+      index, true, max_elements, &marked_elements);
+  return marked_elements;
+}
+
+template <typename Monoid>
+void AugmentedElement<Monoid>::SetValue(const Value& value) {
+  node_data_.value = value;
+  for (AugmentedElement* current = this;
+       current != nullptr;
+       current = current->parent_) {
+    current->UpdateSubtreeData();
+  }
+}
+
+template <typename Monoid>
+const typename AugmentedElement<Monoid>::Value&
+AugmentedElement<Monoid>::GetValue() const {
+  return node_data_.value;
+}
+
+template <typename Monoid>
+const typename AugmentedElement<Monoid>::Value&
+AugmentedElement<Monoid>::GetAggregate() const {
+  return GetRoot()->subtree_data_.aggregate;
+}
+
+template <typename Monoid>
+typename AugmentedElement<Monoid>::Value
+AugmentedElement<Monoid>::GetPrefixAggregate() const {
+  const AugmentedElement* const left{children_[detail::kLeft]};
+  Value aggregate{
+    left == nullptr
+    ? node_data_.value
+    : Monoid::Combine(left->subtree_data_.aggregate, node_data_.value)};
+  // Walking up, every ancestor of which we're in the right subtree precedes
+  // this element, as does that ancestor's left subtree.
+  for (const AugmentedElement* current = this;
+       current->parent_ != nullptr;
+       current = current->parent_) {
+    const AugmentedElement* const parent{current->parent_};
+    if (parent->children_[detail::kRight] == current) {
+      const AugmentedElement* const parent_left{
+        parent->children_[detail::kLeft]};
+      aggregate = Monoid::Combine(parent->node_data_.value, aggregate);
+      if (parent_left != nullptr) {
+        aggregate =
+          Monoid::Combine(parent_left->subtree_data_.aggregate, aggregate);
+      }
+    }
+  }
+  return aggregate;
+}
+
+template <typename Monoid>
+std::size_t AugmentedElement<Monoid>::GetNodeBytes(
+    const AugmentedElement*, int64_t) {
+  return 0;
+}
+
+template <typename Monoid>
+void AugmentedElement<Monoid>::CopySequences(
+    const AugmentedElement* source,
+    AugmentedElement* destination,
+    int64_t num_elements,
+    const int64_t* destination_indices) {
+  const auto get_destination_index{[&](int64_t i) {
+    return destination_indices == nullptr ? i : destination_indices[i];
+  }};
+  // Translates a pointer to a source element into a pointer to the element it
+  // is copied to.
+  const auto relocate{[&](const AugmentedElement* element)
+      -> AugmentedElement* {
+    if (element == nullptr) {
+      return nullptr;
+    }
+    ASSERT_MSG(
+        source <= element && element < source + num_elements,
+        "Copied sequences contain elements outside of the copied range");
+    const int64_t index{get_destination_index(element - source)};
+    ASSERT_MSG(index >= 0, "Copied sequences contain uncopied elements");
+    return destination + index;
+  }};
+  for (int64_t i = 0; i < num_elements; i++) {
+    const int64_t destination_index{get_destination_index(i)};
+    if (destination_index < 0) {
+      continue;
+    }
+    const AugmentedElement& from{source[i]};
+    AugmentedElement& to{destination[destination_index]};
+    to.id_ = from.id_;
+    to.children_ = {
+      relocate(from.children_[detail::kLeft]),
+      relocate(from.children_[detail::kRight])};
+    to.parent_ = relocate(from.parent_);
+    to.priority_ = from.priority_;
+    to.node_data_ = from.node_data_;
+    to.subtree_data_ = from.subtree_data_;
+  }
+}
+
+template <typename Monoid>
+void AugmentedElement<Monoid>::SequenceIds(std::vector<Id>* output) const {
+  if (children_[detail::kLeft] != nullptr) {
+    children_[detail::kLeft]->SequenceIds(output);
+  }
+  (*output).push_back(id_);
+  if (children_[detail::kRight] != nullptr) {
+    children_[detail::kRight]->SequenceIds(output);
+  }
+}
+
+template <typename Monoid>
+std::vector<Id> AugmentedElement<Monoid>::SequenceIds() const {
+  const AugmentedElement* root = GetRoot();
+  std::vector<Id> output;
+  root->SequenceIds(&output);
+  return output;
+}
+
+}  // namespace sequence
@@ -0,0 +1,73 @@
+#include <thread_pool.hpp>
+
+#include <algorithm>
+
+#include <utilities/assert.hpp>
+
+ThreadPool::ThreadPool(int32_t num_workers) {
+  ASSERT_MSG_ALWAYS(
+      num_workers >= 0, "The number of workers must be non-negative");
+  workers_.reserve(num_workers);
+  for (int32_t i = 0; i < num_workers; i++) {
+    workers_.emplace_back([this] { Work(); });
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard<std::mutex> lock{mutex_};
+    is_stopping_ = true;
+  }
+  work_condition_.notify_all();
+  for (std::thread& worker : workers_) {
+    worker.join();
+  }
+}
+
+int32_t ThreadPool::GetNumberOfWorkers() const {
+  return static_cast<int32_t>(workers_.size());
+}
+
+void ThreadPool::Run(
+    int32_t num_workers, const std::function<void()>& function) {
+  num_workers = std::clamp(num_workers, 0, GetNumberOfWorkers());
+  if (num_workers > 0) {
+    {
+      std::lock_guard<std::mutex> lock{mutex_};
+      function_ = &function;
+      generation_++;
+      num_unclaimed_ = num_workers;
+      num_running_ = num_workers;
+    }
+    work_condition_.notify_all();
+  }
+  function();
+  if (num_workers > 0) {
+    std::unique_lock<std::mutex> lock{mutex_};
+    done_condition_.wait(lock, [this] { return num_running_ == 0; });
+    function_ = nullptr;
+  }
+}
+
+void ThreadPool::Work() {
+  uint64_t last_generation{0};
+  std::unique_lock<std::mutex> lock{mutex_};
+  while (true) {
+    work_condition_.wait(lock, [&] {
+      return is_stopping_
+        || (generation_ != last_generation && num_unclaimed_ > 0);
+    });
+    if (is_stopping_) {
+      return;
+    }
+    last_generation = generation_;
+    num_unclaimed_--;
+    const std::function<void()>& function{*function_};
+    lock.unlock();
+    function();
+    lock.lock();
+    if (--num_running_ == 0) {
+      done_condition_.notify_one();
+    }
+  }
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// This is a fixed set of worker threads that help the calling thread run a
+// function, so that work split across threads does not pay for starting
+// threads each time.
+class ThreadPool {
+ public:
+  // Starts `num_workers` worker threads, which wait until there is work.
+  explicit ThreadPool(int32_t num_workers);
+  ThreadPool() = delete;
+
+  // Stops and joins the worker threads.
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool& other) = delete;
+  ThreadPool& operator=(const ThreadPool& other) = delete;
+  ThreadPool(ThreadPool&& other) = delete;
+  ThreadPool& operator=(ThreadPool&& other) = delete;
+
+  // Returns the number of worker threads.
+  int32_t GetNumberOfWorkers() const;
+
+  // Calls `function` once on each of `num_workers` worker threads, or on every
+  // worker thread if there are fewer, and once on the calling thread. Returns
+  // once every call has returned.
+  //
+  // Only one thread may call `Run()` at a time.
+  void Run(int32_t num_workers, const std::function<void()>& function);
+
+ private:
+  void Work();
+
+  std::mutex mutex_;
+  // Signaled when work is added or the pool is stopping.
+  std::condition_variable work_condition_;
+  // Signaled when the last worker of a `Run()` is done.
+  std::condition_variable done_condition_;
+  // Function of the current `Run()`, or null.
+  const std::function<void()>* function_{nullptr};
+  // Incremented by each `Run()` so that a worker calls each run's function at
+  // most once.
+  uint64_t generation_{0};
+  // Number of workers that the current `Run()` still needs to start.
+  int32_t num_unclaimed_{0};
+  // Number of workers of the current `Run()` that have not finished.
+  int32_t num_running_{0};
+  bool is_stopping_{false};
+  std::vector<std::thread> workers_;
+};
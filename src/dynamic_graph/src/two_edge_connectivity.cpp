@@ -0,0 +1,895 @@
+// This is implemented using the 2-edge connectivity data structure described in
+// section 3 of the following paper:
+//   Jacob Holm, Kristian de Lichtenberg, and Mikkel Thorup. "Poly-logarithmic
+//   deterministic fully-dynamic algorithms for connectivity, minimum spanning
+//   tree, 2-edge, and biconnectivity." Journal of the ACM, 48(4):723–760, 2001.
+//
+// The data structure keeps a spanning forest T of the graph. Each non-tree edge
+// has a level between 0 and L - 1 where L = floor(log2 n), and each tree edge
+// has a cover level, which is the highest level of a non-tree edge whose tree
+// path contains the edge, or -1 if there is none. A tree edge is a bridge
+// exactly when its cover level is -1, so two vertices are 2-edge-connected
+// exactly when the tree path between them has no edge of cover level -1.
+//
+// Two vertices are i-connected if the tree path between them only has edges
+// of cover level i or higher. The levels keep the following invariant: the
+// vertices that are (i + 1)-connected to a vertex touching a level-(i + 1)
+// non-tree edge number at most n / 2^(i + 1). Deleting a non-tree edge of level
+// i lowers the cover levels on its tree path, which may uncover edges that
+// other non-tree edges of level i or lower also covered. `Recover()` finds
+// those edges and covers their paths again. Each edge it looks at either moves
+// up a level, of which there are only L, or ends the search, which bounds the
+// amortized cost. Deleting a tree edge first swaps it with a replacement
+// non-tree edge, which is found similarly.
+//
+// ---
+//
+// Some implementation details:
+//
+// T is stored in a link-cut tree as in `LinkCutTree`, with a node for each
+// vertex and for each tree edge. Each edge node holds its cover level, and
+// covering and uncovering a path is a lazy update of the cover levels in a
+// splay tree.
+//
+// Besides the paths, searches need to know which vertices are i-connected to
+// a path, and these hang off the path in subtrees. So, as in top trees, each
+// node keeps counts over the paths that hang off it, its virtual children, for
+// each level. A virtual child contributes the vertices reachable from the node
+// through edges of cover level at least i. Cover levels only change on the
+// path exposed by `Access()`, so the contribution of a virtual child doesn't
+// change while it is virtual. It is computed when the child becomes virtual and
+// again when it stops being virtual. The counts don't depend on cover levels
+// otherwise, so the lazy updates don't need to touch them.
+//
+// The paper ternarizes T so that searches for a vertex with level-i non-tree
+// edges near a path don't have to scan the virtual children of high-degree
+// vertices. Instead, each node lists, for each level i, its virtual children
+// that contribute vertices with level-i non-tree edges, and a search steps
+// straight into the first of them.
+//
+// As for costs, a rotation recomputes O(log n) counts, and exposing a path
+// with `Access()` changes O(log n) virtual children amortized, each of whose
+// contributions takes O(log n) splays, one per level. So exposing a path, and
+// with it a query, takes O(log^4 n) amortized time. An update exposes O(1)
+// paths plus O(1) paths for each non-tree edge it looks at, and each edge is
+// looked at O(1) times per level it moves up, so updates take O(log^5 n)
+// amortized time.
+#include <two_edge_connectivity.hpp>
+
+#include <algorithm>
+#include <limits>
+#include <utility>
+
+#include <dynamic_forest.hpp>
+#include <dynamic_graph/memory_arena.hpp>
+#include <utilities/assert.hpp>
+
+namespace {
+
+// Cover level of vertex nodes.
+constexpr int32_t kVertexCover{std::numeric_limits<int32_t>::max() / 2};
+// Pending cover level change that changes nothing.
+constexpr int32_t kNoUncover{-2};
+constexpr int32_t kNoCover{-1};
+
+int32_t GetNumberOfLevels(int64_t num_vertices) {
+  int32_t log{0};
+  while ((num_vertices >> (log + 1)) > 0) {
+    log++;
+  }
+  return std::max(log, 1);
+}
+
+}  // namespace
+
+TwoEdgeConnectivity::TwoEdgeConnectivity(int64_t num_vertices)
+    : num_vertices_{num_vertices}
+    , num_levels_{GetNumberOfLevels(num_vertices)} {
+  ASSERT_MSG_ALWAYS(
+      num_vertices_ > 0,
+      "The number of vertices must be positive");
+  ASSERT_MSG_ALWAYS(
+      num_vertices_ <= std::numeric_limits<int32_t>::max(),
+      "The number of vertices must fit in 32 bits");
+
+  const int64_t max_num_edges{num_vertices_ - 1};
+  const int64_t num_nodes{num_vertices_ + max_num_edges};
+  nodes_.resize(num_nodes);
+  virtual_sizes_.resize(num_nodes * num_levels_, 0);
+  virtual_incidences_.resize(num_nodes * num_levels_, 0);
+  subtree_sizes_.resize(num_nodes * num_levels_, 0);
+  subtree_incidences_.resize(num_nodes * num_levels_, 0);
+  first_incident_virtual_children_.resize(num_nodes * num_levels_, kNoNode);
+  previous_incident_virtual_siblings_.resize(num_nodes * num_levels_, kNoNode);
+  next_incident_virtual_siblings_.resize(num_nodes * num_levels_, kNoNode);
+  incident_levels_.resize(num_vertices_, 0);
+  for (NodeIndex node = 0; node < num_nodes; node++) {
+    ResetNode(node, kVertexCover);
+  }
+  free_edge_nodes_.reserve(max_num_edges);
+  for (NodeIndex node = num_nodes - 1; node >= num_vertices_; node--) {
+    free_edge_nodes_.emplace_back(node);
+  }
+  non_tree_adjacency_lists_.resize(num_levels_);
+  contribution_sizes_.resize(num_levels_);
+  contribution_incidences_.resize(num_levels_);
+}
+
+TwoEdgeConnectivity::~TwoEdgeConnectivity() {}
+
+// Nodes refer to each other by index, so copying the members copies the
+// forest.
+TwoEdgeConnectivity::TwoEdgeConnectivity(const TwoEdgeConnectivity& other)
+  = default;
+
+TwoEdgeConnectivity::TwoEdgeConnectivity(TwoEdgeConnectivity&& other) noexcept
+  = default;
+
+bool TwoEdgeConnectivity::IsSplayRoot(NodeIndex node) const {
+  const NodeIndex parent{nodes_[node].parent};
+  return parent == kNoNode
+    || (nodes_[parent].children[0] != node
+        && nodes_[parent].children[1] != node);
+}
+
+bool TwoEdgeConnectivity::IsVertex(NodeIndex node) const {
+  return node < num_vertices_;
+}
+
+// Returns true if `node` is a vertex incident to a level-`level` non-tree edge.
+bool TwoEdgeConnectivity::IsIncident(NodeIndex node, int32_t level) const {
+  return IsVertex(node) && ((incident_levels_[node] >> level) & 1) != 0;
+}
+
+// Returns the counts of `node` in `counts`, one per level.
+int32_t* TwoEdgeConnectivity::GetCounts(
+    std::vector<int32_t>* counts, NodeIndex node) {
+  return counts->data() + node * num_levels_;
+}
+
+// Returns the links of `node` in `links`, one per level.
+TwoEdgeConnectivity::NodeIndex* TwoEdgeConnectivity::GetLinks(
+    std::vector<NodeIndex>* links, NodeIndex node) {
+  return links->data() + node * num_levels_;
+}
+
+// Resets `node` to a node with no neighbors, no virtual children, and the given
+// cover level.
+void TwoEdgeConnectivity::ResetNode(NodeIndex node, int32_t cover) {
+  nodes_[node] = Node{};
+  nodes_[node].cover = nodes_[node].min_cover = cover;
+  nodes_[node].pending_uncover = kNoUncover;
+  nodes_[node].pending_cover = kNoCover;
+  std::fill_n(GetCounts(&virtual_sizes_, node), num_levels_, 0);
+  std::fill_n(GetCounts(&virtual_incidences_, node), num_levels_, 0);
+  std::fill_n(
+      GetLinks(&first_incident_virtual_children_, node), num_levels_, kNoNode);
+  Update(node);
+}
+
+// Replaces each cover level c in `node`'s splay subtree by
+// max(cover, c > uncover ? c : -1). Covering a path at level i is the change
+// with `uncover` = `kNoUncover` and `cover` = i, and uncovering the edges of
+// cover level i or lower is the change with `uncover` = i and `cover` =
+// `kNoCover`.
+void TwoEdgeConnectivity::ChangeCovers(
+    NodeIndex node, int32_t uncover, int32_t cover) {
+  Node& n{nodes_[node]};
+  // The change is monotone, so it maps the lowest cover level to the lowest
+  // cover level.
+  const auto change{[&](int32_t c) {
+    return std::max(cover, c > uncover ? c : -1);
+  }};
+  n.cover = change(n.cover);
+  n.min_cover = change(n.min_cover);
+  // Compose the change with the pending one.
+  if (n.pending_cover > uncover) {
+    n.pending_cover = std::max(n.pending_cover, cover);
+  } else {
+    n.pending_uncover = std::max(n.pending_uncover, uncover);
+    n.pending_cover = cover;
+  }
+}
+
+// Pushes pending reversals and cover level changes down to `node`'s children.
+void TwoEdgeConnectivity::PushDown(NodeIndex node) {
+  Node& n{nodes_[node]};
+  if (n.reversed) {
+    std::swap(n.children[0], n.children[1]);
+    for (const NodeIndex child : n.children) {
+      if (child != kNoNode) {
+        nodes_[child].reversed = !nodes_[child].reversed;
+      }
+    }
+    n.reversed = false;
+  }
+  if (n.pending_uncover != kNoUncover || n.pending_cover != kNoCover) {
+    for (const NodeIndex child : n.children) {
+      if (child != kNoNode) {
+        ChangeCovers(child, n.pending_uncover, n.pending_cover);
+      }
+    }
+    n.pending_uncover = kNoUncover;
+    n.pending_cover = kNoCover;
+  }
+}
+
+// Recomputes the aggregates of `node` from its children.
+void TwoEdgeConnectivity::Update(NodeIndex node) {
+  Node& n{nodes_[node]};
+  n.min_cover = n.cover;
+  int32_t* const sizes{GetCounts(&subtree_sizes_, node)};
+  int32_t* const incidences{GetCounts(&subtree_incidences_, node)};
+  const int32_t* const virtual_sizes{GetCounts(&virtual_sizes_, node)};
+  const int32_t* const virtual_incidences{
+    GetCounts(&virtual_incidences_, node)};
+  const int32_t own_size{IsVertex(node) ? 1 : 0};
+  for (int32_t level = 0; level < num_levels_; level++) {
+    sizes[level] = virtual_sizes[level] + own_size;
+    incidences[level] =
+      virtual_incidences[level] + (IsIncident(node, level) ? 1 : 0);
+  }
+  for (const NodeIndex child : n.children) {
+    if (child != kNoNode) {
+      n.min_cover = std::min(n.min_cover, nodes_[child].min_cover);
+      const int32_t* const child_sizes{GetCounts(&subtree_sizes_, child)};
+      const int32_t* const child_incidences{
+        GetCounts(&subtree_incidences_, child)};
+      for (int32_t level = 0; level < num_levels_; level++) {
+        sizes[level] += child_sizes[level];
+        incidences[level] += child_incidences[level];
+      }
+    }
+  }
+}
+
+// Rotates `node` above its parent in their splay tree.
+void TwoEdgeConnectivity::Rotate(NodeIndex node) {
+  const NodeIndex parent{nodes_[node].parent};
+  const NodeIndex grandparent{nodes_[parent].parent};
+  const bool is_parent_root{IsSplayRoot(parent)};
+  const int direction{nodes_[parent].children[1] == node ? 1 : 0};
+  if (!is_parent_root) {
+    Node& g{nodes_[grandparent]};
+    g.children[g.children[1] == parent ? 1 : 0] = node;
+  }
+  nodes_[node].parent = grandparent;
+  const NodeIndex middle_child{nodes_[node].children[1 - direction]};
+  nodes_[parent].children[direction] = middle_child;
+  if (middle_child != kNoNode) {
+    nodes_[middle_child].parent = parent;
+  }
+  nodes_[node].children[1 - direction] = parent;
+  nodes_[parent].parent = node;
+  Update(parent);
+  Update(node);
+  if (is_parent_root && grandparent != kNoNode) {
+    // `node` replaces `parent` as the root of a virtual child.
+    ReplaceVirtualChild(grandparent, parent, node);
+  }
+}
+
+// Moves `node` to the root of its splay tree.
+void TwoEdgeConnectivity::Splay(NodeIndex node) {
+  // Pending changes must be pushed down from the root before rotating.
+  splay_path_.clear();
+  for (NodeIndex current = node; ; current = nodes_[current].parent) {
+    splay_path_.emplace_back(current);
+    if (IsSplayRoot(current)) {
+      break;
+    }
+  }
+  for (auto it = splay_path_.rbegin(); it != splay_path_.rend(); it++) {
+    PushDown(*it);
+  }
+
+  while (!IsSplayRoot(node)) {
+    const NodeIndex parent{nodes_[node].parent};
+    if (!IsSplayRoot(parent)) {
+      const NodeIndex grandparent{nodes_[parent].parent};
+      const bool is_zig_zig{
+        (nodes_[parent].children[0] == node)
+          == (nodes_[grandparent].children[0] == parent)};
+      Rotate(is_zig_zig ? parent : node);
+    }
+    Rotate(node);
+  }
+}
+
+// Makes the path from `node` to the root of its tree into a single splay tree
+// rooted at `node`, with `node` the deepest node on the path.
+void TwoEdgeConnectivity::Access(NodeIndex node) {
+  Splay(node);
+  DetachRightChild(node);
+  NodeIndex child{node};
+  while (nodes_[child].parent != kNoNode) {
+    const NodeIndex parent{nodes_[child].parent};
+    Splay(parent);
+    const NodeIndex child_root{RemoveVirtualChild(parent, child)};
+    DetachRightChild(parent);
+    nodes_[parent].children[1] = child_root;
+    Update(parent);
+    child = parent;
+  }
+  Splay(node);
+}
+
+// Reroots the tree containing `node` at `node`.
+void TwoEdgeConnectivity::MakeRoot(NodeIndex node) {
+  Access(node);
+  nodes_[node].reversed = !nodes_[node].reversed;
+  PushDown(node);
+}
+
+// Returns the root of the tree containing `node`.
+TwoEdgeConnectivity::NodeIndex TwoEdgeConnectivity::FindRoot(NodeIndex node) {
+  Access(node);
+  NodeIndex root{node};
+  while (true) {
+    PushDown(root);
+    if (nodes_[root].children[0] == kNoNode) {
+      break;
+    }
+    root = nodes_[root].children[0];
+  }
+  Splay(root);
+  return root;
+}
+
+void TwoEdgeConnectivity::Link(NodeIndex child, NodeIndex parent) {
+  MakeRoot(child);
+  Access(parent);
+  nodes_[child].parent = parent;
+  AddVirtualChild(parent, child);
+  Update(parent);
+}
+
+void TwoEdgeConnectivity::Cut(NodeIndex u, NodeIndex v) {
+  MakeRoot(u);
+  Access(v);
+  // The path from `u` to `v` is just the two nodes, so `u` is `v`'s only
+  // descendant in the splay tree.
+  ASSERT_MSG(
+      nodes_[v].children[0] == u && nodes_[u].children[0] == kNoNode
+        && nodes_[u].children[1] == kNoNode,
+      "Cut nodes are not adjacent");
+  nodes_[v].children[0] = kNoNode;
+  nodes_[u].parent = kNoNode;
+  Update(v);
+}
+
+// Turns the right child of `node`, which must be a splay root with no pending
+// changes, into a virtual child.
+void TwoEdgeConnectivity::DetachRightChild(NodeIndex node) {
+  const NodeIndex child{nodes_[node].children[1]};
+  if (child != kNoNode) {
+    nodes_[node].children[1] = kNoNode;
+    AddVirtualChild(node, child);
+    Update(node);
+  }
+}
+
+// Adds the contribution of `child`'s splay tree, which must hang off `parent`,
+// to `parent`'s virtual counts and lists the tree's root as a virtual child of
+// `parent`. Returns the root, which may differ from `child`. Does not update
+// `parent`'s subtree counts.
+TwoEdgeConnectivity::NodeIndex TwoEdgeConnectivity::AddVirtualChild(
+    NodeIndex parent, NodeIndex child) {
+  const NodeIndex root{GetContribution(child)};
+  int32_t* const sizes{GetCounts(&virtual_sizes_, parent)};
+  int32_t* const incidences{GetCounts(&virtual_incidences_, parent)};
+  for (int32_t level = 0; level < num_levels_; level++) {
+    sizes[level] += contribution_sizes_[level];
+    incidences[level] += contribution_incidences_[level];
+  }
+  Node& p{nodes_[parent]};
+  Node& r{nodes_[root]};
+  r.previous_virtual_sibling = kNoNode;
+  r.next_virtual_sibling = p.first_virtual_child;
+  if (p.first_virtual_child != kNoNode) {
+    nodes_[p.first_virtual_child].previous_virtual_sibling = root;
+  }
+  p.first_virtual_child = root;
+
+  NodeIndex* const first_children{
+    GetLinks(&first_incident_virtual_children_, parent)};
+  NodeIndex* const previous_siblings{
+    GetLinks(&previous_incident_virtual_siblings_, root)};
+  NodeIndex* const next_siblings{
+    GetLinks(&next_incident_virtual_siblings_, root)};
+  r.incident_child_levels = 0;
+  for (int32_t level = 0; level < num_levels_; level++) {
+    if (contribution_incidences_[level] > 0) {
+      r.incident_child_levels |= uint64_t{1} << level;
+      previous_siblings[level] = kNoNode;
+      next_siblings[level] = first_children[level];
+      if (first_children[level] != kNoNode) {
+        GetLinks(&previous_incident_virtual_siblings_, first_children[level])
+          [level] = root;
+      }
+      first_children[level] = root;
+    }
+  }
+  return root;
+}
+
+// Reverses `AddVirtualChild()` for the virtual child of `parent` whose splay
+// tree contains `child`. Returns the tree's root.
+TwoEdgeConnectivity::NodeIndex TwoEdgeConnectivity::RemoveVirtualChild(
+    NodeIndex parent, NodeIndex child) {
+  const NodeIndex root{GetContribution(child)};
+  int32_t* const sizes{GetCounts(&virtual_sizes_, parent)};
+  int32_t* const incidences{GetCounts(&virtual_incidences_, parent)};
+  for (int32_t level = 0; level < num_levels_; level++) {
+    sizes[level] -= contribution_sizes_[level];
+    incidences[level] -= contribution_incidences_[level];
+  }
+  Node& r{nodes_[root]};
+  if (r.previous_virtual_sibling == kNoNode) {
+    nodes_[parent].first_virtual_child = r.next_virtual_sibling;
+  } else {
+    nodes_[r.previous_virtual_sibling].next_virtual_sibling =
+      r.next_virtual_sibling;
+  }
+  if (r.next_virtual_sibling != kNoNode) {
+    nodes_[r.next_virtual_sibling].previous_virtual_sibling =
+      r.previous_virtual_sibling;
+  }
+  r.previous_virtual_sibling = r.next_virtual_sibling = kNoNode;
+
+  NodeIndex* const previous_siblings{
+    GetLinks(&previous_incident_virtual_siblings_, root)};
+  NodeIndex* const next_siblings{
+    GetLinks(&next_incident_virtual_siblings_, root)};
+  for (uint64_t levels = r.incident_child_levels; levels != 0;
+       levels &= levels - 1) {
+    const int32_t level{__builtin_ctzll(levels)};
+    if (previous_siblings[level] == kNoNode) {
+      GetLinks(&first_incident_virtual_children_, parent)[level] =
+        next_siblings[level];
+    } else {
+      GetLinks(&next_incident_virtual_siblings_, previous_siblings[level])
+        [level] = next_siblings[level];
+    }
+    if (next_siblings[level] != kNoNode) {
+      GetLinks(&previous_incident_virtual_siblings_, next_siblings[level])
+        [level] = previous_siblings[level];
+    }
+  }
+  r.incident_child_levels = 0;
+  return root;
+}
+
+// If `old_child` is listed as a virtual child of `parent`, lists `new_child`,
+// the new root of its splay tree, in its place.
+void TwoEdgeConnectivity::ReplaceVirtualChild(
+    NodeIndex parent, NodeIndex old_child, NodeIndex new_child) {
+  Node& o{nodes_[old_child]};
+  if (o.previous_virtual_sibling == kNoNode
+      && nodes_[parent].first_virtual_child != old_child) {
+    // `old_child`'s tree is being added or removed as a virtual child.
+    return;
+  }
+  Node& n{nodes_[new_child]};
+  n.previous_virtual_sibling = o.previous_virtual_sibling;
+  n.next_virtual_sibling = o.next_virtual_sibling;
+  if (n.previous_virtual_sibling == kNoNode) {
+    nodes_[parent].first_virtual_child = new_child;
+  } else {
+    nodes_[n.previous_virtual_sibling].next_virtual_sibling = new_child;
+  }
+  if (n.next_virtual_sibling != kNoNode) {
+    nodes_[n.next_virtual_sibling].previous_virtual_sibling = new_child;
+  }
+  o.previous_virtual_sibling = o.next_virtual_sibling = kNoNode;
+
+  n.incident_child_levels = o.incident_child_levels;
+  o.incident_child_levels = 0;
+  const NodeIndex* const old_previous_siblings{
+    GetLinks(&previous_incident_virtual_siblings_, old_child)};
+  const NodeIndex* const old_next_siblings{
+    GetLinks(&next_incident_virtual_siblings_, old_child)};
+  NodeIndex* const previous_siblings{
+    GetLinks(&previous_incident_virtual_siblings_, new_child)};
+  NodeIndex* const next_siblings{
+    GetLinks(&next_incident_virtual_siblings_, new_child)};
+  for (uint64_t levels = n.incident_child_levels; levels != 0;
+       levels &= levels - 1) {
+    const int32_t level{__builtin_ctzll(levels)};
+    previous_siblings[level] = old_previous_siblings[level];
+    next_siblings[level] = old_next_siblings[level];
+    if (previous_siblings[level] == kNoNode) {
+      GetLinks(&first_incident_virtual_children_, parent)[level] = new_child;
+    } else {
+      GetLinks(&next_incident_virtual_siblings_, previous_siblings[level])
+        [level] = new_child;
+    }
+    if (next_siblings[level] != kNoNode) {
+      GetLinks(&previous_incident_virtual_siblings_, next_siblings[level])
+        [level] = new_child;
+    }
+  }
+}
+
+// Computes into `contribution_sizes_` and `contribution_incidences_` the
+// counts that the splay tree containing `node` contributes to the node its
+// path hangs off. For level i, these count the vertices reachable from the
+// node through edges of cover level at least i, which are those reachable from
+// the nodes of the path before its first edge of cover level below i. Returns
+// the root of the splay tree afterwards.
+TwoEdgeConnectivity::NodeIndex
+TwoEdgeConnectivity::GetContribution(NodeIndex node) {
+  NodeIndex root{node};
+  while (!IsSplayRoot(root)) {
+    root = nodes_[root].parent;
+  }
+  // Each edge of cover level c ends the counted part of the path for the levels
+  // above c, so go from the highest level down, finding the next edge that
+  // ends the counted part for some remaining level.
+  int32_t level{num_levels_ - 1};
+  while (level >= 0) {
+    const NodeIndex uncovered{FindUncoveredNode(root, level)};
+    if (uncovered == kNoNode) {
+      const int32_t* const sizes{GetCounts(&subtree_sizes_, root)};
+      const int32_t* const incidences{GetCounts(&subtree_incidences_, root)};
+      for (; level >= 0; level--) {
+        contribution_sizes_[level] = sizes[level];
+        contribution_incidences_[level] = incidences[level];
+      }
+      break;
+    }
+    // `uncovered` is now the root, and the nodes before it are its left
+    // subtree.
+    root = uncovered;
+    const int32_t cover{nodes_[uncovered].cover};
+    const NodeIndex left{nodes_[uncovered].children[0]};
+    for (; level > cover; level--) {
+      contribution_sizes_[level] =
+        left == kNoNode ? 0 : GetCounts(&subtree_sizes_, left)[level];
+      contribution_incidences_[level] =
+        left == kNoNode ? 0 : GetCounts(&subtree_incidences_, left)[level];
+    }
+  }
+  return root;
+}
+
+// Returns the first node, in path order, with cover level below `level` in the
+// splay tree rooted at `root`, after splaying it to the root, or `kNoNode` if
+// there is none.
+TwoEdgeConnectivity::NodeIndex
+TwoEdgeConnectivity::FindUncoveredNode(NodeIndex root, int32_t level) {
+  if (nodes_[root].min_cover >= level) {
+    return kNoNode;
+  }
+  NodeIndex node{root};
+  while (true) {
+    PushDown(node);
+    const NodeIndex left{nodes_[node].children[0]};
+    if (left != kNoNode && nodes_[left].min_cover < level) {
+      node = left;
+    } else if (nodes_[node].cover < level) {
+      break;
+    } else {
+      node = nodes_[node].children[1];
+    }
+  }
+  Splay(node);
+  return node;
+}
+
+// Returns the first node, in path order, in the splay tree rooted at `root`
+// that is incident to a level-`level` non-tree edge or has virtual children
+// with such vertices, after splaying it to the root. If `stops_at_uncovered`
+// is true, only looks before the first node of cover level below `level`.
+// Returns `kNoNode` if there is no such node.
+TwoEdgeConnectivity::NodeIndex TwoEdgeConnectivity::FindIncidentNode(
+    NodeIndex root, int32_t level, bool stops_at_uncovered) {
+  NodeIndex node{root};
+  if (stops_at_uncovered) {
+    const NodeIndex uncovered{FindUncoveredNode(root, level)};
+    if (uncovered != kNoNode) {
+      node = nodes_[uncovered].children[0];
+    }
+  }
+  if (node == kNoNode || GetCounts(&subtree_incidences_, node)[level] == 0) {
+    return kNoNode;
+  }
+  while (true) {
+    PushDown(node);
+    const NodeIndex left{nodes_[node].children[0]};
+    if (left != kNoNode && GetCounts(&subtree_incidences_, left)[level] > 0) {
+      node = left;
+    } else if (
+        IsIncident(node, level)
+        || GetCounts(&virtual_incidences_, node)[level] > 0) {
+      break;
+    } else {
+      node = nodes_[node].children[1];
+    }
+  }
+  Splay(node);
+  return node;
+}
+
+bool TwoEdgeConnectivity::IsConnected(Vertex u, Vertex v) {
+  return u == v || FindRoot(u) == FindRoot(v);
+}
+
+// Makes the tree path between connected vertices `u` and `v` into a single
+// splay tree, ordered from `u` to `v`, and returns its root.
+TwoEdgeConnectivity::NodeIndex TwoEdgeConnectivity::ExposePath(
+    Vertex u, Vertex v) {
+  MakeRoot(u);
+  Access(v);
+  return v;
+}
+
+// Raises the cover level of each edge on the tree path between `u` and `v` to
+// at least `level`.
+void TwoEdgeConnectivity::CoverPath(Vertex u, Vertex v, int32_t level) {
+  ChangeCovers(ExposePath(u, v), kNoUncover, level);
+}
+
+// Returns the number of vertices that are `level`-connected to the tree path
+// between `u` and `v`.
+int32_t TwoEdgeConnectivity::GetSizeAroundPath(
+    Vertex u, Vertex v, int32_t level) {
+  return GetCounts(&subtree_sizes_, ExposePath(u, v))[level];
+}
+
+// Returns a vertex incident to a level-`level` non-tree edge that is
+// `level`-connected to the tree path between `u` and `v`. Of all such
+// vertices, it returns one whose closest vertex on the path is closest to `u`.
+std::optional<Vertex> TwoEdgeConnectivity::FindIncidentVertexAroundPath(
+    Vertex u, Vertex v, int32_t level) {
+  NodeIndex node{FindIncidentNode(ExposePath(u, v), level, false)};
+  if (node == kNoNode) {
+    return std::nullopt;
+  }
+  while (!IsIncident(node, level)) {
+    // The vertex is in the subtree of one of `node`'s virtual children, and
+    // each virtual child listed for `level` has such a vertex.
+    const NodeIndex child{
+      GetLinks(&first_incident_virtual_children_, node)[level]};
+    ASSERT_MSG(child != kNoNode, "Virtual counts are inconsistent");
+    node = FindIncidentNode(child, level, true);
+    ASSERT_MSG(node != kNoNode, "Virtual counts are inconsistent");
+  }
+  return node;
+}
+
+// Sets whether vertex `v` is incident to a level-`level` non-tree edge.
+void TwoEdgeConnectivity::SetIncident(
+    Vertex v, int32_t level, bool is_incident) {
+  // Once accessed, `v` is the root of the splay tree of the root path, so only
+  // its own counts depend on it.
+  Access(v);
+  if (is_incident) {
+    incident_levels_[v] |= uint64_t{1} << level;
+  } else {
+    incident_levels_[v] &= ~(uint64_t{1} << level);
+  }
+  Update(v);
+}
+
+// Adds `edge`, whose endpoints must not be connected, to the spanning forest
+// with cover level `cover`.
+void TwoEdgeConnectivity::AddTreeEdge(
+    const UndirectedEdge& edge, int32_t cover) {
+  const NodeIndex edge_node{free_edge_nodes_.back()};
+  free_edge_nodes_.pop_back();
+  ResetNode(edge_node, cover);
+  tree_edges_.emplace(edge, edge_node);
+  Link(edge_node, edge.first);
+  Link(edge.second, edge_node);
+}
+
+void TwoEdgeConnectivity::DeleteTreeEdge(const UndirectedEdge& edge) {
+  const auto& edge_it{tree_edges_.find(edge)};
+  const NodeIndex edge_node{edge_it->second};
+  tree_edges_.erase(edge_it);
+  Cut(edge.first, edge_node);
+  Cut(edge_node, edge.second);
+  ResetNode(edge_node, kVertexCover);
+  free_edge_nodes_.emplace_back(edge_node);
+}
+
+// Adds `edge` as a non-tree edge of level `level` without covering its path.
+void TwoEdgeConnectivity::AddNonTreeEdge(
+    const UndirectedEdge& edge, int32_t level) {
+  non_tree_edges_.emplace(edge, level);
+  auto& adjacency_lists{non_tree_adjacency_lists_[level]};
+  for (const auto& [u, v] : {std::make_pair(edge.first, edge.second),
+                            std::make_pair(edge.second, edge.first)}) {
+    auto& adjacency_list{adjacency_lists[u]};
+    adjacency_list.insert(v);
+    if (adjacency_list.size() == 1) {
+      SetIncident(u, level, true);
+    }
+  }
+}
+
+// Deletes non-tree edge `edge` without uncovering its path.
+void TwoEdgeConnectivity::DeleteNonTreeEdge(const UndirectedEdge& edge) {
+  const auto& edge_it{non_tree_edges_.find(edge)};
+  const int32_t level{edge_it->second};
+  non_tree_edges_.erase(edge_it);
+  auto& adjacency_lists{non_tree_adjacency_lists_[level]};
+  for (const auto& [u, v] : {std::make_pair(edge.first, edge.second),
+                            std::make_pair(edge.second, edge.first)}) {
+    const auto& list_it{adjacency_lists.find(u)};
+    list_it->second.erase(v);
+    if (list_it->second.empty()) {
+      adjacency_lists.erase(list_it);
+      SetIncident(u, level, false);
+    }
+  }
+}
+
+// Restores the cover levels after deleting a non-tree edge of level `level`
+// between the endpoints of `edge`.
+void TwoEdgeConnectivity::Uncover(const UndirectedEdge& edge, int32_t level) {
+  ChangeCovers(ExposePath(edge.first, edge.second), level, kNoCover);
+  for (int32_t i = level; i >= 0; i--) {
+    Recover(edge, i);
+  }
+}
+
+// Covers again the edges on the tree path between the endpoints of `edge`
+// that level-`level` non-tree edges cover.
+//
+// The non-tree edges are processed from each end of the path in turn, in order
+// of where they meet the path. Each is moved up a level if that keeps the
+// level invariant. Otherwise it just covers its path, and the search from that
+// end stops: the vertices (`level` + 1)-connected to that non-tree edge are
+// then too many for those connected to a non-tree edge found from the other
+// end to be disjoint from them, so the two edges cover the rest of the path
+// between them.
+void TwoEdgeConnectivity::Recover(const UndirectedEdge& edge, int32_t level) {
+  for (const auto& [start, end] :
+       {std::make_pair(edge.first, edge.second),
+        std::make_pair(edge.second, edge.first)}) {
+    while (true) {
+      const std::optional<Vertex> u{
+        FindIncidentVertexAroundPath(start, end, level)};
+      if (!u.has_value()) {
+        // There is no level-`level` non-tree edge to look at from either end.
+        return;
+      }
+      const Vertex v{*non_tree_adjacency_lists_[level].at(*u).begin()};
+      const bool is_promotable{
+        level + 1 < num_levels_
+          && GetSizeAroundPath(*u, v, level + 1)
+            <= (num_vertices_ >> (level + 1))};
+      if (is_promotable) {
+        DeleteNonTreeEdge({*u, v});
+        AddNonTreeEdge({*u, v}, level + 1);
+        CoverPath(*u, v, level + 1);
+      } else {
+        CoverPath(*u, v, level);
+        break;
+      }
+    }
+  }
+}
+
+// Deletes tree edge `edge` of cover level `level`, which must not be -1, and
+// replaces it in the spanning forest with a non-tree edge that covers it.
+void TwoEdgeConnectivity::Swap(const UndirectedEdge& edge, int32_t level) {
+  DeleteTreeEdge(edge);
+  // A level-`level` non-tree edge covered `edge`, so it joins the vertices
+  // `level`-connected to the two endpoints. Look for it on the smaller side,
+  // moving the non-tree edges within that side up a level, which keeps the
+  // level invariant since the side has at most half of the vertices that were
+  // `level`-connected to `edge`.
+  const Vertex side{
+    GetSizeAroundPath(edge.first, edge.first, level)
+        <= GetSizeAroundPath(edge.second, edge.second, level)
+      ? edge.first
+      : edge.second};
+  while (true) {
+    const std::optional<Vertex> u{
+      FindIncidentVertexAroundPath(side, side, level)};
+    ASSERT_MSG(u.has_value(), "Covered edge has no replacement");
+    const Vertex v{*non_tree_adjacency_lists_[level].at(*u).begin()};
+    if (IsConnected(*u, v)) {
+      ASSERT_MSG(level + 1 < num_levels_, "Level is too high");
+      DeleteNonTreeEdge({*u, v});
+      AddNonTreeEdge({*u, v}, level + 1);
+      CoverPath(*u, v, level + 1);
+    } else {
+      DeleteNonTreeEdge({*u, v});
+      AddTreeEdge({*u, v}, level);
+      break;
+    }
+  }
+  // `edge` now acts as a level-`level` non-tree edge that is being deleted.
+  Uncover(edge, level);
+}
+
+void TwoEdgeConnectivity::AddEdge(const UndirectedEdge& edge) {
+  detail::ValidateEdge(edge, num_vertices_);
+  ASSERT_MSG(
+      tree_edges_.find(edge) == tree_edges_.end()
+        && non_tree_edges_.find(edge) == non_tree_edges_.end(),
+      "Edge " << edge << " is already in the graph.");
+  if (IsConnected(edge.first, edge.second)) {
+    AddNonTreeEdge(edge, 0);
+    CoverPath(edge.first, edge.second, 0);
+  } else {
+    AddTreeEdge(edge, -1);
+  }
+}
+
+void TwoEdgeConnectivity::DeleteEdge(const UndirectedEdge& edge) {
+  const auto& non_tree_edge_it{non_tree_edges_.find(edge)};
+  if (non_tree_edge_it != non_tree_edges_.end()) {
+    const int32_t level{non_tree_edge_it->second};
+    DeleteNonTreeEdge(edge);
+    Uncover(edge, level);
+    return;
+  }
+  const auto& tree_edge_it{tree_edges_.find(edge)};
+  ASSERT_MSG(
+      tree_edge_it != tree_edges_.end(),
+      "Edge " << edge << " is not in the graph.");
+  const NodeIndex edge_node{tree_edge_it->second};
+  // Accessing the node pushes pending changes down to its cover level.
+  Access(edge_node);
+  const int32_t cover{nodes_[edge_node].cover};
+  if (cover < 0) {
+    DeleteTreeEdge(edge);
+  } else {
+    Swap(edge, cover);
+  }
+}
+
+bool TwoEdgeConnectivity::Is2EdgeConnected(Vertex u, Vertex v) {
+  detail::ValidateVertex(u, num_vertices_);
+  detail::ValidateVertex(v, num_vertices_);
+  if (u == v) {
+    return true;
+  }
+  if (!IsConnected(u, v)) {
+    return false;
+  }
+  return nodes_[ExposePath(u, v)].min_cover >= 0;
+}
+
+void TwoEdgeConnectivity::Compact() {
+  tree_edges_.rehash(0);
+  non_tree_edges_.rehash(0);
+  for (auto& adjacency_lists : non_tree_adjacency_lists_) {
+    adjacency_lists.rehash(0);
+    for (auto& [vertex, adjacency_list] : adjacency_lists) {
+      adjacency_list.rehash(0);
+    }
+  }
+  splay_path_.shrink_to_fit();
+}
+
+std::size_t TwoEdgeConnectivity::GetMemoryUsage() const {
+  std::size_t bytes{
+    nodes_.capacity() * sizeof(Node)
+      + free_edge_nodes_.capacity() * sizeof(NodeIndex)
+      + (virtual_sizes_.capacity() + virtual_incidences_.capacity()
+          + subtree_sizes_.capacity() + subtree_incidences_.capacity()
+          + contribution_sizes_.capacity()
+          + contribution_incidences_.capacity()) * sizeof(int32_t)
+      + (first_incident_virtual_children_.capacity()
+          + previous_incident_virtual_siblings_.capacity()
+          + next_incident_virtual_siblings_.capacity()) * sizeof(NodeIndex)
+      + incident_levels_.capacity() * sizeof(uint64_t)
+      + detail::GetHashTableBytes(tree_edges_)
+      + detail::GetHashTableBytes(non_tree_edges_)
+      + non_tree_adjacency_lists_.capacity()
+        * sizeof(decltype(non_tree_adjacency_lists_)::value_type)
+      + splay_path_.capacity() * sizeof(NodeIndex)};
+  for (const auto& adjacency_lists : non_tree_adjacency_lists_) {
+    bytes += detail::GetHashTableBytes(adjacency_lists);
+    for (const auto& [vertex, adjacency_list] : adjacency_lists) {
+      bytes += detail::GetHashTableBytes(adjacency_list);
+    }
+  }
+  return bytes;
+}
@@ -0,0 +1,191 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include <dynamic_graph/graph.hpp>
+
+// This is a data structure that maintains which pairs of vertices in an
+// undirected graph are 2-edge-connected, i.e., remain connected after deleting
+// any one edge, as edges are added to and deleted from the graph.
+class TwoEdgeConnectivity {
+ public:
+  // Initializes a graph with `num_vertices` vertices and no edges.
+  //
+  // Efficiency: O(n log n) where n is the number of vertices.
+  explicit TwoEdgeConnectivity(int64_t num_vertices);
+  TwoEdgeConnectivity() = delete;
+
+  ~TwoEdgeConnectivity();
+
+  // Copies the graph.
+  //
+  // Efficiency: linear in the size of the data structure.
+  TwoEdgeConnectivity(const TwoEdgeConnectivity& other);
+  TwoEdgeConnectivity& operator=(const TwoEdgeConnectivity& other) = delete;
+
+  TwoEdgeConnectivity(TwoEdgeConnectivity&& other) noexcept;
+  TwoEdgeConnectivity& operator=(TwoEdgeConnectivity&& other) noexcept
+    = delete;
+
+  // Adds edge to graph.
+  //
+  // The edge must not already be in the graph and must not be a self-loop edge.
+  //
+  // Efficiency: O(log^5 n) amortized where n is the number of vertices. See
+  // the .cpp file.
+  void AddEdge(const UndirectedEdge& edge);
+
+  // Deletes edge from graph.
+  //
+  // The edge must be in the graph.
+  //
+  // Efficiency: O(log^5 n) amortized where n is the number of vertices. See
+  // the .cpp file.
+  void DeleteEdge(const UndirectedEdge& edge);
+
+  // Returns true if vertices `u` and `v` are 2-edge-connected. Every vertex is
+  // 2-edge-connected to itself.
+  //
+  // The query restructures the data structure, so it is not a const method.
+  //
+  // Efficiency: O(log^4 n) amortized where n is the number of vertices. See
+  // the .cpp file.
+  bool Is2EdgeConnected(Vertex u, Vertex v);
+
+  // Returns the number of bytes of memory that the data structure holds. Sizes
+  // of hash tables are estimates.
+  //
+  // Efficiency: linear in the number of vertices.
+  std::size_t GetMemoryUsage() const;
+
+  // Shrinks the maps of edges and the adjacency lists to fit.
+  //
+  // Efficiency: linear in the size of the data structure.
+  void Compact();
+
+ private:
+  // Index of a node in `nodes_`, or `kNoNode`.
+  typedef int64_t NodeIndex;
+  static constexpr NodeIndex kNoNode{-1};
+
+  // Node in a splay tree representing a path in the spanning forest. There is
+  // a node for each vertex and for each edge of the spanning forest.
+  struct Node {
+    std::array<NodeIndex, 2> children{{kNoNode, kNoNode}};
+    // Parent in the splay tree, or, for the root of a splay tree, the parent of
+    // the path in the forest.
+    NodeIndex parent{kNoNode};
+    // The roots of the splay trees of the paths hanging off this node, which
+    // we call its virtual children, form a linked list.
+    NodeIndex first_virtual_child{kNoNode};
+    NodeIndex previous_virtual_sibling{kNoNode};
+    NodeIndex next_virtual_sibling{kNoNode};
+    // Bit i is set if this node is the root of a virtual child that
+    // contributes vertices incident to level-i non-tree edges, in which case it
+    // is also in its parent's list of such virtual children for level i.
+    uint64_t incident_child_levels{0};
+    // Cover level of an edge node. Vertex nodes have cover level
+    // `kVertexCover`, which is higher than any edge's.
+    int32_t cover;
+    // Lowest cover level in this node's splay subtree.
+    int32_t min_cover;
+    // Pending change to the cover levels of this node's splay descendants that
+    // replaces each cover level c by max(pending_cover, c > pending_uncover ?
+    // c : -1).
+    int32_t pending_uncover;
+    int32_t pending_cover;
+    // Whether the children of all nodes in this subtree should be swapped.
+    bool reversed{false};
+  };
+
+  bool IsSplayRoot(NodeIndex node) const;
+  bool IsVertex(NodeIndex node) const;
+  bool IsIncident(NodeIndex node, int32_t level) const;
+  int32_t* GetCounts(std::vector<int32_t>* counts, NodeIndex node);
+  NodeIndex* GetLinks(std::vector<NodeIndex>* links, NodeIndex node);
+  void ResetNode(NodeIndex node, int32_t cover);
+  void ChangeCovers(NodeIndex node, int32_t uncover, int32_t cover);
+  void PushDown(NodeIndex node);
+  void Update(NodeIndex node);
+  void Rotate(NodeIndex node);
+  void Splay(NodeIndex node);
+  void Access(NodeIndex node);
+  void MakeRoot(NodeIndex node);
+  NodeIndex FindRoot(NodeIndex node);
+  void Link(NodeIndex child, NodeIndex parent);
+  void Cut(NodeIndex u, NodeIndex v);
+  void DetachRightChild(NodeIndex node);
+  NodeIndex AddVirtualChild(NodeIndex parent, NodeIndex child);
+  NodeIndex RemoveVirtualChild(NodeIndex parent, NodeIndex child);
+  void ReplaceVirtualChild(
+      NodeIndex parent, NodeIndex old_child, NodeIndex new_child);
+  NodeIndex GetContribution(NodeIndex root);
+  NodeIndex FindUncoveredNode(NodeIndex root, int32_t level);
+  NodeIndex FindIncidentNode(
+      NodeIndex root, int32_t level, bool stops_at_uncovered);
+
+  bool IsConnected(Vertex u, Vertex v);
+  NodeIndex ExposePath(Vertex u, Vertex v);
+  void CoverPath(Vertex u, Vertex v, int32_t level);
+  int32_t GetSizeAroundPath(Vertex u, Vertex v, int32_t level);
+  std::optional<Vertex>
+  FindIncidentVertexAroundPath(Vertex u, Vertex v, int32_t level);
+  void SetIncident(Vertex v, int32_t level, bool is_incident);
+  void AddTreeEdge(const UndirectedEdge& edge, int32_t cover);
+  void DeleteTreeEdge(const UndirectedEdge& edge);
+  void AddNonTreeEdge(const UndirectedEdge& edge, int32_t level);
+  void DeleteNonTreeEdge(const UndirectedEdge& edge);
+  void Uncover(const UndirectedEdge& edge, int32_t level);
+  void Recover(const UndirectedEdge& edge, int32_t level);
+  void Swap(const UndirectedEdge& edge, int32_t level);
+
+  const int64_t num_vertices_;
+  // Number of levels. Edges have levels and cover levels below this.
+  const int32_t num_levels_;
+  // The first `num_vertices_` nodes represent vertices. The rest are
+  // preallocated nodes for edges, of which the unused ones are listed in
+  // `free_edge_nodes_`.
+  std::vector<Node> nodes_;
+  std::vector<NodeIndex> free_edge_nodes_;
+  // Each of these holds `num_levels_` counts per node. For level i, they count
+  // the vertices that are i-connected to the node through its virtual children
+  // (`virtual_...`) or through the nodes of its splay subtree and their
+  // virtual children (`subtree_...`). The `..._sizes` count all such vertices,
+  // while the `..._incidences` count only those incident to level-i non-tree
+  // edges.
+  std::vector<int32_t> virtual_sizes_;
+  std::vector<int32_t> virtual_incidences_;
+  std::vector<int32_t> subtree_sizes_;
+  std::vector<int32_t> subtree_incidences_;
+  // Each of these holds `num_levels_` links per node. For level i, the virtual
+  // children of a node that contribute vertices incident to level-i non-tree
+  // edges form a linked list, so that searches find one without scanning all
+  // virtual children.
+  std::vector<NodeIndex> first_incident_virtual_children_;
+  std::vector<NodeIndex> previous_incident_virtual_siblings_;
+  std::vector<NodeIndex> next_incident_virtual_siblings_;
+  // Bit i of `incident_levels_[v]` is set if vertex v is incident to a level-i
+  // non-tree edge.
+  std::vector<uint64_t> incident_levels_;
+  // Maps each edge of the spanning forest to its node.
+  std::unordered_map<UndirectedEdge, NodeIndex, UndirectedEdgeHash>
+    tree_edges_;
+  // Maps each non-tree edge to its level.
+  std::unordered_map<UndirectedEdge, int32_t, UndirectedEdgeHash>
+    non_tree_edges_;
+  // `non_tree_adjacency_lists_[i][v]` contains the vertices connected to
+  // vertex v by level-i non-tree edges. Vertices with no such edges have no
+  // entry.
+  std::vector<std::unordered_map<Vertex, std::unordered_set<Vertex>>>
+    non_tree_adjacency_lists_;
+  // Scratch space.
+  std::vector<NodeIndex> splay_path_;
+  std::vector<int32_t> contribution_sizes_;
+  std::vector<int32_t> contribution_incidences_;
+};
@@ -0,0 +1,76 @@
+#include <dynamic_graph/async_dynamic_connectivity.hpp>
+
+#include <chrono>
+#include <future>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+TEST(AsyncDynamicConnectivity, AddAndDeleteEdge) {
+  AsyncDynamicConnectivity graph(4);
+  graph.AddEdge({0, 1}).wait();
+  graph.AddEdge({1, 2});
+  graph.AddEdge({2, 0}).wait();
+  EXPECT_TRUE(graph.IsConnected(0, 2));
+  EXPECT_TRUE(graph.HasEdge({1, 2}));
+  EXPECT_EQ(graph.GetSizeOfConnectedComponent(1), 3);
+  EXPECT_EQ(graph.GetNumberOfConnectedComponents(), 2);
+
+  graph.DeleteEdge({0, 1});
+  graph.AddEdge({2, 3});
+  graph.Flush();
+  EXPECT_TRUE(graph.IsConnected(0, 3));
+  EXPECT_FALSE(graph.HasEdge({0, 1}));
+  graph.DeleteEdge({2, 0});
+  graph.Flush();
+  EXPECT_FALSE(graph.IsConnected(0, 1));
+}
+
+// Updates that cancel out within a batch should never reach the graph.
+TEST(AsyncDynamicConnectivity, CoalesceFlappingEdge) {
+  AsyncDynamicConnectivity graph(3, std::chrono::milliseconds{50});
+  std::vector<std::future<void>> updates;
+  for (int32_t i = 0; i < 100; i++) {
+    updates.emplace_back(graph.AddEdge({0, 1}));
+    updates.emplace_back(graph.DeleteEdge({0, 1}));
+  }
+  updates.emplace_back(graph.AddEdge({1, 2}));
+  for (std::future<void>& update : updates) {
+    update.wait();
+  }
+  EXPECT_FALSE(graph.HasEdge({0, 1}));
+  EXPECT_TRUE(graph.HasEdge({1, 2}));
+  // Every update to {0, 1} is superseded by the last one, which finds the edge
+  // already absent, unless the window happened to split the updates into
+  // several batches.
+  EXPECT_GE(graph.GetNumberOfSkippedUpdates(), 100);
+
+  // Redundant updates are skipped too.
+  graph.AddEdge({1, 2});
+  graph.DeleteEdge({0, 2});
+  graph.Flush();
+  EXPECT_TRUE(graph.HasEdge({1, 2}));
+  EXPECT_EQ(graph.GetNumberOfConnectedComponents(), 2);
+}
+
+TEST(AsyncDynamicConnectivity, ManyProducers) {
+  constexpr int64_t kNumVertices{400};
+  constexpr int32_t kNumProducers{4};
+  AsyncDynamicConnectivity graph(kNumVertices);
+  std::vector<std::thread> producers;
+  for (int32_t i = 0; i < kNumProducers; i++) {
+    producers.emplace_back([&, i] {
+      // Together, the producers build a path through all the vertices.
+      for (Vertex v = i; v + 1 < kNumVertices; v += kNumProducers) {
+        graph.AddEdge({v, v + 1});
+      }
+      graph.Flush();
+    });
+  }
+  for (std::thread& producer : producers) {
+    producer.join();
+  }
+  EXPECT_EQ(graph.GetNumberOfConnectedComponents(), 1);
+  EXPECT_EQ(graph.GetSizeOfConnectedComponent(0), kNumVertices);
+}
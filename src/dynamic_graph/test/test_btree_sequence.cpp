@@ -0,0 +1,319 @@
+#include <btree_sequence.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <new>
+#include <random>
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+namespace seq = sequence;
+
+namespace {
+
+typedef seq::BTreeElement<NoAggregate> Element;
+
+// Enough elements for trees several levels tall.
+constexpr int32_t kNumElements{3000};
+
+// Returns the ids that `element`'s sequence should have when it holds
+// `elements[indices[0]]`, `elements[indices[1]]`, ....
+std::vector<seq::Id> ExpectedIds(const std::vector<int32_t>& indices) {
+  std::vector<seq::Id> ids;
+  for (const int32_t i : indices) {
+    ids.emplace_back(i, i);
+  }
+  return ids;
+}
+
+}  // namespace
+
+TEST(BTreeSequence, CopyConstructorMultipleElements) {
+  Element elements[2];
+  Element::Join(&elements[0], &elements[1]);
+  EXPECT_DEATH(
+      Element newElement{elements[0]},
+      "Copied element cannot live in a sequence of multiple elements");
+}
+
+TEST(BTreeSequence, JoinAndSplitAndGetSize) {
+  std::vector<Element> elements;
+  elements.reserve(kNumElements);
+  for (int32_t i = 0; i < kNumElements; i++) {
+    elements.emplace_back(std::make_pair(i, i));
+  }
+  EXPECT_EQ(elements[0].GetSize(), 1);
+  for (int32_t i = 1; i < kNumElements; i++) {
+    EXPECT_NE(elements[0].GetRepresentative(), elements[i].GetRepresentative());
+    Element::Join(&elements[i - 1], &elements[i]);
+  }
+  EXPECT_EQ(elements[0].GetSize(), kNumElements);
+  EXPECT_EQ(
+      elements[0].GetRepresentative(),
+      elements[kNumElements - 1].GetRepresentative());
+  for (int32_t i = 1; i < kNumElements; i++) {
+    EXPECT_EQ(elements[i].GetPredecessor(), &elements[i - 1]);
+  }
+
+  Element* split_successor{elements[1000].Split()};
+  EXPECT_EQ(split_successor, &elements[1001]);
+  EXPECT_NE(elements[0].GetRepresentative(), elements[1001].GetRepresentative());
+  EXPECT_EQ(elements[0].GetSize(), 1001);
+  EXPECT_EQ(elements[kNumElements - 1].GetSize(), kNumElements - 1001);
+  EXPECT_EQ(elements[1001].GetPredecessor(), nullptr);
+  EXPECT_EQ(elements[kNumElements - 1].Split(), nullptr);
+}
+
+TEST(BTreeSequence, RandomJoinsAndSplits) {
+  std::mt19937 random_generator{0};
+  std::vector<Element> elements;
+  elements.reserve(kNumElements);
+  for (int32_t i = 0; i < kNumElements; i++) {
+    elements.emplace_back(std::make_pair(i, i));
+  }
+  // `sequences` mirrors the sequences of `elements` by index.
+  std::vector<std::vector<int32_t>> sequences(kNumElements);
+  for (int32_t i = 0; i < kNumElements; i++) {
+    sequences[i] = {i};
+  }
+  for (int32_t step = 0; step < 4000; step++) {
+    if (sequences.size() > 1 && random_generator() % 3 != 0) {
+      const std::size_t a{random_generator() % sequences.size()};
+      std::size_t b{random_generator() % (sequences.size() - 1)};
+      if (b >= a) {
+        b++;
+      }
+      Element::Join(
+          &elements[sequences[a].back()], &elements[sequences[b].front()]);
+      sequences[a].insert(
+          sequences[a].end(), sequences[b].begin(), sequences[b].end());
+      sequences[b] = std::move(sequences.back());
+      sequences.pop_back();
+    } else {
+      const std::size_t a{random_generator() % sequences.size()};
+      const std::size_t position{random_generator() % sequences[a].size()};
+      Element* const successor{elements[sequences[a][position]].Split()};
+      if (position + 1 == sequences[a].size()) {
+        EXPECT_EQ(successor, nullptr);
+      } else {
+        EXPECT_EQ(successor, &elements[sequences[a][position + 1]]);
+        sequences.emplace_back(
+            sequences[a].begin() + position + 1, sequences[a].end());
+        sequences[a].resize(position + 1);
+      }
+    }
+  }
+  for (const std::vector<int32_t>& sequence : sequences) {
+    const Element& element{elements[sequence[random_generator() % sequence.size()]]};
+    EXPECT_EQ(element.GetSize(), sequence.size());
+    EXPECT_EQ(element.SequenceIds(), ExpectedIds(sequence));
+    EXPECT_EQ(
+        element.GetRepresentative(),
+        elements[sequence.front()].GetRepresentative());
+  }
+}
+
+TEST(BTreeSequence, Mark) {
+  std::vector<Element> elements(kNumElements);
+  for (int32_t i = 1; i < kNumElements; i++) {
+    Element::Join(&elements[i - 1], &elements[i]);
+  }
+  EXPECT_EQ(elements[0].FindMarkedElement(0), std::nullopt);
+  elements[2500].Mark(0, true);
+  elements[10].Mark(1, true);
+  EXPECT_THAT(elements[7].FindMarkedElement(0), testing::Optional(&elements[2500]));
+  EXPECT_THAT(elements[7].FindMarkedElement(1), testing::Optional(&elements[10]));
+  elements[2500].Mark(0, false);
+  EXPECT_EQ(elements[7].FindMarkedElement(0), std::nullopt);
+
+  elements[1500].Mark(0, true);
+  elements[999].Split();
+  EXPECT_EQ(elements[0].FindMarkedElement(0), std::nullopt);
+  EXPECT_THAT(elements[0].FindMarkedElement(1), testing::Optional(&elements[10]));
+  EXPECT_THAT(
+      elements[1000].FindMarkedElement(0),
+      testing::Optional(&elements[1500]));
+}
+
+TEST(BTreeSequence, TakeMarkedElements) {
+  std::vector<Element> elements(kNumElements);
+  for (int32_t i = 1; i < kNumElements; i++) {
+    Element::Join(&elements[i - 1], &elements[i]);
+  }
+  std::vector<Element*> expected_marked;
+  for (int32_t i = 5; i < kNumElements; i += 97) {
+    elements[i].Mark(0, true);
+    expected_marked.push_back(&elements[i]);
+  }
+  elements[1234].Mark(1, true);
+
+  EXPECT_EQ(elements[0].FindMarkedElements(0, kNumElements), expected_marked);
+  EXPECT_EQ(
+      elements[7].TakeMarkedElements(0, 10),
+      std::vector<Element*>(
+        expected_marked.begin(), expected_marked.begin() + 10));
+  EXPECT_THAT(
+      elements[0].FindMarkedElement(0),
+      testing::Optional(expected_marked[10]));
+  EXPECT_EQ(
+      elements[0].TakeMarkedElements(0, kNumElements),
+      std::vector<Element*>(
+        expected_marked.begin() + 10, expected_marked.end()));
+  EXPECT_EQ(elements[0].FindMarkedElement(0), std::nullopt);
+  EXPECT_THAT(
+      elements[0].FindMarkedElement(1),
+      testing::Optional(&elements[1234]));
+
+  Element single_element;
+  single_element.Mark(0, true);
+  EXPECT_EQ(
+      single_element.TakeMarkedElements(0, 1),
+      std::vector<Element*>{&single_element});
+  EXPECT_EQ(single_element.FindMarkedElement(0), std::nullopt);
+}
+
+TEST(BTreeSequence, CopySequences) {
+  std::vector<Element> elements;
+  for (int32_t i = 0; i < kNumElements; i++) {
+    elements.emplace_back(std::make_pair(i, i));
+  }
+  std::vector<int32_t> first_sequence;
+  for (int32_t i = 1; i < kNumElements - 1; i++) {
+    Element::Join(&elements[i - 1], &elements[i]);
+  }
+  elements[42].Mark(0, true);
+  std::vector<Element> copies(kNumElements);
+  Element::CopySequences(elements.data(), copies.data(), kNumElements);
+  EXPECT_EQ(copies[0].GetRepresentative(), copies[100].GetRepresentative());
+  EXPECT_NE(
+      copies[0].GetRepresentative(),
+      copies[kNumElements - 1].GetRepresentative());
+  EXPECT_EQ(copies[5].SequenceIds(), elements[5].SequenceIds());
+  EXPECT_THAT(copies[0].FindMarkedElement(0), testing::Optional(&copies[42]));
+
+  // The copies are independent of the originals.
+  copies[0].Split();
+  EXPECT_EQ(copies[1].GetSize(), kNumElements - 2);
+  EXPECT_EQ(elements[1].GetSize(), kNumElements - 1);
+}
+
+TEST(BTreeSequence, CopySequencesToIndices) {
+  std::vector<Element> elements;
+  for (int32_t i = 0; i < kNumElements; i++) {
+    elements.emplace_back(std::make_pair(i, i));
+  }
+  // Join the even elements into one sequence and copy them, in reverse, into
+  // the front half of the destination. The odd elements are not copied.
+  for (int32_t i = 2; i < kNumElements; i += 2) {
+    Element::Join(&elements[i - 2], &elements[i]);
+  }
+  elements[42].Mark(0, true);
+  const int32_t num_copies{(kNumElements + 1) / 2};
+  std::vector<int64_t> destination_indices(kNumElements, -1);
+  for (int32_t i = 0; i < kNumElements; i += 2) {
+    destination_indices[i] = num_copies - 1 - i / 2;
+  }
+  std::vector<Element> copies(num_copies);
+  Element::CopySequences(
+      elements.data(),
+      copies.data(),
+      kNumElements,
+      destination_indices.data());
+  EXPECT_EQ(copies[0].GetSize(), num_copies);
+  EXPECT_EQ(copies[0].id_, elements[2 * (num_copies - 1)].id_);
+  EXPECT_EQ(copies[0].SequenceIds(), elements[0].SequenceIds());
+  EXPECT_THAT(
+      copies[0].FindMarkedElement(0),
+      testing::Optional(&copies[num_copies - 1 - 21]));
+}
+
+TEST(BTreeSequence, GetNodeBytes) {
+  std::vector<Element> elements(kNumElements);
+  EXPECT_EQ(Element::GetNodeBytes(elements.data(), kNumElements), 0);
+  for (int32_t i = 1; i < kNumElements; i++) {
+    Element::Join(&elements[i - 1], &elements[i]);
+  }
+  const std::size_t node_size{sizeof(seq::detail::BTreeNode<NoAggregate>)};
+  const std::size_t num_bytes{
+    Element::GetNodeBytes(elements.data(), kNumElements)};
+  EXPECT_EQ(num_bytes % node_size, 0);
+  // Every node but the root has between `kBTreeMinFanout` and
+  // `kBTreeMaxFanout` children.
+  const std::size_t num_nodes{num_bytes / node_size};
+  EXPECT_GE(num_nodes, kNumElements / seq::detail::kBTreeMaxFanout);
+  EXPECT_LE(num_nodes, 2 * kNumElements / seq::detail::kBTreeMinFanout);
+}
+
+namespace {
+
+// Arena that allocates from the global allocator and counts the bytes it has
+// handed out and not yet taken back.
+class CountingArena : public MemoryArena {
+ public:
+  void* Allocate(std::size_t num_bytes, std::size_t) override {
+    num_bytes_ += num_bytes;
+    return ::operator new(num_bytes);
+  }
+  void Deallocate(void* pointer, std::size_t num_bytes, std::size_t) override {
+    num_bytes_ -= num_bytes;
+    ::operator delete(pointer);
+  }
+  std::size_t GetNumberOfBytes() const { return num_bytes_; }
+
+ private:
+  std::size_t num_bytes_{0};
+};
+
+}  // namespace
+
+// The B-tree nodes are allocated from the elements' arena, including those of
+// copies, and given back to it as the sequences shrink.
+TEST(BTreeSequence, AllocatesNodesFromArena) {
+  CountingArena arena;
+  {
+    std::vector<Element> elements;
+    for (int32_t i = 0; i < kNumElements; i++) {
+      elements.emplace_back(std::make_pair(i, i), &arena);
+    }
+    for (int32_t i = 1; i < kNumElements; i++) {
+      Element::Join(&elements[i - 1], &elements[i]);
+    }
+    const std::size_t num_bytes{
+      Element::GetNodeBytes(elements.data(), kNumElements)};
+    EXPECT_GT(num_bytes, 0);
+    EXPECT_EQ(arena.GetNumberOfBytes(), num_bytes);
+
+    std::vector<Element> copies(
+        kNumElements, Element{std::make_pair(-1, -1), &arena});
+    Element::CopySequences(elements.data(), copies.data(), kNumElements);
+    EXPECT_EQ(arena.GetNumberOfBytes(), 2 * num_bytes);
+
+    for (int32_t i = 0; i < kNumElements - 1; i++) {
+      elements[i].Split();
+    }
+    EXPECT_EQ(arena.GetNumberOfBytes(), num_bytes);
+  }
+  EXPECT_EQ(arena.GetNumberOfBytes(), 0);
+}
+
+TEST(BTreeSequence, Aggregate) {
+  typedef seq::BTreeElement<SumAggregate<int64_t>> SumElement;
+  std::vector<SumElement> elements(kNumElements);
+  for (int32_t i = 0; i < kNumElements; i++) {
+    elements[i].SetValue(i);
+  }
+  for (int32_t i = 1; i < kNumElements; i++) {
+    SumElement::Join(&elements[i - 1], &elements[i]);
+  }
+  const int64_t n{kNumElements};
+  EXPECT_EQ(elements[0].GetAggregate(), n * (n - 1) / 2);
+  EXPECT_EQ(elements[2000].GetPrefixAggregate(), 2000 * 2001 / 2);
+
+  elements[5].SetValue(0);
+  EXPECT_EQ(elements[2999].GetAggregate(), n * (n - 1) / 2 - 5);
+  elements[99].Split();
+  EXPECT_EQ(elements[0].GetAggregate(), 99 * 100 / 2 - 5);
+  EXPECT_EQ(elements[100].GetPrefixAggregate(), 100);
+}
@@ -0,0 +1,73 @@
+#include <dynamic_graph/concurrent_dynamic_connectivity.hpp>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+TEST(ConcurrentDynamicConnectivity, AddAndDeleteEdge) {
+  BasicConcurrentDynamicConnectivity<SumAggregate<int64_t>> graph(4);
+  graph.SetVertexValue(0, 1);
+  graph.SetVertexValue(3, 2);
+  graph.SetTwoEdgeConnectivityTracking(true);
+  graph.AddEdge({0, 1});
+  graph.AddEdge({1, 2});
+  graph.AddEdge({2, 0});
+  EXPECT_TRUE(graph.IsConnected(0, 2));
+  EXPECT_TRUE(graph.HasEdge({1, 2}));
+  EXPECT_EQ(graph.GetSizeOfConnectedComponent(1), 3);
+  EXPECT_EQ(graph.GetNumberOfConnectedComponents(), 2);
+  EXPECT_EQ(graph.GetComponentAggregate(2), 1);
+  EXPECT_FALSE(graph.IsBridge({0, 1}));
+  EXPECT_TRUE(graph.Is2EdgeConnected(0, 1));
+
+  graph.DeleteEdge({0, 1});
+  graph.AddEdge({2, 3});
+  EXPECT_TRUE(graph.IsConnected(0, 1));
+  EXPECT_TRUE(graph.IsBridge({2, 3}));
+  EXPECT_FALSE(graph.Is2EdgeConnected(0, 1));
+  EXPECT_EQ(graph.GetComponentAggregate(1), 3);
+  EXPECT_EQ(graph.GetVertexValue(3), 2);
+  graph.DeleteEdge({2, 0});
+  EXPECT_FALSE(graph.IsConnected(0, 1));
+}
+
+// Readers should only ever see the graph between updates.
+TEST(ConcurrentDynamicConnectivity, ConcurrentReaders) {
+  constexpr int64_t kNumVertices{200};
+  ConcurrentDynamicConnectivity graph(kNumVertices);
+  // Build a cycle. Deleting any one edge of it keeps the graph connected.
+  for (Vertex v = 0; v < kNumVertices; v++) {
+    graph.AddEdge({v, (v + 1) % kNumVertices});
+  }
+
+  std::atomic<bool> done{false};
+  std::atomic<int64_t> num_failures{0};
+  std::vector<std::thread> readers;
+  for (int32_t i = 0; i < 3; i++) {
+    readers.emplace_back([&, i] {
+      Vertex u{i};
+      while (!done.load()) {
+        u = (u * 37 + 11) % kNumVertices;
+        if (!graph.IsConnected(u, (u * 13 + 5) % kNumVertices)
+            || graph.GetNumberOfConnectedComponents() != 1
+            || graph.GetSizeOfConnectedComponent(u) != kNumVertices) {
+          num_failures++;
+        }
+      }
+    });
+  }
+  for (int32_t round = 0; round < 3; round++) {
+    for (Vertex v = 0; v < kNumVertices; v++) {
+      const UndirectedEdge edge{v, (v + 1) % kNumVertices};
+      graph.DeleteEdge(edge);
+      graph.AddEdge(edge);
+    }
+  }
+  done = true;
+  for (std::thread& reader : readers) {
+    reader.join();
+  }
+  EXPECT_EQ(num_failures.load(), 0);
+}
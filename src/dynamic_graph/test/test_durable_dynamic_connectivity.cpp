@@ -0,0 +1,128 @@
+#include <dynamic_graph/durable_dynamic_connectivity.hpp>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <fstream>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+namespace {
+
+// Returns a new empty directory.
+std::string MakeDirectory() {
+  std::string path{testing::TempDir() + "/durable_XXXXXX"};
+  EXPECT_NE(mkdtemp(path.data()), nullptr);
+  return path;
+}
+
+void ExpectSameGraph(
+    const DurableDynamicConnectivity& graph,
+    const DynamicConnectivity& expected_graph,
+    int64_t num_vertices) {
+  EXPECT_EQ(
+      graph.GetNumberOfConnectedComponents(),
+      expected_graph.GetNumberOfConnectedComponents());
+  for (Vertex u = 0; u < num_vertices; u++) {
+    EXPECT_EQ(
+        graph.GetSizeOfConnectedComponent(u),
+        expected_graph.GetSizeOfConnectedComponent(u));
+    for (Vertex v = u + 1; v < num_vertices; v++) {
+      EXPECT_EQ(graph.IsConnected(u, v), expected_graph.IsConnected(u, v));
+      EXPECT_EQ(graph.HasEdge({u, v}), expected_graph.HasEdge({u, v}));
+    }
+  }
+}
+
+}  // namespace
+
+TEST(DurableDynamicConnectivity, RecoverFromLog) {
+  const std::string directory{MakeDirectory()};
+  {
+    DurableDynamicConnectivity graph{5, directory, 2};
+    graph.AddEdge({0, 1});
+    graph.AddEdge({1, 2});
+    graph.AddEdge({0, 2});
+    graph.DeleteEdge({0, 1});
+    graph.AddEdge({3, 4});
+  }
+  DurableDynamicConnectivity graph{5, directory};
+  EXPECT_TRUE(graph.IsConnected(0, 1));
+  EXPECT_FALSE(graph.HasEdge({0, 1}));
+  EXPECT_TRUE(graph.HasEdge({0, 2}));
+  EXPECT_TRUE(graph.IsConnected(3, 4));
+  EXPECT_FALSE(graph.IsConnected(2, 3));
+  EXPECT_EQ(graph.GetNumberOfConnectedComponents(), 2);
+}
+
+TEST(DurableDynamicConnectivity, DropTornBatch) {
+  const std::string directory{MakeDirectory()};
+  {
+    DurableDynamicConnectivity graph{4, directory, 1};
+    graph.AddEdge({0, 1});
+    graph.AddEdge({2, 3});
+  }
+  {
+    // Simulate a crash in the middle of writing a batch.
+    std::ofstream log{directory + "/log.0", std::ios::app | std::ios::binary};
+    log << "torn batch";
+  }
+  {
+    DurableDynamicConnectivity graph{4, directory, 1};
+    EXPECT_TRUE(graph.HasEdge({0, 1}));
+    EXPECT_TRUE(graph.HasEdge({2, 3}));
+    // The torn batch is cut off, so later batches are readable.
+    graph.AddEdge({1, 2});
+  }
+  DurableDynamicConnectivity graph{4, directory};
+  EXPECT_TRUE(graph.IsConnected(0, 3));
+}
+
+// Saves snapshots often while updating randomly and recovers now and then,
+// comparing against a graph that is never saved.
+TEST(DurableDynamicConnectivity, RandomUpdatesWithSnapshots) {
+  constexpr int64_t kNumVertices{40};
+  const std::string directory{MakeDirectory()};
+  std::mt19937 random_generator{0};
+  std::uniform_int_distribution<Vertex> vertex_distribution{
+    0, kNumVertices - 1};
+  DynamicConnectivity expected_graph(kNumVertices);
+  std::vector<std::pair<Vertex, Vertex>> edges;
+  for (int32_t round = 0; round < 5; round++) {
+    DurableDynamicConnectivity graph{
+      kNumVertices,
+      directory,
+      16,
+      DurableDynamicConnectivity::SyncPolicy::kNone,
+      300};
+    ExpectSameGraph(graph, expected_graph, kNumVertices);
+    for (int32_t i = 0; i < 1000; i++) {
+      if (edges.size() < 60 || random_generator() % 2 == 0) {
+        const UndirectedEdge edge{
+          vertex_distribution(random_generator),
+          vertex_distribution(random_generator)};
+        if (edge.first == edge.second || expected_graph.HasEdge(edge)) {
+          continue;
+        }
+        graph.AddEdge(edge);
+        expected_graph.AddEdge(edge);
+        edges.emplace_back(edge.first, edge.second);
+      } else {
+        const std::size_t index{random_generator() % edges.size()};
+        const UndirectedEdge edge{edges[index].first, edges[index].second};
+        std::swap(edges[index], edges.back());
+        edges.pop_back();
+        graph.DeleteEdge(edge);
+        expected_graph.DeleteEdge(edge);
+      }
+    }
+  }
+  DurableDynamicConnectivity graph{kNumVertices, directory};
+  ExpectSameGraph(graph, expected_graph, kNumVertices);
+  // Logs of generations that have been saved to snapshots are deleted.
+  EXPECT_EQ(access((directory + "/log.0").c_str(), F_OK), -1);
+}
@@ -1,5 +1,12 @@
 #include <dynamic_graph/dynamic_connectivity.hpp>
 
+#include <algorithm>
+#include <random>
+#include <set>
+#include <tuple>
+#include <utility>
+#include <vector>
+
 #include <gtest/gtest.h>
 
 TEST(DynamicConnectivity, SingleVertexGraph) {
@@ -115,3 +122,781 @@ TEST(DynamicConnectivity, GetNumberOfConnectedComponents) {
   graph.DeleteEdge({1, 3});
   EXPECT_EQ(graph.GetNumberOfConnectedComponents(), 4);
 }
+
+TEST(DynamicConnectivity, ComponentSizes) {
+  DynamicConnectivity graph(10);
+  EXPECT_EQ(graph.GetLargestComponentSizes(3), (std::vector<int64_t>{1, 1, 1}));
+  EXPECT_EQ(
+      graph.GetComponentSizeHistogram(),
+      (std::vector<int64_t>{10, 0, 0, 0}));
+
+  // Components {0, 1, 2, 3, 4}, {5, 6}, {7, 8}, and {9}.
+  for (Vertex v = 1; v < 5; v++) {
+    graph.AddEdge({v - 1, v});
+  }
+  graph.AddEdge({0, 4});
+  graph.AddEdge({5, 6});
+  graph.AddEdge({7, 8});
+  EXPECT_EQ(graph.GetLargestComponentSizes(2), (std::vector<int64_t>{5, 2}));
+  EXPECT_EQ(
+      graph.GetLargestComponentSizes(10),
+      (std::vector<int64_t>{5, 2, 2, 1}));
+  EXPECT_EQ(
+      graph.GetComponentSizeHistogram(),
+      (std::vector<int64_t>{1, 2, 1, 0}));
+
+  // Deleting a tree edge with a replacement keeps the sizes.
+  graph.DeleteEdge({1, 2});
+  EXPECT_EQ(graph.GetLargestComponentSizes(1), (std::vector<int64_t>{5}));
+  graph.Checkpoint();
+  graph.DeleteEdge({2, 3});
+  graph.AddEdge({6, 7});
+  EXPECT_EQ(
+      graph.GetLargestComponentSizes(10),
+      (std::vector<int64_t>{4, 4, 1, 1}));
+  EXPECT_EQ(
+      graph.GetComponentSizeHistogram(),
+      (std::vector<int64_t>{2, 0, 2, 0}));
+  graph.Rollback();
+  EXPECT_EQ(
+      graph.GetLargestComponentSizes(10),
+      (std::vector<int64_t>{5, 2, 2, 1}));
+
+  // Compare with sizes computed from scratch after random updates.
+  std::mt19937 random_generator{0};
+  std::uniform_int_distribution<Vertex> vertex_distribution{0, 9};
+  for (int32_t i = 0; i < 500; i++) {
+    const UndirectedEdge edge{
+      vertex_distribution(random_generator),
+      vertex_distribution(random_generator)};
+    if (edge.first == edge.second) {
+      continue;
+    }
+    if (graph.HasEdge(edge)) {
+      graph.DeleteEdge(edge);
+    } else {
+      graph.AddEdge(edge);
+    }
+    std::vector<int64_t> expected_sizes;
+    std::vector<int64_t> expected_histogram(4, 0);
+    for (Vertex v = 0; v < 10; v++) {
+      bool is_first_in_component{true};
+      for (Vertex u = 0; u < v; u++) {
+        is_first_in_component &= !graph.IsConnected(u, v);
+      }
+      if (is_first_in_component) {
+        const int64_t size{graph.GetSizeOfConnectedComponent(v)};
+        expected_sizes.push_back(size);
+        expected_histogram[size >= 8 ? 3 : size >= 4 ? 2 : size >= 2]++;
+      }
+    }
+    std::sort(expected_sizes.rbegin(), expected_sizes.rend());
+    EXPECT_EQ(graph.GetLargestComponentSizes(10), expected_sizes);
+    EXPECT_EQ(graph.GetComponentSizeHistogram(), expected_histogram);
+  }
+}
+
+TEST(DynamicConnectivity, ComponentEvents) {
+  DynamicConnectivity graph(6);
+  typedef ComponentEvent::Type Type;
+  std::vector<std::tuple<Type, Vertex, Vertex, int64_t, int64_t>> events;
+  const int64_t subscription{graph.SubscribeToComponentEvents(
+      [&](const ComponentEvent& event) {
+        events.emplace_back(
+            event.type,
+            event.first_vertex,
+            event.second_vertex,
+            event.first_size,
+            event.second_size);
+      })};
+
+  // Graph is a cycle 0-1-2-3-0 plus path 4-5.
+  graph.AddEdge({0, 1});
+  graph.AddEdge({1, 2});
+  graph.AddEdge({2, 3});
+  graph.AddEdge({0, 3});
+  graph.AddEdge({4, 5});
+  EXPECT_EQ(
+      events,
+      (decltype(events){
+        {Type::kMerge, 0, 1, 1, 1},
+        {Type::kMerge, 1, 2, 2, 1},
+        {Type::kMerge, 2, 3, 3, 1},
+        {Type::kMerge, 4, 5, 1, 1}}));
+  events.clear();
+
+  // Deleting a tree edge with a replacement changes no component.
+  graph.DeleteEdge({1, 2});
+  EXPECT_TRUE(events.empty());
+  graph.DeleteEdge({0, 3});
+  EXPECT_EQ(events, (decltype(events){{Type::kSplit, 0, 3, 2, 2}}));
+  events.clear();
+
+  graph.Checkpoint();
+  graph.DeleteEdge({4, 5});
+  graph.AddEdge({1, 4});
+  events.clear();
+  graph.Rollback();
+  EXPECT_EQ(
+      events,
+      (decltype(events){
+        {Type::kSplit, 1, 4, 2, 1},
+        {Type::kMerge, 4, 5, 1, 1}}));
+  events.clear();
+
+  // Copies and canceled subscriptions hear nothing.
+  DynamicConnectivity copy{graph};
+  copy.AddEdge({0, 5});
+  graph.UnsubscribeFromComponentEvents(subscription);
+  graph.AddEdge({0, 5});
+  EXPECT_TRUE(events.empty());
+}
+
+TEST(DynamicConnectivity, Rollback) {
+  DynamicConnectivity graph(6);
+  // Graph is a cycle 0-1-2-3-4-5-0 plus chord {0, 3}.
+  for (Vertex i = 0; i < 6; i++) {
+    graph.AddEdge({i, (i + 1) % 6});
+  }
+  graph.AddEdge({0, 3});
+
+  graph.Checkpoint();
+  graph.DeleteEdge({0, 1});
+  graph.DeleteEdge({3, 4});
+  graph.DeleteEdge({0, 3});
+  EXPECT_FALSE(graph.IsConnected(0, 3));
+  EXPECT_EQ(graph.GetNumberOfConnectedComponents(), 2);
+  graph.AddEdge({1, 4});
+  EXPECT_TRUE(graph.HasEdge({1, 4}));
+  graph.Rollback();
+
+  EXPECT_FALSE(graph.HasEdge({1, 4}));
+  EXPECT_TRUE(graph.HasEdge({0, 1}));
+  EXPECT_TRUE(graph.HasEdge({3, 4}));
+  EXPECT_TRUE(graph.HasEdge({0, 3}));
+  EXPECT_EQ(graph.GetNumberOfConnectedComponents(), 1);
+  EXPECT_EQ(graph.GetSizeOfConnectedComponent(0), 6);
+
+  // The restored structure should still handle updates correctly.
+  graph.DeleteEdge({0, 1});
+  graph.DeleteEdge({3, 4});
+  EXPECT_TRUE(graph.IsConnected(0, 2));
+  graph.DeleteEdge({0, 3});
+  EXPECT_FALSE(graph.IsConnected(0, 2));
+  EXPECT_TRUE(graph.IsConnected(1, 2));
+  EXPECT_TRUE(graph.IsConnected(0, 5));
+}
+
+TEST(DynamicConnectivity, NestedCheckpoints) {
+  DynamicConnectivity graph(4);
+  graph.AddEdge({0, 1});
+
+  graph.Checkpoint();
+  graph.AddEdge({1, 2});
+  graph.Checkpoint();
+  graph.AddEdge({2, 3});
+  graph.DeleteEdge({0, 1});
+  EXPECT_TRUE(graph.IsConnected(1, 3));
+  graph.Rollback();
+  EXPECT_TRUE(graph.IsConnected(0, 2));
+  EXPECT_FALSE(graph.IsConnected(0, 3));
+
+  graph.Checkpoint();
+  graph.AddEdge({0, 3});
+  graph.DiscardCheckpoint();
+  EXPECT_TRUE(graph.IsConnected(2, 3));
+  graph.Rollback();
+  EXPECT_FALSE(graph.HasEdge({0, 3}));
+  EXPECT_FALSE(graph.HasEdge({1, 2}));
+  EXPECT_TRUE(graph.IsConnected(0, 1));
+  EXPECT_EQ(graph.GetNumberOfConnectedComponents(), 3);
+}
+
+TEST(DynamicConnectivity, CopyConstructor) {
+  DynamicConnectivity graph(5);
+  graph.AddEdge({0, 1});
+  graph.AddEdge({1, 2});
+  graph.AddEdge({2, 0});
+  graph.AddEdge({3, 4});
+
+  DynamicConnectivity copy{graph};
+  EXPECT_TRUE(copy.HasEdge({2, 0}));
+  EXPECT_EQ(copy.GetNumberOfConnectedComponents(), 2);
+
+  copy.DeleteEdge({0, 1});
+  copy.DeleteEdge({1, 2});
+  EXPECT_FALSE(copy.IsConnected(0, 1));
+  copy.AddEdge({2, 3});
+  EXPECT_TRUE(copy.IsConnected(0, 4));
+
+  EXPECT_TRUE(graph.IsConnected(0, 1));
+  EXPECT_FALSE(graph.IsConnected(0, 4));
+  EXPECT_FALSE(graph.HasEdge({2, 3}));
+  graph.DeleteEdge({0, 1});
+  EXPECT_TRUE(graph.IsConnected(0, 1));
+}
+
+TEST(DynamicConnectivity, RestoreEdge) {
+  // A cycle with chords. Deleting some of its edges promotes others.
+  constexpr int64_t kNumVertices{16};
+  DynamicConnectivity graph(kNumVertices);
+  for (Vertex v = 0; v < kNumVertices; v++) {
+    graph.AddEdge({v, (v + 1) % kNumVertices});
+    graph.AddEdge({v, (v + 5) % kNumVertices});
+  }
+  for (Vertex v = 0; v < kNumVertices; v += 3) {
+    graph.DeleteEdge({v, (v + 1) % kNumVertices});
+  }
+
+  typedef std::tuple<Vertex, Vertex, int8_t, bool> EdgeWithLevel;
+  const auto get_edges{[](const DynamicConnectivity& g) {
+    std::vector<EdgeWithLevel> edges;
+    g.ForEachEdgeWithLevel(
+        [&](const UndirectedEdge& edge, int8_t level, bool is_tree_edge) {
+          edges.emplace_back(edge.first, edge.second, level, is_tree_edge);
+        });
+    std::sort(edges.begin(), edges.end());
+    return edges;
+  }};
+  const std::vector<EdgeWithLevel> edges{get_edges(graph)};
+  EXPECT_TRUE(std::any_of(edges.begin(), edges.end(), [](const auto& edge) {
+    return std::get<2>(edge) > 0;
+  }));
+
+  DynamicConnectivity restored_graph(kNumVertices);
+  for (auto it = edges.rbegin(); it != edges.rend(); ++it) {
+    const auto& [u, v, level, is_tree_edge] = *it;
+    restored_graph.RestoreEdge({u, v}, level, is_tree_edge);
+  }
+  EXPECT_EQ(get_edges(restored_graph), edges);
+
+  for (Vertex v = 1; v < kNumVertices; v += 3) {
+    graph.DeleteEdge({v, (v + 5) % kNumVertices});
+    restored_graph.DeleteEdge({v, (v + 5) % kNumVertices});
+    // The graphs may pick different replacement edges, so only compare what
+    // they report about connectivity.
+    for (Vertex u = 0; u < kNumVertices; u++) {
+      EXPECT_EQ(restored_graph.IsConnected(0, u), graph.IsConnected(0, u));
+    }
+    EXPECT_EQ(
+        restored_graph.GetNumberOfConnectedComponents(),
+        graph.GetNumberOfConnectedComponents());
+  }
+}
+
+TEST(DynamicConnectivity, ComponentAggregate) {
+  BasicDynamicConnectivity<SumAggregate<int64_t>> graph(5);
+  for (Vertex v = 0; v < 5; v++) {
+    graph.SetVertexValue(v, 1 << v);
+  }
+  graph.AddEdge({0, 1});
+  graph.AddEdge({1, 2});
+  graph.AddEdge({2, 0});
+  graph.AddEdge({3, 4});
+  EXPECT_EQ(graph.GetComponentAggregate(0), 0b00111);
+  EXPECT_EQ(graph.GetComponentAggregate(4), 0b11000);
+
+  // Deleting a tree edge that has a replacement keeps the aggregate intact.
+  graph.DeleteEdge({0, 1});
+  EXPECT_EQ(graph.GetComponentAggregate(1), 0b00111);
+  graph.DeleteEdge({1, 2});
+  EXPECT_EQ(graph.GetComponentAggregate(1), 0b00010);
+  EXPECT_EQ(graph.GetComponentAggregate(2), 0b00101);
+
+  graph.Checkpoint();
+  graph.SetVertexValue(1, 100);
+  graph.AddEdge({1, 3});
+  EXPECT_EQ(graph.GetComponentAggregate(4), 100 + 0b11000);
+  graph.Rollback();
+  EXPECT_EQ(graph.GetVertexValue(1), 0b00010);
+  EXPECT_EQ(graph.GetComponentAggregate(1), 0b00010);
+  EXPECT_EQ(graph.GetComponentAggregate(4), 0b11000);
+}
+
+TEST(DynamicConnectivity, GetMemoryUsage) {
+  constexpr int64_t kNumVertices{200};
+  DynamicConnectivity graph(kNumVertices);
+  const GraphMemoryUsage empty_usage{graph.GetMemoryUsage()};
+  ASSERT_EQ(empty_usage.levels.size(), 1);
+  EXPECT_EQ(empty_usage.levels[0].sequence_nodes, 0);
+  EXPECT_GT(empty_usage.levels[0].vertex_elements, 0);
+  EXPECT_EQ(empty_usage.two_edge_connectivity, 0);
+
+  // A dense graph whose deletions push edges up several levels.
+  std::mt19937 random_generator{0};
+  std::vector<std::pair<Vertex, Vertex>> edges;
+  for (Vertex u = 0; u < kNumVertices; u++) {
+    for (Vertex v = u + 1; v < kNumVertices; v += 1 + u % 7) {
+      graph.AddEdge({u, v});
+      edges.emplace_back(u, v);
+    }
+  }
+  std::shuffle(edges.begin(), edges.end(), random_generator);
+  for (std::size_t i = 0; i < edges.size() / 2; i++) {
+    graph.DeleteEdge({edges[i].first, edges[i].second});
+  }
+  const GraphMemoryUsage usage{graph.GetMemoryUsage()};
+  EXPECT_GT(usage.levels.size(), 1);
+  EXPECT_GT(
+      usage.levels[0].forest_edges, empty_usage.levels[0].forest_edges);
+  EXPECT_GT(usage.levels[0].sequence_nodes, 0);
+  EXPECT_GT(usage.levels[0].non_tree_adjacency_lists, 0);
+  EXPECT_EQ(usage.levels[1].sequence_nodes, 0);
+  EXPECT_GT(usage.levels[1].vertex_elements, 0);
+  EXPECT_GT(usage.edges, empty_usage.edges);
+  EXPECT_GT(usage.GetTotal(), empty_usage.GetTotal());
+
+  graph.SetTwoEdgeConnectivityTracking(true);
+  EXPECT_GT(graph.GetMemoryUsage().two_edge_connectivity, 0);
+}
+
+namespace {
+
+// Expects `graph` and `expected_graph` to have the same edges and connected
+// components.
+void ExpectSameGraph(
+    const DynamicConnectivity& graph,
+    const DynamicConnectivity& expected_graph) {
+  const int64_t num_vertices{expected_graph.GetNumberOfVertices()};
+  EXPECT_EQ(
+      graph.GetNumberOfConnectedComponents(),
+      expected_graph.GetNumberOfConnectedComponents());
+  for (Vertex u = 0; u < num_vertices; u++) {
+    for (Vertex v = u + 1; v < num_vertices; v++) {
+      EXPECT_EQ(graph.HasEdge({u, v}), expected_graph.HasEdge({u, v}));
+      EXPECT_EQ(graph.IsConnected(u, v), expected_graph.IsConnected(u, v));
+    }
+  }
+}
+
+}  // namespace
+
+TEST(DynamicConnectivity, Compact) {
+  constexpr int64_t kNumVertices{120};
+  std::mt19937 random_generator{0};
+  DynamicConnectivity graph(kNumVertices);
+  std::vector<std::pair<Vertex, Vertex>> edges;
+  for (Vertex u = 0; u < kNumVertices; u++) {
+    for (Vertex v = u + 1; v < kNumVertices; v += 1 + u % 5) {
+      graph.AddEdge({u, v});
+      edges.emplace_back(u, v);
+    }
+  }
+  // Tear down most of the graph.
+  std::shuffle(edges.begin(), edges.end(), random_generator);
+  while (edges.size() > kNumVertices / 2) {
+    graph.DeleteEdge({edges.back().first, edges.back().second});
+    edges.pop_back();
+  }
+  const DynamicConnectivity expected_graph{graph};
+  const GraphMemoryUsage usage{graph.GetMemoryUsage()};
+
+  graph.Compact();
+  const GraphMemoryUsage compacted_usage{graph.GetMemoryUsage()};
+  EXPECT_LT(compacted_usage.GetTotal(), usage.GetTotal() / 2);
+  EXPECT_LT(compacted_usage.edges, usage.edges);
+  EXPECT_LE(compacted_usage.levels.size(), usage.levels.size());
+  ExpectSameGraph(graph, expected_graph);
+
+  // The compacted graph should still handle updates correctly.
+  DynamicConnectivity uncompacted_graph{expected_graph};
+  std::uniform_int_distribution<Vertex> vertex_distribution{
+    0, kNumVertices - 1};
+  for (int32_t i = 0; i < 2000; i++) {
+    const UndirectedEdge edge{
+      vertex_distribution(random_generator),
+      vertex_distribution(random_generator)};
+    if (edge.first == edge.second) {
+      continue;
+    }
+    for (DynamicConnectivity* g : {&graph, &uncompacted_graph}) {
+      if (g->HasEdge(edge)) {
+        g->DeleteEdge(edge);
+      } else {
+        g->AddEdge(edge);
+      }
+    }
+    if (i % 500 == 0) {
+      graph.Compact();
+    }
+  }
+  ExpectSameGraph(graph, uncompacted_graph);
+}
+
+TEST(DynamicConnectivity, CompactWithCheckpoint) {
+  constexpr int64_t kNumVertices{64};
+  DynamicConnectivity graph(kNumVertices);
+  for (Vertex v = 0; v < kNumVertices; v++) {
+    graph.AddEdge({v, (v + 1) % kNumVertices});
+    graph.AddEdge({v, (v + 2) % kNumVertices});
+  }
+  const DynamicConnectivity expected_graph{graph};
+
+  graph.Checkpoint();
+  for (Vertex v = 0; v < kNumVertices; v++) {
+    graph.DeleteEdge({v, (v + 1) % kNumVertices});
+    graph.DeleteEdge({v, (v + 2) % kNumVertices});
+  }
+  graph.Compact();
+  EXPECT_EQ(graph.GetMemoryUsage().levels.size(), 1);
+  graph.Rollback();
+  ExpectSameGraph(graph, expected_graph);
+}
+
+TEST(DynamicConnectivity, CompactionThreshold) {
+  constexpr int64_t kNumVertices{100};
+  DynamicConnectivity graph(kNumVertices);
+  graph.SetCompactionThreshold(0.25);
+  for (Vertex u = 0; u < kNumVertices; u++) {
+    for (Vertex v = u + 1; v < kNumVertices; v++) {
+      graph.AddEdge({u, v});
+    }
+  }
+  DynamicConnectivity uncompacted_graph{graph};
+  uncompacted_graph.SetCompactionThreshold(std::nullopt);
+  for (Vertex u = 1; u < kNumVertices; u++) {
+    for (Vertex v = u + 1; v < kNumVertices; v++) {
+      graph.DeleteEdge({u, v});
+      uncompacted_graph.DeleteEdge({u, v});
+    }
+  }
+  EXPECT_LT(
+      graph.GetMemoryUsage().edges,
+      uncompacted_graph.GetMemoryUsage().edges / 4);
+  ExpectSameGraph(graph, uncompacted_graph);
+}
+
+TEST(DynamicConnectivity, IsTreeEdge) {
+  DynamicConnectivity graph(3);
+  graph.AddEdge({0, 1});
+  graph.AddEdge({1, 2});
+  graph.AddEdge({2, 0});
+  EXPECT_TRUE(graph.IsTreeEdge({0, 1}));
+  EXPECT_TRUE(graph.IsTreeEdge({1, 2}));
+  EXPECT_FALSE(graph.IsTreeEdge({2, 0}));
+  // The non-tree edge replaces the deleted tree edge.
+  graph.DeleteEdge({0, 1});
+  EXPECT_TRUE(graph.IsTreeEdge({2, 0}));
+}
+
+namespace {
+
+// Returns the edges of `edges`, a graph on `num_vertices` vertices, that are
+// bridges, found by deleting each edge in turn and checking whether its
+// endpoints are still connected.
+std::set<std::pair<Vertex, Vertex>> FindBridges(
+    int64_t num_vertices, const std::set<std::pair<Vertex, Vertex>>& edges) {
+  std::set<std::pair<Vertex, Vertex>> bridges;
+  for (const auto& deleted_edge : edges) {
+    std::vector<std::vector<Vertex>> adjacency_lists(num_vertices);
+    for (const auto& [u, v] : edges) {
+      if (std::make_pair(u, v) != deleted_edge) {
+        adjacency_lists[u].push_back(v);
+        adjacency_lists[v].push_back(u);
+      }
+    }
+    std::vector<bool> is_visited(num_vertices, false);
+    std::vector<Vertex> stack{deleted_edge.first};
+    is_visited[deleted_edge.first] = true;
+    while (!stack.empty()) {
+      const Vertex u{stack.back()};
+      stack.pop_back();
+      for (const Vertex v : adjacency_lists[u]) {
+        if (!is_visited[v]) {
+          is_visited[v] = true;
+          stack.push_back(v);
+        }
+      }
+    }
+    if (!is_visited[deleted_edge.second]) {
+      bridges.insert(deleted_edge);
+    }
+  }
+  return bridges;
+}
+
+// Expects `graph`'s bridges and, if `graph` tracks 2-edge connectivity, its
+// 2-edge-connected pairs of vertices to match those of `edges`. Two vertices
+// are 2-edge-connected exactly when they are connected after deleting all
+// bridges.
+void ExpectSameBridges(
+    const DynamicConnectivity& graph,
+    const std::set<std::pair<Vertex, Vertex>>& edges,
+    bool is_tracked) {
+  const int64_t num_vertices{graph.GetNumberOfVertices()};
+  const std::set<std::pair<Vertex, Vertex>> bridges{
+    FindBridges(num_vertices, edges)};
+  DynamicConnectivity bridgeless_graph(num_vertices);
+  for (const auto& [u, v] : edges) {
+    EXPECT_EQ(graph.IsBridge({u, v}), bridges.count({u, v}) > 0)
+      << "Edge " << u << " - " << v;
+    if (bridges.count({u, v}) == 0) {
+      bridgeless_graph.AddEdge({u, v});
+    }
+  }
+  if (!is_tracked) {
+    return;
+  }
+  for (Vertex u = 0; u < num_vertices; u++) {
+    for (Vertex v = u; v < num_vertices; v++) {
+      EXPECT_EQ(
+          graph.Is2EdgeConnected(u, v), bridgeless_graph.IsConnected(u, v))
+        << "Vertices " << u << " and " << v;
+    }
+  }
+}
+
+// Checks bridges and, if `is_tracked`, 2-edge connectivity against brute force
+// over random updates, rollbacks, and copies.
+void CheckBridgesOverRandomUpdates(bool is_tracked) {
+  constexpr int64_t kNumVertices{24};
+  constexpr int32_t kNumRounds{60};
+  constexpr int32_t kUpdatesPerRound{8};
+  std::mt19937 random_generator{0};
+  std::uniform_int_distribution<Vertex> vertex_distribution{
+    0, kNumVertices - 1};
+
+  DynamicConnectivity graph(kNumVertices);
+  graph.SetTwoEdgeConnectivityTracking(is_tracked);
+  std::set<std::pair<Vertex, Vertex>> edges;
+  for (int32_t round = 0; round < kNumRounds; round++) {
+    const bool is_rolled_back{round % 5 == 4};
+    const std::set<std::pair<Vertex, Vertex>> checkpoint_edges{edges};
+    if (is_rolled_back) {
+      graph.Checkpoint();
+    }
+    for (int32_t i = 0; i < kUpdatesPerRound; i++) {
+      const Vertex u{vertex_distribution(random_generator)};
+      const Vertex v{vertex_distribution(random_generator)};
+      if (u == v) {
+        continue;
+      }
+      const std::pair<Vertex, Vertex> edge{std::minmax(u, v)};
+      // Keep the graph fairly sparse so that it has bridges.
+      if (edges.count(edge) > 0) {
+        graph.DeleteEdge({u, v});
+        edges.erase(edge);
+      } else if (edges.size() < 2 * kNumVertices) {
+        graph.AddEdge({u, v});
+        edges.insert(edge);
+      }
+    }
+    ExpectSameBridges(graph, edges, is_tracked);
+    if (is_rolled_back) {
+      const DynamicConnectivity copy{graph};
+      graph.Rollback();
+      ExpectSameBridges(copy, edges, is_tracked);
+      edges = checkpoint_edges;
+      ExpectSameBridges(graph, edges, is_tracked);
+    }
+  }
+
+  graph.SetTwoEdgeConnectivityTracking(!is_tracked);
+  ExpectSameBridges(graph, edges, !is_tracked);
+  graph.SetTwoEdgeConnectivityTracking(is_tracked);
+  ExpectSameBridges(graph, edges, is_tracked);
+}
+
+}  // namespace
+
+TEST(DynamicConnectivity, IsBridge) {
+  CheckBridgesOverRandomUpdates(false);
+}
+
+TEST(DynamicConnectivity, IsBridgeWithTracking) {
+  CheckBridgesOverRandomUpdates(true);
+}
+
+// Once tracking is on, `IsBridge()` should not report any non-bridge, even on
+// a graph where many non-tree edges cross each tree edge's cut.
+TEST(DynamicConnectivity, IsBridgeHasNoFalsePositivesWithTracking) {
+  constexpr int64_t kNumVertices{40};
+  DynamicConnectivity graph(kNumVertices);
+  graph.SetTwoEdgeConnectivityTracking(true);
+  std::set<std::pair<Vertex, Vertex>> edges;
+  // Two complete graphs joined by a bridge {0, kNumVertices / 2}.
+  for (Vertex offset : {Vertex{0}, kNumVertices / 2}) {
+    for (Vertex u = offset; u < offset + kNumVertices / 2; u++) {
+      for (Vertex v = u + 1; v < offset + kNumVertices / 2; v++) {
+        graph.AddEdge({u, v});
+        edges.emplace(u, v);
+      }
+    }
+  }
+  graph.AddEdge({0, kNumVertices / 2});
+  edges.emplace(0, kNumVertices / 2);
+
+  int64_t num_bridges{0};
+  for (const auto& [u, v] : edges) {
+    num_bridges += graph.IsBridge({u, v});
+  }
+  EXPECT_EQ(num_bridges, 1);
+  EXPECT_TRUE(graph.IsBridge({0, kNumVertices / 2}));
+  ExpectSameBridges(graph, edges, true);
+}
+
+TEST(DynamicConnectivity, MaxPromotionsPerUpdate) {
+  constexpr int64_t kNumVertices{64};
+  DynamicConnectivity graph(kNumVertices);
+  graph.SetMaxPromotionsPerUpdate(1);
+  // Graph is a cycle plus chords {v, v + 2}.
+  for (Vertex v = 0; v < kNumVertices; v++) {
+    graph.AddEdge({v, (v + 1) % kNumVertices});
+    graph.AddEdge({v, (v + 2) % kNumVertices});
+  }
+
+  // Deleting the cycle edges leaves the chords, which form two cycles, one
+  // through the even vertices and one through the odd vertices.
+  for (Vertex v = 0; v < kNumVertices; v++) {
+    graph.DeleteEdge({v, (v + 1) % kNumVertices});
+    EXPECT_TRUE(graph.IsConnected(0, 2));
+    EXPECT_EQ(
+        graph.IsConnected(0, 1),
+        v < kNumVertices - 1);
+  }
+  EXPECT_EQ(graph.GetNumberOfConnectedComponents(), 2);
+  while (graph.RunDeferredWork(4)) {}
+  EXPECT_FALSE(graph.RunDeferredWork(0));
+
+  // The graph should still handle updates correctly after deferring work.
+  graph.SetMaxPromotionsPerUpdate(std::nullopt);
+  for (Vertex v = 0; v < kNumVertices; v += 2) {
+    graph.DeleteEdge({v, (v + 2) % kNumVertices});
+  }
+  EXPECT_TRUE(graph.IsConnected(1, 3));
+  EXPECT_FALSE(graph.IsConnected(0, 2));
+  EXPECT_EQ(graph.GetNumberOfConnectedComponents(), kNumVertices / 2 + 1);
+}
+
+TEST(DynamicConnectivity, MaxPromotionsPerUpdateWithRollback) {
+  constexpr int64_t kNumVertices{64};
+  DynamicConnectivity graph(kNumVertices);
+  graph.SetMaxPromotionsPerUpdate(1);
+  // Graph is a cycle plus chords {v, v + 2}.
+  for (Vertex v = 0; v < kNumVertices; v++) {
+    graph.AddEdge({v, (v + 1) % kNumVertices});
+    graph.AddEdge({v, (v + 2) % kNumVertices});
+  }
+
+  // Rolling back should drop the promotions deferred since the checkpoint.
+  graph.Checkpoint();
+  graph.DeleteEdge({0, 1});
+  EXPECT_TRUE(graph.RunDeferredWork(0));
+  graph.Rollback();
+  EXPECT_FALSE(graph.RunDeferredWork(0));
+  EXPECT_TRUE(graph.IsConnected(0, 1));
+
+  // Rolling back should restore the promotions run since the checkpoint.
+  graph.DeleteEdge({0, 1});
+  EXPECT_TRUE(graph.RunDeferredWork(0));
+  graph.Checkpoint();
+  while (graph.RunDeferredWork(4)) {}
+  graph.Rollback();
+  EXPECT_TRUE(graph.RunDeferredWork(0));
+
+  for (Vertex v = 1; v < kNumVertices; v++) {
+    graph.DeleteEdge({v, (v + 1) % kNumVertices});
+    EXPECT_TRUE(graph.IsConnected(0, 2));
+    EXPECT_EQ(graph.IsConnected(0, 1), v < kNumVertices - 1);
+  }
+  while (graph.RunDeferredWork(4)) {}
+  graph.SetMaxPromotionsPerUpdate(std::nullopt);
+  for (Vertex v = 0; v < kNumVertices; v += 2) {
+    graph.DeleteEdge({v, (v + 2) % kNumVertices});
+  }
+  EXPECT_TRUE(graph.IsConnected(1, 3));
+  EXPECT_FALSE(graph.IsConnected(0, 2));
+  EXPECT_EQ(graph.GetNumberOfConnectedComponents(), kNumVertices / 2 + 1);
+}
+
+TEST(DynamicConnectivity, DroppedDeferredPromotions) {
+  constexpr int64_t kNumVertices{16};
+  DynamicConnectivity graph(kNumVertices);
+  graph.SetMaxPromotionsPerUpdate(1);
+  // Graph is a path 0 - ... - 15 closed into a cycle by non-tree edge {15, 0}.
+  for (Vertex v = 1; v < kNumVertices; v++) {
+    graph.AddEdge({v - 1, v});
+  }
+  graph.AddEdge({kNumVertices - 1, 0});
+
+  // Deleting {7, 8} cuts the path into two halves, each small enough to move
+  // up a level, but promotes only one of a half's seven tree edges. Replacement
+  // edge {15, 0} then joins the halves again, so the deferred promotion is
+  // dropped without spending any of the budget.
+  graph.DeleteEdge({kNumVertices / 2 - 1, kNumVertices / 2});
+  EXPECT_TRUE(graph.RunDeferredWork(0));
+  EXPECT_FALSE(graph.RunDeferredWork(1));
+  EXPECT_TRUE(graph.IsConnected(0, kNumVertices - 1));
+
+  // Queries should stay correct as promotions keep being deferred and dropped.
+  DynamicConnectivity reference_graph(kNumVertices);
+  for (Vertex v = 1; v < kNumVertices; v++) {
+    if (v != kNumVertices / 2) {
+      reference_graph.AddEdge({v - 1, v});
+    }
+  }
+  reference_graph.AddEdge({kNumVertices - 1, 0});
+  std::mt19937 random_generator{0};
+  std::uniform_int_distribution<Vertex> vertex_distribution{
+    0, kNumVertices - 1};
+  for (int32_t i = 0; i < 2000; i++) {
+    const UndirectedEdge edge{
+      vertex_distribution(random_generator),
+      vertex_distribution(random_generator)};
+    if (edge.first == edge.second) {
+      continue;
+    }
+    if (graph.HasEdge(edge)) {
+      graph.DeleteEdge(edge);
+      reference_graph.DeleteEdge(edge);
+    } else {
+      graph.AddEdge(edge);
+      reference_graph.AddEdge(edge);
+    }
+    if (i % 7 == 0) {
+      graph.RunDeferredWork(1);
+    }
+    for (Vertex u = 0; u < kNumVertices; u++) {
+      for (Vertex v = u + 1; v < kNumVertices; v++) {
+        ASSERT_EQ(graph.IsConnected(u, v), reference_graph.IsConnected(u, v))
+          << "Vertices " << u << " and " << v << " after update " << i;
+      }
+    }
+    ASSERT_EQ(
+        graph.GetNumberOfConnectedComponents(),
+        reference_graph.GetNumberOfConnectedComponents());
+  }
+}
+
+TEST(DynamicConnectivity, ParallelSearch) {
+  // Two paths 0 - ... - 69 and 70 - ... - 139 joined by edge {69, 70}, with
+  // every other edge among the first path's vertices and one more edge
+  // {0, 139} joining the paths. Deleting {69, 70} makes the search for a
+  // replacement edge look at thousands of non-tree edges.
+  constexpr int64_t kHalfSize{70};
+  DynamicConnectivity graph(2 * kHalfSize);
+  for (Vertex v = 1; v < 2 * kHalfSize; v++) {
+    graph.AddEdge({v - 1, v});
+  }
+  for (Vertex v = 0; v < kHalfSize; v++) {
+    for (Vertex w = v + 2; w < kHalfSize; w++) {
+      graph.AddEdge({v, w});
+    }
+  }
+  graph.AddEdge({0, 2 * kHalfSize - 1});
+  DynamicConnectivity sequential_graph{graph};
+  graph.SetNumberOfSearchThreads(4);
+  // The copy starts its own worker threads.
+  DynamicConnectivity parallel_copy{graph};
+
+  for (DynamicConnectivity* g : {&graph, &parallel_copy, &sequential_graph}) {
+    g->DeleteEdge({kHalfSize - 1, kHalfSize});
+    EXPECT_TRUE(g->IsConnected(0, 2 * kHalfSize - 1));
+    g->DeleteEdge({0, 2 * kHalfSize - 1});
+    EXPECT_FALSE(g->IsConnected(0, 2 * kHalfSize - 1));
+    for (Vertex v = 1; v < kHalfSize; v++) {
+      g->DeleteEdge({v - 1, v});
+    }
+    EXPECT_EQ(g->GetNumberOfConnectedComponents(), 2);
+  }
+}
@@ -4,6 +4,7 @@
 #include <gtest/gtest.h>
 
 using ::testing::Optional;
+using ::testing::UnorderedElementsAre;
 
 TEST(DynamicForest, AddEdgeAndDeleteEdgePathGraph) {
   constexpr int64_t kNumVertices = 10;
@@ -105,3 +106,118 @@ TEST(DynamicForest, Mark) {
   dynamic_forest.MarkEdge({6, 7}, false);
   EXPECT_FALSE(dynamic_forest.GetMarkedEdgeInTree(0).has_value());
 }
+
+TEST(DynamicForest, TakeMarkedEdgesAndGetMarkedVertices) {
+  DynamicForest dynamic_forest(10);
+  for (int32_t i = 1; i < 10; i++) {
+    dynamic_forest.AddEdge({i - 1, i});
+  }
+  dynamic_forest.MarkEdge({1, 2}, true);
+  dynamic_forest.MarkEdge({4, 5}, true);
+  dynamic_forest.MarkEdge({8, 9}, true);
+  dynamic_forest.MarkVertex(0, true);
+  dynamic_forest.MarkVertex(6, true);
+  EXPECT_THAT(
+      dynamic_forest.GetMarkedVerticesInTree(3),
+      UnorderedElementsAre(0, 6));
+
+  std::vector<UndirectedEdge> edges{dynamic_forest.TakeMarkedEdgesInTree(0, 2)};
+  EXPECT_EQ(edges.size(), 2u);
+  for (const UndirectedEdge& edge :
+       dynamic_forest.TakeMarkedEdgesInTree(0, 10)) {
+    edges.push_back(edge);
+  }
+  EXPECT_THAT(
+      edges,
+      UnorderedElementsAre(
+        UndirectedEdge{1, 2}, UndirectedEdge{4, 5}, UndirectedEdge{8, 9}));
+  EXPECT_FALSE(dynamic_forest.GetMarkedEdgeInTree(0).has_value());
+  EXPECT_THAT(dynamic_forest.GetMarkedVertexInTree(9), Optional(0));
+}
+
+TEST(DynamicForest, CopyConstructor) {
+  DynamicForest dynamic_forest(6);
+  dynamic_forest.AddEdge({0, 1});
+  dynamic_forest.AddEdge({1, 2});
+  dynamic_forest.AddEdge({3, 4});
+  dynamic_forest.MarkEdge({1, 2}, true);
+  dynamic_forest.MarkVertex(4, true);
+
+  DynamicForest copy{dynamic_forest};
+  EXPECT_TRUE(copy.IsConnected(0, 2));
+  EXPECT_FALSE(copy.IsConnected(0, 3));
+  EXPECT_EQ(copy.GetSizeOfTree(0), 3);
+  EXPECT_EQ(copy.GetNumberOfTrees(), 3);
+  EXPECT_THAT(copy.GetMarkedEdgeInTree(0), Optional(UndirectedEdge(1, 2)));
+  EXPECT_THAT(copy.GetMarkedVertexInTree(3), Optional(4));
+
+  // Updating the copy leaves the original untouched and vice versa.
+  copy.DeleteEdge({0, 1});
+  copy.AddEdge({2, 3});
+  dynamic_forest.AddEdge({4, 5});
+  EXPECT_FALSE(copy.IsConnected(0, 1));
+  EXPECT_TRUE(copy.IsConnected(1, 4));
+  EXPECT_FALSE(copy.IsConnected(4, 5));
+  EXPECT_TRUE(dynamic_forest.IsConnected(0, 1));
+  EXPECT_FALSE(dynamic_forest.IsConnected(1, 4));
+  EXPECT_TRUE(dynamic_forest.IsConnected(3, 5));
+}
+
+TEST(DynamicForest, Compact) {
+  constexpr int64_t kNumVertices{100};
+  DynamicForest dynamic_forest(kNumVertices);
+  for (Vertex v = 1; v < kNumVertices; v++) {
+    dynamic_forest.AddEdge({v - 1, v});
+  }
+  for (Vertex v = 10; v < kNumVertices; v++) {
+    dynamic_forest.DeleteEdge({v - 1, v});
+  }
+  dynamic_forest.MarkEdge({3, 4}, true);
+  dynamic_forest.MarkVertex(7, true);
+  const std::size_t pool_bytes{
+    dynamic_forest.GetMemoryUsage().edge_element_pool};
+
+  dynamic_forest.Compact();
+  EXPECT_LT(dynamic_forest.GetMemoryUsage().edge_element_pool, pool_bytes);
+  EXPECT_TRUE(dynamic_forest.IsConnected(0, 9));
+  EXPECT_FALSE(dynamic_forest.IsConnected(9, 10));
+  EXPECT_EQ(dynamic_forest.GetSizeOfTree(5), 10);
+  EXPECT_EQ(dynamic_forest.GetNumberOfTrees(), kNumVertices - 9);
+  EXPECT_THAT(
+      dynamic_forest.GetMarkedEdgeInTree(0), Optional(UndirectedEdge(3, 4)));
+  EXPECT_THAT(dynamic_forest.GetMarkedVertexInTree(0), Optional(7));
+
+  // The pool of edge elements grows back as edges are added.
+  for (Vertex v = 10; v < kNumVertices; v++) {
+    dynamic_forest.AddEdge({0, v});
+  }
+  EXPECT_EQ(dynamic_forest.GetNumberOfTrees(), 1);
+  EXPECT_EQ(dynamic_forest.GetSizeOfTree(kNumVertices - 1), kNumVertices);
+  dynamic_forest.DeleteEdge({4, 5});
+  EXPECT_FALSE(dynamic_forest.IsConnected(4, 5));
+  EXPECT_TRUE(dynamic_forest.IsConnected(4, kNumVertices - 1));
+  EXPECT_EQ(dynamic_forest.GetSizeOfTree(5), 5);
+}
+
+TEST(DynamicForest, TreeAggregate) {
+  BasicDynamicForest<sequence::AugmentedElement<MaxAggregate<int32_t>>>
+    dynamic_forest(5);
+  for (Vertex v = 0; v < 5; v++) {
+    dynamic_forest.SetVertexValue(v, static_cast<int32_t>(v));
+  }
+  dynamic_forest.AddEdge({0, 4});
+  dynamic_forest.AddEdge({1, 2});
+  EXPECT_EQ(dynamic_forest.GetTreeAggregate(0), 4);
+  EXPECT_EQ(dynamic_forest.GetTreeAggregate(2), 2);
+  EXPECT_EQ(dynamic_forest.GetTreeAggregate(3), 3);
+
+  dynamic_forest.AddEdge({2, 4});
+  EXPECT_EQ(dynamic_forest.GetTreeAggregate(1), 4);
+  dynamic_forest.SetVertexValue(4, -1);
+  EXPECT_EQ(dynamic_forest.GetVertexValue(4), -1);
+  EXPECT_EQ(dynamic_forest.GetTreeAggregate(1), 2);
+
+  dynamic_forest.DeleteEdge({0, 4});
+  EXPECT_EQ(dynamic_forest.GetTreeAggregate(0), 0);
+  EXPECT_EQ(dynamic_forest.GetTreeAggregate(4), 2);
+}
@@ -0,0 +1,180 @@
+#include <dynamic_graph/dynamic_minimum_spanning_forest.hpp>
+
+#include <algorithm>
+#include <memory>
+#include <numeric>
+#include <random>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include <dynamic_graph/memory_arena.hpp>
+#include <gtest/gtest.h>
+
+namespace {
+
+typedef DynamicMinimumSpanningForest::Weight Weight;
+
+// Returns the weight of the minimum spanning forest of the graph with
+// `num_vertices` vertices and edges `edges` using Kruskal's algorithm.
+Weight KruskalWeight(
+    int64_t num_vertices,
+    std::vector<std::tuple<Weight, Vertex, Vertex>> edges) {
+  std::vector<Vertex> parents(num_vertices);
+  std::iota(parents.begin(), parents.end(), 0);
+  const auto find_root{[&](Vertex v) {
+    while (parents[v] != v) {
+      v = parents[v] = parents[parents[v]];
+    }
+    return v;
+  }};
+  std::sort(edges.begin(), edges.end());
+  Weight weight{0};
+  for (const auto& [edge_weight, u, v] : edges) {
+    const Vertex u_root{find_root(u)};
+    const Vertex v_root{find_root(v)};
+    if (u_root != v_root) {
+      parents[u_root] = v_root;
+      weight += edge_weight;
+    }
+  }
+  return weight;
+}
+
+}  // namespace
+
+TEST(DynamicMinimumSpanningForest, AddAndDeleteEdge) {
+  DynamicMinimumSpanningForest graph(4);
+  graph.AddEdge({0, 1}, 4);
+  graph.AddEdge({1, 2}, 3);
+  graph.AddEdge({2, 3}, 5);
+  EXPECT_EQ(graph.GetForestWeight(), 12);
+
+  // Closes cycle 0 - 1 - 2 - 0 but is heavier than the rest of it.
+  graph.AddEdge({0, 2}, 6);
+  EXPECT_FALSE(graph.IsInForest({0, 2}));
+  EXPECT_EQ(graph.GetForestWeight(), 12);
+
+  // Replaces {2, 3} on cycle 0 - 1 - 2 - 3 - 0.
+  graph.AddEdge({0, 3}, 1);
+  EXPECT_TRUE(graph.IsInForest({0, 3}));
+  EXPECT_FALSE(graph.IsInForest({2, 3}));
+  EXPECT_EQ(graph.GetForestWeight(), 8);
+
+  // The lightest replacement for {0, 1} is {2, 3}, not {0, 2}.
+  graph.DeleteEdge({0, 1});
+  EXPECT_TRUE(graph.IsInForest({2, 3}));
+  EXPECT_FALSE(graph.IsInForest({0, 2}));
+  EXPECT_EQ(graph.GetForestWeight(), 9);
+
+  graph.DeleteEdge({2, 3});
+  EXPECT_TRUE(graph.IsInForest({0, 2}));
+  EXPECT_EQ(graph.GetForestWeight(), 10);
+  graph.DeleteEdge({0, 2});
+  EXPECT_FALSE(graph.IsConnected(1, 3));
+  EXPECT_EQ(graph.GetNumberOfConnectedComponents(), 2);
+  EXPECT_EQ(graph.GetForestWeight(), 4);
+}
+
+TEST(DynamicMinimumSpanningForest, ForEachForestEdge) {
+  DynamicMinimumSpanningForest graph(3);
+  graph.AddEdge({0, 1}, 2);
+  graph.AddEdge({1, 2}, 2);
+  graph.AddEdge({0, 2}, 2);
+  // Ties are broken by endpoints, so {1, 2} is left out.
+  std::vector<std::pair<Vertex, Vertex>> forest_edges;
+  graph.ForEachForestEdge([&](const UndirectedEdge& edge, Weight weight) {
+    EXPECT_EQ(weight, 2);
+    forest_edges.emplace_back(edge.first, edge.second);
+  });
+  std::sort(forest_edges.begin(), forest_edges.end());
+  EXPECT_EQ(
+      forest_edges,
+      (std::vector<std::pair<Vertex, Vertex>>{{0, 1}, {0, 2}}));
+}
+
+TEST(DynamicMinimumSpanningForest, RandomUpdates) {
+  constexpr int64_t kNumVertices{40};
+  std::mt19937 random_generator{0};
+  std::uniform_int_distribution<Vertex> vertex_distribution{
+    0, kNumVertices - 1};
+  std::uniform_int_distribution<Weight> weight_distribution{0, 20};
+
+  DynamicMinimumSpanningForest graph(kNumVertices);
+  std::vector<std::tuple<Weight, Vertex, Vertex>> edges;
+  for (int32_t i = 0; i < 3000; i++) {
+    const bool should_add{edges.size() < 60 || random_generator() % 2 == 0};
+    if (should_add) {
+      const UndirectedEdge edge{
+        vertex_distribution(random_generator),
+        vertex_distribution(random_generator)};
+      if (edge.first == edge.second || graph.HasEdge(edge)) {
+        continue;
+      }
+      const Weight weight{weight_distribution(random_generator)};
+      graph.AddEdge(edge, weight);
+      edges.emplace_back(weight, edge.first, edge.second);
+    } else {
+      const std::size_t index{random_generator() % edges.size()};
+      std::swap(edges[index], edges.back());
+      const auto [weight, u, v]{edges.back()};
+      graph.DeleteEdge({u, v});
+      edges.pop_back();
+    }
+    ASSERT_EQ(graph.GetForestWeight(), KruskalWeight(kNumVertices, edges));
+  }
+}
+
+// With few distinct weights, deletions often find replacement edges on several
+// levels and have to move edges between levels. This used to promote trees
+// that were too big for their new level.
+TEST(DynamicMinimumSpanningForest, RandomUpdatesWithFewWeights) {
+  constexpr int64_t kNumVertices{30};
+  std::mt19937 random_generator{6};
+  std::uniform_int_distribution<Vertex> vertex_distribution{
+    0, kNumVertices - 1};
+  std::uniform_int_distribution<Weight> weight_distribution{0, 9};
+
+  DynamicMinimumSpanningForest graph(kNumVertices);
+  std::vector<std::tuple<Weight, Vertex, Vertex>> edges;
+  for (int32_t i = 0; i < 20000; i++) {
+    const bool should_add{
+      edges.size() < 2 * kNumVertices || random_generator() % 2 == 0};
+    if (should_add) {
+      const UndirectedEdge edge{
+        vertex_distribution(random_generator),
+        vertex_distribution(random_generator)};
+      if (edge.first == edge.second || graph.HasEdge(edge)) {
+        continue;
+      }
+      const Weight weight{weight_distribution(random_generator)};
+      graph.AddEdge(edge, weight);
+      edges.emplace_back(weight, edge.first, edge.second);
+    } else {
+      const std::size_t index{random_generator() % edges.size()};
+      std::swap(edges[index], edges.back());
+      const auto [weight, u, v]{edges.back()};
+      graph.DeleteEdge({u, v});
+      edges.pop_back();
+    }
+    ASSERT_EQ(graph.GetForestWeight(), KruskalWeight(kNumVertices, edges));
+  }
+}
+
+TEST(DynamicMinimumSpanningForest, Arena) {
+  const auto arena{std::make_shared<HugePageArena>()};
+  DynamicMinimumSpanningForest graph(4, arena);
+  graph.AddEdge({0, 1}, 3);
+  graph.AddEdge({1, 2}, 5);
+  graph.AddEdge({0, 2}, 1);
+  graph.AddEdge({2, 3}, 2);
+  EXPECT_GT(arena->GetNumberOfMappedBytes(), 0);
+  EXPECT_EQ(graph.GetForestWeight(), 6);
+  graph.DeleteEdge({0, 2});
+  EXPECT_EQ(graph.GetForestWeight(), 10);
+
+  DynamicMinimumSpanningForest moved_graph{std::move(graph)};
+  moved_graph.DeleteEdge({1, 2});
+  EXPECT_FALSE(moved_graph.IsConnected(0, 3));
+  EXPECT_EQ(moved_graph.GetForestWeight(), 5);
+}
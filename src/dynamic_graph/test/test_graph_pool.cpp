@@ -0,0 +1,100 @@
+#include <dynamic_graph/graph_pool.hpp>
+
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <dynamic_graph/memory_arena.hpp>
+#include <gtest/gtest.h>
+
+TEST(GraphPool, AddAndRemoveGraphs) {
+  GraphPool pool;
+  const GraphPool::GraphId id_1{pool.AddGraph(3)};
+  const GraphPool::GraphId id_2{pool.AddGraph(5)};
+  EXPECT_NE(id_1, id_2);
+  EXPECT_EQ(pool.GetNumberOfGraphs(), 2);
+  EXPECT_TRUE(pool.HasGraph(id_1));
+
+  pool.WithGraph(id_1, [](DynamicConnectivity& graph) {
+    graph.AddEdge({0, 1});
+  });
+  EXPECT_TRUE(pool.WithGraph(id_1, [](DynamicConnectivity& graph) {
+    return graph.IsConnected(0, 1);
+  }));
+  EXPECT_FALSE(pool.WithGraph(id_2, [](DynamicConnectivity& graph) {
+    return graph.IsConnected(0, 1);
+  }));
+  EXPECT_EQ(pool.WithGraph(id_2, [](DynamicConnectivity& graph) {
+    return graph.GetNumberOfConnectedComponents();
+  }), 5);
+
+  pool.RemoveGraph(id_1);
+  EXPECT_FALSE(pool.HasGraph(id_1));
+  EXPECT_EQ(pool.GetNumberOfGraphs(), 1);
+  // The slot of the removed graph is reused and holds a fresh graph.
+  const GraphPool::GraphId id_3{pool.AddGraph(2)};
+  EXPECT_EQ(id_3, id_1);
+  EXPECT_FALSE(pool.WithGraph(id_3, [](DynamicConnectivity& graph) {
+    return graph.IsConnected(0, 1);
+  }));
+  EXPECT_FALSE(pool.HasGraph(1000));
+}
+
+namespace {
+
+// Tenants on different threads should not interfere with each other.
+void CheckParallelTenants(GraphPool& pool) {
+  constexpr int32_t kNumThreads{4};
+  constexpr int32_t kGraphsPerThread{50};
+  constexpr int64_t kNumVertices{20};
+
+  std::vector<std::vector<GraphPool::GraphId>> ids(kNumThreads);
+  std::vector<std::thread> threads;
+  for (int32_t i = 0; i < kNumThreads; i++) {
+    threads.emplace_back([&, i] {
+      for (int32_t j = 0; j < kGraphsPerThread; j++) {
+        const GraphPool::GraphId id{pool.AddGraph(kNumVertices)};
+        ids[i].push_back(id);
+        pool.WithGraph(id, [&](DynamicConnectivity& graph) {
+          // Build a cycle and then cut it into two paths.
+          for (Vertex v = 0; v < kNumVertices; v++) {
+            graph.AddEdge({v, (v + 1) % kNumVertices});
+          }
+          graph.DeleteEdge({0, 1});
+          graph.DeleteEdge({kNumVertices / 2, kNumVertices / 2 + 1});
+        });
+      }
+    });
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+
+  EXPECT_EQ(pool.GetNumberOfGraphs(), kNumThreads * kGraphsPerThread);
+  for (const std::vector<GraphPool::GraphId>& thread_ids : ids) {
+    for (GraphPool::GraphId id : thread_ids) {
+      pool.WithGraph(id, [&](DynamicConnectivity& graph) {
+        EXPECT_EQ(graph.GetNumberOfConnectedComponents(), 2);
+        EXPECT_FALSE(graph.IsConnected(0, 1));
+        EXPECT_TRUE(graph.IsConnected(1, kNumVertices / 2));
+        EXPECT_EQ(graph.GetSizeOfConnectedComponent(0), kNumVertices / 2);
+      });
+    }
+  }
+}
+
+}  // namespace
+
+TEST(GraphPool, ParallelTenants) {
+  GraphPool pool;
+  CheckParallelTenants(pool);
+}
+
+// Graphs of a pool given an arena should all allocate from it, from different
+// threads at once.
+TEST(GraphPool, SharedArena) {
+  const auto arena{std::make_shared<HugePageArena>()};
+  GraphPool pool{arena};
+  CheckParallelTenants(pool);
+  EXPECT_GT(arena->GetNumberOfMappedBytes(), 0);
+}
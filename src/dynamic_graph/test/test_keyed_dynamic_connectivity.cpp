@@ -0,0 +1,146 @@
+#include <dynamic_graph/keyed_dynamic_connectivity.hpp>
+
+#include <algorithm>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+TEST(KeyedDynamicConnectivity, StringKeys) {
+  KeyedDynamicConnectivity<std::string> graph(3);
+  EXPECT_TRUE(graph.IsConnected("alice", "alice"));
+  EXPECT_FALSE(graph.IsConnected("alice", "bob"));
+  EXPECT_EQ(graph.GetSizeOfConnectedComponent("alice"), 1);
+
+  graph.AddEdge("alice", "bob");
+  graph.AddEdge("bob", "carol");
+  EXPECT_TRUE(graph.IsConnected("alice", "carol"));
+  EXPECT_TRUE(graph.HasEdge("bob", "alice"));
+  EXPECT_FALSE(graph.HasEdge("alice", "carol"));
+  EXPECT_EQ(graph.GetSizeOfConnectedComponent("carol"), 3);
+  EXPECT_EQ(graph.GetNumberOfNonIsolatedVertices(), 3);
+
+  // Deleting alice's only edge frees her vertex for dave.
+  graph.DeleteEdge("alice", "bob");
+  EXPECT_FALSE(graph.IsConnected("alice", "carol"));
+  EXPECT_EQ(graph.GetNumberOfNonIsolatedVertices(), 2);
+  graph.AddEdge("dave", "carol");
+  EXPECT_TRUE(graph.IsConnected("dave", "bob"));
+  EXPECT_FALSE(graph.IsConnected("alice", "dave"));
+  EXPECT_EQ(graph.GetSizeOfConnectedComponent("alice"), 1);
+}
+
+// Compares against a `DynamicConnectivity` on dense vertices while sparse keys
+// come and go, so that vertices and hash table entries get recycled, and while
+// the vertices get renumbered now and then.
+TEST(KeyedDynamicConnectivity, RandomUpdates) {
+  constexpr int64_t kNumKeys{60};
+  std::mt19937 random_generator{0};
+  std::vector<int64_t> keys(kNumKeys);
+  for (int64_t& key : keys) {
+    key = static_cast<int64_t>(random_generator()) << 32;
+  }
+  std::uniform_int_distribution<Vertex> vertex_distribution{0, kNumKeys - 1};
+
+  KeyedDynamicConnectivity<int64_t> graph(kNumKeys);
+  DynamicConnectivity expected_graph(kNumKeys);
+  std::vector<std::pair<Vertex, Vertex>> edges;
+  for (int32_t i = 0; i < 3000; i++) {
+    if (edges.size() < 40 || random_generator() % 2 == 0) {
+      const UndirectedEdge edge{
+        vertex_distribution(random_generator),
+        vertex_distribution(random_generator)};
+      if (edge.first == edge.second || expected_graph.HasEdge(edge)) {
+        continue;
+      }
+      graph.AddEdge(keys[edge.first], keys[edge.second]);
+      expected_graph.AddEdge(edge);
+      edges.emplace_back(edge.first, edge.second);
+    } else {
+      const std::size_t index{random_generator() % edges.size()};
+      const UndirectedEdge edge{edges[index].first, edges[index].second};
+      std::swap(edges[index], edges.back());
+      edges.pop_back();
+      graph.DeleteEdge(keys[edge.second], keys[edge.first]);
+      expected_graph.DeleteEdge(edge);
+    }
+
+    if (i % 500 == 0) {
+      graph.ReorderVertices();
+    }
+
+    const Vertex u{vertex_distribution(random_generator)};
+    const Vertex v{vertex_distribution(random_generator)};
+    ASSERT_EQ(
+        graph.IsConnected(keys[u], keys[v]), expected_graph.IsConnected(u, v));
+    ASSERT_EQ(
+        graph.GetSizeOfConnectedComponent(keys[u]),
+        expected_graph.GetSizeOfConnectedComponent(u));
+  }
+}
+
+TEST(KeyedDynamicConnectivity, BulkBuildAndReorderVertices) {
+  const std::vector<std::pair<int64_t, int64_t>> edges{
+    {7000, 12}, {12, -5}, {-5, 7000}, {99, 100}, {100, 101}};
+  KeyedDynamicConnectivity<int64_t> graph(8, edges);
+  EXPECT_TRUE(graph.IsConnected(7000, -5));
+  EXPECT_TRUE(graph.IsConnected(99, 101));
+  EXPECT_FALSE(graph.IsConnected(12, 100));
+  EXPECT_EQ(graph.GetNumberOfNonIsolatedVertices(), 6);
+
+  graph.DeleteEdge(12, -5);
+  graph.AddEdge(101, 5);
+  graph.ReorderVertices();
+  EXPECT_TRUE(graph.HasEdge(-5, 7000));
+  EXPECT_FALSE(graph.HasEdge(12, -5));
+  EXPECT_TRUE(graph.IsConnected(12, -5));
+  EXPECT_EQ(graph.GetSizeOfConnectedComponent(5), 4);
+  EXPECT_EQ(graph.GetNumberOfNonIsolatedVertices(), 7);
+  graph.DeleteEdge(7000, 12);
+  EXPECT_FALSE(graph.IsConnected(12, -5));
+  EXPECT_EQ(graph.GetNumberOfNonIsolatedVertices(), 6);
+  // 12's vertex was freed, so there is room for two new keys.
+  graph.AddEdge(1, 2);
+  EXPECT_TRUE(graph.IsConnected(2, 1));
+  EXPECT_EQ(graph.GetNumberOfNonIsolatedVertices(), 8);
+}
+
+TEST(KeyedDynamicConnectivity, BulkBuildDuplicateEdge) {
+  const std::vector<std::pair<int64_t, int64_t>> edges{
+    {7000, 12}, {12, -5}, {12, 7000}};
+  EXPECT_DEATH(
+      (KeyedDynamicConnectivity<int64_t>{8, edges}),
+      "Edge is already in the graph");
+}
+
+TEST(KeyedDynamicConnectivity, AddEdgeOverCapacity) {
+  KeyedDynamicConnectivity<int64_t> graph(3);
+  graph.AddEdge(1, 2);
+  EXPECT_DEATH(graph.AddEdge(3, 4), "More than 3 vertices have edges");
+  // There is room for one new key.
+  graph.AddEdge(2, 3);
+  EXPECT_TRUE(graph.IsConnected(1, 3));
+}
+
+TEST(ComputeLocalityOrder, ShuffledPath) {
+  // A path whose vertices are numbered in a scrambled order, plus an isolated
+  // vertex.
+  const std::vector<Vertex> path{4, 0, 6, 2, 5, 1};
+  std::vector<UndirectedEdge> edges;
+  for (std::size_t i = 0; i + 1 < path.size(); i++) {
+    edges.emplace_back(path[i], path[i + 1]);
+  }
+  const std::vector<Vertex> new_ids{ComputeLocalityOrder(7, edges)};
+
+  std::vector<Vertex> sorted_ids{new_ids};
+  std::sort(sorted_ids.begin(), sorted_ids.end());
+  EXPECT_EQ(sorted_ids, (std::vector<Vertex>{0, 1, 2, 3, 4, 5, 6}));
+  EXPECT_EQ(new_ids[3], 6);
+  // Neighbors on the path end up at most two apart: a depth-first search from
+  // vertex 0 numbers one side of it, 4, and then walks the other side.
+  for (const UndirectedEdge& edge : edges) {
+    EXPECT_LE(std::abs(new_ids[edge.first] - new_ids[edge.second]), 2);
+  }
+}
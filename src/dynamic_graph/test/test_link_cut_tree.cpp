@@ -0,0 +1,38 @@
+#include <link_cut_tree.hpp>
+
+#include <gtest/gtest.h>
+
+TEST(LinkCutTree, GetHeaviestEdgeOnPath) {
+  LinkCutTree forest(6);
+  // Path 0 - 1 - 2 - 3 with a branch 2 - 4.
+  forest.AddEdge({0, 1}, 5);
+  forest.AddEdge({1, 2}, 3);
+  forest.AddEdge({2, 3}, 7);
+  forest.AddEdge({2, 4}, 1);
+  EXPECT_EQ(forest.GetHeaviestEdgeOnPath(0, 2), UndirectedEdge(0, 1));
+  EXPECT_EQ(forest.GetHeaviestEdgeOnPath(4, 0), UndirectedEdge(0, 1));
+  EXPECT_EQ(forest.GetHeaviestEdgeOnPath(1, 3), UndirectedEdge(2, 3));
+  EXPECT_EQ(forest.GetHeaviestEdgeOnPath(4, 2), UndirectedEdge(2, 4));
+
+  forest.DeleteEdge({2, 3});
+  forest.AddEdge({3, 4}, 2);
+  EXPECT_EQ(forest.GetHeaviestEdgeOnPath(3, 1), UndirectedEdge(1, 2));
+  forest.AddEdge({3, 5}, 2);
+  // Ties are broken by endpoints.
+  EXPECT_EQ(forest.GetHeaviestEdgeOnPath(4, 5), UndirectedEdge(3, 5));
+}
+
+TEST(LinkCutTree, Copy) {
+  LinkCutTree forest(5);
+  forest.AddEdge({0, 1}, 1);
+  forest.AddEdge({1, 2}, 2);
+  forest.AddEdge({2, 3}, 3);
+  forest.AddEdge({1, 4}, 4);
+
+  // The copy is independent of the original.
+  LinkCutTree copy{forest};
+  copy.DeleteEdge({1, 4});
+  copy.AddEdge({0, 4}, 0);
+  EXPECT_EQ(copy.GetHeaviestEdgeOnPath(4, 1), UndirectedEdge(0, 1));
+  EXPECT_EQ(forest.GetHeaviestEdgeOnPath(4, 0), UndirectedEdge(1, 4));
+}
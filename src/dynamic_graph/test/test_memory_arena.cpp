@@ -0,0 +1,149 @@
+#include <dynamic_graph/memory_arena.hpp>
+
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include <dynamic_graph/dynamic_connectivity.hpp>
+#include <gtest/gtest.h>
+
+TEST(HugePageArena, AllocateAndReuse) {
+  HugePageArena arena{
+    HugePageArena::PageSize::k2Mb, HugePageArena::NumaPlacement::kInterleave};
+  EXPECT_EQ(arena.GetNumberOfMappedBytes(), 0);
+
+  void* const a{arena.Allocate(24, 8)};
+  void* const b{arena.Allocate(24, 8)};
+  EXPECT_NE(a, b);
+  EXPECT_EQ(reinterpret_cast<std::uintptr_t>(a) % 16, 0);
+  const std::size_t num_chunk_bytes{arena.GetNumberOfMappedBytes()};
+  EXPECT_GT(num_chunk_bytes, 0);
+  EXPECT_LE(arena.GetNumberOfHugeTlbBytes(), num_chunk_bytes);
+  // Freed memory is handed out again to allocations of the same size class.
+  arena.Deallocate(a, 24, 8);
+  EXPECT_EQ(arena.Allocate(20, 4), a);
+  void* const c{arena.Allocate(290, 8)};
+  arena.Deallocate(c, 290, 8);
+  EXPECT_EQ(arena.Allocate(310, 8), c);
+  void* const d{arena.Allocate(330, 8)};
+  EXPECT_NE(d, c);
+
+  // Large allocations get mappings of their own and give them back when freed.
+  constexpr std::size_t kLargeSize{std::size_t{64} << 20};
+  char* const large{static_cast<char*>(arena.Allocate(kLargeSize, 8))};
+  large[0] = 1;
+  large[kLargeSize - 1] = 1;
+  EXPECT_GE(arena.GetNumberOfMappedBytes(), num_chunk_bytes + kLargeSize);
+  arena.Deallocate(large, kLargeSize, 8);
+  EXPECT_EQ(arena.GetNumberOfMappedBytes(), num_chunk_bytes);
+}
+
+namespace {
+
+// Compares a graph allocated from the given arenas against one using the
+// global allocator, and checks that a copy of the graph keeps working after the
+// original is destroyed.
+void CompareAgainstGlobalAllocator(
+    const std::shared_ptr<MemoryArena>& arena,
+    const std::shared_ptr<MemoryArena>& upper_level_arena) {
+  constexpr int64_t kNumVertices{100};
+  auto graph{std::make_unique<DynamicConnectivity>(
+      kNumVertices, arena, upper_level_arena)};
+  DynamicConnectivity expected_graph(kNumVertices);
+  std::mt19937 random_generator{0};
+  std::uniform_int_distribution<Vertex> vertex_distribution{
+    0, kNumVertices - 1};
+  std::vector<std::pair<Vertex, Vertex>> edges;
+  for (int32_t i = 0; i < 4000; i++) {
+    if (edges.size() < 150 || random_generator() % 2 == 0) {
+      const UndirectedEdge edge{
+        vertex_distribution(random_generator),
+        vertex_distribution(random_generator)};
+      if (edge.first == edge.second || expected_graph.HasEdge(edge)) {
+        continue;
+      }
+      graph->AddEdge(edge);
+      expected_graph.AddEdge(edge);
+      edges.emplace_back(edge.first, edge.second);
+    } else {
+      const std::size_t index{random_generator() % edges.size()};
+      const UndirectedEdge edge{edges[index].first, edges[index].second};
+      std::swap(edges[index], edges.back());
+      edges.pop_back();
+      graph->DeleteEdge(edge);
+      expected_graph.DeleteEdge(edge);
+    }
+
+    if (i == 2000) {
+      graph = std::make_unique<DynamicConnectivity>(*graph);
+    }
+
+    const Vertex u{vertex_distribution(random_generator)};
+    const Vertex v{vertex_distribution(random_generator)};
+    ASSERT_EQ(graph->IsConnected(u, v), expected_graph.IsConnected(u, v));
+    ASSERT_EQ(
+        graph->GetSizeOfConnectedComponent(u),
+        expected_graph.GetSizeOfConnectedComponent(u));
+  }
+}
+
+}  // namespace
+
+TEST(HugePageArena, DynamicConnectivity) {
+  const auto arena{std::make_shared<HugePageArena>()};
+  CompareAgainstGlobalAllocator(arena, nullptr);
+  EXPECT_GT(arena->GetNumberOfMappedBytes(), 0);
+}
+
+TEST(MappedFileArena, AllocateAndReuse) {
+  MappedFileArena arena{testing::TempDir(), 1 << 16};
+  char* const a{static_cast<char*>(arena.Allocate(100, 8))};
+  a[0] = 'a';
+  a[99] = 'z';
+  EXPECT_EQ(arena.GetNumberOfMappedBytes(), 1 << 16);
+  arena.Deallocate(a, 100, 8);
+  EXPECT_EQ(arena.Allocate(100, 8), a);
+
+  char* const large{static_cast<char*>(arena.Allocate(1 << 20, 8))};
+  large[(1 << 20) - 1] = 1;
+  EXPECT_EQ(arena.GetNumberOfMappedBytes(), (1 << 16) + (1 << 20));
+  arena.Deallocate(large, 1 << 20, 8);
+  EXPECT_EQ(arena.GetNumberOfMappedBytes(), 1 << 16);
+}
+
+// Keeps level 0 in memory and puts the upper levels in a file.
+TEST(MappedFileArena, DynamicConnectivityUpperLevels) {
+  const auto upper_level_arena{
+    std::make_shared<MappedFileArena>(testing::TempDir(), 1 << 16)};
+  CompareAgainstGlobalAllocator(nullptr, upper_level_arena);
+  EXPECT_GT(upper_level_arena->GetNumberOfMappedBytes(), 0);
+}
+
+TEST(SubArena, AllocateAndReuse) {
+  constexpr std::size_t kChunkSize{1 << 16};
+  const auto parent{std::make_shared<HugePageArena>()};
+  auto arena{std::make_unique<SubArena>(parent, kChunkSize)};
+  EXPECT_EQ(arena->GetNumberOfMappedBytes(), 0);
+
+  void* const a{arena->Allocate(100, 8)};
+  EXPECT_EQ(arena->GetNumberOfMappedBytes(), kChunkSize);
+  const std::size_t num_parent_bytes{parent->GetNumberOfMappedBytes()};
+  EXPECT_GT(num_parent_bytes, 0);
+  arena->Deallocate(a, 100, 8);
+  EXPECT_EQ(arena->Allocate(100, 8), a);
+
+  // Large allocations come straight from the parent.
+  void* const large{arena->Allocate(kChunkSize, 8)};
+  EXPECT_EQ(arena->GetNumberOfMappedBytes(), 2 * kChunkSize);
+  arena->Deallocate(large, kChunkSize, 8);
+  EXPECT_EQ(arena->GetNumberOfMappedBytes(), kChunkSize);
+
+  // Destroying the sub-arena gives its chunk back to the parent, which hands
+  // it out again.
+  arena.reset();
+  EXPECT_EQ(parent->Allocate(kChunkSize, 8), a);
+  EXPECT_EQ(parent->GetNumberOfMappedBytes(), num_parent_bytes);
+}
+
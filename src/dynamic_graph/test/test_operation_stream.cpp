@@ -0,0 +1,174 @@
+#include <dynamic_graph/operation_stream.hpp>
+
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+namespace {
+
+std::string MakePath(const std::string& name) {
+  return testing::TempDir() + "/operation_stream_" + name;
+}
+
+}  // namespace
+
+TEST(OperationStream, DecodeOperations) {
+  constexpr int64_t kNumVertices{10};
+  std::vector<char> buffer(4 * kEncodedOperationSize);
+  EncodeOperation(
+      {Operation::Type::kAddEdge, UndirectedEdge{3, 1}}, buffer.data());
+  EncodeOperation(
+      {Operation::Type::kDeleteEdge, UndirectedEdge{0, 9}},
+      buffer.data() + kEncodedOperationSize);
+  EncodeOperation(
+      {Operation::Type::kIsConnected, UndirectedEdge{5, 5}},
+      buffer.data() + 2 * kEncodedOperationSize);
+  EncodeOperation(
+      {Operation::Type::kAddEdge, UndirectedEdge{2, 4}},
+      buffer.data() + 3 * kEncodedOperationSize);
+
+  OperationBatch batch;
+  EXPECT_EQ(DecodeOperations(buffer.data(), 4, kNumVertices, &batch), 4);
+  EXPECT_EQ(batch.GetSize(), 4);
+  EXPECT_EQ(batch.types[1], Operation::Type::kDeleteEdge);
+  EXPECT_EQ(batch.types[2], Operation::Type::kIsConnected);
+  EXPECT_EQ(batch.first_vertices[0], 1);
+  EXPECT_EQ(batch.second_vertices[0], 3);
+  EXPECT_EQ(batch.second_vertices[1], 9);
+
+  // Vertex out of range.
+  EXPECT_EQ(DecodeOperations(buffer.data(), 4, 9, &batch), 1);
+  // Invalid op code.
+  std::vector<char> corrupt_buffer{buffer};
+  corrupt_buffer[2 * kEncodedOperationSize] = 4;
+  EXPECT_EQ(
+      DecodeOperations(corrupt_buffer.data(), 4, kNumVertices, &batch), 2);
+  // Nonzero padding.
+  corrupt_buffer = buffer;
+  corrupt_buffer[3 * kEncodedOperationSize + 5] = 1;
+  EXPECT_EQ(
+      DecodeOperations(corrupt_buffer.data(), 4, kNumVertices, &batch), 3);
+  // Negative vertex.
+  corrupt_buffer = buffer;
+  const Vertex negative_vertex{-1};
+  std::memcpy(
+      corrupt_buffer.data() + 8, &negative_vertex, sizeof(negative_vertex));
+  EXPECT_EQ(
+      DecodeOperations(corrupt_buffer.data(), 4, kNumVertices, &batch), 0);
+}
+
+TEST(OperationStream, WriteAndRead) {
+  const std::string path{MakePath("write_and_read")};
+  {
+    OperationStreamWriter writer{path};
+    for (Vertex v = 0; v < 10000; v++) {
+      writer.Append({Operation::Type::kAddEdge, UndirectedEdge{v, v + 1}});
+    }
+  }
+  const OperationStreamReader stream{path};
+  ASSERT_EQ(stream.GetNumberOfOperations(), 10000);
+  OperationBatch batch;
+  EXPECT_EQ(stream.Decode(5000, 6000, 10001, &batch), 6000);
+  ASSERT_EQ(batch.GetSize(), 1000);
+  for (int64_t i = 0; i < batch.GetSize(); i++) {
+    EXPECT_EQ(batch.types[i], Operation::Type::kAddEdge);
+    EXPECT_EQ(batch.first_vertices[i], 5000 + i);
+    EXPECT_EQ(batch.second_vertices[i], 5001 + i);
+  }
+  // The last vertex is out of range.
+  EXPECT_EQ(stream.Decode(0, 10000, 10000, &batch), 9999);
+}
+
+TEST(OperationStream, IngestEmptyStream) {
+  const std::string path{MakePath("empty")};
+  { OperationStreamWriter writer{path}; }
+  const OperationStreamReader stream{path};
+  EXPECT_EQ(stream.GetNumberOfOperations(), 0);
+  DynamicConnectivity graph(5);
+  const IngestStatistics statistics{IngestOperationStream(stream, &graph)};
+  EXPECT_EQ(statistics.num_edges_added, 0);
+  EXPECT_EQ(statistics.num_queries, 0);
+  EXPECT_EQ(graph.GetNumberOfConnectedComponents(), 5);
+}
+
+// Ingests random operations, including duplicate updates and self-loops, in
+// small batches and compares against applying them directly.
+TEST(OperationStream, IngestRandomOperations) {
+  constexpr int64_t kNumVertices{50};
+  constexpr int64_t kNumOperations{20000};
+  const std::string path{MakePath("random")};
+  std::mt19937 random_generator{0};
+  std::uniform_int_distribution<Vertex> vertex_distribution{
+    0, kNumVertices - 1};
+  DynamicConnectivity expected_graph(kNumVertices);
+  IngestStatistics expected_statistics;
+  {
+    OperationStreamWriter writer{path};
+    for (int64_t i = 0; i < kNumOperations; i++) {
+      const Vertex u{vertex_distribution(random_generator)};
+      const Vertex v{vertex_distribution(random_generator)};
+      const UndirectedEdge edge{u, v};
+      switch (random_generator() % 3) {
+        case 0:
+          writer.Append({Operation::Type::kAddEdge, UndirectedEdge{u, v}});
+          if (u == v || expected_graph.HasEdge(edge)) {
+            expected_statistics.num_updates_skipped++;
+          } else {
+            expected_graph.AddEdge(edge);
+            expected_statistics.num_edges_added++;
+          }
+          break;
+        case 1:
+          writer.Append({Operation::Type::kDeleteEdge, UndirectedEdge{u, v}});
+          if (expected_graph.HasEdge(edge)) {
+            expected_graph.DeleteEdge(edge);
+            expected_statistics.num_edges_deleted++;
+          } else {
+            expected_statistics.num_updates_skipped++;
+          }
+          break;
+        default:
+          writer.Append({Operation::Type::kIsConnected, UndirectedEdge{u, v}});
+          expected_statistics.num_queries++;
+          expected_statistics.num_connected_queries +=
+            expected_graph.IsConnected(u, v);
+          break;
+      }
+    }
+  }
+
+  const OperationStreamReader stream{path};
+  DynamicConnectivity graph(kNumVertices);
+  const IngestStatistics statistics{IngestOperationStream(stream, &graph, 7)};
+  EXPECT_EQ(statistics.num_edges_added, expected_statistics.num_edges_added);
+  EXPECT_EQ(
+      statistics.num_edges_deleted, expected_statistics.num_edges_deleted);
+  EXPECT_EQ(
+      statistics.num_updates_skipped, expected_statistics.num_updates_skipped);
+  EXPECT_EQ(statistics.num_queries, expected_statistics.num_queries);
+  EXPECT_EQ(
+      statistics.num_connected_queries,
+      expected_statistics.num_connected_queries);
+  for (Vertex u = 0; u < kNumVertices; u++) {
+    for (Vertex v = u + 1; v < kNumVertices; v++) {
+      EXPECT_EQ(graph.HasEdge({u, v}), expected_graph.HasEdge({u, v}));
+      EXPECT_EQ(graph.IsConnected(u, v), expected_graph.IsConnected(u, v));
+    }
+  }
+}
+
+TEST(OperationStream, IngestInvalidOperation) {
+  const std::string path{MakePath("invalid")};
+  {
+    OperationStreamWriter writer{path};
+    writer.Append({Operation::Type::kAddEdge, UndirectedEdge{0, 1}});
+    writer.Append({Operation::Type::kAddEdge, UndirectedEdge{1, 5}});
+  }
+  const OperationStreamReader stream{path};
+  DynamicConnectivity graph(5);
+  EXPECT_DEATH(
+      IngestOperationStream(stream, &graph), "Operation 1 of the stream");
+}
@@ -1,5 +1,7 @@
 #include <sequence.hpp>
 
+#include <vector>
+
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
@@ -98,6 +100,38 @@ TEST(Sequence, Mark) {
   EXPECT_THAT(elements[1].FindMarkedElement(1), Optional(&elements[1]));
 }
 
+TEST(Sequence, TakeMarkedElements) {
+  constexpr int32_t kNumElements{100};
+  seq::Element elements[kNumElements];
+  for (int32_t i = 1; i < kNumElements; i++) {
+    seq::Element::Join(&elements[i - 1], &elements[i]);
+  }
+  std::vector<seq::Element*> expected_marked;
+  for (int32_t i = 3; i < kNumElements; i += 7) {
+    elements[i].Mark(0, true);
+    expected_marked.push_back(&elements[i]);
+  }
+  elements[50].Mark(1, true);
+
+  EXPECT_EQ(elements[0].FindMarkedElements(0, kNumElements), expected_marked);
+  EXPECT_EQ(
+      elements[0].FindMarkedElements(1, kNumElements),
+      std::vector<seq::Element*>{&elements[50]});
+  EXPECT_EQ(
+      elements[99].TakeMarkedElements(0, 3),
+      std::vector<seq::Element*>(
+        expected_marked.begin(), expected_marked.begin() + 3));
+  const std::vector<seq::Element*> remaining_marked(
+      expected_marked.begin() + 3, expected_marked.end());
+  EXPECT_EQ(
+      elements[0].FindMarkedElements(0, kNumElements), remaining_marked);
+  EXPECT_EQ(
+      elements[0].TakeMarkedElements(0, kNumElements), remaining_marked);
+  EXPECT_FALSE(elements[0].FindMarkedElement(0).has_value());
+  EXPECT_TRUE(elements[0].TakeMarkedElements(0, kNumElements).empty());
+  EXPECT_THAT(elements[0].FindMarkedElement(1), Optional(&elements[50]));
+}
+
 TEST(Sequence, MoveConstructor) {
   seq::Element elements[3];
   seq::Element::Join(&elements[0], &elements[1]);
@@ -116,3 +150,90 @@ TEST(Sequence, MoveConstructor) {
       movedElement1.GetRepresentative(),
       movedElement2.GetRepresentative());
 }
+
+TEST(Sequence, CopySequences) {
+  seq::Element elements[5];
+  for (int32_t i = 0; i < 5; i++) {
+    elements[i].id_ = {i, i};
+  }
+  seq::Element::Join(&elements[0], &elements[1]);
+  seq::Element::Join(&elements[1], &elements[2]);
+  seq::Element::Join(&elements[3], &elements[4]);
+  elements[2].Mark(0, true);
+
+  seq::Element copies[5];
+  seq::Element::CopySequences(elements, copies, 5);
+  EXPECT_EQ(copies[0].GetRepresentative(), copies[2].GetRepresentative());
+  EXPECT_NE(copies[0].GetRepresentative(), copies[3].GetRepresentative());
+  EXPECT_EQ(copies[0].GetSize(), 3);
+  EXPECT_EQ(copies[4].GetSize(), 2);
+  EXPECT_THAT(copies[0].FindMarkedElement(0), Optional(&copies[2]));
+  EXPECT_EQ(
+      copies[0].SequenceIds(),
+      (std::vector<seq::Id>{{0, 0}, {1, 1}, {2, 2}}));
+
+  // The copies are independent of the originals.
+  copies[0].Split();
+  EXPECT_EQ(copies[1].GetSize(), 2);
+  EXPECT_EQ(elements[1].GetSize(), 3);
+}
+
+TEST(Sequence, CopySequencesToIndices) {
+  seq::Element elements[5];
+  for (int32_t i = 0; i < 5; i++) {
+    elements[i].id_ = {i, i};
+  }
+  seq::Element::Join(&elements[0], &elements[2]);
+  seq::Element::Join(&elements[2], &elements[4]);
+  elements[4].Mark(0, true);
+
+  // Copy the sequence in reverse index order, leaving out the singletons.
+  const int64_t destination_indices[5]{2, -1, 1, -1, 0};
+  seq::Element copies[3];
+  seq::Element::CopySequences(elements, copies, 5, destination_indices);
+  EXPECT_EQ(copies[0].GetRepresentative(), copies[2].GetRepresentative());
+  EXPECT_EQ(copies[1].GetSize(), 3);
+  EXPECT_THAT(copies[2].FindMarkedElement(0), Optional(&copies[0]));
+  EXPECT_EQ(
+      copies[1].SequenceIds(),
+      (std::vector<seq::Id>{{0, 0}, {2, 2}, {4, 4}}));
+}
+
+TEST(Sequence, Aggregate) {
+  typedef seq::AugmentedElement<SumAggregate<int64_t>> SumElement;
+  SumElement elements[4];
+  for (int32_t i = 0; i < 4; i++) {
+    elements[i].SetValue(i + 1);
+  }
+  EXPECT_EQ(elements[2].GetValue(), 3);
+  EXPECT_EQ(elements[2].GetAggregate(), 3);
+
+  SumElement::Join(&elements[0], &elements[1]);
+  SumElement::Join(&elements[1], &elements[2]);
+  SumElement::Join(&elements[2], &elements[3]);
+  EXPECT_EQ(elements[0].GetAggregate(), 10);
+
+  elements[1].SetValue(10);
+  EXPECT_EQ(elements[3].GetAggregate(), 18);
+
+  elements[1].Split();
+  EXPECT_EQ(elements[0].GetAggregate(), 11);
+  EXPECT_EQ(elements[2].GetAggregate(), 7);
+}
+
+TEST(Sequence, GetPrefixAggregate) {
+  typedef seq::AugmentedElement<SumAggregate<int64_t>> SumElement;
+  SumElement elements[5];
+  for (int32_t i = 0; i < 5; i++) {
+    elements[i].SetValue(1 << i);
+  }
+  EXPECT_EQ(elements[3].GetPrefixAggregate(), 0b01000);
+  for (int32_t i = 0; i < 4; i++) {
+    SumElement::Join(&elements[i], &elements[i + 1]);
+  }
+  for (int32_t i = 0; i < 5; i++) {
+    EXPECT_EQ(elements[i].GetPrefixAggregate(), (2 << i) - 1);
+  }
+  elements[2].Split();
+  EXPECT_EQ(elements[4].GetPrefixAggregate(), 0b11000);
+}
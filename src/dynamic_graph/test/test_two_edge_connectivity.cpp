@@ -0,0 +1,134 @@
+#include <two_edge_connectivity.hpp>
+
+#include <algorithm>
+#include <random>
+#include <set>
+#include <utility>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+TEST(TwoEdgeConnectivity, Is2EdgeConnected) {
+  TwoEdgeConnectivity graph(6);
+  // Triangle 0 - 1 - 2 attached by bridge 2 - 3 to path 3 - 4.
+  graph.AddEdge({0, 1});
+  graph.AddEdge({1, 2});
+  graph.AddEdge({2, 0});
+  graph.AddEdge({2, 3});
+  graph.AddEdge({3, 4});
+  EXPECT_TRUE(graph.Is2EdgeConnected(0, 2));
+  EXPECT_FALSE(graph.Is2EdgeConnected(0, 3));
+  EXPECT_FALSE(graph.Is2EdgeConnected(0, 5));
+  EXPECT_TRUE(graph.Is2EdgeConnected(5, 5));
+
+  graph.AddEdge({4, 0});
+  EXPECT_TRUE(graph.Is2EdgeConnected(1, 4));
+  // Deleting a tree edge swaps in the non-tree edge that covers it.
+  graph.DeleteEdge({0, 1});
+  EXPECT_FALSE(graph.Is2EdgeConnected(1, 4));
+  EXPECT_TRUE(graph.Is2EdgeConnected(0, 4));
+
+  // The copy is independent of the original.
+  TwoEdgeConnectivity copy{graph};
+  copy.AddEdge({1, 5});
+  copy.AddEdge({5, 4});
+  EXPECT_TRUE(copy.Is2EdgeConnected(1, 4));
+  EXPECT_FALSE(graph.Is2EdgeConnected(1, 4));
+}
+
+namespace {
+
+typedef std::set<std::pair<Vertex, Vertex>> EdgeSet;
+
+// Returns the 2-edge-connected component of each vertex of `edges`, a graph on
+// `num_vertices` vertices, found by deleting each edge in turn to find the
+// bridges and then finding the connected components without them.
+std::vector<Vertex> Find2EdgeConnectedComponents(
+    int64_t num_vertices, const EdgeSet& edges) {
+  // Labels the connected components of `edges` without `deleted_edges`.
+  const auto find_components{[&](const EdgeSet& deleted_edges) {
+    std::vector<std::vector<Vertex>> adjacency_lists(num_vertices);
+    for (const auto& [u, v] : edges) {
+      if (deleted_edges.count({u, v}) == 0) {
+        adjacency_lists[u].push_back(v);
+        adjacency_lists[v].push_back(u);
+      }
+    }
+    std::vector<Vertex> components(num_vertices, -1);
+    for (Vertex source = 0; source < num_vertices; source++) {
+      if (components[source] != -1) {
+        continue;
+      }
+      components[source] = source;
+      std::vector<Vertex> stack{source};
+      while (!stack.empty()) {
+        const Vertex u{stack.back()};
+        stack.pop_back();
+        for (const Vertex v : adjacency_lists[u]) {
+          if (components[v] == -1) {
+            components[v] = source;
+            stack.push_back(v);
+          }
+        }
+      }
+    }
+    return components;
+  }};
+
+  EdgeSet bridges;
+  for (const auto& edge : edges) {
+    if (find_components({edge}) != find_components({})) {
+      bridges.insert(edge);
+    }
+  }
+  return find_components(bridges);
+}
+
+}  // namespace
+
+// Checks 2-edge connectivity against brute force over random updates on a
+// graph large enough for edges to move up several levels.
+TEST(TwoEdgeConnectivity, RandomUpdates) {
+  constexpr int64_t kNumVertices{64};
+  constexpr int32_t kNumRounds{150};
+  constexpr int32_t kUpdatesPerRound{10};
+  std::mt19937 random_generator{0};
+  std::uniform_int_distribution<Vertex> vertex_distribution{
+    0, kNumVertices - 1};
+
+  TwoEdgeConnectivity graph(kNumVertices);
+  EdgeSet edges;
+  for (int32_t round = 0; round < kNumRounds; round++) {
+    // Alternate between growing the graph to a dense one, which moves edges
+    // up levels when its tree edges are deleted, and shrinking it to a sparse
+    // one with many bridges.
+    const std::size_t target_num_edges{static_cast<std::size_t>(
+      (round / 25) % 2 == 0 ? 3 * kNumVertices : kNumVertices)};
+    for (int32_t i = 0; i < kUpdatesPerRound; i++) {
+      if (edges.size() < target_num_edges) {
+        const Vertex u{vertex_distribution(random_generator)};
+        const Vertex v{vertex_distribution(random_generator)};
+        if (u != v && edges.insert(std::minmax(u, v)).second) {
+          graph.AddEdge({u, v});
+        }
+      } else {
+        auto edge_it{edges.begin()};
+        std::advance(
+            edge_it,
+            std::uniform_int_distribution<std::size_t>{
+              0, edges.size() - 1}(random_generator));
+        graph.DeleteEdge({edge_it->first, edge_it->second});
+        edges.erase(edge_it);
+      }
+    }
+
+    const std::vector<Vertex> components{
+      Find2EdgeConnectedComponents(kNumVertices, edges)};
+    for (int32_t i = 0; i < 2 * kNumVertices; i++) {
+      const Vertex u{vertex_distribution(random_generator)};
+      const Vertex v{vertex_distribution(random_generator)};
+      EXPECT_EQ(graph.Is2EdgeConnected(u, v), components[u] == components[v])
+        << "Round " << round << ", vertices " << u << " and " << v;
+    }
+  }
+}
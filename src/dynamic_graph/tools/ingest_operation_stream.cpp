@@ -0,0 +1,112 @@
+// Converts text edge lists to operation streams and ingests operation streams
+// into a `DynamicConnectivity`.
+//
+// Usage:
+//   ingest_operation_stream encode <edge list> <operation stream>
+//     Writes an operation stream that adds each edge of a text edge list. Each
+//     line of the edge list is two vertices separated by whitespace. Lines
+//     starting with '#' or '%' are comments.
+//   ingest_operation_stream <number of vertices> <operation stream>
+//       [<batch size>]
+//     Applies an operation stream to an empty graph and reports how long it
+//     took.
+#include <dynamic_graph/operation_stream.hpp>
+
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+namespace {
+
+typedef std::chrono::high_resolution_clock Clock;
+
+double DurationToSeconds(const Clock::duration& duration) {
+  return
+    std::chrono::duration_cast<std::chrono::duration<double>>(duration).count();
+}
+
+int PrintUsage(const char* program) {
+  std::cerr << "Usage:\n"
+    << "  " << program << " encode <edge list> <operation stream>\n"
+    << "  " << program
+    << " <number of vertices> <operation stream> [<batch size>]\n";
+  return 1;
+}
+
+int Encode(const std::string& edge_list_path, const std::string& stream_path) {
+  std::ifstream edge_list{edge_list_path};
+  if (!edge_list) {
+    std::cerr << "Failed to open " << edge_list_path << '\n';
+    return 1;
+  }
+  OperationStreamWriter writer{stream_path};
+  std::string line;
+  int64_t num_edges{0};
+  for (int64_t line_number = 1; std::getline(edge_list, line); line_number++) {
+    if (line.empty() || line[0] == '#' || line[0] == '%') {
+      continue;
+    }
+    std::istringstream line_stream{line};
+    Vertex u;
+    Vertex v;
+    if (!(line_stream >> u >> v)) {
+      std::cerr << edge_list_path << ':' << line_number
+        << ": expected two vertices\n";
+      return 1;
+    }
+    writer.Append({Operation::Type::kAddEdge, UndirectedEdge{u, v}});
+    num_edges++;
+  }
+  std::cout << "Encoded " << num_edges << " edges.\n";
+  return 0;
+}
+
+int Ingest(
+    int64_t num_vertices, const std::string& stream_path, int64_t batch_size) {
+  const auto start{Clock::now()};
+  const OperationStreamReader stream{stream_path};
+  DynamicConnectivity graph(num_vertices);
+  const auto ingest_start{Clock::now()};
+  const IngestStatistics statistics{
+    IngestOperationStream(stream, &graph, batch_size)};
+  const auto finish{Clock::now()};
+
+  const int32_t kPrecision{4};
+  const double ingest_seconds{DurationToSeconds(finish - ingest_start)};
+  std::cout << std::setprecision(kPrecision);
+  std::cout << "Graph of " << num_vertices << " vertices.\n";
+  std::cout << "Added " << statistics.num_edges_added << " edges, deleted "
+    << statistics.num_edges_deleted << " edges, and skipped "
+    << statistics.num_updates_skipped << " updates.\n";
+  std::cout << "Answered " << statistics.num_queries << " queries, "
+    << statistics.num_connected_queries << " of them connected.\n";
+  std::cout << graph.GetNumberOfConnectedComponents()
+    << " connected components.\n";
+  std::cout << DurationToSeconds(ingest_start - start)
+    << " seconds to map the stream and initialize the graph.\n";
+  std::cout << ingest_seconds << " seconds to ingest "
+    << stream.GetNumberOfOperations() << " operations ("
+    << stream.GetNumberOfOperations() / ingest_seconds
+    << " operations per second).\n";
+  return 0;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  if (argc == 4 && std::string{argv[1]} == "encode") {
+    return Encode(argv[2], argv[3]);
+  }
+  if (argc != 3 && argc != 4) {
+    return PrintUsage(argv[0]);
+  }
+  const int64_t num_vertices{std::stoll(argv[1])};
+  const int64_t batch_size{argc == 4 ? std::stoll(argv[3]) : 1 << 16};
+  if (num_vertices <= 0 || batch_size <= 0) {
+    return PrintUsage(argv[0]);
+  }
+  return Ingest(num_vertices, argv[2], batch_size);
+}